@@ -25,6 +25,9 @@ EditorResourceRootPath = RootPath.."/Engine/EditorResources/"
 -- Game
 GameSourcePath = path.join(EngineSourcePath, "Game")
 
+-- Benchmark
+BenchmarkSourcePath = path.join(EngineSourcePath, "Benchmark")
+
 -- Project
 ProjectSharedPath = RootPath.."/Projects/Shared/"
 DefaultProjectName = "Test"
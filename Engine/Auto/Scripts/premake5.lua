@@ -231,6 +231,9 @@ end
 -- game projects
 dofile("game.lua")
 
+-- headless benchmarks for engine runtime modules
+dofile("benchmark.lua")
+
 -- regression tests for engine core modules
 dofile("test.lua")
 
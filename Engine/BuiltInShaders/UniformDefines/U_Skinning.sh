@@ -0,0 +1,4 @@
+#define SKINNING_PALETTE_SLOT 0
+// Every bone takes 3 RGBA32F texels, one per row of its 3x4 skinning matrix.
+#define SKINNING_PALETTE_TEXELS_PER_BONE 3
+#define SKINNING_PALETTE_WIDTH 3072
\ No newline at end of file
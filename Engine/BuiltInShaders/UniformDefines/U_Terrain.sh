@@ -1,4 +1,5 @@
 #define TERRAIN_TOP_ALBEDO_MAP_SLOT 7
 #define TERRAIN_MEDIUM_ALBEDO_MAP_SLOT 8
 #define TERRAIN_BOTTOM_ALBEDO_MAP_SLOT 9
-#define TERRAIN_ELEVATION_MAP_SLOT 10
\ No newline at end of file
+#define TERRAIN_ELEVATION_MAP_SLOT 10
+#define TERRAIN_NORMAL_MAP_SLOT 11
\ No newline at end of file
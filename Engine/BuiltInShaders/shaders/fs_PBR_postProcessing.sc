@@ -3,7 +3,8 @@ $input v_texcoord0
 #include "../common/common.sh"
 
 SAMPLER2D(s_lightingColor, 0);
-uniform vec4 u_gamma;
+// x : exposure scale, y : gamma, z : tone mapping weight
+uniform vec4 u_postProcessParams;
 
 vec3 ACES(vec3 color) {
 	mat3 ACESInputMat  = mtxFromRows(vec3(0.59719,  0.35458,  0.04823), vec3( 0.07600, 0.90834,  0.01566), vec3( 0.02840,  0.13383, 0.83777));
@@ -18,42 +19,18 @@ vec3 ACES(vec3 color) {
 	return color;
 }
 
-// Exposure
-float ComputeEV100(float aperture ,float shutterTime ,float ISO) {
-	// EV number is defined as:
-	// 2^ EV_s = N^2 / t and EV_s = EV_100 + log2 (S /100)
-	// This gives
-	// EV_s = log2 (N^2 / t)
-	// EV_100 + log2 (S /100) = log2 (N^2 / t)
-	// EV_100 = log2 (N^2 / t) - log2 (S /100)
-	// EV_100 = log2 (N^2 / t . 100 / S)
-	
-	return log2(aperture * aperture / shutterTime * 100.0 / ISO);
-}
-
-float ConvertEV100ToExposure(float EV100) {
-	// Compute the maximum luminance possible with H_sbs sensitivity
-	// maxLum = 78 / ( S * q ) * N^2 / t
-	// = 78 / ( S * q ) * 2^ EV_100
-	// = 78 / (100 * 0.65) * 2^ EV_100
-	// = 1.2 * 2^ EV
-	// Reference : http :// en. wikipedia . org / wiki / Film_speed
-	
-	return 1.0 / (1.2 * exp2(EV100));
-}
-
 void main()
 {
 	vec3 color = texture2D(s_lightingColor, v_texcoord0).rgb;
 	
 	// Exposure
-	color *= ConvertEV100ToExposure(0.0);
+	color *= u_postProcessParams.x;
 	
 	// Tone Mapping
-	color = ACES(color);
+	color = mix(color, ACES(color), u_postProcessParams.z);
 	
 	// Gamma Correction
-	color = pow(color, vec3_splat(u_gamma.x));
+	color = pow(color, vec3_splat(u_postProcessParams.y));
 	
 	gl_FragColor = vec4(color, 1.0);
-}
+}
\ No newline at end of file
@@ -0,0 +1,7 @@
+#include "../common/common.sh"
+
+void main()
+{
+	// Color writes are masked out. Only depth is written.
+	gl_FragColor = vec4_splat(0.0);
+}
\ No newline at end of file
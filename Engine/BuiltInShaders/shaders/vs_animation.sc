@@ -3,17 +3,39 @@ $output v_worldPos
 
 #include "../common/common.sh"
 
-uniform mat4 u_boneMatrices[128];
+#include "../UniformDefines/U_Skinning.sh"
+
+// x : index of the first palette entry of this instance.
+uniform vec4 u_skinningParams;
+SAMPLER2D(s_skinningPalette, SKINNING_PALETTE_SLOT);
+
+vec4 FetchPaletteRow(int boneIndex, int row)
+{
+	int texel = boneIndex * SKINNING_PALETTE_TEXELS_PER_BONE + row;
+	return texelFetch(s_skinningPalette, ivec2(texel % SKINNING_PALETTE_WIDTH, texel / SKINNING_PALETTE_WIDTH), 0);
+}
 
 void main()
 {
-	mat4 boneTransform = u_boneMatrices[a_indices[0]] * a_weight[0];
-	boneTransform += u_boneMatrices[a_indices[1]] * a_weight[1];
-	boneTransform += u_boneMatrices[a_indices[2]] * a_weight[2];
-	boneTransform += u_boneMatrices[a_indices[3]] * a_weight[3];
-	
-	vec4 localPosition = mul(boneTransform, vec4(a_position, 1.0));
+	int paletteOffset = int(u_skinningParams.x);
+	ivec4 boneIndices = ivec4(a_indices) + paletteOffset;
+
+	vec4 row0 = FetchPaletteRow(boneIndices.x, 0) * a_weight.x;
+	vec4 row1 = FetchPaletteRow(boneIndices.x, 1) * a_weight.x;
+	vec4 row2 = FetchPaletteRow(boneIndices.x, 2) * a_weight.x;
+	row0 += FetchPaletteRow(boneIndices.y, 0) * a_weight.y;
+	row1 += FetchPaletteRow(boneIndices.y, 1) * a_weight.y;
+	row2 += FetchPaletteRow(boneIndices.y, 2) * a_weight.y;
+	row0 += FetchPaletteRow(boneIndices.z, 0) * a_weight.z;
+	row1 += FetchPaletteRow(boneIndices.z, 1) * a_weight.z;
+	row2 += FetchPaletteRow(boneIndices.z, 2) * a_weight.z;
+	row0 += FetchPaletteRow(boneIndices.w, 0) * a_weight.w;
+	row1 += FetchPaletteRow(boneIndices.w, 1) * a_weight.w;
+	row2 += FetchPaletteRow(boneIndices.w, 2) * a_weight.w;
+
+	vec4 position = vec4(a_position, 1.0);
+	vec4 localPosition = vec4(dot(row0, position), dot(row1, position), dot(row2, position), 1.0);
 	gl_Position = mul(u_modelViewProj, localPosition);
 	
-	v_worldPos = mul(u_model[0], vec4(a_position, 1.0)).xyz;
+	v_worldPos = mul(u_model[0], localPosition).xyz;
 }
\ No newline at end of file
@@ -0,0 +1,13 @@
+$input a_position, i_data0, i_data1, i_data2, i_data3
+$output v_color0
+
+#include "../common/common.sh"
+
+// i_data0-2 : rows of the 3x4 matrix placing the unit cube, i_data3 : color.
+void main()
+{
+	vec4 position = vec4(a_position, 1.0);
+	vec3 worldPosition = vec3(dot(i_data0, position), dot(i_data1, position), dot(i_data2, position));
+	gl_Position = mul(u_viewProj, vec4(worldPosition, 1.0));
+	v_color0 = i_data3;
+}
\ No newline at end of file
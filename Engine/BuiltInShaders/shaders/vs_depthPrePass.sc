@@ -0,0 +1,9 @@
+$input a_position
+
+#include "../common/common.sh"
+
+void main()
+{
+	// Same expression as vs_PBR. The main pass tests depth with LEQUAL against the result.
+	gl_Position = mul(u_modelViewProj, vec4(a_position, 1.0));
+}
\ No newline at end of file
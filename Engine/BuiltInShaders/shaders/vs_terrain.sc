@@ -5,35 +5,32 @@ $output v_worldPos, v_normal, v_texcoord0, v_TBN
 
 #include "../UniformDefines/U_Terrain.sh"
 
+// xy : heightfield sample under the first patch vertex, z : samples between two patch vertices.
+uniform vec4 u_terrainPatch;
+// xy : heightfield size in samples, zw : its inverse.
+uniform vec4 u_terrainSize;
+// x : height between the lowest and highest sample values, y : height of the lowest one.
+uniform vec4 u_terrainHeightRange;
+
 SAMPLER2D(s_texElevation, TERRAIN_ELEVATION_MAP_SLOT);
+// xy : normal x and z packed to unsigned bytes, y is rebuilt from them.
+SAMPLER2D(s_texTerrainNormal, TERRAIN_NORMAL_MAP_SLOT);
 
 void main()
 {
-	vec2 uvElevation = vec2(a_texcoord0.x*4/129,a_texcoord0.y*4/129);
-	float elevation = texture2DLod(s_texElevation, uvElevation, 0).x;
-
-	vec2 uvRElevation = vec2((a_texcoord0.x*4+1)/129,(a_texcoord0.y*4)/129);
-	vec2 uvLElevation = vec2((a_texcoord0.x*4-1)/129,(a_texcoord0.y*4)/129);
-	vec2 uvTElevation = vec2((a_texcoord0.x*4)/129,(a_texcoord0.y*4+1)/129);
-	vec2 uvBElevation = vec2((a_texcoord0.x*4)/129,(a_texcoord0.y*4-1)/129);
-	float elevationR = texture2DLod(s_texElevation, uvRElevation, 0).x;
-	float elevationL = texture2DLod(s_texElevation, uvLElevation, 0).x;
-	float elevationT = texture2DLod(s_texElevation, uvTElevation, 0).x;
-	float elevationB = texture2DLod(s_texElevation, uvBElevation, 0).x;
+	// Patches past the heightfield border collapse onto it.
+	vec2 samplePos = min(u_terrainPatch.xy + a_position.xz * u_terrainPatch.z, u_terrainSize.xy - 1.0);
+	vec2 sampleUV = (samplePos + 0.5) * u_terrainSize.zw;
+	float elevation = texture2DLod(s_texElevation, sampleUV, 0).x * u_terrainHeightRange.x + u_terrainHeightRange.y;
 
-	vec3 N1 = cross(vec3(a_position.x+1, elevationR, a_position.z),
-					vec3(a_position.x, elevationT, a_position.z+1));
-	vec3 N2 = cross(vec3(a_position.x, elevationT, a_position.z+1),
-					vec3(a_position.x-1, elevationL, a_position.z));
-	vec3 N3 = cross(vec3(a_position.x-1, elevationL, a_position.z),
-					vec3(a_position.x, elevationB, a_position.z-1));
-	vec3 N4 = cross(vec3(a_position.x, elevationB, a_position.z-1),
-					vec3(a_position.x+1, elevationR, a_position.z));
+	vec2 packedNormal = (texture2DLod(s_texTerrainNormal, sampleUV, 0).xy * 255.0 - 128.0) / 127.0;
+	vec3 normal = vec3(packedNormal.x, sqrt(max(1.0 - dot(packedNormal, packedNormal), 0.0)), packedNormal.y);
 
-	gl_Position = mul(u_modelViewProj, vec4(a_position.x, elevation, a_position.z, 1.0));
-	v_worldPos = mul(u_model[0], vec4(a_position.x, elevation, a_position.z, 1.0)).xyz;
+	vec4 localPos = vec4(samplePos.x, elevation, samplePos.y, 1.0);
+	gl_Position = mul(u_modelViewProj, localPos);
+	v_worldPos = mul(u_model[0], localPos).xyz;
 	
-	v_normal     = -normalize(N1 + N2 + N3 +N4);
+	v_normal     = normalize(mul(u_modelInvTrans, vec4(normal, 0.0)).xyz);
 	vec3 tangent = normalize(mul(u_modelInvTrans, vec4(a_tangent, 0.0)).xyz);
 	
 	// re-orthogonalize T with respect to N
@@ -43,5 +40,6 @@ void main()
 	// TBN
 	v_TBN = mtxFromCols(tangent, biTangent, v_normal);
 	
-	v_texcoord0 = a_texcoord0;
+	// Albedo maps repeat every 4 samples whatever the patch level is.
+	v_texcoord0 = samplePos * 0.25;
 }
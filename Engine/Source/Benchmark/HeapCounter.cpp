@@ -0,0 +1,86 @@
+#include "HeapCounter.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+
+std::atomic<uint64_t> s_allocationCount = 0U;
+
+class CountingAllocator final : public bx::AllocatorI
+{
+public:
+	virtual void* realloc(void* pData, size_t size, size_t alignment, const char* pFilePath, uint32_t line) override
+	{
+		if (size > 0U)
+		{
+			s_allocationCount.fetch_add(1U, std::memory_order_relaxed);
+		}
+		return m_allocator.realloc(pData, size, alignment, pFilePath, line);
+	}
+
+private:
+	bx::DefaultAllocator m_allocator;
+};
+
+void* CountedMalloc(size_t size)
+{
+	s_allocationCount.fetch_add(1U, std::memory_order_relaxed);
+	return std::malloc(size > 0U ? size : 1U);
+}
+
+}
+
+// The nothrow overloads of the standard library forward to these. Aligned overloads stay uncounted,
+// nothing in the engine uses over aligned types.
+void* operator new(size_t size)
+{
+	if (void* pData = CountedMalloc(size))
+	{
+		return pData;
+	}
+	std::abort();
+}
+
+void* operator new[](size_t size)
+{
+	return operator new(size);
+}
+
+void operator delete(void* pData) noexcept
+{
+	std::free(pData);
+}
+
+void operator delete[](void* pData) noexcept
+{
+	std::free(pData);
+}
+
+void operator delete(void* pData, size_t) noexcept
+{
+	std::free(pData);
+}
+
+void operator delete[](void* pData, size_t) noexcept
+{
+	std::free(pData);
+}
+
+namespace benchmark
+{
+
+uint64_t HeapCounter::GetAllocationCount()
+{
+	return s_allocationCount.load(std::memory_order_relaxed);
+}
+
+bx::AllocatorI* HeapCounter::GetBgfxAllocator()
+{
+	static CountingAllocator s_bgfxAllocator;
+	return &s_bgfxAllocator;
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <bx/allocator.h>
+
+#include <cstdint>
+
+namespace benchmark
+{
+
+// Counts heap allocations made through the global operator new of the process
+// and through the bgfx allocator, so that frames can report how often they hit the heap.
+class HeapCounter final
+{
+public:
+	HeapCounter() = delete;
+
+	// Allocations and reallocations since start, summed over both sources.
+	static uint64_t GetAllocationCount();
+
+	// Pass to RenderContext::Init. Forwards to the bx default allocator.
+	static bx::AllocatorI* GetBgfxAllocator();
+};
+
+}
\ No newline at end of file
@@ -0,0 +1,75 @@
+#include "RenderBenchmark.h"
+#include "Log/Log.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+
+// Usage : Benchmark [--frames N] [--warmup N] [--meshes N] [--lights N] [--animations N] [--bones N] [--terrains N] [--terrainsize N] [--terrainbrushes N] [--terrainstreaming KB] [--debugboxes N] [--prepass 0|1|2] [--compress 0|1] [--threads N] [--output file.json]
+// The JSON report is printed to stdout when no output file is specified.
+int main(int argc, char** argv)
+{
+	using namespace engine;
+	Log::Init();
+
+	benchmark::BenchmarkArgs args;
+	const char* pOutputFilePath = nullptr;
+	for (int argIndex = 1; argIndex < argc; argIndex += 2)
+	{
+		const char* pKey = argv[argIndex];
+		if (argIndex + 1 >= argc)
+		{
+			std::printf("Missing value for argument : %s\n", pKey);
+			return 1;
+		}
+
+		const char* pValue = argv[argIndex + 1];
+		uint32_t value = static_cast<uint32_t>(std::strtoul(pValue, nullptr, 10));
+
+		if (0 == std::strcmp(pKey, "--frames")) { args.frameCount = value; }
+		else if (0 == std::strcmp(pKey, "--warmup")) { args.warmupFrameCount = value; }
+		else if (0 == std::strcmp(pKey, "--meshes")) { args.meshCount = value; }
+		else if (0 == std::strcmp(pKey, "--lights")) { args.lightCount = value; }
+		else if (0 == std::strcmp(pKey, "--animations")) { args.animationCount = value; }
+		else if (0 == std::strcmp(pKey, "--bones")) { args.boneCount = value; }
+		else if (0 == std::strcmp(pKey, "--terrains")) { args.terrainCount = value; }
+		else if (0 == std::strcmp(pKey, "--terrainsize")) { args.terrainSize = value; }
+		else if (0 == std::strcmp(pKey, "--terrainbrushes")) { args.terrainBrushCount = value; }
+		else if (0 == std::strcmp(pKey, "--terrainstreaming")) { args.terrainStreamingBudget = value; }
+		else if (0 == std::strcmp(pKey, "--debugboxes")) { args.debugBoxCount = value; }
+		else if (0 == std::strcmp(pKey, "--prepass")) { args.depthPrePassMode = value; }
+		else if (0 == std::strcmp(pKey, "--compress")) { args.useCompressedClip = value; }
+		else if (0 == std::strcmp(pKey, "--threads")) { args.workerCount = value; }
+		else if (0 == std::strcmp(pKey, "--output")) { pOutputFilePath = pValue; }
+		else
+		{
+			std::printf("Unknown argument : %s\n", pKey);
+			return 1;
+		}
+	}
+
+	benchmark::RenderBenchmark renderBenchmark;
+	renderBenchmark.Init(args);
+	renderBenchmark.Run();
+
+	std::string report = renderBenchmark.GetReport();
+	renderBenchmark.Shutdown();
+
+	if (pOutputFilePath)
+	{
+		std::ofstream fout(pOutputFilePath, std::ios::out | std::ios::trunc);
+		if (!fout.is_open())
+		{
+			std::printf("Failed to open output file : %s\n", pOutputFilePath);
+			return 1;
+		}
+		fout << report;
+	}
+	else
+	{
+		std::printf("%s\n", report.c_str());
+	}
+
+	return 0;
+}
\ No newline at end of file
@@ -0,0 +1,1091 @@
+#include "RenderBenchmark.h"
+
+#include "HeapCounter.h"
+#include "Animation/AnimationSystem.h"
+#include "Core/FrameAllocator.h"
+#include "ECWorld/SceneWorld.h"
+#include "Log/Log.h"
+#include "Math/MeshGenerator.h"
+#include "Path/Path.h"
+#include "Rendering/AnimationRenderer.h"
+#include "Rendering/DebugDraw.h"
+#include "Rendering/PostProcessRenderer.h"
+#include "Rendering/RenderContext.h"
+#include "Rendering/RenderStateCache.h"
+#include "Rendering/SkyboxRenderer.h"
+#include "Rendering/TerrainRenderer.h"
+#include "Rendering/WorldRenderer.h"
+#include "Resources/ShaderLoader.h"
+#include "Scene/SceneDatabase.h"
+#include "Terrain/TerrainTileStreamer.h"
+
+#include <bgfx/bgfx.h>
+#include <json/json.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <limits>
+#include <memory>
+#include <random>
+#include <thread>
+
+namespace benchmark
+{
+
+namespace
+{
+
+// Fixed frame time keeps animation sampling identical between runs.
+constexpr float fixedDeltaTime = 1.0f / 60.0f;
+
+constexpr uint32_t animationKeyCount = 30U;
+constexpr float animationTicksPerSecond = 30.0f;
+constexpr uint32_t clipCompressionSampleCount = 1000U;
+constexpr uint32_t terrainRayCount = 10000U;
+constexpr uint32_t terrainStreamingTileSize = 128U;
+constexpr uint32_t terrainStreamingFrameCount = 600U;
+constexpr uint32_t terrainStreamingTileRadius = 1U;
+
+// Spread entities on a grid in front of the camera so that every renderer sees real work.
+cd::Point GetGridPosition(uint32_t index, uint32_t count, float spacing)
+{
+	uint32_t columnCount = std::max(1U, static_cast<uint32_t>(std::ceil(std::sqrt(static_cast<float>(count)))));
+	float x = static_cast<float>(index % columnCount) - static_cast<float>(columnCount) * 0.5f;
+	float z = static_cast<float>(index / columnCount);
+	return cd::Point(x * spacing, 0.0f, z * spacing);
+}
+
+double ToMilliseconds(std::chrono::steady_clock::duration duration)
+{
+	return std::chrono::duration<double, std::milli>(duration).count();
+}
+
+// Queues a grid of boxes every frame the way an editor overlay would, then flushes them.
+class DebugBoxRenderer final : public engine::Renderer
+{
+public:
+	DebugBoxRenderer(uint16_t viewID, engine::RenderTarget* pRenderTarget, uint32_t boxCount)
+		: engine::Renderer(viewID, pRenderTarget)
+		, m_boxCount(boxCount)
+	{
+	}
+
+	virtual void Init() override
+	{
+		m_debugDraw.Init();
+		bgfx::setViewName(GetViewID(), "DebugBoxRenderer");
+	}
+
+	virtual void UpdateView(const float* pViewMatrix, const float* pProjectionMatrix) override
+	{
+		UpdateViewRenderTarget();
+		bgfx::setViewTransform(GetViewID(), pViewMatrix, pProjectionMatrix);
+	}
+
+	virtual void Prepare() override
+	{
+		for (uint32_t boxIndex = 0U; boxIndex < m_boxCount; ++boxIndex)
+		{
+			cd::Point center = GetGridPosition(boxIndex, m_boxCount, 2.0f);
+			m_debugDraw.AddBox(cd::AABB(center - cd::Point(0.5f), center + cd::Point(0.5f)), 0xFF00FF00);
+		}
+	}
+
+	virtual void Render(float deltaTime) override
+	{
+		m_debugDraw.Flush(GetViewID());
+	}
+
+	const engine::DebugDraw& GetDebugDraw() const { return m_debugDraw; }
+
+private:
+	uint32_t m_boxCount;
+	engine::DebugDraw m_debugDraw;
+};
+
+}
+
+RenderBenchmark::RenderBenchmark()
+{
+}
+
+RenderBenchmark::~RenderBenchmark()
+{
+}
+
+void RenderBenchmark::Init(BenchmarkArgs args)
+{
+	m_args = cd::MoveTemp(args);
+	assert(m_args.boneCount > 0U);
+
+	// Shader binaries are looked up by backend name, but nothing is ever presented.
+	engine::Path::SetGraphicsBackend(m_args.shaderBackend);
+	m_pRenderContext = std::make_unique<engine::RenderContext>();
+	m_pRenderContext->Init(engine::GraphicsBackend::Noop, nullptr, HeapCounter::GetBgfxAllocator());
+	m_pRenderContext->OnResize(m_args.width, m_args.height);
+	engine::Renderer::SetRenderContext(m_pRenderContext.get());
+
+	m_positionOnlyVertexFormat.AddAttributeLayout(cd::VertexAttributeType::Position, cd::AttributeValueType::Float, 3);
+	m_pRenderContext->CreateVertexLayout(engine::StringCrc("PosistionOnly"), m_positionOnlyVertexFormat.GetVertexLayout());
+
+	InitECWorld();
+	InitRenderers();
+}
+
+void RenderBenchmark::InitECWorld()
+{
+	m_pSceneWorld = std::make_unique<engine::SceneWorld>();
+	m_pSceneWorld->CreatePBRMaterialType(false);
+	m_pSceneWorld->CreateAnimationMaterialType();
+	m_pSceneWorld->CreateTerrainMaterialType();
+
+	m_pThreadPool = std::make_unique<engine::ThreadPool>(m_args.workerCount);
+	m_pAnimationSystem = std::make_unique<engine::AnimationSystem>(m_pThreadPool.get());
+	m_pAnimationSystem->SetSceneWorld(m_pSceneWorld.get());
+
+	engine::ShaderLoader::UploadUberShader(m_pSceneWorld->GetPBRMaterialType());
+
+	// Sky, box, terrain and skin meshes. Components keep pointers into this vector so it must not grow.
+	m_meshes.reserve(4);
+
+	InitCameraEntity();
+	InitSkyEntity();
+	InitLightEntities();
+	InitMeshEntities();
+	InitTerrainEntities();
+	InitAnimationClip();
+	InitAnimationEntities();
+	MeasureClipCompression();
+	MeasureTerrainRaycast();
+	MeasureTerrainStreaming();
+}
+
+void RenderBenchmark::InitCameraEntity()
+{
+	engine::World* pWorld = m_pSceneWorld->GetWorld();
+
+	engine::Entity cameraEntity = pWorld->CreateEntity();
+	m_pSceneWorld->SetMainCameraEntity(cameraEntity);
+	auto& nameComponent = pWorld->CreateComponent<engine::NameComponent>(cameraEntity);
+	nameComponent.SetName("MainCamera");
+
+	auto& cameraTransformComponent = pWorld->CreateComponent<engine::TransformComponent>(cameraEntity);
+	cameraTransformComponent.SetTransform(cd::Transform::Identity());
+	cameraTransformComponent.Build();
+
+	auto& cameraTransform = cameraTransformComponent.GetTransform();
+	cameraTransform.SetTranslation(cd::Point(0.0f, 20.0f, -100.0f));
+	engine::CameraComponent::SetLookAt(cd::Direction(0.0f, 0.0f, 1.0f), cameraTransform);
+	engine::CameraComponent::SetUp(cd::Direction(0.0f, 1.0f, 0.0f), cameraTransform);
+
+	auto& cameraComponent = pWorld->CreateComponent<engine::CameraComponent>(cameraEntity);
+	cameraComponent.SetAspect(static_cast<float>(m_args.width) / static_cast<float>(m_args.height));
+	cameraComponent.SetFov(45.0f);
+	cameraComponent.SetNearPlane(0.1f);
+	cameraComponent.SetFarPlane(2000.0f);
+	cameraComponent.SetNDCDepth(bgfx::getCaps()->homogeneousDepth ? cd::NDCDepth::MinusOneToOne : cd::NDCDepth::ZeroToOne);
+	cameraComponent.SetPostProcessEnable(true);
+	cameraComponent.SetGammaCorrection(0.45f);
+	cameraComponent.SetExposure(0.0f);
+	cameraComponent.BuildProjectMatrix();
+	cameraComponent.BuildViewMatrix(cameraTransform);
+}
+
+void RenderBenchmark::InitSkyEntity()
+{
+	engine::World* pWorld = m_pSceneWorld->GetWorld();
+
+	engine::Entity skyEntity = pWorld->CreateEntity();
+	m_pSceneWorld->SetSkyEntity(skyEntity);
+
+	auto& nameComponent = pWorld->CreateComponent<engine::NameComponent>(skyEntity);
+	nameComponent.SetName("Sky");
+
+	pWorld->CreateComponent<engine::SkyComponent>(skyEntity);
+
+	std::optional<cd::Mesh> optMesh = cd::MeshGenerator::Generate(cd::Box(cd::Point(-1.0f), cd::Point(1.0f)), m_positionOnlyVertexFormat, false);
+	assert(optMesh.has_value());
+	cd::Mesh& skyMesh = m_meshes.emplace_back(cd::MoveTemp(optMesh.value()));
+
+	auto& meshComponent = pWorld->CreateComponent<engine::StaticMeshComponent>(skyEntity);
+	meshComponent.SetMeshData(&skyMesh);
+	meshComponent.SetRequiredVertexFormat(&m_positionOnlyVertexFormat);
+	meshComponent.Build();
+}
+
+void RenderBenchmark::InitLightEntities()
+{
+	engine::World* pWorld = m_pSceneWorld->GetWorld();
+
+	for (uint32_t lightIndex = 0U; lightIndex < m_args.lightCount; ++lightIndex)
+	{
+		engine::Entity lightEntity = pWorld->CreateEntity();
+		auto& nameComponent = pWorld->CreateComponent<engine::NameComponent>(lightEntity);
+		nameComponent.SetName("Light" + std::to_string(lightIndex));
+
+		auto& lightComponent = pWorld->CreateComponent<engine::LightComponent>(lightEntity);
+		lightComponent.SetType(0U == lightIndex ? cd::LightType::Directional : cd::LightType::Point);
+		lightComponent.SetIntensity(0U == lightIndex ? 4.0f : 1024.0f);
+		lightComponent.SetRange(100.0f);
+		lightComponent.SetColor(cd::Vec3f(1.0f));
+		lightComponent.SetPosition(GetGridPosition(lightIndex, m_args.lightCount, 40.0f));
+		lightComponent.SetDirection(cd::Direction(0.0f, -1.0f, 0.0f));
+
+		auto& transformComponent = pWorld->CreateComponent<engine::TransformComponent>(lightEntity);
+		transformComponent.SetTransform(cd::Transform::Identity());
+		transformComponent.Build();
+	}
+}
+
+void RenderBenchmark::InitMeshEntities()
+{
+	engine::World* pWorld = m_pSceneWorld->GetWorld();
+	engine::MaterialType* pPBRMaterialType = m_pSceneWorld->GetPBRMaterialType();
+
+	std::optional<cd::Mesh> optMesh = cd::MeshGenerator::Generate(cd::Box(cd::Point(-1.0f), cd::Point(1.0f)), pPBRMaterialType->GetRequiredVertexFormat());
+	assert(optMesh.has_value());
+	const cd::Mesh& boxMesh = m_meshes.emplace_back(cd::MoveTemp(optMesh.value()));
+
+	for (uint32_t meshIndex = 0U; meshIndex < m_args.meshCount; ++meshIndex)
+	{
+		engine::Entity entity = pWorld->CreateEntity();
+		auto& nameComponent = pWorld->CreateComponent<engine::NameComponent>(entity);
+		nameComponent.SetName("Mesh" + std::to_string(meshIndex));
+
+		auto& meshComponent = pWorld->CreateComponent<engine::StaticMeshComponent>(entity);
+		meshComponent.SetMeshData(&boxMesh);
+		meshComponent.SetRequiredVertexFormat(&pPBRMaterialType->GetRequiredVertexFormat());
+		meshComponent.Build();
+
+		// Vary material parameters so that uniform values really change between draws.
+		float factor = static_cast<float>(meshIndex % 16U) / 15.0f;
+		auto& materialComponent = pWorld->CreateComponent<engine::MaterialComponent>(entity);
+		materialComponent.Init();
+		materialComponent.SetMaterialType(pPBRMaterialType);
+		materialComponent.SetAlbedoColor(cd::Vec3f(factor, 1.0f - factor, 0.5f));
+		materialComponent.SetMetallicFactor(factor);
+		materialComponent.SetRoughnessFactor(1.0f - factor);
+		materialComponent.SetTwoSided(0U == meshIndex % 4U);
+		materialComponent.SetSkyType(m_pSceneWorld->GetSkyComponent(m_pSceneWorld->GetSkyEntity())->GetSkyType());
+		materialComponent.Build();
+
+		auto& transformComponent = pWorld->CreateComponent<engine::TransformComponent>(entity);
+		transformComponent.SetTransform(cd::Transform(GetGridPosition(meshIndex, m_args.meshCount, 4.0f), cd::Quaternion::Identity(), cd::Vec3f::One()));
+		transformComponent.Build();
+	}
+}
+
+void RenderBenchmark::InitTerrainEntities()
+{
+	engine::World* pWorld = m_pSceneWorld->GetWorld();
+	engine::MaterialType* pTerrainMaterialType = m_pSceneWorld->GetTerrainMaterialType();
+
+	// Terrains are drawn as quadtree patches and need no mesh of their own.
+	uint16_t terrainSize = static_cast<uint16_t>(m_args.terrainSize);
+	for (uint32_t terrainIndex = 0U; terrainIndex < m_args.terrainCount; ++terrainIndex)
+	{
+		engine::Entity entity = pWorld->CreateEntity();
+		auto& nameComponent = pWorld->CreateComponent<engine::NameComponent>(entity);
+		nameComponent.SetName("Terrain" + std::to_string(terrainIndex));
+
+		auto& terrainComponent = pWorld->CreateComponent<engine::TerrainComponent>(entity);
+		terrainComponent.SetTexWidth(terrainSize);
+		terrainComponent.SetTexDepth(terrainSize);
+		terrainComponent.InitElevationRawData(m_pThreadPool.get());
+
+		auto& materialComponent = pWorld->CreateComponent<engine::MaterialComponent>(entity);
+		materialComponent.Init();
+		materialComponent.SetMaterialType(pTerrainMaterialType);
+		materialComponent.SetAlbedoColor(cd::Vec3f(0.2f));
+		materialComponent.SetSkyType(m_pSceneWorld->GetSkyComponent(m_pSceneWorld->GetSkyEntity())->GetSkyType());
+		materialComponent.SetTwoSided(true);
+		materialComponent.Build();
+
+		auto& transformComponent = pWorld->CreateComponent<engine::TransformComponent>(entity);
+		transformComponent.SetTransform(cd::Transform(GetGridPosition(terrainIndex, m_args.terrainCount, static_cast<float>(terrainSize + 1U)), cd::Quaternion::Identity(), cd::Vec3f::One()));
+		transformComponent.Build();
+	}
+}
+
+void RenderBenchmark::InitAnimationClip()
+{
+	if (0U == m_args.animationCount)
+	{
+		return;
+	}
+
+	// A single bone chain with one track per bone. Every animated entity shares it, the same as
+	// AnimationRenderer which evaluates the skeleton stored in the SceneWorld database.
+	cd::SceneDatabase* pSceneDatabase = m_pSceneWorld->GetSceneDatabase();
+
+	cd::Animation animation(cd::AnimationID(pSceneDatabase->GetAnimationCount()), "BenchmarkClip");
+	animation.SetDuration(static_cast<float>(animationKeyCount - 1U));
+	animation.SetTicksPerSecnod(animationTicksPerSecond);
+
+	for (uint32_t boneIndex = 0U; boneIndex < m_args.boneCount; ++boneIndex)
+	{
+		std::string boneName = "Bone" + std::to_string(boneIndex);
+
+		cd::Bone bone(cd::BoneID(boneIndex), boneName);
+		if (boneIndex > 0U)
+		{
+			bone.SetParentID(cd::BoneID(boneIndex - 1U));
+		}
+		if (boneIndex + 1U < m_args.boneCount)
+		{
+			bone.AddChildID(cd::BoneID(boneIndex + 1U));
+		}
+		bone.SetOffset(cd::Matrix4x4::Identity());
+		bone.SetTransform(cd::Transform(cd::Vec3f(0.0f, 1.0f, 0.0f), cd::Quaternion::Identity(), cd::Vec3f::One()));
+		pSceneDatabase->AddBone(cd::MoveTemp(bone));
+
+		std::vector<cd::TranslationKey> translationKeys(animationKeyCount);
+		std::vector<cd::RotationKey> rotationKeys(animationKeyCount);
+		std::vector<cd::ScaleKey> scaleKeys(animationKeyCount);
+		for (uint32_t keyIndex = 0U; keyIndex < animationKeyCount; ++keyIndex)
+		{
+			float keyTime = static_cast<float>(keyIndex);
+			// A phase shifted swing per bone so that keys can't all be reduced away.
+			float phase = static_cast<float>(keyIndex) / static_cast<float>(animationKeyCount - 1U) * cd::Math::TWO_PI + static_cast<float>(boneIndex) * 0.3f;
+			float angle = std::sin(phase) * cd::Math::DegreeToRadian<float>(15.0f);
+
+			translationKeys[keyIndex].SetTime(keyTime);
+			translationKeys[keyIndex].SetValue(cd::Vec3f(0.0f, 1.0f, 0.0f));
+			rotationKeys[keyIndex].SetTime(keyTime);
+			rotationKeys[keyIndex].SetValue(cd::Quaternion::FromAxisAngle(cd::Vec3f(0.0f, 0.0f, 1.0f), angle));
+			scaleKeys[keyIndex].SetTime(keyTime);
+			scaleKeys[keyIndex].SetValue(cd::Vec3f::One());
+		}
+
+		cd::Track track(cd::TrackID(pSceneDatabase->GetTrackCount()), cd::MoveTemp(boneName));
+		track.SetTranslationKeys(cd::MoveTemp(translationKeys));
+		track.SetRotationKeys(cd::MoveTemp(rotationKeys));
+		track.SetScaleKeys(cd::MoveTemp(scaleKeys));
+		animation.AddBoneTrackID(track.GetID().Data());
+		pSceneDatabase->AddTrack(cd::MoveTemp(track));
+	}
+
+	pSceneDatabase->AddAnimation(cd::MoveTemp(animation));
+}
+
+void RenderBenchmark::InitAnimationEntities()
+{
+	if (0U == m_args.animationCount)
+	{
+		return;
+	}
+
+	engine::World* pWorld = m_pSceneWorld->GetWorld();
+	cd::SceneDatabase* pSceneDatabase = m_pSceneWorld->GetSceneDatabase();
+	const cd::Animation& animation = pSceneDatabase->GetAnimation(0);
+	std::shared_ptr<const engine::SkeletonBinding> pSkeletonBinding = m_pSceneWorld->GetSkeletonBinding(animation);
+	std::shared_ptr<const engine::CompressedClip> pCompressedClip = m_args.useCompressedClip ? m_pSceneWorld->GetCompressedClip(animation) : nullptr;
+
+	// Noop doesn't validate vertex layouts against shaders, so skinned entities can share a position only mesh.
+	std::optional<cd::Mesh> optMesh = cd::MeshGenerator::Generate(cd::Box(cd::Point(-1.0f), cd::Point(1.0f)), m_positionOnlyVertexFormat, false);
+	assert(optMesh.has_value());
+	const cd::Mesh& skinMesh = m_meshes.emplace_back(cd::MoveTemp(optMesh.value()));
+
+	for (uint32_t animationIndex = 0U; animationIndex < m_args.animationCount; ++animationIndex)
+	{
+		engine::Entity entity = pWorld->CreateEntity();
+		auto& nameComponent = pWorld->CreateComponent<engine::NameComponent>(entity);
+		nameComponent.SetName("Skin" + std::to_string(animationIndex));
+
+		auto& meshComponent = pWorld->CreateComponent<engine::StaticMeshComponent>(entity);
+		meshComponent.SetMeshData(&skinMesh);
+		meshComponent.SetRequiredVertexFormat(&m_positionOnlyVertexFormat);
+		meshComponent.Build();
+
+		auto& animationComponent = pWorld->CreateComponent<engine::AnimationComponent>(entity);
+		animationComponent.SetAnimationData(&animation);
+		animationComponent.SetTrackData(pSceneDatabase->GetTracks().data());
+		animationComponent.SetSkeletonBinding(pSkeletonBinding);
+		animationComponent.SetCompressedClip(pCompressedClip);
+		animationComponent.SetDuration(animation.GetDuration());
+		animationComponent.SetTicksPerSecond(animation.GetTicksPerSecnod());
+
+		// Every instance has its own playback state so that neighbours don't sample the same keys.
+		animationComponent.SetPlayTime(static_cast<float>(animationIndex) * 0.1f);
+		animationComponent.SetPlaybackSpeed(0.5f + static_cast<float>(animationIndex % 11U) * 0.1f);
+
+		cd::Point gridPosition = GetGridPosition(animationIndex, m_args.animationCount, 6.0f);
+		cd::Point position(gridPosition.x(), gridPosition.y(), gridPosition.z() - 20.0f);
+		auto& transformComponent = pWorld->CreateComponent<engine::TransformComponent>(entity);
+		transformComponent.SetTransform(cd::Transform(position, cd::Quaternion::Identity(), cd::Vec3f::One()));
+		transformComponent.Build();
+	}
+}
+
+void RenderBenchmark::MeasureClipCompression()
+{
+	if (0U == m_args.animationCount)
+	{
+		return;
+	}
+
+	cd::SceneDatabase* pSceneDatabase = m_pSceneWorld->GetSceneDatabase();
+	const cd::Track* pTracks = pSceneDatabase->GetTracks().data();
+	const cd::Animation& animation = pSceneDatabase->GetAnimation(0);
+	std::shared_ptr<const engine::SkeletonBinding> pSkeletonBinding = m_pSceneWorld->GetSkeletonBinding(animation);
+	std::shared_ptr<const engine::CompressedClip> pCompressedClip = m_pSceneWorld->GetCompressedClip(animation);
+
+	m_clipCompression.rawBytes = engine::CompressedClip::GetUncompressedMemorySize(*pSkeletonBinding, pTracks);
+	m_clipCompression.compressedBytes = pCompressedClip->GetMemorySize();
+	m_clipCompression.rawKeyCount = static_cast<uint64_t>(m_args.boneCount) * animationKeyCount * 3U;
+	m_clipCompression.compressedKeyCount = pCompressedClip->GetKeyCount();
+
+	engine::ClipCompressionError error = engine::MeasureClipCompressionError(*pSkeletonBinding, pTracks, *pCompressedClip,
+		animation.GetDuration(), clipCompressionSampleCount);
+	m_clipCompression.maxJointError = error.maxJointError;
+	m_clipCompression.averageJointError = error.averageJointError;
+
+	// One skeleton on the calling thread, stepping forward like playback does.
+	std::vector<engine::KeyframeCursor> cursors;
+	std::vector<cd::Matrix4x4> globalTransforms;
+	std::vector<cd::Matrix4x4> palette;
+	auto MeasurePose = [&](auto EvaluatePose)
+	{
+		cursors.clear();
+		auto begin = std::chrono::steady_clock::now();
+		for (uint32_t sampleIndex = 0U; sampleIndex < clipCompressionSampleCount; ++sampleIndex)
+		{
+			float time = std::fmod(static_cast<float>(sampleIndex) * fixedDeltaTime * animationTicksPerSecond, animation.GetDuration());
+			EvaluatePose(time);
+		}
+		return ToMilliseconds(std::chrono::steady_clock::now() - begin) * 1000.0 / static_cast<double>(clipCompressionSampleCount);
+	};
+
+	m_clipCompression.rawMicrosecondsPerPose = MeasurePose([&](float time)
+	{
+		engine::EvaluateSkeletonPose(*pSkeletonBinding, pTracks, time, cd::Matrix4x4::Identity(), cursors, globalTransforms, palette);
+	});
+	m_clipCompression.compressedMicrosecondsPerPose = MeasurePose([&](float time)
+	{
+		engine::EvaluateSkeletonPose(*pSkeletonBinding, *pCompressedClip, time, cd::Matrix4x4::Identity(), cursors, globalTransforms, palette);
+	});
+
+	// Like the editor import, compressed playback drops the raw keys once they are measured against.
+	if (m_args.useCompressedClip)
+	{
+		m_pSceneWorld->ReleaseRawTracks(animation);
+	}
+	m_clipCompression.residentBytes = engine::CompressedClip::GetUncompressedMemorySize(*pSkeletonBinding, pTracks) + pCompressedClip->GetMemorySize();
+}
+
+void RenderBenchmark::MeasureTerrainRaycast()
+{
+	if (0U == m_args.terrainCount)
+	{
+		return;
+	}
+
+	engine::TerrainComponent* pTerrainComponent = m_pSceneWorld->GetTerrainComponent(m_pSceneWorld->GetTerrainEntities()[0]);
+	engine::QuantizedHeights elevations = pTerrainComponent->GetElevations();
+	const engine::TerrainHeightPyramid& heightPyramid = pTerrainComponent->GetHeightPyramid();
+	float size = static_cast<float>(m_args.terrainSize);
+
+	// Grazing rays from above the terrain, the case a camera looking at the horizon produces.
+	std::vector<cd::Point> origins;
+	std::vector<cd::Direction> directions;
+	origins.reserve(terrainRayCount);
+	directions.reserve(terrainRayCount);
+	std::mt19937 generator(0U);
+	std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+	for (uint32_t rayIndex = 0U; rayIndex < terrainRayCount; ++rayIndex)
+	{
+		origins.emplace_back(unit(generator) * size, 40.0f, unit(generator) * size);
+		directions.push_back(cd::Direction(unit(generator) - 0.5f, -0.02f - unit(generator) * 0.1f, unit(generator) - 0.5f).Normalize());
+	}
+
+	m_terrainRaycast.rayCount = terrainRayCount;
+	uint64_t visitedNodeCount = 0U;
+	uint64_t testedCellCount = 0U;
+	auto pyramidBegin = std::chrono::steady_clock::now();
+	for (uint32_t rayIndex = 0U; rayIndex < terrainRayCount; ++rayIndex)
+	{
+		engine::TerrainHeightPyramid::RayHit hit;
+		engine::TerrainHeightPyramid::RaycastStatistics statistics;
+		if (heightPyramid.Raycast(elevations, origins[rayIndex], directions[rayIndex], std::numeric_limits<float>::max(), hit, &statistics))
+		{
+			++m_terrainRaycast.pyramidHitCount;
+		}
+		visitedNodeCount += statistics.visitedNodeCount;
+		testedCellCount += statistics.testedCellCount;
+	}
+	m_terrainRaycast.pyramidMicrosecondsPerRay = ToMilliseconds(std::chrono::steady_clock::now() - pyramidBegin) * 1000.0 / terrainRayCount;
+	m_terrainRaycast.visitedNodesPerRay = static_cast<double>(visitedNodeCount) / terrainRayCount;
+	m_terrainRaycast.testedCellsPerRay = static_cast<double>(testedCellCount) / terrainRayCount;
+
+	// The unit step march ScreenSpaceSmooth used before, over the diagonal of the terrain.
+	uint32_t marchStepCount = static_cast<uint32_t>(size * 1.5f);
+	auto marchBegin = std::chrono::steady_clock::now();
+	for (uint32_t rayIndex = 0U; rayIndex < terrainRayCount; ++rayIndex)
+	{
+		cd::Point position = origins[rayIndex];
+		for (uint32_t stepIndex = 0U; stepIndex < marchStepCount; ++stepIndex)
+		{
+			position = position + directions[rayIndex];
+			uint32_t x = static_cast<uint32_t>(position.x());
+			uint32_t z = static_cast<uint32_t>(position.z());
+			if (x < m_args.terrainSize && z < m_args.terrainSize && position.y() < pTerrainComponent->GetElevationRawDataAt(x, z))
+			{
+				++m_terrainRaycast.marchHitCount;
+				break;
+			}
+		}
+	}
+	m_terrainRaycast.marchMicrosecondsPerRay = ToMilliseconds(std::chrono::steady_clock::now() - marchBegin) * 1000.0 / terrainRayCount;
+}
+
+void RenderBenchmark::MeasureTerrainStreaming()
+{
+	if (0U == m_args.terrainCount || 0U == m_args.terrainStreamingBudget)
+	{
+		return;
+	}
+
+	engine::TerrainComponent* pTerrainComponent = m_pSceneWorld->GetTerrainComponent(m_pSceneWorld->GetTerrainEntities()[0]);
+	engine::QuantizedHeights elevations = pTerrainComponent->GetElevations();
+	uint32_t size = m_args.terrainSize;
+
+	std::string pyramidFilePath = (std::filesystem::temp_directory_path() / "CatDogBenchmarkTerrain.cdth").string();
+	if (!engine::TerrainTileFile::Write(pyramidFilePath.c_str(), elevations, size, size, terrainStreamingTileSize))
+	{
+		CD_ERROR("Failed to write terrain pyramid {0}.", pyramidFilePath);
+		return;
+	}
+
+	size_t memoryBudget = static_cast<size_t>(m_args.terrainStreamingBudget) << 10U;
+	engine::TerrainTileStreamer streamer(memoryBudget);
+	if (!streamer.Open(pyramidFilePath.c_str()))
+	{
+		CD_ERROR("Failed to open terrain pyramid {0}.", pyramidFilePath);
+		std::filesystem::remove(pyramidFilePath);
+		return;
+	}
+
+	const engine::TerrainTileFile& tileFile = streamer.GetTileFile();
+	uint32_t coarsestLevel = tileFile.GetLevelCount() - 1U;
+	m_terrainStreaming.fileBytes = std::filesystem::file_size(pyramidFilePath);
+	m_terrainStreaming.tileBytes = tileFile.GetTileSampleCount() * sizeof(uint16_t);
+	m_terrainStreaming.pinnedBytes = m_terrainStreaming.tileBytes * tileFile.GetTileCountX(coarsestLevel) * tileFile.GetTileCountZ(coarsestLevel);
+	m_terrainStreaming.levelCount = tileFile.GetLevelCount();
+	for (uint32_t level = 0U; level < tileFile.GetLevelCount(); ++level)
+	{
+		m_terrainStreaming.tileCount += tileFile.GetTileCountX(level) * tileFile.GetTileCountZ(level);
+	}
+	m_terrainStreaming.frameCount = terrainStreamingFrameCount;
+	uint64_t allowedBytes = std::max<uint64_t>(memoryBudget, m_terrainStreaming.pinnedBytes);
+
+	// A camera flying over the diagonal and back, so tiles behind it get evicted and some come back later.
+	double streamingMilliseconds = 0.0;
+	uint32_t tileSampleCount = terrainStreamingTileSize + 1U;
+	for (uint32_t frameIndex = 0U; frameIndex < terrainStreamingFrameCount; ++frameIndex)
+	{
+		float progress = static_cast<float>(frameIndex) / static_cast<float>(terrainStreamingFrameCount - 1U);
+		float position = (1.0f - std::abs(progress * 2.0f - 1.0f)) * static_cast<float>(size - 1U);
+		engine::TerrainTileKey cameraKey { 0U, std::min(static_cast<uint32_t>(position) / terrainStreamingTileSize, tileFile.GetTileCountX(0U) - 1U),
+			std::min(static_cast<uint32_t>(position) / terrainStreamingTileSize, tileFile.GetTileCountZ(0U) - 1U) };
+
+		auto requestBegin = std::chrono::steady_clock::now();
+		streamer.RequestAround(position, position, terrainStreamingTileRadius);
+		engine::TerrainTileKey resolvedKey;
+		const uint16_t* pSamples = streamer.AcquireTileOrAncestor(cameraKey, &resolvedKey);
+		streamingMilliseconds += ToMilliseconds(std::chrono::steady_clock::now() - requestBegin);
+
+		if (resolvedKey.level > 0U)
+		{
+			++m_terrainStreaming.fallbackFrameCount;
+			m_terrainStreaming.fallbackLevelCount += resolvedKey.level;
+		}
+		else if (pSamples)
+		{
+			// Checked before Update, which may recycle the buffer.
+			for (uint32_t z = 0U; z < tileSampleCount; ++z)
+			{
+				uint32_t sourceZ = std::min(cameraKey.z * terrainStreamingTileSize + z, size - 1U);
+				for (uint32_t x = 0U; x < tileSampleCount; ++x)
+				{
+					uint32_t sourceX = std::min(cameraKey.x * terrainStreamingTileSize + x, size - 1U);
+					if (pSamples[z * tileSampleCount + x] != elevations.pSamples[static_cast<size_t>(sourceZ) * size + sourceX])
+					{
+						++m_terrainStreaming.sampleMismatchCount;
+					}
+				}
+			}
+		}
+
+		const engine::TerrainTileStreamer::Statistics& statistics = streamer.GetStatistics();
+		m_terrainStreaming.hitCount += statistics.hitCount;
+		m_terrainStreaming.missCount += statistics.missCount;
+
+		auto updateBegin = std::chrono::steady_clock::now();
+		streamer.Update();
+		streamingMilliseconds += ToMilliseconds(std::chrono::steady_clock::now() - updateBegin);
+
+		m_terrainStreaming.loadCount += statistics.loadCount;
+		m_terrainStreaming.evictionCount += statistics.evictionCount;
+		m_terrainStreaming.peakResidentBytes = std::max<uint64_t>(m_terrainStreaming.peakResidentBytes, statistics.residentBytes);
+		if (statistics.residentBytes > allowedBytes)
+		{
+			++m_terrainStreaming.budgetOverrunCount;
+		}
+
+		// Leaves the loader the time a rendered frame would.
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+	m_terrainStreaming.microsecondsPerFrame = streamingMilliseconds * 1000.0 / terrainStreamingFrameCount;
+
+	streamer.Close();
+	m_terrainPyramidFilePath = cd::MoveTemp(pyramidFilePath);
+}
+
+void RenderBenchmark::InitRenderers()
+{
+	constexpr engine::StringCrc sceneRenderTargetName("SceneRenderTarget");
+	std::vector<engine::AttachmentDescriptor> attachmentDesc = {
+		{.textureFormat = engine::TextureFormat::RGBA32F },
+		{.textureFormat = engine::TextureFormat::D32F },
+	};
+	engine::RenderTarget* pSceneRenderTarget = m_pRenderContext->CreateRenderTarget(sceneRenderTargetName, m_args.width, m_args.height, cd::MoveTemp(attachmentDesc));
+
+	constexpr engine::StringCrc postProcessRenderTargetName("PostProcessRenderTarget");
+	std::vector<engine::AttachmentDescriptor> postProcessAttachmentDesc = {
+		{.textureFormat = engine::TextureFormat::RGBA8 },
+	};
+	engine::RenderTarget* pPostProcessRenderTarget = m_pRenderContext->CreateRenderTarget(postProcessRenderTargetName, m_args.width, m_args.height, cd::MoveTemp(postProcessAttachmentDesc));
+
+	// Same order as the editor scene view. ImGui and debug renderers are left out as they don't scale with scene content.
+	auto pSkyboxRenderer = std::make_unique<engine::SkyboxRenderer>(m_pRenderContext->CreateView(), pSceneRenderTarget);
+	pSkyboxRenderer->SetSceneWorld(m_pSceneWorld.get());
+	AddRenderer("SkyboxRenderer", cd::MoveTemp(pSkyboxRenderer));
+
+	auto pWorldRenderer = std::make_unique<engine::WorldRenderer>(m_pRenderContext->CreateView(), pSceneRenderTarget);
+	pWorldRenderer->SetSceneWorld(m_pSceneWorld.get());
+	pWorldRenderer->SetDepthPrePassMode(static_cast<engine::WorldRenderer::DepthPrePassMode>(m_args.depthPrePassMode));
+	m_pWorldRenderer = pWorldRenderer.get();
+	AddRenderer("WorldRenderer", cd::MoveTemp(pWorldRenderer));
+
+	auto pTerrainRenderer = std::make_unique<engine::TerrainRenderer>(m_pRenderContext->CreateView(), pSceneRenderTarget);
+	pTerrainRenderer->SetSceneWorld(m_pSceneWorld.get());
+	m_pTerrainRenderer = pTerrainRenderer.get();
+	if (!m_terrainPyramidFilePath.empty())
+	{
+		// The first terrain is drawn from the pyramid measured above, with a fresh streamer of the same budget.
+		m_pTerrainStreamer = std::make_unique<engine::TerrainTileStreamer>(static_cast<size_t>(m_args.terrainStreamingBudget) << 10U);
+		if (m_pTerrainStreamer->Open(m_terrainPyramidFilePath.c_str()))
+		{
+			pTerrainRenderer->SetTileStreamer(m_pSceneWorld->GetTerrainEntities()[0], m_pTerrainStreamer.get());
+		}
+		else
+		{
+			CD_ERROR("Failed to open terrain pyramid {0}.", m_terrainPyramidFilePath);
+			m_pTerrainStreamer.reset();
+		}
+	}
+	AddRenderer("TerrainRenderer", cd::MoveTemp(pTerrainRenderer));
+
+	auto pAnimationRenderer = std::make_unique<engine::AnimationRenderer>(m_pRenderContext->CreateView(), pSceneRenderTarget);
+	pAnimationRenderer->SetSceneWorld(m_pSceneWorld.get());
+	AddRenderer("AnimationRenderer", cd::MoveTemp(pAnimationRenderer));
+
+	if (m_args.debugBoxCount > 0U)
+	{
+		auto pDebugBoxRenderer = std::make_unique<DebugBoxRenderer>(m_pRenderContext->CreateView(), pSceneRenderTarget, m_args.debugBoxCount);
+		m_pDebugDraw = &pDebugBoxRenderer->GetDebugDraw();
+		AddRenderer("DebugBoxRenderer", cd::MoveTemp(pDebugBoxRenderer));
+	}
+
+	auto pPostProcessRenderer = std::make_unique<engine::PostProcessRenderer>(m_pRenderContext->CreateView(), pPostProcessRenderTarget);
+	pPostProcessRenderer->SetSceneWorld(m_pSceneWorld.get());
+	AddRenderer("PostProcessRenderer", cd::MoveTemp(pPostProcessRenderer));
+}
+
+void RenderBenchmark::AddRenderer(const char* pName, std::unique_ptr<engine::Renderer> pRenderer)
+{
+	pRenderer->Init();
+
+	RendererRecord& record = m_renderers.emplace_back();
+	record.name = pName;
+	record.pRenderer = cd::MoveTemp(pRenderer);
+}
+
+void RenderBenchmark::Run()
+{
+	for (uint32_t frameIndex = 0U; frameIndex < m_args.warmupFrameCount; ++frameIndex)
+	{
+		RenderFrame(fixedDeltaTime, false);
+	}
+
+	engine::RenderStateCache::ResetStatistics();
+	m_frames.reserve(m_args.frameCount);
+	for (uint32_t frameIndex = 0U; frameIndex < m_args.frameCount; ++frameIndex)
+	{
+		RenderFrame(fixedDeltaTime, true);
+	}
+}
+
+void RenderBenchmark::ApplyTerrainBrushes()
+{
+	// Strokes walk along a diagonal so that consecutive frames touch neighbouring samples.
+	constexpr int16_t brushSize = 8;
+	for (engine::Entity entity : m_pSceneWorld->GetTerrainEntities())
+	{
+		engine::TerrainComponent* pTerrainComponent = m_pSceneWorld->GetTerrainComponent(entity);
+		uint32_t range = std::max(pTerrainComponent->GetTexWidth(), pTerrainComponent->GetTexDepth());
+		for (uint32_t strokeIndex = 0U; strokeIndex < m_args.terrainBrushCount; ++strokeIndex)
+		{
+			uint32_t step = (m_terrainBrushStrokeIndex + strokeIndex) * 3U;
+			uint16_t x = static_cast<uint16_t>(step % pTerrainComponent->GetTexWidth());
+			uint16_t z = static_cast<uint16_t>((step + range / 2U) % pTerrainComponent->GetTexDepth());
+			pTerrainComponent->SmoothElevationRawDataAround(x, z, brushSize, 0.5f);
+		}
+	}
+	m_terrainBrushStrokeIndex += m_args.terrainBrushCount;
+}
+
+void RenderBenchmark::RenderFrame(float deltaTime, bool record)
+{
+	auto frameBegin = std::chrono::steady_clock::now();
+	uint64_t heapAllocationBegin = HeapCounter::GetAllocationCount();
+
+	m_pSceneWorld->Update();
+	if (m_args.terrainBrushCount > 0U)
+	{
+		ApplyTerrainBrushes();
+	}
+
+	auto animationBegin = std::chrono::steady_clock::now();
+	m_pAnimationSystem->Update(deltaTime);
+	double animationMilliseconds = ToMilliseconds(std::chrono::steady_clock::now() - animationBegin);
+	if (record)
+	{
+		m_animationTotalMilliseconds += animationMilliseconds;
+		m_animationMaxMilliseconds = std::max(m_animationMaxMilliseconds, animationMilliseconds);
+	}
+
+	engine::CameraComponent* pMainCameraComponent = m_pSceneWorld->GetCameraComponent(m_pSceneWorld->GetMainCameraEntity());
+	assert(pMainCameraComponent);
+	pMainCameraComponent->BuildProjectMatrix();
+	const float* pViewMatrix = pMainCameraComponent->GetViewMatrix().Begin();
+	const float* pProjectionMatrix = pMainCameraComponent->GetProjectionMatrix().Begin();
+
+	m_pRenderContext->BeginFrame();
+	for (RendererRecord& rendererRecord : m_renderers)
+	{
+		if (!rendererRecord.pRenderer->IsEnable())
+		{
+			continue;
+		}
+
+		auto rendererBegin = std::chrono::steady_clock::now();
+		rendererRecord.pRenderer->UpdateView(pViewMatrix, pProjectionMatrix);
+		rendererRecord.pRenderer->Prepare();
+		rendererRecord.pRenderer->Render(deltaTime);
+		double rendererMilliseconds = ToMilliseconds(std::chrono::steady_clock::now() - rendererBegin);
+
+		if (record)
+		{
+			rendererRecord.totalMilliseconds += rendererMilliseconds;
+			rendererRecord.maxMilliseconds = std::max(rendererRecord.maxMilliseconds, rendererMilliseconds);
+		}
+	}
+
+	auto submitBegin = std::chrono::steady_clock::now();
+	m_pRenderContext->EndFrame();
+	auto frameEnd = std::chrono::steady_clock::now();
+	uint64_t heapAllocationCount = HeapCounter::GetAllocationCount() - heapAllocationBegin;
+
+	if (!record)
+	{
+		return;
+	}
+
+	// bgfx::frame() has just processed the submitted frame so the stats describe it.
+	const bgfx::Stats* pStats = bgfx::getStats();
+	FrameRecord& frameRecord = m_frames.emplace_back();
+	frameRecord.cpuMilliseconds = ToMilliseconds(frameEnd - frameBegin);
+	frameRecord.submitMilliseconds = ToMilliseconds(frameEnd - submitBegin);
+	frameRecord.heapAllocationCount = heapAllocationCount;
+	frameRecord.drawCallCount = pStats->numDraw;
+	frameRecord.computeCount = pStats->numCompute;
+	frameRecord.blitCount = pStats->numBlit;
+	frameRecord.triangleCount = pStats->numPrims[bgfx::Topology::TriList] + pStats->numPrims[bgfx::Topology::TriStrip];
+	frameRecord.transientVertexBytes = static_cast<uint64_t>(std::max(pStats->transientVbUsed, 0));
+	frameRecord.transientIndexBytes = static_cast<uint64_t>(std::max(pStats->transientIbUsed, 0));
+
+	const engine::WorldRenderer::OverdrawStatistics& overdrawStats = m_pWorldRenderer->GetOverdrawStatistics();
+	frameRecord.depthPrePassEnabled = overdrawStats.isDepthPrePassEnabled ? 1U : 0U;
+	frameRecord.prePassDrawCount = overdrawStats.prePassDrawCount;
+	frameRecord.estimatedDepthComplexity = overdrawStats.estimatedDepthComplexity;
+
+	if (m_pDebugDraw)
+	{
+		const engine::DebugDraw::Statistics& debugDrawStats = m_pDebugDraw->GetStatistics();
+		frameRecord.debugBoxCount = debugDrawStats.boxCount;
+		frameRecord.debugDrawCount = debugDrawStats.drawCount;
+		frameRecord.debugDroppedCount = debugDrawStats.droppedCount;
+	}
+
+	const engine::TerrainRenderer::Statistics& terrainStats = m_pTerrainRenderer->GetStatistics();
+	frameRecord.terrainPatchCount = terrainStats.selectedPatchCount;
+	frameRecord.terrainCulledNodeCount = terrainStats.culledNodeCount;
+	frameRecord.terrainTriangleCount = terrainStats.triangleCount;
+	frameRecord.terrainUploadCount = terrainStats.elevationUploadCount;
+	frameRecord.terrainUploadedBytes = terrainStats.elevationUploadedBytes;
+	frameRecord.terrainSkippedBytes = terrainStats.elevationSkippedBytes;
+	frameRecord.terrainStreamedTileCount = terrainStats.streamedTileCount;
+	frameRecord.terrainStreamedFallbackCount = terrainStats.streamedFallbackCount;
+}
+
+std::string RenderBenchmark::GetReport() const
+{
+	nlohmann::json report;
+	report["backend"] = "Noop";
+	report["scene"] = {
+		{ "meshes", m_args.meshCount },
+		{ "lights", m_args.lightCount },
+		{ "animations", m_args.animationCount },
+		{ "bones", m_args.boneCount },
+		{ "terrains", m_args.terrainCount },
+		{ "terrainSize", m_args.terrainSize },
+		{ "terrainBrushes", m_args.terrainBrushCount },
+		{ "debugBoxes", m_args.debugBoxCount },
+		{ "width", m_args.width },
+		{ "height", m_args.height },
+		{ "depthPrePassMode", m_args.depthPrePassMode },
+	};
+	report["frames"] = m_frames.size();
+	report["warmupFrames"] = m_args.warmupFrameCount;
+
+	double frameCount = static_cast<double>(std::max<size_t>(m_frames.size(), 1));
+
+	nlohmann::json renderers = nlohmann::json::array();
+	for (const RendererRecord& rendererRecord : m_renderers)
+	{
+		renderers.push_back({
+			{ "name", rendererRecord.name },
+			{ "totalMs", rendererRecord.totalMilliseconds },
+			{ "avgMs", rendererRecord.totalMilliseconds / frameCount },
+			{ "maxMs", rendererRecord.maxMilliseconds },
+		});
+	}
+	report["renderers"] = cd::MoveTemp(renderers);
+
+	// AnimationSystem evaluates every skeleton before the renderers run. AnimationRenderer only uploads palettes.
+	if (m_args.animationCount > 0U)
+	{
+		double microsecondsPerSkeleton = m_animationTotalMilliseconds * 1000.0 / frameCount / static_cast<double>(m_args.animationCount);
+		report["animation"] = {
+			{ "skeletons", m_args.animationCount },
+			{ "bonesPerSkeleton", m_args.boneCount },
+			{ "workerThreads", m_pThreadPool->GetWorkerCount() },
+			{ "avgMs", m_animationTotalMilliseconds / frameCount },
+			{ "maxMs", m_animationMaxMilliseconds },
+			{ "usPerSkeleton", microsecondsPerSkeleton },
+			{ "usPerBone", microsecondsPerSkeleton / static_cast<double>(m_args.boneCount) },
+			// AnimationRenderer packs every palette into one texture as 3x4 matrices.
+			{ "skinningPaletteBytes", static_cast<uint64_t>(m_args.animationCount) * m_args.boneCount * 3U * 4U * sizeof(float) },
+		};
+	}
+
+	// Raw tracks against the compressed clip of the shared skeleton. Joint errors are in scene units.
+	if (m_args.animationCount > 0U)
+	{
+		report["clipCompression"] = {
+			{ "sampling", m_args.useCompressedClip ? "compressed" : "raw" },
+			{ "rawBytes", m_clipCompression.rawBytes },
+			{ "compressedBytes", m_clipCompression.compressedBytes },
+			{ "residentBytes", m_clipCompression.residentBytes },
+			{ "compressionRatio", static_cast<double>(m_clipCompression.rawBytes) / static_cast<double>(std::max<uint64_t>(m_clipCompression.compressedBytes, 1U)) },
+			{ "rawKeys", m_clipCompression.rawKeyCount },
+			{ "compressedKeys", m_clipCompression.compressedKeyCount },
+			{ "maxJointError", m_clipCompression.maxJointError },
+			{ "averageJointError", m_clipCompression.averageJointError },
+			{ "rawUsPerPose", m_clipCompression.rawMicrosecondsPerPose },
+			{ "compressedUsPerPose", m_clipCompression.compressedMicrosecondsPerPose },
+		};
+	}
+
+	// Exact pyramid traversal against a unit step march, which may step over thin features.
+	if (m_args.terrainCount > 0U)
+	{
+		report["terrainRaycast"] = {
+			{ "rays", m_terrainRaycast.rayCount },
+			{ "pyramidHits", m_terrainRaycast.pyramidHitCount },
+			{ "marchHits", m_terrainRaycast.marchHitCount },
+			{ "pyramidUsPerRay", m_terrainRaycast.pyramidMicrosecondsPerRay },
+			{ "marchUsPerRay", m_terrainRaycast.marchMicrosecondsPerRay },
+			{ "visitedNodesPerRay", m_terrainRaycast.visitedNodesPerRay },
+			{ "testedCellsPerRay", m_terrainRaycast.testedCellsPerRay },
+		};
+	}
+
+	// Tiles of a pyramid file of the first terrain streamed around a moving camera. Resident bytes must stay within the
+	// budget, and the camera tile falls back to a coarser level until its full resolution tile is loaded.
+	if (m_args.terrainCount > 0U && m_args.terrainStreamingBudget > 0U)
+	{
+		report["terrainStreaming"] = {
+			{ "budgetBytes", static_cast<uint64_t>(m_args.terrainStreamingBudget) << 10U },
+			{ "fileBytes", m_terrainStreaming.fileBytes },
+			{ "tileBytes", m_terrainStreaming.tileBytes },
+			{ "pinnedBytes", m_terrainStreaming.pinnedBytes },
+			{ "levels", m_terrainStreaming.levelCount },
+			{ "tiles", m_terrainStreaming.tileCount },
+			{ "frames", m_terrainStreaming.frameCount },
+			{ "peakResidentBytes", m_terrainStreaming.peakResidentBytes },
+			{ "budgetOverruns", m_terrainStreaming.budgetOverrunCount },
+			{ "loads", m_terrainStreaming.loadCount },
+			{ "evictions", m_terrainStreaming.evictionCount },
+			{ "hits", m_terrainStreaming.hitCount },
+			{ "misses", m_terrainStreaming.missCount },
+			{ "fallbackFrames", m_terrainStreaming.fallbackFrameCount },
+			{ "averageFallbackLevels", static_cast<double>(m_terrainStreaming.fallbackLevelCount) / std::max(m_terrainStreaming.fallbackFrameCount, 1U) },
+			{ "sampleMismatches", m_terrainStreaming.sampleMismatchCount },
+			{ "usPerFrame", m_terrainStreaming.microsecondsPerFrame },
+		};
+	}
+
+	FrameRecord total;
+	double maxFrameMilliseconds = 0.0;
+	uint64_t maxHeapAllocationCount = 0U;
+	for (const FrameRecord& frameRecord : m_frames)
+	{
+		total.cpuMilliseconds += frameRecord.cpuMilliseconds;
+		total.submitMilliseconds += frameRecord.submitMilliseconds;
+		total.drawCallCount += frameRecord.drawCallCount;
+		total.computeCount += frameRecord.computeCount;
+		total.blitCount += frameRecord.blitCount;
+		total.triangleCount += frameRecord.triangleCount;
+		total.transientVertexBytes += frameRecord.transientVertexBytes;
+		total.transientIndexBytes += frameRecord.transientIndexBytes;
+		total.depthPrePassEnabled += frameRecord.depthPrePassEnabled;
+		total.prePassDrawCount += frameRecord.prePassDrawCount;
+		total.estimatedDepthComplexity += frameRecord.estimatedDepthComplexity;
+		total.debugBoxCount += frameRecord.debugBoxCount;
+		total.debugDrawCount += frameRecord.debugDrawCount;
+		total.debugDroppedCount += frameRecord.debugDroppedCount;
+		total.terrainPatchCount += frameRecord.terrainPatchCount;
+		total.terrainCulledNodeCount += frameRecord.terrainCulledNodeCount;
+		total.terrainTriangleCount += frameRecord.terrainTriangleCount;
+		total.terrainUploadCount += frameRecord.terrainUploadCount;
+		total.terrainUploadedBytes += frameRecord.terrainUploadedBytes;
+		total.terrainSkippedBytes += frameRecord.terrainSkippedBytes;
+		total.terrainStreamedTileCount += frameRecord.terrainStreamedTileCount;
+		total.terrainStreamedFallbackCount += frameRecord.terrainStreamedFallbackCount;
+		total.heapAllocationCount += frameRecord.heapAllocationCount;
+		maxHeapAllocationCount = std::max(maxHeapAllocationCount, frameRecord.heapAllocationCount);
+		maxFrameMilliseconds = std::max(maxFrameMilliseconds, frameRecord.cpuMilliseconds);
+	}
+
+	// Averages per frame.
+	report["frame"] = {
+		{ "cpuMs", total.cpuMilliseconds / frameCount },
+		{ "maxCpuMs", maxFrameMilliseconds },
+		{ "submitMs", total.submitMilliseconds / frameCount },
+		{ "drawCalls", static_cast<double>(total.drawCallCount) / frameCount },
+		{ "computes", static_cast<double>(total.computeCount) / frameCount },
+		{ "blits", static_cast<double>(total.blitCount) / frameCount },
+		{ "triangles", static_cast<double>(total.triangleCount) / frameCount },
+		{ "transientVertexBytes", static_cast<double>(total.transientVertexBytes) / frameCount },
+		{ "transientIndexBytes", static_cast<double>(total.transientIndexBytes) / frameCount },
+	};
+
+	// WorldRenderer depth complexity is estimated from projected bounding boxes.
+	// With the pre-pass enabled, opaque pixels are shaded once whatever the depth complexity is.
+	report["overdraw"] = {
+		{ "depthPrePassFrameRatio", static_cast<double>(total.depthPrePassEnabled) / frameCount },
+		{ "prePassDrawCalls", static_cast<double>(total.prePassDrawCount) / frameCount },
+		{ "estimatedDepthComplexity", total.estimatedDepthComplexity / frameCount },
+	};
+
+	// Quadtree patches drawn per frame. Every patch is one draw call of the shared grid.
+	// Skipped bytes are what uploading the whole heightfield textures of every visible terrain would have added.
+	// Elevations are 16 bits samples on the CPU and in the R16 texture alike.
+	// With streaming, the first terrain draws pyramid tiles instead, and fallbacks are tiles drawn coarser while they load.
+	if (m_args.terrainCount > 0U)
+	{
+		report["terrain"] = {
+			{ "samplesPerSide", m_args.terrainSize },
+			{ "elevationBytes", static_cast<uint64_t>(m_args.terrainCount) * m_args.terrainSize * m_args.terrainSize * sizeof(uint16_t) },
+			{ "fullResolutionTriangles", static_cast<uint64_t>(m_args.terrainCount) * (m_args.terrainSize - 1U) * (m_args.terrainSize - 1U) * 2U },
+			{ "patches", static_cast<double>(total.terrainPatchCount) / frameCount },
+			{ "culledNodes", static_cast<double>(total.terrainCulledNodeCount) / frameCount },
+			{ "triangles", static_cast<double>(total.terrainTriangleCount) / frameCount },
+			{ "elevationUploads", static_cast<double>(total.terrainUploadCount) / frameCount },
+			{ "elevationUploadedBytes", static_cast<double>(total.terrainUploadedBytes) / frameCount },
+			{ "elevationSkippedBytes", static_cast<double>(total.terrainSkippedBytes) / frameCount },
+			{ "streamedTiles", static_cast<double>(total.terrainStreamedTileCount) / frameCount },
+			{ "streamedFallbacks", static_cast<double>(total.terrainStreamedFallbackCount) / frameCount },
+		};
+	}
+
+	// Boxes which made it into the instanced draws, per frame. Dropped boxes didn't fit in the transient buffers.
+	if (m_args.debugBoxCount > 0U)
+	{
+		report["debugDraw"] = {
+			{ "queuedBoxes", m_args.debugBoxCount },
+			{ "boxes", static_cast<double>(total.debugBoxCount) / frameCount },
+			{ "drawCalls", static_cast<double>(total.debugDrawCount) / frameCount },
+			{ "dropped", static_cast<double>(total.debugDroppedCount) / frameCount },
+		};
+	}
+
+	// Heap allocations counted from operator new and the bgfx allocator, per frame.
+	// Frame memory figures are summed over the threads which allocated from FrameAllocator.
+	engine::FrameAllocator::Statistics frameMemoryStats = engine::FrameAllocator::GetStatistics();
+	report["memory"] = {
+		{ "heapAllocations", static_cast<double>(total.heapAllocationCount) / frameCount },
+		{ "maxHeapAllocations", maxHeapAllocationCount },
+		{ "frameMemoryThreads", frameMemoryStats.threadCount },
+		{ "frameMemoryPeakBytes", frameMemoryStats.peakUsedSize },
+		{ "frameMemoryCapacityBytes", frameMemoryStats.capacity },
+		{ "frameMemoryBlockAllocations", frameMemoryStats.blockAllocationCount },
+	};
+
+	// Calls going through RenderStateCache, per frame. Elided calls never reach bgfx.
+	engine::RenderStateCache::Statistics cacheStats = engine::RenderStateCache::GetStatistics();
+	auto PerFrame = [frameCount](uint64_t value) { return static_cast<double>(value) / frameCount; };
+	report["stateCache"] = {
+		{ "submits", PerFrame(cacheStats.submitCount) },
+		{ "stateCalls", PerFrame(cacheStats.stateCalls) },
+		{ "stateElided", PerFrame(cacheStats.stateElided) },
+		{ "vertexBufferCalls", PerFrame(cacheStats.vertexBufferCalls) },
+		{ "vertexBufferElided", PerFrame(cacheStats.vertexBufferElided) },
+		{ "indexBufferCalls", PerFrame(cacheStats.indexBufferCalls) },
+		{ "indexBufferElided", PerFrame(cacheStats.indexBufferElided) },
+		{ "textureCalls", PerFrame(cacheStats.textureCalls) },
+		{ "textureElided", PerFrame(cacheStats.textureElided) },
+		{ "uniformCalls", PerFrame(cacheStats.uniformCalls) },
+		{ "uniformElided", PerFrame(cacheStats.uniformElided) },
+		{ "uniformBytes", PerFrame(cacheStats.uniformBytes) },
+		{ "uniformBytesElided", PerFrame(cacheStats.uniformBytesElided) },
+	};
+
+	return report.dump(2);
+}
+
+void RenderBenchmark::Shutdown()
+{
+	m_pWorldRenderer = nullptr;
+	m_pTerrainRenderer = nullptr;
+	m_pDebugDraw = nullptr;
+	m_renderers.clear();
+	m_pTerrainStreamer.reset();
+	if (!m_terrainPyramidFilePath.empty())
+	{
+		std::filesystem::remove(m_terrainPyramidFilePath);
+		m_terrainPyramidFilePath.clear();
+	}
+	m_pAnimationSystem.reset();
+	m_pThreadPool.reset();
+	m_pSceneWorld.reset();
+	m_pRenderContext->Shutdown();
+	m_pRenderContext.reset();
+}
+
+}
\ No newline at end of file
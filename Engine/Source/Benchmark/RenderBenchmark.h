@@ -0,0 +1,212 @@
+#pragma once
+
+#include "Core/ThreadPool.h"
+#include "Graphics/GraphicsBackend.h"
+#include "Scene/Mesh.h"
+#include "Scene/VertexFormat.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace engine
+{
+
+class AnimationSystem;
+class DebugDraw;
+class RenderContext;
+class Renderer;
+class SceneWorld;
+class TerrainRenderer;
+class TerrainTileStreamer;
+class WorldRenderer;
+
+}
+
+namespace benchmark
+{
+
+struct BenchmarkArgs
+{
+	uint32_t frameCount = 600;
+	uint32_t warmupFrameCount = 60;
+	uint32_t meshCount = 1000;
+	uint32_t lightCount = 8;
+	uint32_t animationCount = 1024;
+	uint32_t boneCount = 64;
+	uint32_t terrainCount = 1;
+	// Heightfield samples per side of every terrain.
+	uint32_t terrainSize = 1025;
+	// Smoothing brush strokes applied to every terrain each frame, like an editor drag.
+	uint32_t terrainBrushCount = 0;
+	// Memory budget in KB of the tile streamer fed with a pyramid file of the first terrain, which is then drawn from
+	// the streamer. 0 skips the measurement and draws the heightfield.
+	uint32_t terrainStreamingBudget = 1024;
+	// Boxes queued into DebugDraw every frame. 0 skips the debug draw renderer.
+	uint32_t debugBoxCount = 0;
+	uint16_t width = 1280;
+	uint16_t height = 720;
+
+	// Maps to WorldRenderer::DepthPrePassMode. 0 : auto, 1 : enabled, 2 : disabled.
+	uint32_t depthPrePassMode = 0;
+
+	// 1 samples the compressed clip, 0 the raw tracks.
+	uint32_t useCompressedClip = 1;
+
+	// Worker threads used by AnimationSystem. 0 evaluates every instance on the main thread.
+	uint32_t workerCount = engine::ThreadPool::GetDefaultWorkerCount();
+
+	// bgfx always runs on Noop. This only decides which compiled shader binaries are loaded.
+	engine::GraphicsBackend shaderBackend = engine::GraphicsBackend::Direct3D11;
+};
+
+// Boots the engine render path without a window on the Noop backend, fills a SceneWorld with
+// procedural entities and measures the CPU cost of each renderer for a fixed number of frames.
+class RenderBenchmark
+{
+public:
+	RenderBenchmark();
+	RenderBenchmark(const RenderBenchmark&) = delete;
+	RenderBenchmark& operator=(const RenderBenchmark&) = delete;
+	RenderBenchmark(RenderBenchmark&&) = delete;
+	RenderBenchmark& operator=(RenderBenchmark&&) = delete;
+	~RenderBenchmark();
+
+	void Init(BenchmarkArgs args);
+	void Run();
+	void Shutdown();
+
+	// Results of the measured frames as a JSON document.
+	std::string GetReport() const;
+
+private:
+	struct RendererRecord
+	{
+		std::string name;
+		std::unique_ptr<engine::Renderer> pRenderer;
+		double totalMilliseconds = 0.0;
+		double maxMilliseconds = 0.0;
+	};
+
+	struct ClipCompressionRecord
+	{
+		uint64_t rawBytes = 0;
+		uint64_t compressedBytes = 0;
+		// Raw keys still in the SceneDatabase plus the clip, after playback was set up.
+		uint64_t residentBytes = 0;
+		uint64_t rawKeyCount = 0;
+		uint64_t compressedKeyCount = 0;
+		float maxJointError = 0.0f;
+		float averageJointError = 0.0f;
+		double rawMicrosecondsPerPose = 0.0;
+		double compressedMicrosecondsPerPose = 0.0;
+	};
+
+	struct TerrainRaycastRecord
+	{
+		uint32_t rayCount = 0;
+		uint32_t pyramidHitCount = 0;
+		uint32_t marchHitCount = 0;
+		double pyramidMicrosecondsPerRay = 0.0;
+		double marchMicrosecondsPerRay = 0.0;
+		double visitedNodesPerRay = 0.0;
+		double testedCellsPerRay = 0.0;
+	};
+
+	struct TerrainStreamingRecord
+	{
+		uint64_t fileBytes = 0;
+		uint64_t tileBytes = 0;
+		uint64_t pinnedBytes = 0;
+		uint32_t levelCount = 0;
+		uint32_t tileCount = 0;
+		uint32_t frameCount = 0;
+		uint64_t peakResidentBytes = 0;
+		// Frames which ended with more resident bytes than the budget, or the pinned tiles when they need more.
+		uint32_t budgetOverrunCount = 0;
+		uint64_t loadCount = 0;
+		uint64_t evictionCount = 0;
+		uint64_t hitCount = 0;
+		uint64_t missCount = 0;
+		// Frames whose camera tile wasn't resident at full resolution, and how many levels coarser the fallback was.
+		uint32_t fallbackFrameCount = 0;
+		uint64_t fallbackLevelCount = 0;
+		// Samples of resident camera tiles which differ from the terrain.
+		uint64_t sampleMismatchCount = 0;
+		double microsecondsPerFrame = 0.0;
+	};
+
+	struct FrameRecord
+	{
+		double cpuMilliseconds = 0.0;
+		double submitMilliseconds = 0.0;
+		uint64_t heapAllocationCount = 0;
+		uint64_t drawCallCount = 0;
+		uint64_t computeCount = 0;
+		uint64_t blitCount = 0;
+		uint64_t triangleCount = 0;
+		uint64_t transientVertexBytes = 0;
+		uint64_t transientIndexBytes = 0;
+		uint64_t depthPrePassEnabled = 0;
+		uint64_t prePassDrawCount = 0;
+		double estimatedDepthComplexity = 0.0;
+		uint64_t debugBoxCount = 0;
+		uint64_t debugDrawCount = 0;
+		uint64_t debugDroppedCount = 0;
+		uint64_t terrainPatchCount = 0;
+		uint64_t terrainCulledNodeCount = 0;
+		uint64_t terrainTriangleCount = 0;
+		uint64_t terrainUploadCount = 0;
+		uint64_t terrainUploadedBytes = 0;
+		uint64_t terrainSkippedBytes = 0;
+		uint64_t terrainStreamedTileCount = 0;
+		uint64_t terrainStreamedFallbackCount = 0;
+	};
+
+	void InitECWorld();
+	void InitCameraEntity();
+	void InitSkyEntity();
+	void InitLightEntities();
+	void InitMeshEntities();
+	void InitTerrainEntities();
+	void InitAnimationClip();
+	void InitAnimationEntities();
+	void MeasureClipCompression();
+	void MeasureTerrainRaycast();
+	void MeasureTerrainStreaming();
+	void InitRenderers();
+	void AddRenderer(const char* pName, std::unique_ptr<engine::Renderer> pRenderer);
+
+	void ApplyTerrainBrushes();
+	void RenderFrame(float deltaTime, bool record);
+
+	BenchmarkArgs m_args;
+
+	std::unique_ptr<engine::RenderContext> m_pRenderContext;
+	std::unique_ptr<engine::SceneWorld> m_pSceneWorld;
+	std::unique_ptr<engine::ThreadPool> m_pThreadPool;
+	std::unique_ptr<engine::AnimationSystem> m_pAnimationSystem;
+	std::vector<RendererRecord> m_renderers;
+	engine::WorldRenderer* m_pWorldRenderer = nullptr;
+	const engine::TerrainRenderer* m_pTerrainRenderer = nullptr;
+	const engine::DebugDraw* m_pDebugDraw = nullptr;
+
+	// Left by MeasureTerrainStreaming for TerrainRenderer and removed on Shutdown.
+	std::string m_terrainPyramidFilePath;
+	std::unique_ptr<engine::TerrainTileStreamer> m_pTerrainStreamer;
+
+	// StaticMeshComponent only keeps pointers to its source data.
+	cd::VertexFormat m_positionOnlyVertexFormat;
+	std::vector<cd::Mesh> m_meshes;
+
+	std::vector<FrameRecord> m_frames;
+	ClipCompressionRecord m_clipCompression;
+	TerrainRaycastRecord m_terrainRaycast;
+	TerrainStreamingRecord m_terrainStreaming;
+	double m_animationTotalMilliseconds = 0.0;
+	double m_animationMaxMilliseconds = 0.0;
+	uint32_t m_terrainBrushStrokeIndex = 0U;
+};
+
+}
\ No newline at end of file
@@ -207,11 +207,14 @@ void ECWorldConsumer::AddAnimation(engine::Entity entity, const cd::Animation& a
 	engine::AnimationComponent& animationComponent = pWorld->CreateComponent<engine::AnimationComponent>(entity);
 	animationComponent.SetAnimationData(&animation);
 	animationComponent.SetTrackData(pSceneDatabase->GetTracks().data());
+	animationComponent.SetSkeletonBinding(m_pSceneWorld->GetSkeletonBinding(animation));
+	animationComponent.SetCompressedClip(m_pSceneWorld->GetCompressedClip(animation));
+
+	// Playback only samples the clip, so the raw keys don't need to stay resident next to it.
+	m_pSceneWorld->ReleaseRawTracks(animation);
+
 	animationComponent.SetDuration(animation.GetDuration());
 	animationComponent.SetTicksPerSecond(animation.GetTicksPerSecnod());
-
-	bgfx::UniformHandle boneMatricesUniform = bgfx::createUniform("u_boneMatrices", bgfx::UniformType::Mat4, 128);
-	animationComponent.SetBoneMatricesUniform(boneMatricesUniform.idx);
 }
 
 void ECWorldConsumer::AddMaterial(engine::Entity entity, const cd::Material* pMaterial, engine::MaterialType* pMaterialType, const cd::SceneDatabase* pSceneDatabase)
@@ -1,6 +1,8 @@
 ﻿#include "EditorApp.h"
 
+#include "Animation/AnimationSystem.h"
 #include "Application/Engine.h"
+#include "Core/ThreadPool.h"
 #include "Display/CameraController.h"
 #include "ECWorld/SceneWorld.h"
 #include "ImGui/EditorImGuiViewport.h"
@@ -12,7 +14,6 @@
 #include "Path/Path.h"
 #include "Rendering/AABBRenderer.h"
 #include "Rendering/AnimationRenderer.h"
-#include "Rendering/BlitRenderTargetPass.h"
 #ifdef ENABLE_DDGI
 #include "Rendering/DDGIRenderer.h"
 #endif
@@ -46,11 +47,21 @@
 #include "ImGui/imfilebrowser.h"
 
 //#include <format>
+#include <algorithm>
+#include <cstring>
 #include <thread>
 
 namespace editor
 {
 
+namespace
+{
+
+// ImGui needs a few frames after the last input to settle hover states and window layouts.
+constexpr uint32_t settleFrameCount = 3U;
+
+}
+
 EditorApp::EditorApp()
 {
 }
@@ -95,15 +106,25 @@ void EditorApp::Init(engine::EngineInitArgs initArgs)
 	InitShaderPrograms();
 	m_pEditorImGuiContext->AddStaticLayer(std::make_unique<Splash>("Splash"));
 
-	std::thread resourceThread([]()
+	m_resourceBuildThread = std::thread([]()
 	{
 		ResourceBuilder::Get().Update(true/*doPrintLog*/);
 	});
-	resourceThread.detach();
 }
 
 void EditorApp::Shutdown()
 {
+	// Don't keep the splash screen build running past the editor. The thread is joined so that it is out of
+	// ResourceBuilder before static destruction saves the build database and destroys the pool.
+	ResourceBuilder::Get().Cancel();
+	if (m_resourceBuildThread.joinable())
+	{
+		m_resourceBuildThread.join();
+	}
+
+	double runSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - m_startTime).count();
+	CD_INFO("Editor ran {:.1f}s : {:.1f}% waiting for events, {} frames, {} scene view renders.",
+		runSeconds, m_waitSeconds / std::max(runSeconds, 0.001) * 100.0, m_frameCount, m_sceneRenderCount);
 }
 
 engine::Window* EditorApp::GetWindow(size_t index) const
@@ -227,6 +248,10 @@ void EditorApp::RegisterImGuiUserData(engine::ImGuiContextInstance* pImGuiContex
 void EditorApp::InitECWorld()
 {
 	m_pSceneWorld = std::make_unique<engine::SceneWorld>();
+
+	m_pThreadPool = std::make_unique<engine::ThreadPool>();
+	m_pAnimationSystem = std::make_unique<engine::AnimationSystem>(m_pThreadPool.get());
+	m_pAnimationSystem->SetSceneWorld(m_pSceneWorld.get());
 	
 	if (IsAtmosphericScatteringEnable())
 	{
@@ -273,7 +298,9 @@ void EditorApp::InitEditorCameraEntity()
 	cameraComponent.SetNearPlane(0.1f);
 	cameraComponent.SetFarPlane(2000.0f);
 	cameraComponent.SetNDCDepth(bgfx::getCaps()->homogeneousDepth ? cd::NDCDepth::MinusOneToOne : cd::NDCDepth::ZeroToOne);
+	cameraComponent.SetPostProcessEnable(true);
 	cameraComponent.SetGammaCorrection(0.45f);
+	cameraComponent.SetExposure(0.0f);
 	cameraComponent.BuildProjectMatrix();
 	cameraComponent.BuildViewMatrix(cameraTransform);
 }
@@ -345,7 +372,6 @@ void EditorApp::InitEngineRenderers()
 {
 	constexpr engine::StringCrc sceneViewRenderTargetName("SceneRenderTarget");
 	std::vector<engine::AttachmentDescriptor> attachmentDesc = {
-		{.textureFormat = engine::TextureFormat::RGBA32F },
 		{.textureFormat = engine::TextureFormat::RGBA32F },
 		{.textureFormat = engine::TextureFormat::D32F },
 	};
@@ -353,6 +379,14 @@ void EditorApp::InitEngineRenderers()
 	// The init size doesn't make sense. It will resize by SceneView.
 	engine::RenderTarget* pSceneRenderTarget = m_pRenderContext->CreateRenderTarget(sceneViewRenderTargetName, 1, 1, std::move(attachmentDesc));
 
+	// PostProcessRenderer resolves the HDR scene color into this LDR target which SceneView displays.
+	constexpr engine::StringCrc postProcessRenderTargetName("PostProcessRenderTarget");
+	std::vector<engine::AttachmentDescriptor> postProcessAttachmentDesc = {
+		{.textureFormat = engine::TextureFormat::RGBA8 },
+	};
+	engine::RenderTarget* pPostProcessRenderTarget = m_pRenderContext->CreateRenderTarget(postProcessRenderTargetName, 1, 1, std::move(postProcessAttachmentDesc));
+	pSceneRenderTarget->OnResize.Bind<engine::RenderTarget, &engine::RenderTarget::Resize>(pPostProcessRenderTarget);
+
 	auto pSkyboxRenderer = std::make_unique<engine::SkyboxRenderer>(m_pRenderContext->CreateView(), pSceneRenderTarget);
 	m_pIBLSkyRenderer = pSkyboxRenderer.get();
 	pSkyboxRenderer->SetSceneWorld(m_pSceneWorld.get());
@@ -398,18 +432,14 @@ void EditorApp::InitEngineRenderers()
 	AddEngineRenderer(cd::MoveTemp(pDDGIRenderer));
 #endif
 
-	auto pBlitRTRenderPass = std::make_unique<engine::BlitRenderTargetPass>(m_pRenderContext->CreateView(), pSceneRenderTarget);
-	AddEngineRenderer(cd::MoveTemp(pBlitRTRenderPass));
-
 	// We can debug vertex/material/texture information by just output that to screen as fragmentColor.
 	// But postprocess will bring unnecessary confusion. 
-	auto pPostProcessRenderer = std::make_unique<engine::PostProcessRenderer>(m_pRenderContext->CreateView(), pSceneRenderTarget);
+	auto pPostProcessRenderer = std::make_unique<engine::PostProcessRenderer>(m_pRenderContext->CreateView(), pPostProcessRenderTarget);
 	pPostProcessRenderer->SetSceneWorld(m_pSceneWorld.get());
-	pPostProcessRenderer->SetEnable(true);
 	AddEngineRenderer(cd::MoveTemp(pPostProcessRenderer));
 
 	// Note that if you don't want to use ImGuiRenderer for engine, you should also disable EngineImGuiContext.
-	AddEngineRenderer(std::make_unique<engine::ImGuiRenderer>(m_pRenderContext->CreateView(), pSceneRenderTarget));
+	AddEngineRenderer(std::make_unique<engine::ImGuiRenderer>(m_pRenderContext->CreateView(), pPostProcessRenderTarget));
 }
 
 bool EditorApp::IsAtmosphericScatteringEnable() const
@@ -502,7 +532,15 @@ bool EditorApp::Update(float deltaTime)
 	}
 
 	GetMainWindow()->Update();
+	const bool hasInput = GetMainWindow()->HasReceivedEvents() || engine::Input::Get().IsAnyPressed();
+
+	// Time spent waiting for events is not simulated.
+	deltaTime = std::max(deltaTime - m_lastWaitSeconds, 0.0001f);
+	m_lastWaitSeconds = 0.0f;
+	++m_frameCount;
+
 	m_pSceneWorld->Update();
+	m_pAnimationSystem->Update(deltaTime);
 	m_pEditorImGuiContext->Update(deltaTime);
 
 	engine::CameraComponent* pMainCameraComponent = m_pSceneWorld->GetCameraComponent(m_pSceneWorld->GetMainCameraEntity());
@@ -518,11 +556,14 @@ bool EditorApp::Update(float deltaTime)
 			const float* pViewMatrix = nullptr;
 			const float* pProjectionMatrix = nullptr;
 			pRenderer->UpdateView(pViewMatrix, pProjectionMatrix);
+			pRenderer->Prepare();
 			pRenderer->Render(deltaTime);
 		}
 	}
 
-	if (m_pEngineImGuiContext)
+	// Inspector and gizmo edits come with input, so the scene view keeps its last image only when nothing was touched.
+	const bool isSceneViewChanged = m_pEngineImGuiContext && UpdateSceneViewState();
+	if (m_pEngineImGuiContext && (hasInput || isSceneViewChanged || m_activeFrameCount > 0U || IsContinuousUpdate()))
 	{
 		if (m_pViewportCameraController)
 		{
@@ -553,16 +594,86 @@ bool EditorApp::Update(float deltaTime)
 				const float* pViewMatrix = pMainCameraComponent->GetViewMatrix().Begin();
 				const float* pProjectionMatrix = pMainCameraComponent->GetProjectionMatrix().Begin();
 				pRenderer->UpdateView(pViewMatrix, pProjectionMatrix);
+				pRenderer->Prepare();
 				pRenderer->Render(deltaTime);
 			}
 		}
+		++m_sceneRenderCount;
 	}
 
 	m_pRenderContext->EndFrame();
 
 	engine::Input::Get().FlushInputs();
-	
+
+	if (hasInput || isSceneViewChanged)
+	{
+		m_activeFrameCount = settleFrameCount;
+	}
+	else if (m_activeFrameCount > 0U)
+	{
+		--m_activeFrameCount;
+	}
+
+	if (m_initArgs.idleRefreshRate > 0U && 0U == m_activeFrameCount && !IsContinuousUpdate())
+	{
+		WaitForInvalidation();
+	}
+
 	return !GetMainWindow()->ShouldClose();
 }
 
+bool EditorApp::IsContinuousUpdate() const
+{
+#ifdef ENABLE_DDGI
+	// DDGI volumes are streamed in every frame.
+	return true;
+#else
+	if (!m_bInitEditor || !ResourceBuilder::Get().IsIdle())
+	{
+		return true;
+	}
+
+	for (engine::Entity entity : m_pSceneWorld->GetAnimationEntities())
+	{
+		const engine::AnimationComponent* pAnimationComponent = m_pSceneWorld->GetAnimationComponent(entity);
+		if (pAnimationComponent && pAnimationComponent->IsPlaying())
+		{
+			return true;
+		}
+	}
+
+	return false;
+#endif
 }
+
+bool EditorApp::UpdateSceneViewState()
+{
+	const engine::CameraComponent* pMainCameraComponent = m_pSceneWorld->GetCameraComponent(m_pSceneWorld->GetMainCameraEntity());
+	const engine::RenderTarget* pSceneRenderTarget = m_pSceneView->GetRenderTarget();
+
+	SceneViewState state{};
+	std::memcpy(state.viewMatrix, pMainCameraComponent->GetViewMatrix().Begin(), sizeof(state.viewMatrix));
+	std::memcpy(state.projectionMatrix, pMainCameraComponent->GetProjectionMatrix().Begin(), sizeof(state.projectionMatrix));
+	state.selectedEntity = m_pSceneWorld->GetSelectedEntity();
+	state.componentsVersion = m_pSceneWorld->GetWorld()->GetComponentsVersion();
+	state.width = pSceneRenderTarget->GetWidth();
+	state.height = pSceneRenderTarget->GetHeight();
+
+	if (0 == std::memcmp(&state, &m_sceneViewState, sizeof(SceneViewState)))
+	{
+		return false;
+	}
+
+	m_sceneViewState = state;
+	return true;
+}
+
+void EditorApp::WaitForInvalidation()
+{
+	auto waitBegin = std::chrono::steady_clock::now();
+	GetMainWindow()->WaitEvent(1000U / m_initArgs.idleRefreshRate);
+	m_lastWaitSeconds = std::chrono::duration<float>(std::chrono::steady_clock::now() - waitBegin).count();
+	m_waitSeconds += m_lastWaitSeconds;
+}
+
+}
\ No newline at end of file
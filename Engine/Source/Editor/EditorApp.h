@@ -1,13 +1,17 @@
 #pragma once
 
 #include "Application/IApplication.h"
+#include "ECWorld/Entity.h"
 
+#include <chrono>
 #include <memory>
+#include <thread>
 #include <vector>
 
 namespace engine
 {
 
+class AnimationSystem;
 class CameraController;
 class FlybyCamera;
 class ImGuiBaseLayer;
@@ -18,6 +22,7 @@ class Renderer;
 class AABBRenderer;
 class RenderTarget;
 class SceneWorld;
+class ThreadPool;
 
 }
 
@@ -68,10 +73,25 @@ public:
 	bool IsAtmosphericScatteringEnable() const;
 
 private:
+	// Inputs of the scene view. Engine renderers are skipped while they don't change.
+	struct SceneViewState
+	{
+		float viewMatrix[16];
+		float projectionMatrix[16];
+		engine::Entity selectedEntity;
+		uint32_t componentsVersion;
+		uint16_t width;
+		uint16_t height;
+	};
+
 	void InitEditorCameraEntity();
 	void InitDDGIEntity();
 	void InitSkyEntity();
 
+	bool IsContinuousUpdate() const;
+	bool UpdateSceneViewState();
+	void WaitForInvalidation();
+
 	bool m_bInitEditor = false;
 	engine::EngineInitArgs m_initArgs;
 
@@ -85,6 +105,8 @@ private:
 
 	// Scene
 	std::unique_ptr<engine::SceneWorld> m_pSceneWorld;
+	std::unique_ptr<engine::ThreadPool> m_pThreadPool;
+	std::unique_ptr<engine::AnimationSystem> m_pAnimationSystem;
 	editor::SceneView* m_pSceneView = nullptr;
 	engine::Renderer* m_pSceneRenderer = nullptr;
 	engine::Renderer* m_pDebugRenderer = nullptr;
@@ -98,8 +120,22 @@ private:
 	std::vector<std::unique_ptr<engine::Renderer>> m_pEditorRenderers;
 	std::vector<std::unique_ptr<engine::Renderer>> m_pEngineRenderers;
 
+	// Runs the resource builds queued during Init while the splash screen shows.
+	std::thread m_resourceBuildThread;
+
 	// Controllers for processing input events.
 	std::unique_ptr<engine::CameraController> m_pViewportCameraController;
+
+	// Frame invalidation
+	SceneViewState m_sceneViewState{};
+	uint32_t m_activeFrameCount = 0U;
+	float m_lastWaitSeconds = 0.0f;
+
+	// Idle statistics which are logged on shutdown.
+	std::chrono::steady_clock::time_point m_startTime = std::chrono::steady_clock::now();
+	double m_waitSeconds = 0.0;
+	uint64_t m_frameCount = 0U;
+	uint64_t m_sceneRenderCount = 0U;
 };
 
 }
\ No newline at end of file
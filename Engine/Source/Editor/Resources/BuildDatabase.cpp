@@ -0,0 +1,105 @@
+#include "BuildDatabase.h"
+
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+namespace editor
+{
+
+namespace
+{
+
+constexpr char databaseMagic[4] = { 'C', 'D', 'B', 'D' };
+constexpr uint32_t databaseVersion = 1U;
+
+// Header followed by recordCount pairs of build key and output hash, all little endian.
+struct DatabaseHeader
+{
+	char magic[4];
+	uint32_t version;
+	uint64_t recordCount;
+};
+
+}
+
+bool BuildDatabase::Load(const char* pFilePath)
+{
+	m_outputHashes.clear();
+	m_isModified = false;
+
+	std::ifstream inFile(pFilePath, std::ios::binary | std::ios::ate);
+	if (!inFile.is_open())
+	{
+		return false;
+	}
+
+	uint64_t fileSize = static_cast<uint64_t>(inFile.tellg());
+	inFile.seekg(0);
+
+	DatabaseHeader header;
+	if (!inFile.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+		0 != std::memcmp(header.magic, databaseMagic, sizeof(databaseMagic)) || header.version != databaseVersion ||
+		header.recordCount != (fileSize - sizeof(header)) / (2U * sizeof(uint64_t)))
+	{
+		return false;
+	}
+
+	std::vector<uint64_t> records(header.recordCount * 2U);
+	if (!inFile.read(reinterpret_cast<char*>(records.data()), records.size() * sizeof(uint64_t)))
+	{
+		return false;
+	}
+
+	m_outputHashes.reserve(header.recordCount);
+	for (size_t recordIndex = 0U; recordIndex < records.size(); recordIndex += 2U)
+	{
+		m_outputHashes[records[recordIndex]] = records[recordIndex + 1U];
+	}
+
+	return true;
+}
+
+bool BuildDatabase::Save(const char* pFilePath)
+{
+	std::vector<uint64_t> records;
+	records.reserve(m_outputHashes.size() * 2U);
+	for (const auto& [buildKey, outputHash] : m_outputHashes)
+	{
+		records.push_back(buildKey);
+		records.push_back(outputHash);
+	}
+
+	DatabaseHeader header;
+	std::memcpy(header.magic, databaseMagic, sizeof(databaseMagic));
+	header.version = databaseVersion;
+	header.recordCount = m_outputHashes.size();
+
+	std::ofstream outFile(pFilePath, std::ios::binary | std::ios::trunc);
+	if (!outFile.write(reinterpret_cast<const char*>(&header), sizeof(header)) ||
+		!outFile.write(reinterpret_cast<const char*>(records.data()), records.size() * sizeof(uint64_t)))
+	{
+		return false;
+	}
+
+	m_isModified = false;
+	return true;
+}
+
+const uint64_t* BuildDatabase::FindOutputHash(uint64_t buildKey) const
+{
+	auto itOutputHash = m_outputHashes.find(buildKey);
+	return itOutputHash != m_outputHashes.end() ? &itOutputHash->second : nullptr;
+}
+
+void BuildDatabase::SetOutputHash(uint64_t buildKey, uint64_t outputHash)
+{
+	auto [itOutputHash, isInserted] = m_outputHashes.try_emplace(buildKey, outputHash);
+	if (isInserted || itOutputHash->second != outputHash)
+	{
+		itOutputHash->second = outputHash;
+		m_isModified = true;
+	}
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+
+namespace editor
+{
+
+// Content hashes of build outputs by build key, the hash of everything a build depends on : input file contents,
+// the tool binary and its options. An output is up to date when the database holds its build key and the file
+// still hashes to the stored value. Keys don't contain paths, so a moved or copied project or a switch back
+// to an earlier branch finds its records again.
+class BuildDatabase final
+{
+public:
+	BuildDatabase() = default;
+	BuildDatabase(const BuildDatabase&) = delete;
+	BuildDatabase& operator=(const BuildDatabase&) = delete;
+	BuildDatabase(BuildDatabase&&) = default;
+	BuildDatabase& operator=(BuildDatabase&&) = default;
+	~BuildDatabase() = default;
+
+	// A missing or damaged file leaves the database empty.
+	bool Load(const char* pFilePath);
+	bool Save(const char* pFilePath);
+
+	bool IsModified() const { return m_isModified; }
+	size_t GetRecordCount() const { return m_outputHashes.size(); }
+
+	const uint64_t* FindOutputHash(uint64_t buildKey) const;
+	void SetOutputHash(uint64_t buildKey, uint64_t outputHash);
+
+private:
+	std::unordered_map<uint64_t, uint64_t> m_outputHashes;
+	bool m_isModified = false;
+};
+
+}
\ No newline at end of file
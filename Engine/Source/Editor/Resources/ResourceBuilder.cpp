@@ -1,162 +1,217 @@
 #include "ResourceBuilder.h"
 
 #include "Base/Template.h"
+#include "Core/ContentHash.h"
 #include "Path/Path.h"
-#include "Time/Clock.h"
 #include "Log/Log.h"
 
+#include <algorithm>
 #include <cassert>
+#include <string_view>
 
 namespace editor
 {
 
+namespace
+{
+
+// Stand ins for the paths in tool options, so that build keys don't depend on where the project lives.
+constexpr const char* inputPathPlaceholder = "<input>";
+constexpr const char* outputPathPlaceholder = "<output>";
+
+}
+
 ResourceBuilder::ResourceBuilder()
 {
-	std::string modifyCachePath = GetModifyCacheFilePath();
-	if (std::filesystem::exists(modifyCachePath))
-	{
-		ReadModifyCacheFile();
-	}
-	else
-	{
-		CD_INFO("Modify time cache {0} does not exist.", modifyCachePath);
-		CD_WARN("Everything will be compiled at the begining.");
-	}
+	LoadBuildDatabase();
 }
 
 ResourceBuilder::~ResourceBuilder()
 {
-	WriteModifyCacheFile();
+	SaveBuildDatabase();
 }
 
-void ResourceBuilder::ReadModifyCacheFile()
+void ResourceBuilder::LoadBuildDatabase()
 {
-	std::string modifyCachePath = GetModifyCacheFilePath();
-	std::ifstream inFile(modifyCachePath);
-	if (!inFile.is_open())
+	std::string buildDatabasePath = GetBuildDatabaseFilePath();
+	if (!std::filesystem::exists(buildDatabasePath))
 	{
-		CD_ERROR("Open file {0} failed!", modifyCachePath);
+		CD_INFO("Build database {0} does not exist.", buildDatabasePath);
+		CD_WARN("Everything will be compiled at the begining.");
 		return;
 	}
 
-	CD_INFO("Reading modify time cache from {0}.", modifyCachePath);
-
-	std::string line;
-	while (std::getline(inFile, line))
+	if (!m_buildDatabase.Load(buildDatabasePath.c_str()))
 	{
-		size_t pos = line.find("=");
-		if (pos != std::string::npos)
-		{
-			std::string filePath = line.substr(0, pos);
-
-			long long timeStamp = std::stoll(line.substr(pos + 1));
-			m_modifyTimeCache[filePath] = timeStamp;
-		}
+		CD_ERROR("Read build database {0} failed! Everything will be compiled.", buildDatabasePath);
+		return;
 	}
 
-	inFile.close();
+	CD_INFO("Read {0} records from build database {1}.", m_buildDatabase.GetRecordCount(), buildDatabasePath);
 }
 
-void ResourceBuilder::WriteModifyCacheFile()
+void ResourceBuilder::SaveBuildDatabase()
 {
-	if (!HasNewModifyTimeCache())
+	std::lock_guard<std::mutex> lock(m_cacheMutex);
+	if (!m_buildDatabase.IsModified())
 	{
 		return;
 	}
 
-	std::string modifyCachePath = GetModifyCacheFilePath();
-
-	if (!std::filesystem::exists(modifyCachePath))
+	std::string buildDatabasePath = GetBuildDatabaseFilePath();
+	if (!std::filesystem::exists(buildDatabasePath))
 	{
-		std::filesystem::create_directories(std::filesystem::path(modifyCachePath).parent_path());
+		std::filesystem::create_directories(std::filesystem::path(buildDatabasePath).parent_path());
 	}
 
-	std::ofstream outFile(modifyCachePath, std::ios::trunc);
-	if (!outFile.is_open())
+	if (!m_buildDatabase.Save(buildDatabasePath.c_str()))
 	{
-		CD_ERROR("Open file {0} failed!", modifyCachePath);
+		CD_ERROR("Write build database {0} failed!", buildDatabasePath);
 		return;
 	}
 
-	CD_INFO("Writing modify time cache to {0}.", modifyCachePath);
-
-	UpdateModifyTimeCache();
-
-	outFile.clear();
-	for (const auto& [filePath, timeStamp] : m_modifyTimeCache)
-	{
-		outFile << filePath << "=" << timeStamp << std::endl;
-	}
-
-	outFile.close();
+	CD_INFO("Wrote {0} records to build database {1}.", m_buildDatabase.GetRecordCount(), buildDatabasePath);
 }
 
-std::string ResourceBuilder::GetModifyCacheFilePath()
+std::string ResourceBuilder::GetBuildDatabaseFilePath()
 {
 	const auto& appDataPath = engine::Path::GetApplicationDataPath();
 	if (appDataPath.has_value())
 	{
-		return (appDataPath.value() / engine::Path::EngineName / "modifyTimeCache.bin").string();
+		return (appDataPath.value() / engine::Path::EngineName / "buildDatabase.bin").string();
 	}
 
 	CD_ERROR("Can not find application data path!");
 	return "";
 }
 
-ProcessStatus ResourceBuilder::CheckFileStatus(const char* pInputFilePath, const char* pOutputFilePath)
+std::optional<uint64_t> ResourceBuilder::GetFileHash(const std::string& filePath)
 {
-	if (!std::filesystem::exists(pInputFilePath))
+	std::error_code errorCode;
+	std::filesystem::file_time_type writeTime = std::filesystem::last_write_time(filePath, errorCode);
+	uintmax_t size = std::filesystem::file_size(filePath, errorCode);
+	if (errorCode)
 	{
-		CD_ERROR("Input file path {0} does not exist!", pInputFilePath);
-		return ProcessStatus::InputNotExist;
+		return std::nullopt;
 	}
 
-	auto crtTimeStamp = engine::Clock::FileTimePointToTimeStamp(std::filesystem::last_write_time(pInputFilePath));
+	auto itFileHash = m_fileHashes.find(filePath);
+	if (itFileHash != m_fileHashes.end() && itFileHash->second.writeTime == writeTime && itFileHash->second.size == size)
+	{
+		return itFileHash->second.hash;
+	}
 
-	if (m_modifyTimeCache.find(pInputFilePath) == m_modifyTimeCache.end())
+	std::optional<uint64_t> optHash = engine::HashFileContent(filePath.c_str());
+	if (optHash.has_value())
 	{
-		CD_INFO("New input file {0} detected.", pInputFilePath);
-		m_newModifyTimeCache[pInputFilePath] = crtTimeStamp;
-		return ProcessStatus::InputAdded;
+		m_fileHashes[filePath] = FileHash{ writeTime, size, optHash.value() };
 	}
 
-	if (m_modifyTimeCache[pInputFilePath] != crtTimeStamp)
+	return optHash;
+}
+
+ProcessStatus ResourceBuilder::CheckBuildStatus(const std::vector<std::string>& inputFilePaths, const char* pOutputFilePath,
+	const std::string& toolPath, const std::vector<std::string>& commandArguments, uint64_t& buildKey)
+{
+	auto checkBegin = std::chrono::steady_clock::now();
+	std::lock_guard<std::mutex> lock(m_cacheMutex);
+
+	engine::ContentHasher buildKeyHasher;
+	for (const std::string& inputFilePath : inputFilePaths)
 	{
-		CD_INFO("Input file path {0} has been modified.", pInputFilePath);
-		m_newModifyTimeCache[pInputFilePath] = crtTimeStamp;
-		return ProcessStatus::InputModified;
+		std::optional<uint64_t> optInputHash = GetFileHash(inputFilePath);
+		if (!optInputHash.has_value())
+		{
+			CD_ERROR("Input file path {0} does not exist!", inputFilePath);
+			return ProcessStatus::InputNotExist;
+		}
+		buildKeyHasher.Update(optInputHash.value());
 	}
 
-	if (!std::filesystem::exists(pOutputFilePath))
+	// Tools are found with or without the executable extension.
+	std::optional<uint64_t> optToolHash = GetFileHash(toolPath);
+#if CD_PLATFORM_WINDOWS
+	if (!optToolHash.has_value())
 	{
-		CD_INFO("Output file path {0} dose not exist.", pOutputFilePath);
-		return ProcessStatus::OutputNotExist;
+		optToolHash = GetFileHash(toolPath + ".exe");
+	}
+#endif
+	buildKeyHasher.Update(optToolHash.value_or(0U));
+
+	std::string outputPathWithoutExtension = std::filesystem::path(pOutputFilePath).replace_extension().generic_string();
+	for (const std::string& commandArgument : commandArguments)
+	{
+		std::string_view hashedArgument = commandArgument;
+		if (std::find(inputFilePaths.begin(), inputFilePaths.end(), commandArgument) != inputFilePaths.end())
+		{
+			hashedArgument = inputPathPlaceholder;
+		}
+		else if (commandArgument == pOutputFilePath || commandArgument == outputPathWithoutExtension)
+		{
+			hashedArgument = outputPathPlaceholder;
+		}
+
+		// Sizes keep argument boundaries apart.
+		buildKeyHasher.Update(static_cast<uint64_t>(hashedArgument.size()));
+		buildKeyHasher.Update(hashedArgument.data(), hashedArgument.size());
+	}
+	buildKey = buildKeyHasher.GetHash();
+
+	ProcessStatus status;
+	const uint64_t* pOutputHash = m_buildDatabase.FindOutputHash(buildKey);
+	if (!pOutputHash)
+	{
+		bool isOutputExisting = std::filesystem::exists(pOutputFilePath);
+		CD_INFO("Inputs or options of output {0} have no build record.", pOutputFilePath);
+		status = isOutputExisting ? ProcessStatus::InputModified : ProcessStatus::InputAdded;
 	}
 	else
 	{
-		CD_TRACE("Output file path {0} already exist.", pOutputFilePath);
-		return ProcessStatus::Stable;
+		std::optional<uint64_t> optOutputHash = GetFileHash(pOutputFilePath);
+		if (!optOutputHash.has_value())
+		{
+			CD_INFO("Output file path {0} dose not exist.", pOutputFilePath);
+			status = ProcessStatus::OutputNotExist;
+		}
+		else if (optOutputHash.value() != *pOutputHash)
+		{
+			CD_INFO("Output file path {0} has been modified.", pOutputFilePath);
+			status = ProcessStatus::OutputModified;
+		}
+		else
+		{
+			CD_TRACE("Output file path {0} is up to date.", pOutputFilePath);
+			status = ProcessStatus::Stable;
+			++m_upToDateCount;
+		}
 	}
 
-	CD_ERROR("Unknow ProcessStatus of input {0} and output {1}!", pInputFilePath, pOutputFilePath);
-	assert(false);
-	return ProcessStatus::None;
+	m_checkMilliseconds += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - checkBegin).count();
+	return status;
 }
 
-
 bool ResourceBuilder::AddTask(Process process)
 {
-	m_buildTasks.push(cd::MoveTemp(process));
-	return true;
+	return AddTask(cd::MoveTemp(process), nullptr, 0U);
 }
 
-bool ResourceBuilder::AddShaderBuildTask(ShaderType shaderType, const char* pInputFilePath, const char* pOutputFilePath, const char* pUberOptions)
+bool ResourceBuilder::AddTask(Process process, const char* pOutputFilePath, uint64_t buildKey)
 {
-	if (s_SkipStatus & static_cast<uint8_t>(CheckFileStatus(pInputFilePath, pOutputFilePath)))
+	// Logs are printed by Update in task order instead of by the process.
+	process.SetPrintChildProcessLog(false);
+
+	std::lock_guard<std::mutex> lock(m_cacheMutex);
+	uint32_t taskIndex = m_processPool.Add(cd::MoveTemp(process));
+	if (pOutputFilePath)
 	{
-		return false;
+		m_pendingOutputs[taskIndex] = PendingOutput{ pOutputFilePath, buildKey };
 	}
 
+	return true;
+}
+
+bool ResourceBuilder::AddShaderBuildTask(ShaderType shaderType, const char* pInputFilePath, const char* pOutputFilePath, const char* pUberOptions)
+{
 	// Document : https://bkaradzic.github.io/bgfx/tools.html#shader-compiler-shaderc
 	std::string cmftExePath = CDENGINE_TOOL_PATH;
 	cmftExePath += "/shaderc";
@@ -231,19 +286,27 @@ bool ResourceBuilder::AddShaderBuildTask(ShaderType shaderType, const char* pInp
 		commandArguments.push_back(shaderLanguageDefine + ";" + pUberOptions);
 	}
 
+	// Variants are built again when any file which the shader includes changes.
+	std::vector<std::string> inputFilePaths{ pInputFilePath, shaderSourceFolderPath.string() };
+	{
+		std::lock_guard<std::mutex> lock(m_cacheMutex);
+		m_shaderIncludeScanner.AppendIncludedFiles(pInputFilePath, inputFilePaths);
+	}
+
+	uint64_t buildKey;
+	if (s_SkipStatus & static_cast<uint8_t>(CheckBuildStatus(inputFilePaths, pOutputFilePath, cmftExePath, commandArguments, buildKey)))
+	{
+		return false;
+	}
+
 	process.SetCommandArguments(cd::MoveTemp(commandArguments));
-	AddTask(cd::MoveTemp(process));
+	AddTask(cd::MoveTemp(process), pOutputFilePath, buildKey);
 
 	return true;
 }
 
 bool ResourceBuilder::AddIrradianceCubeMapBuildTask(const char* pInputFilePath, const char* pOutputFilePath)
 {
-	if (s_SkipStatus & static_cast<uint8_t>(CheckFileStatus(pInputFilePath, pOutputFilePath)))
-	{
-		return false;
-	}
-
 	std::string cmftExePath = (std::filesystem::path(CDENGINE_TOOL_PATH) / "cmft").generic_string();
 	Process process(cmftExePath.c_str());
 	std::string pathWithoutExtension = std::filesystem::path(pOutputFilePath).replace_extension().generic_string();
@@ -253,19 +316,20 @@ bool ResourceBuilder::AddIrradianceCubeMapBuildTask(const char* pInputFilePath,
 		"--dstFaceSize", "256",
 		"--outputNum", "1", "--output0", cd::MoveTemp(pathWithoutExtension), "--output0params", "dds,rgba16f,cubemap"};
 
+	uint64_t buildKey;
+	if (s_SkipStatus & static_cast<uint8_t>(CheckBuildStatus({ pInputFilePath }, pOutputFilePath, cmftExePath, irradianceCommandArguments, buildKey)))
+	{
+		return false;
+	}
+
 	process.SetCommandArguments(cd::MoveTemp(irradianceCommandArguments));
-	AddTask(cd::MoveTemp(process));
+	AddTask(cd::MoveTemp(process), pOutputFilePath, buildKey);
 
 	return true;
 }
 
 bool ResourceBuilder::AddRadianceCubeMapBuildTask(const char* pInputFilePath, const char* pOutputFilePath)
 {
-	if (s_SkipStatus & static_cast<uint8_t>(CheckFileStatus(pInputFilePath, pOutputFilePath)))
-	{
-		return false;
-	}
-
 	std::string cmftExePath = (std::filesystem::path(CDENGINE_TOOL_PATH) / "cmft").generic_string();
 	Process process(cmftExePath.c_str());
 	std::string pathWithoutExtension = std::filesystem::path(pOutputFilePath).replace_extension().generic_string();
@@ -275,19 +339,20 @@ bool ResourceBuilder::AddRadianceCubeMapBuildTask(const char* pInputFilePath, co
 		"--dstFaceSize", "256",
 		"--outputNum", "1", "--output0", cd::MoveTemp(pathWithoutExtension), "--output0params", "dds,rgba16f,cubemap"};
 
+	uint64_t buildKey;
+	if (s_SkipStatus & static_cast<uint8_t>(CheckBuildStatus({ pInputFilePath }, pOutputFilePath, cmftExePath, radianceCommandArguments, buildKey)))
+	{
+		return false;
+	}
+
 	process.SetCommandArguments(cd::MoveTemp(radianceCommandArguments));
-	AddTask(cd::MoveTemp(process));
+	AddTask(cd::MoveTemp(process), pOutputFilePath, buildKey);
 
 	return true;
 }
 
 bool ResourceBuilder::AddTextureBuildTask(cd::MaterialTextureType textureType, const char* pInputFilePath, const char* pOutputFilePath)
 {
-	if (s_SkipStatus & static_cast<uint8_t>(CheckFileStatus(pInputFilePath, pOutputFilePath)))
-	{
-		return false;
-	}
-
 	// Document : https://bkaradzic.github.io/bgfx/tools.html#texture-compiler-texturec
 	std::string texturecExePath = CDENGINE_TOOL_PATH;
 	texturecExePath += "/texturec";
@@ -302,61 +367,90 @@ bool ResourceBuilder::AddTextureBuildTask(cd::MaterialTextureType textureType, c
 	{
 		commandArguments.push_back("--linear");
 	}
+	uint64_t buildKey;
+	if (s_SkipStatus & static_cast<uint8_t>(CheckBuildStatus({ pInputFilePath }, pOutputFilePath, texturecExePath, commandArguments, buildKey)))
+	{
+		return false;
+	}
+
 	process.SetCommandArguments(cd::MoveTemp(commandArguments));
-	AddTask(cd::MoveTemp(process));
+	AddTask(cd::MoveTemp(process), pOutputFilePath, buildKey);
 
 	return true;
 }
 
 void ResourceBuilder::Update(bool doPrintLog)
 {
-	if (m_buildTasks.empty())
+	if (IsIdle())
 	{
 		return;
 	}
 
-	// It may wait until process exited which depends on process's setting.
-	while (!m_buildTasks.empty())
+	auto buildBegin = std::chrono::steady_clock::now();
+	m_processPool.Run([this, doPrintLog](uint32_t taskIndex, const Process& process, bool isCancelled)
 	{
-		Process& process = m_buildTasks.front();
-		process.SetWaitUntilFinished(m_buildTasks.size() == 1);
-		process.SetPrintChildProcessLog(doPrintLog);
-		process.Run();
-		m_buildTasks.pop();
-	}
+		if (doPrintLog && !process.GetLog().empty())
+		{
+			// Logs from child process's stdout maybe error info because many tool authors will use stdout to print rather than stderr.
+			CD_ERROR("{0}\n{1}", process.GetProcessName(), process.GetLog());
+		}
 
-	if (m_buildTasks.empty())
-	{
-		WriteModifyCacheFile();
-	}
-}
+		bool isFailed = isCancelled || 0 != process.GetExitCode();
+		if (isCancelled)
+		{
+			CD_WARN("Build task {0} of {1} is cancelled.", taskIndex, process.GetProcessName());
+		}
+		else if (isFailed)
+		{
+			CD_ERROR("Build task {0} of {1} failed with exit code {2}.", taskIndex, process.GetProcessName(), process.GetExitCode());
+		}
 
-bool ResourceBuilder::HasNewModifyTimeCache() const
-{
-	return !m_newModifyTimeCache.empty();
-}
+		PendingOutput pendingOutput;
+		{
+			std::lock_guard<std::mutex> lock(m_cacheMutex);
+			auto itPendingOutput = m_pendingOutputs.find(taskIndex);
+			if (itPendingOutput == m_pendingOutputs.end())
+			{
+				return;
+			}
+			pendingOutput = cd::MoveTemp(itPendingOutput->second);
+			m_pendingOutputs.erase(itPendingOutput);
+		}
 
-void ResourceBuilder::UpdateModifyTimeCache()
-{
-	for (auto& [filePath, fileTime] : m_newModifyTimeCache)
-	{
-		m_modifyTimeCache[filePath] = cd::MoveTemp(fileTime);
-	}
+		if (isFailed)
+		{
+			return;
+		}
 
-	m_newModifyTimeCache.clear();
-}
+		// Outputs are hashed outside of the lock so that other tasks can report meanwhile.
+		std::error_code errorCode;
+		std::filesystem::file_time_type writeTime = std::filesystem::last_write_time(pendingOutput.filePath, errorCode);
+		uintmax_t size = std::filesystem::file_size(pendingOutput.filePath, errorCode);
+		std::optional<uint64_t> optOutputHash = engine::HashFileContent(pendingOutput.filePath.c_str());
+		if (errorCode || !optOutputHash.has_value())
+		{
+			CD_ERROR("Build task {0} of {1} didn't write output {2}.", taskIndex, process.GetProcessName(), pendingOutput.filePath);
+			return;
+		}
 
-void ResourceBuilder::ClearModifyTimeCache()
-{
-	m_modifyTimeCache.clear();
-	m_newModifyTimeCache.clear();
-}
+		std::lock_guard<std::mutex> lock(m_cacheMutex);
+		m_buildDatabase.SetOutputHash(pendingOutput.buildKey, optOutputHash.value());
+		m_fileHashes[pendingOutput.filePath] = FileHash{ writeTime, size, optOutputHash.value() };
+		++m_builtCount;
+	});
 
-void ResourceBuilder::DeleteModifyTimeCache()
-{
-	if (!std::filesystem::remove(GetModifyCacheFilePath()))
+	if (IsIdle())
 	{
-		CD_WARN("Delete file {0} failed!", GetModifyCacheFilePath());
+		double buildSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - buildBegin).count();
+		{
+			std::lock_guard<std::mutex> lock(m_cacheMutex);
+			CD_INFO("Build database : {0} outputs up to date, {1} built in {2:.2f}s, checks took {3:.1f} ms.",
+				m_upToDateCount, m_builtCount, buildSeconds, m_checkMilliseconds);
+			m_upToDateCount = 0U;
+			m_builtCount = 0U;
+			m_checkMilliseconds = 0.0;
+		}
+		SaveBuildDatabase();
 	}
 }
 
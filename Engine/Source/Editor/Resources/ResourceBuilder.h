@@ -1,14 +1,18 @@
 #pragma once
 
-#include "Process/Process.h"
+#include "BuildDatabase.h"
+#include "Process/ProcessPool.h"
 #include "Scene/MaterialTextureType.h"
+#include "ShaderIncludeScanner.h"
 
 #include <chrono>
 #include <filesystem>
 #include <fstream>
-#include <queue>
+#include <mutex>
+#include <optional>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 namespace editor
 {
@@ -29,12 +33,14 @@ enum class ProcessStatus : uint8_t
 	InputModified  = 1 << 3,
 	InputAdded     = 1 << 4,
 	Stable         = 1 << 5,
+	OutputModified = 1 << 6,
 };
 
 class Process;
 
 // ResourceBuilder is used to create processes to build different resource types.
 // So it is OK to update in the main thread or work thread.
+// Build processes run concurrently, up to one per hardware thread, and their logs are printed in the order tasks were added.
 // For resource build tasks which are using dll calls, it will be wrapped as a task to multithreading JobSystem.
 class ResourceBuilder final
 {
@@ -62,34 +68,58 @@ public:
 	bool AddShaderBuildTask(ShaderType shaderType, const char* pInputFilePath, const char* pOutputFilePath, const char* pUberOptions = nullptr);
 	bool AddTextureBuildTask(cd::MaterialTextureType textureType, const char* pInputFilePath, const char* pOutputFilePath);
 
+	// Blocks until every task added so far, and the ones added meanwhile, is done.
 	void Update(bool doPrintLog = true);
-	size_t GetCurrentTaskCount() const { return m_buildTasks.size(); }
-	bool IsIdle() const { return m_buildTasks.empty(); }
+	// Thread safe. Drops tasks which didn't start and terminates running ones. Their outputs are built again next time.
+	void Cancel() { m_processPool.Cancel(); }
+	size_t GetCurrentTaskCount() const { return m_processPool.GetPendingCount(); }
+	bool IsIdle() const { return m_processPool.IsEmpty(); }
 
 private:
 	ResourceBuilder();
 	~ResourceBuilder();
 
-	void ReadModifyCacheFile();
-	void WriteModifyCacheFile();
+	void LoadBuildDatabase();
+	void SaveBuildDatabase();
 
-	bool HasNewModifyTimeCache() const;
-	void UpdateModifyTimeCache();
-	void ClearModifyTimeCache();
-	void DeleteModifyTimeCache();
+	std::string GetBuildDatabaseFilePath();
 
-	std::string GetModifyCacheFilePath();
+	// Hashes are reused while the file keeps its size and write time.
+	std::optional<uint64_t> GetFileHash(const std::string& filePath);
 
-	ProcessStatus CheckFileStatus(const char* pInputFilePath, const char* pOutputFilePath);
+	// Computes the build key from the contents of the inputs and of the tool, and from the tool options in which
+	// the input and output paths are replaced by placeholders.
+	ProcessStatus CheckBuildStatus(const std::vector<std::string>& inputFilePaths, const char* pOutputFilePath,
+		const std::string& toolPath, const std::vector<std::string>& commandArguments, uint64_t& buildKey);
+	bool AddTask(Process process, const char* pOutputFilePath, uint64_t buildKey);
 
 private:
-	std::queue<Process> m_buildTasks;
-	
-	std::unordered_map<std::string, long long> m_modifyTimeCache;
+	struct FileHash
+	{
+		std::filesystem::file_time_type writeTime;
+		uintmax_t size;
+		uint64_t hash;
+	};
 
-	// We always access to fragment shader multiple times by using ubre options.
-	// So we can not update fragment shader's modify time every time we found it has been modified.
-	std::unordered_map<std::string, long long> m_newModifyTimeCache;
+	struct PendingOutput
+	{
+		std::string filePath;
+		uint64_t buildKey;
+	};
+
+	ProcessPool m_processPool;
+
+	// Guards the database, file hashes, shader includes and pending outputs, which tasks finishing on pool threads update.
+	std::mutex m_cacheMutex;
+	BuildDatabase m_buildDatabase;
+	std::unordered_map<std::string, FileHash> m_fileHashes;
+	ShaderIncludeScanner m_shaderIncludeScanner;
+	// Outputs of the tasks in the pool by task index. They are recorded once their task succeeded.
+	std::unordered_map<uint32_t, PendingOutput> m_pendingOutputs;
+
+	uint32_t m_upToDateCount = 0U;
+	uint32_t m_builtCount = 0U;
+	double m_checkMilliseconds = 0.0;
 };
 
 }
\ No newline at end of file
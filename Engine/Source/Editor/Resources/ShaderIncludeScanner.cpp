@@ -0,0 +1,195 @@
+#include "ShaderIncludeScanner.h"
+
+#include "Base/Template.h"
+#include "Log/Log.h"
+
+#include <fstream>
+#include <iterator>
+#include <unordered_set>
+
+namespace editor
+{
+
+namespace
+{
+
+// Blanks comments out but keeps line breaks, so that directives stay on their own lines.
+std::string RemoveComments(const std::string& source)
+{
+	std::string result;
+	result.reserve(source.size());
+
+	size_t index = 0U;
+	while (index < source.size())
+	{
+		if ('/' == source[index] && index + 1U < source.size() && '/' == source[index + 1U])
+		{
+			while (index < source.size() && '\n' != source[index])
+			{
+				++index;
+			}
+		}
+		else if ('/' == source[index] && index + 1U < source.size() && '*' == source[index + 1U])
+		{
+			index += 2U;
+			while (index < source.size() && !('*' == source[index] && index + 1U < source.size() && '/' == source[index + 1U]))
+			{
+				if ('\n' == source[index])
+				{
+					result.push_back('\n');
+				}
+				++index;
+			}
+			index += 2U;
+			result.push_back(' ');
+		}
+		else
+		{
+			result.push_back(source[index]);
+			++index;
+		}
+	}
+
+	return result;
+}
+
+bool IsBlank(char c)
+{
+	return ' ' == c || '\t' == c;
+}
+
+// Returns the quoted or bracketed path of an #include line, empty for other lines.
+std::string ParseIncludePath(const std::string& source, size_t lineBegin, size_t lineEnd)
+{
+	constexpr char includeKeyword[] = "include";
+	constexpr size_t includeKeywordLength = sizeof(includeKeyword) - 1U;
+
+	size_t index = lineBegin;
+	while (index < lineEnd && IsBlank(source[index]))
+	{
+		++index;
+	}
+	if (index == lineEnd || '#' != source[index])
+	{
+		return std::string();
+	}
+
+	++index;
+	while (index < lineEnd && IsBlank(source[index]))
+	{
+		++index;
+	}
+	if (lineEnd - index <= includeKeywordLength || 0 != source.compare(index, includeKeywordLength, includeKeyword))
+	{
+		return std::string();
+	}
+
+	index += includeKeywordLength;
+	while (index < lineEnd && IsBlank(source[index]))
+	{
+		++index;
+	}
+	if (index == lineEnd || ('"' != source[index] && '<' != source[index]))
+	{
+		return std::string();
+	}
+
+	char closing = '"' == source[index] ? '"' : '>';
+	size_t pathBegin = index + 1U;
+	size_t pathEnd = source.find(closing, pathBegin);
+	if (std::string::npos == pathEnd || pathEnd > lineEnd)
+	{
+		return std::string();
+	}
+
+	return source.substr(pathBegin, pathEnd - pathBegin);
+}
+
+}
+
+void ShaderIncludeScanner::AppendIncludedFiles(const char* pShaderFilePath, std::vector<std::string>& filePaths)
+{
+	std::string shaderFilePath = std::filesystem::path(pShaderFilePath).lexically_normal().generic_string();
+
+	// Depth first over the include graph. Visited files also stop include cycles.
+	std::unordered_set<std::string> visitedFilePaths{ shaderFilePath };
+	std::vector<std::string> pendingFilePaths{ cd::MoveTemp(shaderFilePath) };
+	while (!pendingFilePaths.empty())
+	{
+		std::string filePath = cd::MoveTemp(pendingFilePaths.back());
+		pendingFilePaths.pop_back();
+
+		const ScannedFile* pScannedFile = Scan(filePath);
+		if (!pScannedFile)
+		{
+			continue;
+		}
+
+		for (const std::string& includedFilePath : pScannedFile->includedFilePaths)
+		{
+			if (visitedFilePaths.insert(includedFilePath).second)
+			{
+				filePaths.push_back(includedFilePath);
+				pendingFilePaths.push_back(includedFilePath);
+			}
+		}
+	}
+}
+
+const ShaderIncludeScanner::ScannedFile* ShaderIncludeScanner::Scan(const std::string& filePath)
+{
+	std::error_code errorCode;
+	std::filesystem::file_time_type writeTime = std::filesystem::last_write_time(filePath, errorCode);
+	uintmax_t size = std::filesystem::file_size(filePath, errorCode);
+	if (errorCode)
+	{
+		m_scannedFiles.erase(filePath);
+		return nullptr;
+	}
+
+	auto itScannedFile = m_scannedFiles.find(filePath);
+	if (itScannedFile != m_scannedFiles.end() && itScannedFile->second.writeTime == writeTime && itScannedFile->second.size == size)
+	{
+		return &itScannedFile->second;
+	}
+
+	std::ifstream inFile(filePath, std::ios::binary);
+	if (!inFile.is_open())
+	{
+		return nullptr;
+	}
+	std::string source = RemoveComments(std::string(std::istreambuf_iterator<char>(inFile), std::istreambuf_iterator<char>()));
+
+	ScannedFile scannedFile{ writeTime, size, {} };
+	std::filesystem::path folderPath = std::filesystem::path(filePath).parent_path();
+	size_t lineBegin = 0U;
+	while (lineBegin < source.size())
+	{
+		size_t lineEnd = source.find('\n', lineBegin);
+		if (std::string::npos == lineEnd)
+		{
+			lineEnd = source.size();
+		}
+
+		std::string includePath = ParseIncludePath(source, lineBegin, lineEnd);
+		if (!includePath.empty())
+		{
+			std::string includedFilePath = (folderPath / includePath).lexically_normal().generic_string();
+			if (std::filesystem::exists(includedFilePath))
+			{
+				scannedFile.includedFilePaths.push_back(cd::MoveTemp(includedFilePath));
+			}
+			else
+			{
+				// shaderc reports it when compiling.
+				CD_WARN("Include file {0} of shader {1} does not exist.", includedFilePath, filePath);
+			}
+		}
+
+		lineBegin = lineEnd + 1U;
+	}
+
+	return &(m_scannedFiles[filePath] = cd::MoveTemp(scannedFile));
+}
+
+}
\ No newline at end of file
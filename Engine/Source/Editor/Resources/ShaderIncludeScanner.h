@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace editor
+{
+
+// Finds the files which a shader source includes, directly or through other includes. Every #include outside of
+// comments counts, also the ones behind #if, so one set serves all uber variants of the shader. Paths are resolved
+// against the folder of the including file as shaderc does without extra include folders.
+// Direct includes of each file are cached until its write time or size changes.
+class ShaderIncludeScanner final
+{
+public:
+	ShaderIncludeScanner() = default;
+	ShaderIncludeScanner(const ShaderIncludeScanner&) = delete;
+	ShaderIncludeScanner& operator=(const ShaderIncludeScanner&) = delete;
+	ShaderIncludeScanner(ShaderIncludeScanner&&) = default;
+	ShaderIncludeScanner& operator=(ShaderIncludeScanner&&) = default;
+	~ShaderIncludeScanner() = default;
+
+	// Appends the existing included files of the shader, each once. The shader itself isn't appended.
+	void AppendIncludedFiles(const char* pShaderFilePath, std::vector<std::string>& filePaths);
+
+	void Clear() { m_scannedFiles.clear(); }
+
+private:
+	struct ScannedFile
+	{
+		std::filesystem::file_time_type writeTime;
+		uintmax_t size;
+		std::vector<std::string> includedFilePaths;
+	};
+
+	const ScannedFile* Scan(const std::string& filePath);
+
+	std::unordered_map<std::string, ScannedFile> m_scannedFiles;
+};
+
+}
\ No newline at end of file
@@ -1,5 +1,6 @@
 ﻿#include "Inspector.h"
 
+#include "Core/FrameAllocator.h"
 #include "Graphics/GraphicsBackend.h"
 #include "ImGui/ImGuiUtils.hpp"
 #include "Path/Path.h"
@@ -104,8 +105,10 @@ void UpdateComponentWidget<engine::MaterialComponent>(engine::SceneWorld* pScene
 				ImGui::PushStyleVar(ImGuiStyleVar_FramePadding, ImVec2(2, 2));
 				ImGui::Separator();
 
-				std::string uvOffset = std::string(title) + std::string(" UVOffset");
-				std::string uvScale = std::string(title) + std::string(" UVScale");
+				engine::FrameString uvOffset(title);
+				uvOffset += " UVOffset";
+				engine::FrameString uvScale(title);
+				uvScale += " UVScale";
 				if (isOpen)
 				{
 					ImGuiUtils::ImGuiVectorProperty(uvOffset.c_str(), pTextureInfo->GetUVOffset());
@@ -150,6 +153,7 @@ void UpdateComponentWidget<engine::CameraComponent>(engine::SceneWorld* pSceneWo
 		ImGuiUtils::ImGuiBoolProperty("Constrain Aspect Ratio", pCameraComponent->GetDoConstrainAspectRatio());
 		ImGuiUtils::ImGuiBoolProperty("Post Processing", pCameraComponent->GetIsPostProcessEnable());
 		ImGuiUtils::ImGuiFloatProperty("Gamma Correction", pCameraComponent->GetGammaCorrection(), cd::Unit::None, 0.0f, 1.0f);
+		ImGuiUtils::ImGuiFloatProperty("Exposure (EV100)", pCameraComponent->GetExposure(), cd::Unit::None, -10.0f, 10.0f);
 	}
 
 	ImGui::Separator();
@@ -333,7 +337,8 @@ void UpdateComponentWidget<engine::SkyComponent>(engine::SceneWorld* pSceneWorld
 
 	if (isOpen)
 	{
-		std::vector<const char*> skyTypes;
+		engine::FrameVector<const char*> skyTypes;
+		skyTypes.reserve(static_cast<size_t>(engine::SkyType::Count));
 		for (size_t type = 0; type < static_cast<size_t>(engine::SkyType::Count); ++type)
 		{
 			if (!pSkyComponent->GetAtmophericScatteringEnable() && engine::SkyType::AtmosphericScattering == static_cast<engine::SkyType>(type))
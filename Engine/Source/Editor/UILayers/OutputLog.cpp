@@ -63,7 +63,20 @@ void OutputLog::AddLog(const char *fmt, ...) {
 void OutputLog::AddSpdLog(const std::ostringstream &oss, bool clearBuffer)
 {
 #ifdef SPDLOG_ENABLE
-    AddLog(oss.str().c_str());
+    // Most frames log nothing, so check the put position before copying the stream out.
+    if (oss.rdbuf()->pubseekoff(0, std::ios_base::cur, std::ios_base::out) <= 0) {
+        return;
+    }
+
+    // Appended as is : log text isn't a format string.
+    const std::string text = oss.str();
+    int old_size = m_buffer.size();
+    m_buffer.append(text.data(), text.data() + text.size());
+    for (int new_size = m_buffer.size(); old_size < new_size; old_size++) {
+        if (m_buffer[old_size] == '\n') {
+            m_lineOffsets.push_back(old_size + 1);
+        }
+    }
     if (clearBuffer) {
         engine::Log::ClearBuffer();
     }
@@ -325,8 +325,9 @@ void SceneView::Update()
 
 	if (nullptr == m_pRenderTarget)
 	{
-		constexpr engine::StringCrc sceneRenderTarget("SceneRenderTarget");
-		m_pRenderTarget = GetRenderContext()->GetRenderTarget(sceneRenderTarget);
+		// Display the post processed result. It follows the size of SceneRenderTarget.
+		constexpr engine::StringCrc postProcessRenderTarget("PostProcessRenderTarget");
+		m_pRenderTarget = GetRenderContext()->GetRenderTarget(postProcessRenderTarget);
 	}
 
 	ImGui::PushStyleVar(ImGuiStyleVar_WindowPadding, ImVec2(0.0f, 0.0f));
@@ -1,6 +1,8 @@
 ﻿#include "GameApp.h"
 
+#include "Animation/AnimationSystem.h"
 #include "Application/Engine.h"
+#include "Core/ThreadPool.h"
 #include "Display/CameraController.h"
 #include "ECWorld/SceneWorld.h"
 #include "ImGui/ImGuiContextInstance.h"
@@ -18,6 +20,7 @@
 #include "Rendering/PBRSkyRenderer.h"
 #include "Rendering/PostProcessRenderer.h"
 #include "Rendering/RenderContext.h"
+#include "Rendering/RenderThread.h"
 #include "Rendering/SkyboxRenderer.h"
 #include "Rendering/WorldRenderer.h"
 #include "Resources/ShaderLoader.h"
@@ -65,6 +68,19 @@ void GameApp::Init(engine::EngineInitArgs initArgs)
 
 void GameApp::Shutdown()
 {
+	if (m_pRenderThread)
+	{
+		m_pRenderThread->Wait();
+
+		const engine::RenderThread::Statistics& statistics = m_pRenderThread->GetStatistics();
+		if (statistics.frameCount > 0U)
+		{
+			double frameCount = static_cast<double>(statistics.frameCount);
+			CD_INFO("Render thread : {} frames, {} dropped, {:.3f} ms average wait, {:.3f} ms average record",
+				statistics.frameCount, statistics.droppedFrameCount,
+				statistics.totalWaitTime * 1000.0 / frameCount, statistics.totalRecordTime * 1000.0 / frameCount);
+		}
+	}
 }
 
 engine::Window* GameApp::GetWindow(size_t index) const
@@ -122,6 +138,11 @@ void GameApp::InitECWorld()
 {
 	m_pSceneWorld = std::make_unique<engine::SceneWorld>();
 
+	m_pThreadPool = std::make_unique<engine::ThreadPool>();
+	m_pAnimationSystem = std::make_unique<engine::AnimationSystem>(m_pThreadPool.get());
+	m_pAnimationSystem->SetSceneWorld(m_pSceneWorld.get());
+	m_pSceneWorld->SetRenderPacket(&m_renderPacket);
+
 	InitEditorCameraEntity();
 
 #ifdef ENABLE_DDGI
@@ -156,7 +177,9 @@ void GameApp::InitEditorCameraEntity()
 	cameraComponent.SetNearPlane(0.1f);
 	cameraComponent.SetFarPlane(2000.0f);
 	cameraComponent.SetNDCDepth(bgfx::getCaps()->homogeneousDepth ? cd::NDCDepth::MinusOneToOne : cd::NDCDepth::ZeroToOne);
+	cameraComponent.SetPostProcessEnable(true);
 	cameraComponent.SetGammaCorrection(0.45f);
+	cameraComponent.SetExposure(0.0f);
 	cameraComponent.BuildProjectMatrix();
 	cameraComponent.BuildViewMatrix(cameraTransform);
 }
@@ -221,7 +244,6 @@ void GameApp::InitEngineRenderers()
 {
 	constexpr engine::StringCrc sceneViewRenderTargetName("SceneRenderTarget");
 	std::vector<engine::AttachmentDescriptor> attachmentDesc = {
-		{.textureFormat = engine::TextureFormat::RGBA32F },
 		{.textureFormat = engine::TextureFormat::RGBA32F },
 		{.textureFormat = engine::TextureFormat::D32F },
 	};
@@ -268,12 +290,18 @@ void GameApp::InitEngineRenderers()
 	// But postprocess will bring unnecessary confusion. 
 	auto pPostProcessRenderer = std::make_unique<engine::PostProcessRenderer>(m_pRenderContext->CreateView());
 	pPostProcessRenderer->SetSceneWorld(m_pSceneWorld.get());
-	pPostProcessRenderer->SetEnable(true);
 	AddEngineRenderer(cd::MoveTemp(pPostProcessRenderer));
 
 
 	// Note that if you don't want to use ImGuiRenderer for engine, you should also disable EngineImGuiContext.
-	AddEngineRenderer(std::make_unique<engine::ImGuiRenderer>(m_pRenderContext->CreateView()));
+	auto pImGuiRenderer = std::make_unique<engine::ImGuiRenderer>(m_pRenderContext->CreateView());
+	m_pImGuiRenderer = pImGuiRenderer.get();
+	AddEngineRenderer(cd::MoveTemp(pImGuiRenderer));
+
+	if (m_initArgs.useRenderThread)
+	{
+		m_pRenderThread = std::make_unique<engine::RenderThread>();
+	}
 }
 
 bool GameApp::IsAtmosphericScatteringEnable() const
@@ -299,10 +327,54 @@ void GameApp::AddEngineRenderer(std::unique_ptr<engine::Renderer> pRenderer)
 	m_pEngineRenderers.emplace_back(cd::MoveTemp(pRenderer));
 }
 
+void GameApp::FixedUpdate(float fixedDeltaTime)
+{
+	if (!m_bInitEditor)
+	{
+		return;
+	}
+
+	// Overlaps with the recorded frame, which only reads the published frame of the packet.
+	m_pAnimationSystem->Update(fixedDeltaTime);
+	m_renderPacket.Extract(*m_pSceneWorld);
+}
+
+void GameApp::FinishRenderFrame()
+{
+	// Scene draw calls of the last frame are recorded on the render thread. They have to be finished
+	// before bgfx::frame and before anything they read changes : window events, UI edits, renderer
+	// preparation and the next Publish.
+	if (!m_pRenderThread || !m_pRenderThread->IsFrameInFlight())
+	{
+		return;
+	}
+
+	m_pRenderThread->Wait();
+
+	// UI draw data is still the one built together with the recorded frame.
+	if (m_pImGuiRenderer->IsEnable())
+	{
+		m_pImGuiRenderer->Render(m_recordedDeltaTime);
+	}
+	m_pRenderContext->EndFrame();
+}
+
+void GameApp::RenderSceneRenderers(float deltaTime)
+{
+	for (std::unique_ptr<engine::Renderer>& pRenderer : m_pEngineRenderers)
+	{
+		if (pRenderer->IsEnable() && pRenderer.get() != m_pImGuiRenderer)
+		{
+			pRenderer->Render(deltaTime);
+		}
+	}
+}
+
 bool GameApp::Update(float deltaTime)
 {
 	// TODO : it is better to remove these logics about splash -> editor switch here.
 	// Better implementation is to have multiple Application or Window classes and they can switch.
+	bool wasEditorInitialized = m_bInitEditor;
 	if (!m_bInitEditor)
 	{
 		m_bInitEditor = true;
@@ -336,14 +408,18 @@ bool GameApp::Update(float deltaTime)
 
 		InitEngineUILayers();
 	}
-	else
+
+	// Like the fixed steps before it, this overlaps with the recorded frame.
+	if (wasEditorInitialized && m_pCameraController)
 	{
-		if (m_pCameraController)
-		{
-			m_pCameraController->Update(deltaTime);
-		}
+		m_pCameraController->Update(deltaTime);
 	}
 
+	// Renderers draw the simulation state between the last two fixed steps.
+	m_renderPacket.Interpolate(GetEngine()->GetClock().GetInterpolationAlpha());
+
+	FinishRenderFrame();
+
 	GetMainWindow()->Update();
 	m_pSceneWorld->Update();
 
@@ -355,19 +431,42 @@ bool GameApp::Update(float deltaTime)
 	if (m_pEngineImGuiContext)
 	{
 		m_pEngineImGuiContext->Update(deltaTime);
+
+		m_renderPacket.Publish(*m_pSceneWorld);
+
+		// Views, resources and scene mutations are handled on the API thread, only draw calls go to the render thread.
+		const engine::RenderCamera* pCamera = m_renderPacket.GetCamera();
+		assert(pCamera);
+		const float* pViewMatrix = pCamera->viewMatrix.Begin();
+		const float* pProjectionMatrix = pCamera->projectionMatrix.Begin();
 		for (std::unique_ptr<engine::Renderer>& pRenderer : m_pEngineRenderers)
 		{
 			if (pRenderer->IsEnable())
 			{
-				const float* pViewMatrix = pMainCameraComponent->GetViewMatrix().Begin();
-				const float* pProjectionMatrix = pMainCameraComponent->GetProjectionMatrix().Begin();
 				pRenderer->UpdateView(pViewMatrix, pProjectionMatrix);
-				pRenderer->Render(deltaTime);
+				pRenderer->Prepare();
+			}
+		}
+
+		if (m_pRenderThread)
+		{
+			m_recordedDeltaTime = deltaTime;
+			m_pRenderThread->Kick([this, deltaTime]() { RenderSceneRenderers(deltaTime); });
+		}
+		else
+		{
+			RenderSceneRenderers(deltaTime);
+			if (m_pImGuiRenderer->IsEnable())
+			{
+				m_pImGuiRenderer->Render(deltaTime);
 			}
 		}
 	}
 
-	m_pRenderContext->EndFrame();
+	if (!m_pRenderThread || !m_pRenderThread->IsFrameInFlight())
+	{
+		m_pRenderContext->EndFrame();
+	}
 
 	engine::Input::Get().FlushInputs();
 
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Application/IApplication.h"
+#include "Rendering/RenderPacket.h"
 
 #include <memory>
 #include <vector>
@@ -8,6 +9,7 @@
 namespace engine
 {
 
+class AnimationSystem;
 class CameraController;
 class FlybyCamera;
 class ImGuiBaseLayer;
@@ -15,8 +17,10 @@ class ImGuiContextInstance;
 class Window;
 class RenderContext;
 class Renderer;
+class RenderThread;
 class RenderTarget;
 class SceneWorld;
+class ThreadPool;
 
 }
 
@@ -39,6 +43,7 @@ public:
 	virtual ~GameApp();
 
 	virtual void Init(engine::EngineInitArgs initArgs) override;
+	virtual void FixedUpdate(float fixedDeltaTime) override;
 	virtual bool Update(float deltaTime) override;
 	virtual void Shutdown() override;
 
@@ -61,6 +66,8 @@ public:
 	bool IsAtmosphericScatteringEnable() const;
 
 private:
+	void RenderSceneRenderers(float deltaTime);
+	void FinishRenderFrame();
 	void InitEditorCameraEntity();
 #ifdef ENABLE_DDGI
 	void InitDDGIEntity();
@@ -78,10 +85,14 @@ private:
 
 	// Scene
 	std::unique_ptr<engine::SceneWorld> m_pSceneWorld;
+	std::unique_ptr<engine::ThreadPool> m_pThreadPool;
+	std::unique_ptr<engine::AnimationSystem> m_pAnimationSystem;
+	engine::RenderPacket m_renderPacket;
 	engine::Renderer* m_pSceneRenderer = nullptr;
 	engine::Renderer* m_pDebugRenderer = nullptr;
 	engine::Renderer* m_pPBRSkyRenderer = nullptr;
 	engine::Renderer* m_pIBLSkyRenderer = nullptr;
+	engine::Renderer* m_pImGuiRenderer = nullptr;
 
 	// Rendering
 	std::unique_ptr<engine::RenderContext> m_pRenderContext;
@@ -89,6 +100,10 @@ private:
 
 	// Controllers for processing input events.
 	std::unique_ptr<engine::CameraController> m_pCameraController;
+
+	// Declared last so that the frame in flight finishes before anything it reads is destroyed.
+	std::unique_ptr<engine::RenderThread> m_pRenderThread;
+	float m_recordedDeltaTime = 0.0f;
 };
 
 }
\ No newline at end of file
@@ -0,0 +1,154 @@
+#include "AnimationEvaluator.h"
+
+#include "Animation/CompressedClip.h"
+#include "Animation/SkeletonBinding.h"
+#include "Math/Transform.hpp"
+#include "Scene/SceneDatabase.h"
+
+#include <cassert>
+
+namespace engine
+{
+
+namespace
+{
+
+// Samples close to the previous one are found by stepping the cursor. Anything further is a seek.
+constexpr uint32_t maxCursorSteps = 4U;
+
+// Returns the index of the last key whose time is not greater than time, or 0 before the first key.
+template<typename Keys>
+uint32_t SeekKey(const Keys& keys, uint32_t keyCount, float time, uint32_t cursor)
+{
+	if (cursor < keyCount && keys[cursor].GetTime() <= time)
+	{
+		for (uint32_t step = 0U; step < maxCursorSteps; ++step)
+		{
+			if (cursor + 1U >= keyCount || time < keys[cursor + 1U].GetTime())
+			{
+				return cursor;
+			}
+			++cursor;
+		}
+	}
+
+	// Jumped backwards or too far, for example when the clip loops.
+	uint32_t first = 0U;
+	uint32_t count = keyCount;
+	while (count > 0U)
+	{
+		uint32_t half = count / 2U;
+		if (keys[first + half].GetTime() <= time)
+		{
+			first += half + 1U;
+			count -= half + 1U;
+		}
+		else
+		{
+			count = half;
+		}
+	}
+
+	return first > 0U ? first - 1U : 0U;
+}
+
+template<typename Value, typename Keys, typename Interpolate>
+Value SampleKeys(const Keys& keys, uint32_t keyCount, float time, uint32_t& cursor, const Value& defaultValue, Interpolate interpolate)
+{
+	if (0U == keyCount)
+	{
+		return defaultValue;
+	}
+
+	cursor = SeekKey(keys, keyCount, time, cursor);
+	const auto& currentKey = keys[cursor];
+	if (cursor + 1U >= keyCount || time <= currentKey.GetTime())
+	{
+		return currentKey.GetValue();
+	}
+
+	const auto& nextKey = keys[cursor + 1U];
+	float keyFrameRate = (time - currentKey.GetTime()) / (nextKey.GetTime() - currentKey.GetTime());
+	assert(keyFrameRate >= 0.0f && keyFrameRate <= 1.0f);
+	return interpolate(currentKey.GetValue(), nextKey.GetValue(), keyFrameRate);
+}
+
+void ResizePoseBuffers(const SkeletonBinding& binding, std::vector<cd::Matrix4x4>& globalTransforms, std::vector<cd::Matrix4x4>& palette)
+{
+	globalTransforms.resize(binding.GetBoneCount(), cd::Matrix4x4::Identity());
+	if (palette.size() < binding.GetPaletteSize())
+	{
+		palette.resize(binding.GetPaletteSize(), cd::Matrix4x4::Identity());
+	}
+}
+
+// Parents are stored before children so their global transforms are always ready.
+void AccumulateBone(const SkeletonBinding& binding, uint32_t boneIndex, const cd::Matrix4x4& localTransform, const cd::Matrix4x4& globalInverse,
+	std::vector<cd::Matrix4x4>& globalTransforms, std::vector<cd::Matrix4x4>& palette)
+{
+	uint32_t parentIndex = binding.GetParentIndices()[boneIndex];
+	globalTransforms[boneIndex] = SkeletonBinding::InvalidIndex == parentIndex ? localTransform : globalTransforms[parentIndex] * localTransform;
+	palette[binding.GetPaletteIndices()[boneIndex]] = globalInverse * globalTransforms[boneIndex] * binding.GetOffsetMatrices()[boneIndex];
+}
+
+}
+
+void EvaluateSkeletonPose(const SkeletonBinding& binding, const cd::Track* pTracks, float animationTime, const cd::Matrix4x4& globalInverse,
+	std::vector<KeyframeCursor>& cursors, std::vector<cd::Matrix4x4>& globalTransforms, std::vector<cd::Matrix4x4>& palette)
+{
+	const uint32_t boneCount = binding.GetBoneCount();
+	cursors.resize(boneCount);
+	ResizePoseBuffers(binding, globalTransforms, palette);
+
+	const std::vector<uint32_t>& trackIndices = binding.GetTrackIndices();
+	const std::vector<cd::Matrix4x4>& bindPoseTransforms = binding.GetBindPoseTransforms();
+
+	auto LerpVec3f = [](const cd::Vec3f& a, const cd::Vec3f& b, float t) { return cd::Vec3f::Lerp(a, b, t); };
+	auto NlerpQuaternion = [](const cd::Quaternion& a, const cd::Quaternion& b, float t) { return cd::Quaternion::Lerp(a, b, t).Normalize(); };
+
+	for (uint32_t boneIndex = 0U; boneIndex < boneCount; ++boneIndex)
+	{
+		cd::Matrix4x4 localTransform = bindPoseTransforms[boneIndex];
+		if (uint32_t trackIndex = trackIndices[boneIndex]; SkeletonBinding::InvalidIndex != trackIndex)
+		{
+			const cd::Track& track = pTracks[trackIndex];
+			KeyframeCursor& cursor = cursors[boneIndex];
+			cd::Vec3f translation = SampleKeys(track.GetTranslationKeys(), track.GetTranslationKeyCount(), animationTime,
+				cursor.translationKey, cd::Vec3f::Zero(), LerpVec3f);
+			cd::Quaternion rotation = SampleKeys(track.GetRotationKeys(), track.GetRotationKeyCount(), animationTime,
+				cursor.rotationKey, cd::Quaternion::Identity(), NlerpQuaternion);
+			cd::Vec3f scale = SampleKeys(track.GetScaleKeys(), track.GetScaleKeyCount(), animationTime,
+				cursor.scaleKey, cd::Vec3f::One(), LerpVec3f);
+			localTransform = cd::Transform(translation, rotation, scale).GetMatrix();
+		}
+
+		AccumulateBone(binding, boneIndex, localTransform, globalInverse, globalTransforms, palette);
+	}
+}
+
+void EvaluateSkeletonPose(const SkeletonBinding& binding, const CompressedClip& clip, float animationTime, const cd::Matrix4x4& globalInverse,
+	std::vector<KeyframeCursor>& cursors, std::vector<cd::Matrix4x4>& globalTransforms, std::vector<cd::Matrix4x4>& palette)
+{
+	// Decode scratch only lives for one call, so one buffer per thread is enough.
+	thread_local LocalPose pose;
+	clip.SampleLocalPose(animationTime, cursors, pose);
+	ResizePoseBuffers(binding, globalTransforms, palette);
+
+	const std::vector<uint32_t>& animatedSlots = clip.GetAnimatedSlots();
+	const std::vector<cd::Matrix4x4>& bindPoseTransforms = binding.GetBindPoseTransforms();
+	for (uint32_t boneIndex = 0U; boneIndex < binding.GetBoneCount(); ++boneIndex)
+	{
+		cd::Matrix4x4 localTransform = bindPoseTransforms[boneIndex];
+		if (uint32_t slot = animatedSlots[boneIndex]; CompressedClip::InvalidIndex != slot)
+		{
+			cd::Vec3f translation(pose.translationX[slot], pose.translationY[slot], pose.translationZ[slot]);
+			cd::Quaternion rotation(pose.rotationX[slot], pose.rotationY[slot], pose.rotationZ[slot], pose.rotationW[slot]);
+			cd::Vec3f scale(pose.scaleX[slot], pose.scaleY[slot], pose.scaleZ[slot]);
+			localTransform = cd::Transform(translation, rotation, scale).GetMatrix();
+		}
+
+		AccumulateBone(binding, boneIndex, localTransform, globalInverse, globalTransforms, palette);
+	}
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,39 @@
+#pragma once
+
+#include "Math/Matrix.hpp"
+
+#include <cstdint>
+#include <vector>
+
+namespace cd
+{
+
+class Track;
+
+}
+
+namespace engine
+{
+
+class CompressedClip;
+class SkeletonBinding;
+
+// Per bone key positions of one animation instance. They are carried between frames so that
+// sampling close to the previous time only steps a few keys forward.
+struct KeyframeCursor
+{
+	uint32_t translationKey = 0U;
+	uint32_t rotationKey = 0U;
+	uint32_t scaleKey = 0U;
+};
+
+// Samples the bound tracks at animationTime in ticks and writes skinning matrices to the palette.
+// Cursors and global transforms are per instance scratch which is resized on demand.
+void EvaluateSkeletonPose(const SkeletonBinding& binding, const cd::Track* pTracks, float animationTime, const cd::Matrix4x4& globalInverse,
+	std::vector<KeyframeCursor>& cursors, std::vector<cd::Matrix4x4>& globalTransforms, std::vector<cd::Matrix4x4>& palette);
+
+// Same as above but samples a compressed clip. Cursors are indexed by the animated slots of the clip.
+void EvaluateSkeletonPose(const SkeletonBinding& binding, const CompressedClip& clip, float animationTime, const cd::Matrix4x4& globalInverse,
+	std::vector<KeyframeCursor>& cursors, std::vector<cd::Matrix4x4>& globalTransforms, std::vector<cd::Matrix4x4>& palette);
+
+}
\ No newline at end of file
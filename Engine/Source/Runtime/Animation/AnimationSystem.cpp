@@ -0,0 +1,106 @@
+#include "AnimationSystem.h"
+
+#include "Animation/AnimationEvaluator.h"
+#include "Core/ThreadPool.h"
+#include "ECWorld/SceneWorld.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+namespace engine
+{
+
+namespace
+{
+
+// A skeleton takes a few microseconds so smaller batches only add scheduling overhead.
+constexpr uint32_t instanceBatchSize = 8U;
+
+void UpdateInstance(AnimationComponent& animationComponent, const TransformComponent& transformComponent, const cd::Track* pTracks, float deltaTime)
+{
+	const cd::Animation* pAnimation = animationComponent.GetAnimationData();
+	float ticksPerSecond = pAnimation->GetTicksPerSecnod();
+	assert(ticksPerSecond > 1.0f);
+	float durationSeconds = pAnimation->GetDuration() / ticksPerSecond;
+
+	float playTime = animationComponent.GetPlayTime();
+	if (animationComponent.IsPlaying())
+	{
+		playTime += deltaTime * animationComponent.GetPlaybackSpeed();
+	}
+
+	// Wrap the stored time too so that long running loops don't lose precision.
+	if (animationComponent.IsLooping() && durationSeconds > 0.0f)
+	{
+		playTime = std::fmod(playTime, durationSeconds);
+		if (playTime < 0.0f)
+		{
+			playTime += durationSeconds;
+		}
+	}
+	else
+	{
+		playTime = std::clamp(playTime, 0.0f, durationSeconds);
+	}
+	animationComponent.SetPlayTime(playTime);
+
+	const SkeletonBinding& skeletonBinding = *animationComponent.GetSkeletonBinding();
+	cd::Matrix4x4 globalInverse = transformComponent.GetWorldMatrix().Inverse();
+	if (const CompressedClip* pCompressedClip = animationComponent.GetCompressedClip())
+	{
+		EvaluateSkeletonPose(skeletonBinding, *pCompressedClip, playTime * ticksPerSecond, globalInverse,
+			animationComponent.GetKeyframeCursors(), animationComponent.GetGlobalBoneTransforms(), animationComponent.GetBoneMatrices());
+	}
+	else
+	{
+		EvaluateSkeletonPose(skeletonBinding, pTracks, playTime * ticksPerSecond, globalInverse,
+			animationComponent.GetKeyframeCursors(), animationComponent.GetGlobalBoneTransforms(), animationComponent.GetBoneMatrices());
+	}
+}
+
+}
+
+AnimationSystem::AnimationSystem(ThreadPool* pThreadPool)
+	: m_pThreadPool(pThreadPool)
+{
+}
+
+void AnimationSystem::Update(float deltaTime)
+{
+	m_instances.clear();
+	for (Entity entity : m_pCurrentSceneWorld->GetAnimationEntities())
+	{
+		AnimationComponent* pAnimationComponent = m_pCurrentSceneWorld->GetAnimationComponent(entity);
+		const TransformComponent* pTransformComponent = m_pCurrentSceneWorld->GetTransformComponent(entity);
+		if (!pAnimationComponent || !pTransformComponent ||
+			!pAnimationComponent->GetAnimationData() || !pAnimationComponent->GetSkeletonBinding())
+		{
+			continue;
+		}
+
+		m_instances.push_back({ pAnimationComponent, pTransformComponent });
+	}
+
+	const cd::Track* pTracks = m_pCurrentSceneWorld->GetSceneDatabase()->GetTracks().data();
+	auto UpdateInstances = [this, pTracks, deltaTime](uint32_t begin, uint32_t end)
+	{
+		for (uint32_t instanceIndex = begin; instanceIndex < end; ++instanceIndex)
+		{
+			const Instance& instance = m_instances[instanceIndex];
+			UpdateInstance(*instance.pAnimationComponent, *instance.pTransformComponent, pTracks, deltaTime);
+		}
+	};
+
+	uint32_t instanceCount = GetInstanceCount();
+	if (m_pThreadPool)
+	{
+		m_pThreadPool->ParallelFor(instanceCount, instanceBatchSize, UpdateInstances);
+	}
+	else
+	{
+		UpdateInstances(0U, instanceCount);
+	}
+}
+
+}
\ No newline at end of file
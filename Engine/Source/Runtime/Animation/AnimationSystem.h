@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace engine
+{
+
+class AnimationComponent;
+class SceneWorld;
+class ThreadPool;
+class TransformComponent;
+
+// Advances the playback state of every AnimationComponent and evaluates its skinning palette.
+// Instances are independent so they are spread over the thread pool. Renderers only upload the
+// palettes, so Update has to run before them every frame.
+class AnimationSystem final
+{
+public:
+	explicit AnimationSystem(ThreadPool* pThreadPool = nullptr);
+	AnimationSystem(const AnimationSystem&) = delete;
+	AnimationSystem& operator=(const AnimationSystem&) = delete;
+	AnimationSystem(AnimationSystem&&) = default;
+	AnimationSystem& operator=(AnimationSystem&&) = default;
+	~AnimationSystem() = default;
+
+	void SetSceneWorld(SceneWorld* pSceneWorld) { m_pCurrentSceneWorld = pSceneWorld; }
+
+	void Update(float deltaTime);
+
+	// Number of instances evaluated by the last Update.
+	uint32_t GetInstanceCount() const { return static_cast<uint32_t>(m_instances.size()); }
+
+private:
+	struct Instance
+	{
+		AnimationComponent* pAnimationComponent;
+		const TransformComponent* pTransformComponent;
+	};
+
+	SceneWorld* m_pCurrentSceneWorld = nullptr;
+	ThreadPool* m_pThreadPool = nullptr;
+
+	// Component pointers are resolved serially so that jobs never touch the component storages.
+	std::vector<Instance> m_instances;
+};
+
+}
\ No newline at end of file
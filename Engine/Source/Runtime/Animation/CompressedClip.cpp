@@ -0,0 +1,461 @@
+#include "CompressedClip.h"
+
+#include "Animation/AnimationEvaluator.h"
+#include "Animation/SkeletonBinding.h"
+#include "Scene/SceneDatabase.h"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cmath>
+
+namespace engine
+{
+
+namespace
+{
+
+// Same stepping as AnimationEvaluator : follow the cursor for a few keys, then seek.
+constexpr uint32_t maxCursorSteps = 4U;
+
+constexpr float quantizedRange = 65535.0f;
+
+// Smallest three keeps 15 bits for each of the three smaller components which all lie in [-1/sqrt(2), 1/sqrt(2)].
+constexpr uint32_t smallestThreeBits = 15U;
+constexpr float smallestThreeMax = static_cast<float>((1U << smallestThreeBits) - 1U);
+constexpr float smallestThreeBound = 0.70710678f;
+
+using Quaternion4 = std::array<float, 4>;
+
+float Distance(const cd::Vec3f& a, const cd::Vec3f& b)
+{
+	float x = a.x() - b.x();
+	float y = a.y() - b.y();
+	float z = a.z() - b.z();
+	return std::sqrt(x * x + y * y + z * z);
+}
+
+cd::Vec3f Lerp(const cd::Vec3f& a, const cd::Vec3f& b, float t)
+{
+	return cd::Vec3f(a.x() + (b.x() - a.x()) * t, a.y() + (b.y() - a.y()) * t, a.z() + (b.z() - a.z()) * t);
+}
+
+float Dot(const Quaternion4& a, const Quaternion4& b)
+{
+	return a[0] * b[0] + a[1] * b[1] + a[2] * b[2] + a[3] * b[3];
+}
+
+// Normalized lerp on the shortest arc.
+Quaternion4 Nlerp(const Quaternion4& a, const Quaternion4& b, float t)
+{
+	float sign = Dot(a, b) < 0.0f ? -1.0f : 1.0f;
+	Quaternion4 result;
+	float lengthSquared = 0.0f;
+	for (uint32_t component = 0U; component < 4U; ++component)
+	{
+		result[component] = a[component] + (b[component] * sign - a[component]) * t;
+		lengthSquared += result[component] * result[component];
+	}
+
+	float inverseLength = 1.0f / std::sqrt(lengthSquared);
+	for (float& value : result)
+	{
+		value *= inverseLength;
+	}
+	return result;
+}
+
+// Rotation angle between two unit quaternions. It goes through the chord length because acos of a dot
+// product close to one has no precision left for the small angles which key reduction compares.
+float AngleBetween(const Quaternion4& a, const Quaternion4& b)
+{
+	float sign = Dot(a, b) < 0.0f ? -1.0f : 1.0f;
+	float chordSquared = 0.0f;
+	for (uint32_t component = 0U; component < 4U; ++component)
+	{
+		float difference = a[component] - b[component] * sign;
+		chordSquared += difference * difference;
+	}
+	return 4.0f * std::asin(std::min(std::sqrt(chordSquared) * 0.5f, 1.0f));
+}
+
+void EncodeSmallestThree(const Quaternion4& quaternion, uint16_t* pOutput)
+{
+	uint32_t largestIndex = 0U;
+	for (uint32_t component = 1U; component < 4U; ++component)
+	{
+		if (std::abs(quaternion[component]) > std::abs(quaternion[largestIndex]))
+		{
+			largestIndex = component;
+		}
+	}
+
+	// q and -q are the same rotation, so the dropped component can always be rebuilt as positive.
+	float sign = quaternion[largestIndex] < 0.0f ? -1.0f : 1.0f;
+	uint64_t bits = largestIndex;
+	for (uint32_t component = 0U; component < 4U; ++component)
+	{
+		if (component == largestIndex)
+		{
+			continue;
+		}
+
+		float normalized = std::clamp(quaternion[component] * sign / smallestThreeBound * 0.5f + 0.5f, 0.0f, 1.0f);
+		bits = (bits << smallestThreeBits) | static_cast<uint64_t>(std::lround(normalized * smallestThreeMax));
+	}
+
+	pOutput[0] = static_cast<uint16_t>(bits >> 32U);
+	pOutput[1] = static_cast<uint16_t>(bits >> 16U);
+	pOutput[2] = static_cast<uint16_t>(bits);
+}
+
+Quaternion4 DecodeSmallestThree(const uint16_t* pInput)
+{
+	uint64_t bits = (static_cast<uint64_t>(pInput[0]) << 32U) | (static_cast<uint64_t>(pInput[1]) << 16U) | static_cast<uint64_t>(pInput[2]);
+	uint32_t largestIndex = static_cast<uint32_t>(bits >> (smallestThreeBits * 3U)) & 3U;
+
+	constexpr uint64_t componentMask = (1U << smallestThreeBits) - 1U;
+	constexpr float scale = 2.0f * smallestThreeBound / smallestThreeMax;
+	float a = static_cast<float>((bits >> (smallestThreeBits * 2U)) & componentMask) * scale - smallestThreeBound;
+	float b = static_cast<float>((bits >> smallestThreeBits) & componentMask) * scale - smallestThreeBound;
+	float c = static_cast<float>(bits & componentMask) * scale - smallestThreeBound;
+	float largest = std::sqrt(std::max(1.0f - a * a - b * b - c * c, 0.0f));
+
+	// Components were written in order with the largest one skipped.
+	static constexpr uint32_t smallerIndices[4][3] = { { 1, 2, 3 }, { 0, 2, 3 }, { 0, 1, 3 }, { 0, 1, 2 } };
+	Quaternion4 quaternion;
+	quaternion[largestIndex] = largest;
+	quaternion[smallerIndices[largestIndex][0]] = a;
+	quaternion[smallerIndices[largestIndex][1]] = b;
+	quaternion[smallerIndices[largestIndex][2]] = c;
+	return quaternion;
+}
+
+// Greedy reduction : every kept key is followed by the furthest key that still lets linear interpolation
+// reproduce all skipped keys. The first and last keys are always kept, and a constant channel keeps only one.
+template<typename Value, typename Interpolate, typename Error>
+std::vector<uint32_t> ReduceKeys(const std::vector<float>& times, const std::vector<Value>& values, float tolerance, Interpolate interpolate, Error error)
+{
+	const uint32_t keyCount = static_cast<uint32_t>(times.size());
+	auto IsReproduced = [&](uint32_t first, uint32_t last)
+	{
+		float duration = times[last] - times[first];
+		for (uint32_t keyIndex = first + 1U; keyIndex < last; ++keyIndex)
+		{
+			float t = duration > 0.0f ? (times[keyIndex] - times[first]) / duration : 0.0f;
+			if (error(interpolate(values[first], values[last], t), values[keyIndex]) > tolerance)
+			{
+				return false;
+			}
+		}
+		return true;
+	};
+
+	std::vector<uint32_t> keptKeys;
+	keptKeys.push_back(0U);
+	uint32_t anchor = 0U;
+	while (anchor + 1U < keyCount)
+	{
+		uint32_t end = anchor + 1U;
+		while (end + 1U < keyCount && IsReproduced(anchor, end + 1U))
+		{
+			++end;
+		}
+		keptKeys.push_back(end);
+		anchor = end;
+	}
+
+	if (2U == keptKeys.size() && error(values[0], values[keyCount - 1U]) <= tolerance)
+	{
+		keptKeys.pop_back();
+	}
+
+	return keptKeys;
+}
+
+template<typename Keys>
+void GatherVectorKeys(const Keys& keys, uint32_t keyCount, const cd::Vec3f& defaultValue, std::vector<float>& times, std::vector<cd::Vec3f>& values)
+{
+	times.clear();
+	values.clear();
+	for (uint32_t keyIndex = 0U; keyIndex < keyCount; ++keyIndex)
+	{
+		times.push_back(keys[keyIndex].GetTime());
+		values.push_back(keys[keyIndex].GetValue());
+	}
+
+	// An empty channel samples as its default value, which keeps decoding free of special cases.
+	if (times.empty())
+	{
+		times.push_back(0.0f);
+		values.push_back(defaultValue);
+	}
+}
+
+uint32_t SeekTime(const float* pTimes, uint32_t keyCount, float time, uint32_t cursor)
+{
+	if (cursor < keyCount && pTimes[cursor] <= time)
+	{
+		for (uint32_t step = 0U; step < maxCursorSteps; ++step)
+		{
+			if (cursor + 1U >= keyCount || time < pTimes[cursor + 1U])
+			{
+				return cursor;
+			}
+			++cursor;
+		}
+	}
+
+	const float* pKey = std::upper_bound(pTimes, pTimes + keyCount, time);
+	return pKey != pTimes ? static_cast<uint32_t>(pKey - pTimes) - 1U : 0U;
+}
+
+}
+
+void LocalPose::Resize(uint32_t boneCount)
+{
+	for (std::vector<float>* pComponent : { &translationX, &translationY, &translationZ, &rotationX, &rotationY, &rotationZ, &rotationW,
+		&scaleX, &scaleY, &scaleZ, &weights })
+	{
+		pComponent->resize(boneCount);
+	}
+	firstKeys.resize(boneCount);
+	secondKeys.resize(boneCount);
+}
+
+size_t CompressedClip::GetUncompressedMemorySize(const SkeletonBinding& binding, const cd::Track* pTracks)
+{
+	size_t memorySize = 0U;
+	for (uint32_t trackIndex : binding.GetTrackIndices())
+	{
+		if (SkeletonBinding::InvalidIndex == trackIndex)
+		{
+			continue;
+		}
+
+		const cd::Track& track = pTracks[trackIndex];
+		memorySize += track.GetTranslationKeyCount() * sizeof(cd::TranslationKey);
+		memorySize += track.GetRotationKeyCount() * sizeof(cd::RotationKey);
+		memorySize += track.GetScaleKeyCount() * sizeof(cd::ScaleKey);
+	}
+
+	return memorySize;
+}
+
+CompressedClip::CompressedClip(const SkeletonBinding& binding, const cd::Track* pTracks, const ClipCompressionSettings& settings)
+{
+	const uint32_t boneCount = binding.GetBoneCount();
+	const std::vector<uint32_t>& parentIndices = binding.GetParentIndices();
+	const std::vector<uint32_t>& trackIndices = binding.GetTrackIndices();
+	const std::vector<cd::Matrix4x4>& bindPoseTransforms = binding.GetBindPoseTransforms();
+
+	// Rotation and scale errors move descendants proportionally to their distance, so the budget of a bone
+	// is divided by the length of its longest chain in bind pose. Children come after parents so walk backwards.
+	std::vector<float> chainLengths(boneCount, 0.0f);
+	for (uint32_t boneIndex = boneCount; boneIndex-- > 0U;)
+	{
+		if (uint32_t parentIndex = parentIndices[boneIndex]; SkeletonBinding::InvalidIndex != parentIndex)
+		{
+			float chainLength = bindPoseTransforms[boneIndex].GetTranslation().Length() + chainLengths[boneIndex];
+			chainLengths[parentIndex] = std::max(chainLengths[parentIndex], chainLength);
+		}
+	}
+
+	std::vector<float> times;
+	std::vector<cd::Vec3f> vectorValues;
+	std::vector<Quaternion4> rotationValues;
+
+	auto AddVectorChannel = [&](VectorChannels& vectorChannels, float tolerance)
+	{
+		std::vector<uint32_t> keptKeys = ReduceKeys(times, vectorValues, tolerance, Lerp, Distance);
+
+		cd::Vec3f minValue = vectorValues[keptKeys[0]];
+		cd::Vec3f maxValue = minValue;
+		for (uint32_t keyIndex : keptKeys)
+		{
+			const cd::Vec3f& value = vectorValues[keyIndex];
+			minValue = cd::Vec3f(std::min(minValue.x(), value.x()), std::min(minValue.y(), value.y()), std::min(minValue.z(), value.z()));
+			maxValue = cd::Vec3f(std::max(maxValue.x(), value.x()), std::max(maxValue.y(), value.y()), std::max(maxValue.z(), value.z()));
+		}
+
+		// Ranges store the minimum followed by the size of one quantization step.
+		std::array<float, 6> range = { minValue.x(), minValue.y(), minValue.z(),
+			(maxValue.x() - minValue.x()) / quantizedRange, (maxValue.y() - minValue.y()) / quantizedRange, (maxValue.z() - minValue.z()) / quantizedRange };
+		vectorChannels.ranges.insert(vectorChannels.ranges.end(), range.begin(), range.end());
+		vectorChannels.channels.push_back({ static_cast<uint32_t>(vectorChannels.times.size()), static_cast<uint32_t>(keptKeys.size()) });
+
+		for (uint32_t keyIndex : keptKeys)
+		{
+			const cd::Vec3f& value = vectorValues[keyIndex];
+			vectorChannels.times.push_back(times[keyIndex]);
+			for (uint32_t component = 0U; component < 3U; ++component)
+			{
+				float step = range[component + 3U];
+				float quantized = step > 0.0f ? (value[component] - range[component]) / step : 0.0f;
+				vectorChannels.values.push_back(static_cast<uint16_t>(std::lround(std::clamp(quantized, 0.0f, quantizedRange))));
+			}
+		}
+	};
+
+	auto AddRotationChannel = [&](const cd::Track& track, float tolerance)
+	{
+		times.clear();
+		rotationValues.clear();
+		for (uint32_t keyIndex = 0U; keyIndex < track.GetRotationKeyCount(); ++keyIndex)
+		{
+			const cd::RotationKey& key = track.GetRotationKeys()[keyIndex];
+			const cd::Quaternion& rotation = key.GetValue();
+			times.push_back(key.GetTime());
+			rotationValues.push_back({ rotation.x(), rotation.y(), rotation.z(), rotation.w() });
+		}
+
+		if (times.empty())
+		{
+			times.push_back(0.0f);
+			rotationValues.push_back({ 0.0f, 0.0f, 0.0f, 1.0f });
+		}
+
+		std::vector<uint32_t> keptKeys = ReduceKeys(times, rotationValues, tolerance, Nlerp, AngleBetween);
+		m_rotations.channels.push_back({ static_cast<uint32_t>(m_rotations.times.size()), static_cast<uint32_t>(keptKeys.size()) });
+		for (uint32_t keyIndex : keptKeys)
+		{
+			m_rotations.times.push_back(times[keyIndex]);
+			m_rotations.values.resize(m_rotations.values.size() + 3U);
+			EncodeSmallestThree(rotationValues[keyIndex], &m_rotations.values[m_rotations.values.size() - 3U]);
+		}
+	};
+
+	m_animatedSlots.assign(boneCount, InvalidIndex);
+	for (uint32_t boneIndex = 0U; boneIndex < boneCount; ++boneIndex)
+	{
+		uint32_t trackIndex = trackIndices[boneIndex];
+		if (SkeletonBinding::InvalidIndex == trackIndex)
+		{
+			continue;
+		}
+
+		m_animatedSlots[boneIndex] = GetAnimatedBoneCount();
+		m_animatedBoneIndices.push_back(boneIndex);
+
+		const cd::Track& track = pTracks[trackIndex];
+		float angularTolerance = settings.jointErrorBudget / std::max(chainLengths[boneIndex], settings.minimumChainLength);
+
+		GatherVectorKeys(track.GetTranslationKeys(), track.GetTranslationKeyCount(), cd::Vec3f::Zero(), times, vectorValues);
+		AddVectorChannel(m_translations, settings.jointErrorBudget);
+
+		AddRotationChannel(track, angularTolerance);
+
+		GatherVectorKeys(track.GetScaleKeys(), track.GetScaleKeyCount(), cd::Vec3f::One(), times, vectorValues);
+		AddVectorChannel(m_scales, angularTolerance);
+	}
+}
+
+uint32_t CompressedClip::GetKeyCount() const
+{
+	return static_cast<uint32_t>(m_translations.times.size() + m_rotations.times.size() + m_scales.times.size());
+}
+
+size_t CompressedClip::GetMemorySize() const
+{
+	auto VectorBytes = [](const auto& elements) { return elements.size() * sizeof(elements[0]); };
+	auto ChannelBytes = [&VectorBytes](const auto& channels) { return VectorBytes(channels.channels) + VectorBytes(channels.times) + VectorBytes(channels.values); };
+
+	return sizeof(CompressedClip) + VectorBytes(m_animatedBoneIndices) + VectorBytes(m_animatedSlots) +
+		ChannelBytes(m_translations) + VectorBytes(m_translations.ranges) +
+		ChannelBytes(m_rotations) +
+		ChannelBytes(m_scales) + VectorBytes(m_scales.ranges);
+}
+
+void CompressedClip::SampleLocalPose(float time, std::vector<KeyframeCursor>& cursors, LocalPose& pose) const
+{
+	const uint32_t boneCount = GetAnimatedBoneCount();
+	cursors.resize(boneCount);
+	pose.Resize(boneCount);
+
+	// Seeking is the only branchy part. It leaves absolute key pairs and weights so the decode loops below
+	// are straight arithmetic over contiguous arrays.
+	auto SeekChannels = [&](const std::vector<Channel>& channels, const std::vector<float>& keyTimes, uint32_t KeyframeCursor::* pCursorKey)
+	{
+		for (uint32_t slot = 0U; slot < boneCount; ++slot)
+		{
+			const Channel& channel = channels[slot];
+			const float* pTimes = keyTimes.data() + channel.firstKey;
+			uint32_t& cursorKey = cursors[slot].*pCursorKey;
+			cursorKey = SeekTime(pTimes, channel.keyCount, time, cursorKey);
+
+			uint32_t nextKey = std::min(cursorKey + 1U, channel.keyCount - 1U);
+			float keyDuration = pTimes[nextKey] - pTimes[cursorKey];
+			pose.firstKeys[slot] = channel.firstKey + cursorKey;
+			pose.secondKeys[slot] = channel.firstKey + nextKey;
+			pose.weights[slot] = keyDuration > 0.0f ? std::clamp((time - pTimes[cursorKey]) / keyDuration, 0.0f, 1.0f) : 0.0f;
+		}
+	};
+
+	// Interpolates in quantized space and dequantizes once.
+	auto DecodeVectors = [&](const VectorChannels& vectorChannels, float* pX, float* pY, float* pZ)
+	{
+		const uint16_t* pValues = vectorChannels.values.data();
+		const float* pRanges = vectorChannels.ranges.data();
+		for (uint32_t slot = 0U; slot < boneCount; ++slot)
+		{
+			const uint16_t* pFirst = pValues + pose.firstKeys[slot] * 3U;
+			const uint16_t* pSecond = pValues + pose.secondKeys[slot] * 3U;
+			const float* pRange = pRanges + slot * 6U;
+			float weight = pose.weights[slot];
+			pX[slot] = pRange[0] + pRange[3] * (pFirst[0] + (static_cast<float>(pSecond[0]) - pFirst[0]) * weight);
+			pY[slot] = pRange[1] + pRange[4] * (pFirst[1] + (static_cast<float>(pSecond[1]) - pFirst[1]) * weight);
+			pZ[slot] = pRange[2] + pRange[5] * (pFirst[2] + (static_cast<float>(pSecond[2]) - pFirst[2]) * weight);
+		}
+	};
+
+	SeekChannels(m_translations.channels, m_translations.times, &KeyframeCursor::translationKey);
+	DecodeVectors(m_translations, pose.translationX.data(), pose.translationY.data(), pose.translationZ.data());
+
+	SeekChannels(m_rotations.channels, m_rotations.times, &KeyframeCursor::rotationKey);
+	const uint16_t* pRotationValues = m_rotations.values.data();
+	for (uint32_t slot = 0U; slot < boneCount; ++slot)
+	{
+		Quaternion4 rotation = Nlerp(DecodeSmallestThree(pRotationValues + pose.firstKeys[slot] * 3U),
+			DecodeSmallestThree(pRotationValues + pose.secondKeys[slot] * 3U), pose.weights[slot]);
+		pose.rotationX[slot] = rotation[0];
+		pose.rotationY[slot] = rotation[1];
+		pose.rotationZ[slot] = rotation[2];
+		pose.rotationW[slot] = rotation[3];
+	}
+
+	SeekChannels(m_scales.channels, m_scales.times, &KeyframeCursor::scaleKey);
+	DecodeVectors(m_scales, pose.scaleX.data(), pose.scaleY.data(), pose.scaleZ.data());
+}
+
+ClipCompressionError MeasureClipCompressionError(const SkeletonBinding& binding, const cd::Track* pTracks, const CompressedClip& clip,
+	float duration, uint32_t sampleCount)
+{
+	assert(sampleCount > 1U);
+
+	std::vector<KeyframeCursor> rawCursors;
+	std::vector<KeyframeCursor> compressedCursors;
+	std::vector<cd::Matrix4x4> rawGlobalTransforms;
+	std::vector<cd::Matrix4x4> compressedGlobalTransforms;
+	std::vector<cd::Matrix4x4> palette;
+
+	ClipCompressionError error;
+	double errorSum = 0.0;
+	for (uint32_t sampleIndex = 0U; sampleIndex < sampleCount; ++sampleIndex)
+	{
+		float time = duration * static_cast<float>(sampleIndex) / static_cast<float>(sampleCount - 1U);
+		EvaluateSkeletonPose(binding, pTracks, time, cd::Matrix4x4::Identity(), rawCursors, rawGlobalTransforms, palette);
+		EvaluateSkeletonPose(binding, clip, time, cd::Matrix4x4::Identity(), compressedCursors, compressedGlobalTransforms, palette);
+
+		for (uint32_t boneIndex = 0U; boneIndex < binding.GetBoneCount(); ++boneIndex)
+		{
+			float jointError = Distance(rawGlobalTransforms[boneIndex].GetTranslation(), compressedGlobalTransforms[boneIndex].GetTranslation());
+			error.maxJointError = std::max(error.maxJointError, jointError);
+			errorSum += jointError;
+		}
+	}
+
+	error.averageJointError = static_cast<float>(errorSum / std::max(static_cast<double>(sampleCount) * binding.GetBoneCount(), 1.0));
+	return error;
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace cd
+{
+
+class Track;
+
+}
+
+namespace engine
+{
+
+class SkeletonBinding;
+struct KeyframeCursor;
+
+struct ClipCompressionSettings
+{
+	// Largest position error in scene units which one bone may add to itself and its descendants.
+	float jointErrorBudget = 0.001f;
+
+	// Leaf bones have no descendant joints but still carry skinned vertices, so their rotation and scale
+	// budgets are measured at least at this distance.
+	float minimumChainLength = 0.1f;
+};
+
+// Local transforms of the animated bones, one array per component so that decoding runs over contiguous floats.
+// Key indices and weights are decode scratch kept here so that a pose buffer per thread is enough.
+struct LocalPose
+{
+	void Resize(uint32_t boneCount);
+
+	std::vector<float> translationX, translationY, translationZ;
+	std::vector<float> rotationX, rotationY, rotationZ, rotationW;
+	std::vector<float> scaleX, scaleY, scaleZ;
+
+	std::vector<uint32_t> firstKeys, secondKeys;
+	std::vector<float> weights;
+};
+
+// Animation tracks of one SkeletonBinding after import time compression :
+// - Keys which linear interpolation of their neighbours reproduces within the bone error budget are removed.
+// - Rotations are stored as 48 bits smallest three quaternions.
+// - Translations and scales are quantized to 16 bits per component against the range of their track.
+class CompressedClip final
+{
+public:
+	static constexpr uint32_t InvalidIndex = UINT32_MAX;
+
+	// Bytes used by the raw tracks which the binding refers to.
+	static size_t GetUncompressedMemorySize(const SkeletonBinding& binding, const cd::Track* pTracks);
+
+public:
+	CompressedClip() = default;
+	explicit CompressedClip(const SkeletonBinding& binding, const cd::Track* pTracks, const ClipCompressionSettings& settings = ClipCompressionSettings());
+	CompressedClip(const CompressedClip&) = delete;
+	CompressedClip& operator=(const CompressedClip&) = delete;
+	CompressedClip(CompressedClip&&) = default;
+	CompressedClip& operator=(CompressedClip&&) = default;
+	~CompressedClip() = default;
+
+	uint32_t GetAnimatedBoneCount() const { return static_cast<uint32_t>(m_animatedBoneIndices.size()); }
+	// Maps a flattened bone index of the binding to its slot in LocalPose, InvalidIndex when the bone isn't animated.
+	const std::vector<uint32_t>& GetAnimatedSlots() const { return m_animatedSlots; }
+
+	uint32_t GetKeyCount() const;
+	size_t GetMemorySize() const;
+
+	// Cursors are indexed by animated slot. Time is in ticks.
+	void SampleLocalPose(float time, std::vector<KeyframeCursor>& cursors, LocalPose& pose) const;
+
+private:
+	struct Channel
+	{
+		uint32_t firstKey;
+		uint32_t keyCount;
+	};
+
+	// Translation and scale share one layout. Values are 3 uint16_t per key and ranges are 6 floats per channel.
+	struct VectorChannels
+	{
+		std::vector<Channel> channels;
+		std::vector<float> times;
+		std::vector<uint16_t> values;
+		std::vector<float> ranges;
+	};
+
+	// Values are 3 uint16_t per key holding a smallest three quaternion.
+	struct RotationChannels
+	{
+		std::vector<Channel> channels;
+		std::vector<float> times;
+		std::vector<uint16_t> values;
+	};
+
+	std::vector<uint32_t> m_animatedBoneIndices;
+	std::vector<uint32_t> m_animatedSlots;
+	VectorChannels m_translations;
+	RotationChannels m_rotations;
+	VectorChannels m_scales;
+};
+
+struct ClipCompressionError
+{
+	float maxJointError = 0.0f;
+	float averageJointError = 0.0f;
+};
+
+// Compares model space joint positions of the raw and compressed tracks at sampleCount evenly spaced times of [0, duration] ticks.
+ClipCompressionError MeasureClipCompressionError(const SkeletonBinding& binding, const cd::Track* pTracks, const CompressedClip& clip,
+	float duration, uint32_t sampleCount);
+
+}
\ No newline at end of file
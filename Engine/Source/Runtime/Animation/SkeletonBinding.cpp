@@ -0,0 +1,57 @@
+#include "SkeletonBinding.h"
+
+#include "Scene/SceneDatabase.h"
+
+#include <algorithm>
+#include <cassert>
+#include <string>
+#include <unordered_map>
+
+namespace engine
+{
+
+SkeletonBinding::SkeletonBinding(const cd::SceneDatabase& sceneDatabase, const cd::Animation& animation, uint32_t rootBoneIndex)
+{
+	assert(rootBoneIndex < sceneDatabase.GetBoneCount());
+
+	std::unordered_map<std::string, uint32_t> trackIndices;
+	for (cd::TrackID trackID : animation.GetBoneTrackIDs())
+	{
+		trackIndices.emplace(sceneDatabase.GetTracks()[trackID.Data()].GetName(), trackID.Data());
+	}
+
+	// Breadth first walk. The read cursor chases the write end so parents are always emitted first.
+	std::vector<uint32_t> boneIndices;
+	boneIndices.push_back(rootBoneIndex);
+	m_parentIndices.push_back(InvalidIndex);
+	for (uint32_t flatIndex = 0U; flatIndex < boneIndices.size(); ++flatIndex)
+	{
+		const cd::Bone& bone = sceneDatabase.GetBone(boneIndices[flatIndex]);
+		for (cd::BoneID childID : bone.GetChildIDs())
+		{
+			boneIndices.push_back(childID.Data());
+			m_parentIndices.push_back(flatIndex);
+		}
+	}
+
+	const size_t boneCount = boneIndices.size();
+	m_paletteIndices.reserve(boneCount);
+	m_trackIndices.reserve(boneCount);
+	m_bindPoseTransforms.reserve(boneCount);
+	m_offsetMatrices.reserve(boneCount);
+	for (uint32_t boneIndex : boneIndices)
+	{
+		const cd::Bone& bone = sceneDatabase.GetBone(boneIndex);
+		uint32_t paletteIndex = bone.GetID().Data();
+		m_paletteIndices.push_back(paletteIndex);
+		m_paletteSize = std::max(m_paletteSize, paletteIndex + 1U);
+
+		auto itTrack = trackIndices.find(bone.GetName());
+		m_trackIndices.push_back(itTrack != trackIndices.end() ? itTrack->second : InvalidIndex);
+
+		m_bindPoseTransforms.push_back(bone.GetTransform().GetMatrix());
+		m_offsetMatrices.push_back(bone.GetOffset());
+	}
+}
+
+}
\ No newline at end of file
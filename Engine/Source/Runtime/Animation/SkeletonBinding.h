@@ -0,0 +1,58 @@
+#pragma once
+
+#include "Math/Matrix.hpp"
+
+#include <cstdint>
+#include <vector>
+
+namespace cd
+{
+
+class Animation;
+class SceneDatabase;
+
+}
+
+namespace engine
+{
+
+// Everything about a skeleton and the tracks of one animation which doesn't change per instance.
+// Bones are flattened so that a parent always comes before its children, which lets the pose be
+// evaluated with one forward loop. Tracks are resolved by name once here instead of every frame,
+// only among the tracks of the animation so that other imports using the same bone names don't match.
+class SkeletonBinding final
+{
+public:
+	static constexpr uint32_t InvalidIndex = UINT32_MAX;
+
+public:
+	SkeletonBinding() = default;
+	explicit SkeletonBinding(const cd::SceneDatabase& sceneDatabase, const cd::Animation& animation, uint32_t rootBoneIndex = 0U);
+	SkeletonBinding(const SkeletonBinding&) = delete;
+	SkeletonBinding& operator=(const SkeletonBinding&) = delete;
+	SkeletonBinding(SkeletonBinding&&) = default;
+	SkeletonBinding& operator=(SkeletonBinding&&) = default;
+	~SkeletonBinding() = default;
+
+	uint32_t GetBoneCount() const { return static_cast<uint32_t>(m_parentIndices.size()); }
+	// Skinning palette is indexed by bone ID so it can be larger than the bone count.
+	uint32_t GetPaletteSize() const { return m_paletteSize; }
+
+	// Index into the flattened bone array, InvalidIndex for the root.
+	const std::vector<uint32_t>& GetParentIndices() const { return m_parentIndices; }
+	const std::vector<uint32_t>& GetPaletteIndices() const { return m_paletteIndices; }
+	// Index into SceneDatabase tracks, InvalidIndex when the bone isn't animated.
+	const std::vector<uint32_t>& GetTrackIndices() const { return m_trackIndices; }
+	const std::vector<cd::Matrix4x4>& GetBindPoseTransforms() const { return m_bindPoseTransforms; }
+	const std::vector<cd::Matrix4x4>& GetOffsetMatrices() const { return m_offsetMatrices; }
+
+private:
+	uint32_t m_paletteSize = 0U;
+	std::vector<uint32_t> m_parentIndices;
+	std::vector<uint32_t> m_paletteIndices;
+	std::vector<uint32_t> m_trackIndices;
+	std::vector<cd::Matrix4x4> m_bindPoseTransforms;
+	std::vector<cd::Matrix4x4> m_offsetMatrices;
+};
+
+}
\ No newline at end of file
@@ -34,15 +34,19 @@ void Engine::Init(EngineInitArgs args)
 
 void Engine::Run()
 {
-	Clock clock;
-
 	while (true)
 	{
 		ZoneScoped;
 
-		clock.Update();
+		m_clock.Update();
+
+		// Simulation catches up with real time in fixed steps, then the frame is rendered once.
+		while (m_clock.ConsumeFixedStep())
+		{
+			m_pApplication->FixedUpdate(m_clock.GetFixedDeltaTime());
+		}
 
-		if (!m_pApplication->Update(clock.GetDeltaTime()))
+		if (!m_pApplication->Update(m_clock.GetDeltaTime()))
 		{
 			// quit
 			break;
@@ -2,6 +2,7 @@
 
 #include "EngineDefines.h"
 #include "IApplication.h"
+#include "Time/Clock.h"
 
 #include <vector>
 #include <memory>
@@ -42,8 +43,13 @@ public:
 	//
 	ENGINE_API void Shutdown();
 
+	// Main loop clock. Applications can change its fixed timestep in Init.
+	Clock& GetClock() { return m_clock; }
+	const Clock& GetClock() const { return m_clock; }
+
 private:
 	std::unique_ptr<IApplication> m_pApplication;
+	Clock m_clock;
 };
 
 }
\ No newline at end of file
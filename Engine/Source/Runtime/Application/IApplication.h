@@ -19,6 +19,10 @@ struct EngineInitArgs
 	bool useFullScreen = false;
 	Language language = Language::English;
 	GraphicsBackend backend = GraphicsBackend::Direct3D11;
+	// Editor only. Frames per second kept while nothing invalidates the frame, 0 renders every frame.
+	uint16_t idleRefreshRate = 4;
+	// Game only. Records scene renderers on a dedicated thread while the next frame is simulated.
+	bool useRenderThread = true;
 };
 
 class IApplication
@@ -35,6 +39,9 @@ public:
 	virtual bool Update(float deltaTime) = 0;
 	virtual void Shutdown() = 0;
 
+	// Called zero or more times per frame before Update, at the fixed rate of the engine clock.
+	virtual void FixedUpdate(float fixedDeltaTime) {}
+
 	void SetEngine(Engine* pEngine) { m_pEngine = pEngine; }
 	Engine* GetEngine() { return m_pEngine; };
 
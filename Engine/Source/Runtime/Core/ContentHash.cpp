@@ -0,0 +1,185 @@
+#include "ContentHash.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+namespace engine
+{
+
+namespace
+{
+
+constexpr uint64_t prime1 = 11400714785074694791ULL;
+constexpr uint64_t prime2 = 14029467366897019727ULL;
+constexpr uint64_t prime3 = 1609587929392839161ULL;
+constexpr uint64_t prime4 = 9650029242287828579ULL;
+constexpr uint64_t prime5 = 2870177450012600261ULL;
+
+constexpr size_t fileReadChunkSize = 64U * 1024U;
+
+uint64_t RotateLeft(uint64_t value, uint32_t bitCount)
+{
+	return (value << bitCount) | (value >> (64U - bitCount));
+}
+
+// Streams are hashed as little endian, which every supported platform is.
+uint64_t Read64(const uint8_t* pData)
+{
+	uint64_t value;
+	std::memcpy(&value, pData, sizeof(value));
+	return value;
+}
+
+uint32_t Read32(const uint8_t* pData)
+{
+	uint32_t value;
+	std::memcpy(&value, pData, sizeof(value));
+	return value;
+}
+
+uint64_t Round(uint64_t accumulator, uint64_t input)
+{
+	accumulator += input * prime2;
+	return RotateLeft(accumulator, 31U) * prime1;
+}
+
+uint64_t MergeRound(uint64_t hash, uint64_t accumulator)
+{
+	hash ^= Round(0U, accumulator);
+	return hash * prime1 + prime4;
+}
+
+}
+
+ContentHasher::ContentHasher(uint64_t seed)
+	: m_seed(seed)
+	, m_accumulators{ seed + prime1 + prime2, seed + prime2, seed, seed - prime1 }
+{
+}
+
+void ContentHasher::Update(const void* pData, size_t size)
+{
+	const uint8_t* pInput = static_cast<const uint8_t*>(pData);
+	const uint8_t* pEnd = pInput + size;
+	m_totalSize += size;
+
+	// Fill the pending stripe first, the loop below only takes whole 32 bytes stripes.
+	if (m_bufferSize > 0U)
+	{
+		size_t copySize = std::min<size_t>(sizeof(m_buffer) - m_bufferSize, size);
+		std::memcpy(m_buffer + m_bufferSize, pInput, copySize);
+		m_bufferSize += static_cast<uint32_t>(copySize);
+		pInput += copySize;
+		if (m_bufferSize < sizeof(m_buffer))
+		{
+			return;
+		}
+
+		for (uint32_t lane = 0U; lane < 4U; ++lane)
+		{
+			m_accumulators[lane] = Round(m_accumulators[lane], Read64(m_buffer + lane * 8U));
+		}
+		m_bufferSize = 0U;
+	}
+
+	uint64_t accumulator0 = m_accumulators[0];
+	uint64_t accumulator1 = m_accumulators[1];
+	uint64_t accumulator2 = m_accumulators[2];
+	uint64_t accumulator3 = m_accumulators[3];
+	while (pEnd - pInput >= 32)
+	{
+		accumulator0 = Round(accumulator0, Read64(pInput));
+		accumulator1 = Round(accumulator1, Read64(pInput + 8));
+		accumulator2 = Round(accumulator2, Read64(pInput + 16));
+		accumulator3 = Round(accumulator3, Read64(pInput + 24));
+		pInput += 32;
+	}
+	m_accumulators[0] = accumulator0;
+	m_accumulators[1] = accumulator1;
+	m_accumulators[2] = accumulator2;
+	m_accumulators[3] = accumulator3;
+
+	m_bufferSize = static_cast<uint32_t>(pEnd - pInput);
+	std::memcpy(m_buffer, pInput, m_bufferSize);
+}
+
+uint64_t ContentHasher::GetHash() const
+{
+	uint64_t hash;
+	if (m_totalSize >= 32U)
+	{
+		hash = RotateLeft(m_accumulators[0], 1U) + RotateLeft(m_accumulators[1], 7U) +
+			RotateLeft(m_accumulators[2], 12U) + RotateLeft(m_accumulators[3], 18U);
+		for (uint64_t accumulator : m_accumulators)
+		{
+			hash = MergeRound(hash, accumulator);
+		}
+	}
+	else
+	{
+		hash = m_seed + prime5;
+	}
+	hash += m_totalSize;
+
+	const uint8_t* pInput = m_buffer;
+	const uint8_t* pEnd = m_buffer + m_bufferSize;
+	for (; pEnd - pInput >= 8; pInput += 8)
+	{
+		hash ^= Round(0U, Read64(pInput));
+		hash = RotateLeft(hash, 27U) * prime1 + prime4;
+	}
+	if (pEnd - pInput >= 4)
+	{
+		hash ^= static_cast<uint64_t>(Read32(pInput)) * prime1;
+		hash = RotateLeft(hash, 23U) * prime2 + prime3;
+		pInput += 4;
+	}
+	for (; pInput < pEnd; ++pInput)
+	{
+		hash ^= *pInput * prime5;
+		hash = RotateLeft(hash, 11U) * prime1;
+	}
+
+	hash ^= hash >> 33U;
+	hash *= prime2;
+	hash ^= hash >> 29U;
+	hash *= prime3;
+	hash ^= hash >> 32U;
+	return hash;
+}
+
+uint64_t HashContent(const void* pData, size_t size, uint64_t seed)
+{
+	ContentHasher hasher(seed);
+	hasher.Update(pData, size);
+	return hasher.GetHash();
+}
+
+std::optional<uint64_t> HashFileContent(const char* pFilePath)
+{
+	std::FILE* pFile = std::fopen(pFilePath, "rb");
+	if (!pFile)
+	{
+		return std::nullopt;
+	}
+
+	ContentHasher hasher;
+	static thread_local uint8_t chunk[fileReadChunkSize];
+	size_t readSize;
+	while ((readSize = std::fread(chunk, 1U, sizeof(chunk), pFile)) > 0U)
+	{
+		hasher.Update(chunk, readSize);
+	}
+
+	bool isFailed = std::ferror(pFile) != 0;
+	std::fclose(pFile);
+	if (isFailed)
+	{
+		return std::nullopt;
+	}
+
+	return hasher.GetHash();
+}
+
+}
\ No newline at end of file
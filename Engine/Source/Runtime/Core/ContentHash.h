@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+
+namespace engine
+{
+
+// 64 bits xxHash (XXH64) of a byte stream, fed in pieces of any size. It runs at memory speed, which is what
+// deciding rebuilds from file contents needs, but is not meant to resist collisions made on purpose.
+class ContentHasher final
+{
+public:
+	explicit ContentHasher(uint64_t seed = 0U);
+	ContentHasher(const ContentHasher&) = default;
+	ContentHasher& operator=(const ContentHasher&) = default;
+	ContentHasher(ContentHasher&&) = default;
+	ContentHasher& operator=(ContentHasher&&) = default;
+	~ContentHasher() = default;
+
+	void Update(const void* pData, size_t size);
+	void Update(uint64_t value) { Update(&value, sizeof(value)); }
+
+	// Hash of everything passed to Update so far. More data can be added afterwards.
+	uint64_t GetHash() const;
+
+private:
+	uint64_t m_seed;
+	uint64_t m_accumulators[4];
+	uint64_t m_totalSize = 0U;
+	uint8_t m_buffer[32];
+	uint32_t m_bufferSize = 0U;
+};
+
+uint64_t HashContent(const void* pData, size_t size, uint64_t seed = 0U);
+
+// Empty when the file can't be read.
+std::optional<uint64_t> HashFileContent(const char* pFilePath);
+
+}
\ No newline at end of file
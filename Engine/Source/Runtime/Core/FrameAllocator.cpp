@@ -0,0 +1,162 @@
+#include "FrameAllocator.h"
+
+#include <algorithm>
+#include <cassert>
+#include <mutex>
+
+namespace engine
+{
+
+namespace
+{
+
+constexpr uint64_t InvalidFrameIndex = UINT64_MAX;
+
+std::atomic<uint64_t> s_frameIndex = 0U;
+
+struct ThreadArenas;
+
+// Live threads, so that statistics can be gathered from the main thread.
+std::mutex s_registryMutex;
+std::vector<const ThreadArenas*> s_registry;
+
+struct ThreadArenas
+{
+	ThreadArenas()
+	{
+		std::lock_guard<std::mutex> lock(s_registryMutex);
+		s_registry.push_back(this);
+	}
+
+	~ThreadArenas()
+	{
+		std::lock_guard<std::mutex> lock(s_registryMutex);
+		s_registry.erase(std::find(s_registry.begin(), s_registry.end(), this));
+	}
+
+	LinearArena arenas[2];
+	uint64_t frameIndices[2] = { InvalidFrameIndex, InvalidFrameIndex };
+};
+
+ThreadArenas& GetThreadArenas()
+{
+	thread_local ThreadArenas threadArenas;
+	return threadArenas;
+}
+
+}
+
+LinearArena::LinearArena(size_t blockSize)
+	: m_blockSize(blockSize)
+{
+}
+
+void* LinearArena::Allocate(size_t size, size_t alignment)
+{
+	assert(alignment > 0U && 0U == (alignment & (alignment - 1U)));
+
+	for (; m_blockIndex < m_blocks.size(); ++m_blockIndex, m_blockOffset = 0U)
+	{
+		if (void* pMemory = TryAllocate(size, alignment))
+		{
+			return pMemory;
+		}
+	}
+
+	AddBlock(std::max(m_blockSize, size + alignment - 1U));
+	void* pMemory = TryAllocate(size, alignment);
+	assert(pMemory);
+	return pMemory;
+}
+
+void* LinearArena::TryAllocate(size_t size, size_t alignment)
+{
+	const Block& block = m_blocks[m_blockIndex];
+	uintptr_t begin = reinterpret_cast<uintptr_t>(block.pData.get());
+	uintptr_t alignedAddress = (begin + m_blockOffset + alignment - 1U) & ~static_cast<uintptr_t>(alignment - 1U);
+	size_t endOffset = static_cast<size_t>(alignedAddress - begin) + size;
+	if (endOffset > block.size)
+	{
+		return nullptr;
+	}
+
+	m_usedSize += endOffset - m_blockOffset;
+	m_blockOffset = endOffset;
+	if (m_usedSize > m_peakUsedSize.load(std::memory_order_relaxed))
+	{
+		m_peakUsedSize.store(m_usedSize, std::memory_order_relaxed);
+	}
+
+	return reinterpret_cast<void*>(alignedAddress);
+}
+
+void LinearArena::AddBlock(size_t size)
+{
+	m_blocks.push_back({ std::make_unique<std::byte[]>(size), size });
+	m_blockIndex = m_blocks.size() - 1U;
+	m_blockOffset = 0U;
+	m_capacity.fetch_add(size, std::memory_order_relaxed);
+	m_blockAllocationCount.fetch_add(1U, std::memory_order_relaxed);
+}
+
+void LinearArena::Reset()
+{
+	if (m_blocks.size() > 1U)
+	{
+		size_t totalSize = m_capacity.load(std::memory_order_relaxed);
+		m_blocks.clear();
+		m_capacity.store(0U, std::memory_order_relaxed);
+		AddBlock(totalSize);
+	}
+
+	m_blockIndex = 0U;
+	m_blockOffset = 0U;
+	m_usedSize = 0U;
+}
+
+void FrameAllocator::AdvanceFrame()
+{
+	s_frameIndex.fetch_add(1U, std::memory_order_relaxed);
+}
+
+uint64_t FrameAllocator::GetFrameIndex()
+{
+	return s_frameIndex.load(std::memory_order_relaxed);
+}
+
+void* FrameAllocator::Allocate(size_t size, size_t alignment)
+{
+	ThreadArenas& threadArenas = GetThreadArenas();
+	uint64_t frameIndex = GetFrameIndex();
+	uint32_t arenaIndex = static_cast<uint32_t>(frameIndex & 1U);
+	if (threadArenas.frameIndices[arenaIndex] != frameIndex)
+	{
+		threadArenas.arenas[arenaIndex].Reset();
+		threadArenas.frameIndices[arenaIndex] = frameIndex;
+	}
+
+	return threadArenas.arenas[arenaIndex].Allocate(size, alignment);
+}
+
+FrameAllocator::Statistics FrameAllocator::GetStatistics()
+{
+	Statistics statistics;
+
+	std::lock_guard<std::mutex> lock(s_registryMutex);
+	statistics.threadCount = static_cast<uint32_t>(s_registry.size());
+	for (const ThreadArenas* pThreadArenas : s_registry)
+	{
+		size_t peakUsedSize = 0U;
+		for (const LinearArena& arena : pThreadArenas->arenas)
+		{
+			peakUsedSize = std::max(peakUsedSize, arena.GetPeakUsedSize());
+			statistics.capacity += arena.GetCapacity();
+			statistics.blockAllocationCount += arena.GetBlockAllocationCount();
+		}
+		statistics.peakUsedSize += peakUsedSize;
+	}
+
+	return statistics;
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace engine
+{
+
+// Bump allocator over a list of heap blocks. Allocate only moves an offset and Reset rewinds it,
+// nothing is freed one by one. Not thread safe, except for the statistics getters.
+class LinearArena final
+{
+public:
+	static constexpr size_t DefaultBlockSize = 1U << 20U;
+
+public:
+	explicit LinearArena(size_t blockSize = DefaultBlockSize);
+	LinearArena(const LinearArena&) = delete;
+	LinearArena& operator=(const LinearArena&) = delete;
+	LinearArena(LinearArena&&) = delete;
+	LinearArena& operator=(LinearArena&&) = delete;
+	~LinearArena() = default;
+
+	// alignment must be a power of two.
+	void* Allocate(size_t size, size_t alignment);
+
+	// Forgets every allocation. Blocks are merged into one when the last use spilled over several,
+	// so a steady workload settles on a single block and stops calling the heap.
+	void Reset();
+
+	size_t GetUsedSize() const { return m_usedSize; }
+	size_t GetPeakUsedSize() const { return m_peakUsedSize.load(std::memory_order_relaxed); }
+	size_t GetCapacity() const { return m_capacity.load(std::memory_order_relaxed); }
+	uint64_t GetBlockAllocationCount() const { return m_blockAllocationCount.load(std::memory_order_relaxed); }
+
+private:
+	struct Block
+	{
+		std::unique_ptr<std::byte[]> pData;
+		size_t size;
+	};
+
+	void* TryAllocate(size_t size, size_t alignment);
+	void AddBlock(size_t size);
+
+	std::vector<Block> m_blocks;
+	size_t m_blockSize;
+	size_t m_blockIndex = 0U;
+	size_t m_blockOffset = 0U;
+	size_t m_usedSize = 0U;
+
+	std::atomic<size_t> m_peakUsedSize = 0U;
+	std::atomic<size_t> m_capacity = 0U;
+	std::atomic<uint64_t> m_blockAllocationCount = 0U;
+};
+
+// Memory for data which only lives for the frame. Every thread owns two arenas and allocates from the one
+// matching the parity of the current frame, which is recycled the first time the thread allocates two frames
+// later. So an allocation stays valid until the end of the next frame : long enough for a render thread
+// recording one frame behind, and for bgfx::makeRef which needs the memory to outlive two bgfx::frame calls.
+class FrameAllocator final
+{
+public:
+	struct Statistics
+	{
+		uint32_t threadCount = 0U;
+		// Largest amount of frame memory one thread used in one frame, summed over threads.
+		size_t peakUsedSize = 0U;
+		size_t capacity = 0U;
+		// Heap allocations made by the arenas themselves since start.
+		uint64_t blockAllocationCount = 0U;
+	};
+
+public:
+	FrameAllocator() = delete;
+
+	// Called right after bgfx::frame so that frames match the ones of bgfx.
+	static void AdvanceFrame();
+	static uint64_t GetFrameIndex();
+
+	static void* Allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+
+	template<typename T>
+	static T* AllocateArray(size_t count)
+	{
+		return static_cast<T*>(Allocate(count * sizeof(T), alignof(T)));
+	}
+
+	// Only covers threads which are still alive.
+	static Statistics GetStatistics();
+};
+
+// STL allocator adapter over the frame memory of the calling thread. Deallocation does nothing, so containers
+// should reserve up front instead of growing, and must not be kept beyond the next frame.
+template<typename T>
+class FrameStlAllocator
+{
+public:
+	using value_type = T;
+
+	FrameStlAllocator() noexcept = default;
+
+	template<typename U>
+	FrameStlAllocator(const FrameStlAllocator<U>&) noexcept {}
+
+	T* allocate(size_t count) { return FrameAllocator::AllocateArray<T>(count); }
+	void deallocate(T*, size_t) noexcept {}
+
+	template<typename U>
+	bool operator==(const FrameStlAllocator<U>&) const noexcept { return true; }
+
+	template<typename U>
+	bool operator!=(const FrameStlAllocator<U>&) const noexcept { return false; }
+};
+
+template<typename T>
+using FrameVector = std::vector<T, FrameStlAllocator<T>>;
+
+using FrameString = std::basic_string<char, std::char_traits<char>, FrameStlAllocator<char>>;
+
+}
\ No newline at end of file
@@ -0,0 +1,108 @@
+#include "ThreadPool.h"
+
+#include <algorithm>
+
+namespace engine
+{
+
+uint32_t ThreadPool::GetDefaultWorkerCount()
+{
+	uint32_t hardwareThreadCount = std::thread::hardware_concurrency();
+	return hardwareThreadCount > 1U ? hardwareThreadCount - 1U : 0U;
+}
+
+ThreadPool::ThreadPool(uint32_t workerCount)
+{
+	m_workers.reserve(workerCount);
+	for (uint32_t workerIndex = 0U; workerIndex < workerCount; ++workerIndex)
+	{
+		m_workers.emplace_back(&ThreadPool::WorkerLoop, this);
+	}
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_isExiting = true;
+	}
+	m_wakeCondition.notify_all();
+
+	for (std::thread& worker : m_workers)
+	{
+		worker.join();
+	}
+}
+
+void ThreadPool::ParallelFor(uint32_t count, uint32_t batchSize, const BatchFunction& function)
+{
+	if (0U == count)
+	{
+		return;
+	}
+
+	batchSize = std::max(batchSize, 1U);
+	if (m_workers.empty() || count <= batchSize)
+	{
+		function(0U, count);
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_pFunction = &function;
+		m_count = count;
+		m_batchSize = batchSize;
+		m_nextIndex.store(0U, std::memory_order_relaxed);
+		m_busyWorkerCount = GetWorkerCount();
+		++m_jobGeneration;
+	}
+	m_wakeCondition.notify_all();
+
+	RunBatches();
+
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_doneCondition.wait(lock, [this]() { return 0U == m_busyWorkerCount; });
+	m_pFunction = nullptr;
+}
+
+void ThreadPool::WorkerLoop()
+{
+	uint64_t finishedGeneration = 0U;
+	while (true)
+	{
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_wakeCondition.wait(lock, [this, finishedGeneration]() { return m_isExiting || m_jobGeneration != finishedGeneration; });
+			if (m_isExiting)
+			{
+				return;
+			}
+			finishedGeneration = m_jobGeneration;
+		}
+
+		RunBatches();
+
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			--m_busyWorkerCount;
+		}
+		m_doneCondition.notify_one();
+	}
+}
+
+void ThreadPool::RunBatches()
+{
+	while (true)
+	{
+		uint32_t begin = m_nextIndex.fetch_add(m_batchSize, std::memory_order_relaxed);
+		if (begin >= m_count)
+		{
+			return;
+		}
+
+		(*m_pFunction)(begin, std::min(begin + m_batchSize, m_count));
+	}
+}
+
+}
\ No newline at end of file
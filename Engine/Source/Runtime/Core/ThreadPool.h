@@ -0,0 +1,58 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace engine
+{
+
+// A fixed set of worker threads for data parallel loops.
+// ParallelFor blocks until the whole range is done and the calling thread takes batches too.
+// Only one thread should call ParallelFor at a time and it must not be called from inside a batch.
+class ThreadPool final
+{
+public:
+	using BatchFunction = std::function<void(uint32_t begin, uint32_t end)>;
+
+	// Leaves one hardware thread to the caller.
+	static uint32_t GetDefaultWorkerCount();
+
+public:
+	explicit ThreadPool(uint32_t workerCount = GetDefaultWorkerCount());
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+	ThreadPool(ThreadPool&&) = delete;
+	ThreadPool& operator=(ThreadPool&&) = delete;
+	~ThreadPool();
+
+	uint32_t GetWorkerCount() const { return static_cast<uint32_t>(m_workers.size()); }
+
+	// Splits [0, count) into batches of batchSize indices and calls function for each of them.
+	void ParallelFor(uint32_t count, uint32_t batchSize, const BatchFunction& function);
+
+private:
+	void WorkerLoop();
+	void RunBatches();
+
+	std::vector<std::thread> m_workers;
+
+	std::mutex m_mutex;
+	std::condition_variable m_wakeCondition;
+	std::condition_variable m_doneCondition;
+	uint64_t m_jobGeneration = 0U;
+	uint32_t m_busyWorkerCount = 0U;
+	bool m_isExiting = false;
+
+	// Current job. Written under the mutex before workers are woken up.
+	const BatchFunction* m_pFunction = nullptr;
+	uint32_t m_count = 0U;
+	uint32_t m_batchSize = 1U;
+	std::atomic<uint32_t> m_nextIndex = 0U;
+};
+
+}
\ No newline at end of file
@@ -1,8 +1,10 @@
 #pragma once
 
+#include "Animation/AnimationEvaluator.h"
 #include "Core/StringCrc.h"
 #include "Math/Matrix.hpp"
 
+#include <memory>
 #include <vector>
 
 namespace cd
@@ -16,6 +18,9 @@ class Track;
 namespace engine
 {
 
+class CompressedClip;
+class SkeletonBinding;
+
 class AnimationComponent final
 {
 public:
@@ -40,15 +45,33 @@ public:
 	const cd::Track* GetTrackData() const { return m_pTrack; }
 	void SetTrackData(const cd::Track* pTrack) { m_pTrack = pTrack; }
 
+	// Shared by all instances of the same animation. Built by SceneWorld.
+	const SkeletonBinding* GetSkeletonBinding() const { return m_pSkeletonBinding.get(); }
+	void SetSkeletonBinding(std::shared_ptr<const SkeletonBinding> pSkeletonBinding) { m_pSkeletonBinding = cd::MoveTemp(pSkeletonBinding); }
+
+	// Optional. When set it is sampled instead of the raw tracks. Built by SceneWorld.
+	const CompressedClip* GetCompressedClip() const { return m_pCompressedClip.get(); }
+	void SetCompressedClip(std::shared_ptr<const CompressedClip> pCompressedClip) { m_pCompressedClip = cd::MoveTemp(pCompressedClip); }
+
+	std::vector<KeyframeCursor>& GetKeyframeCursors() { return m_keyframeCursors; }
+	std::vector<cd::Matrix4x4>& GetGlobalBoneTransforms() { return m_globalBoneTransforms; }
+
+	// Playback state of this instance. Play time is in seconds.
+	float GetPlayTime() const { return m_playTime; }
+	void SetPlayTime(float playTime) { m_playTime = playTime; }
+	float GetPlaybackSpeed() const { return m_playbackSpeed; }
+	void SetPlaybackSpeed(float speed) { m_playbackSpeed = speed; }
+	bool IsLooping() const { return m_isLooping; }
+	void SetLooping(bool isLooping) { m_isLooping = isLooping; }
+	bool IsPlaying() const { return m_isPlaying; }
+	void SetPlaying(bool isPlaying) { m_isPlaying = isPlaying; }
+
 	void SetDuration(float duration) { m_duration = duration; }
 	float GetDuration() const { return m_duration; }
 
 	void SetTicksPerSecond(float ticksPerSecond) { m_ticksPerSecond = ticksPerSecond; }
 	float GetTicksPerSecond() const { return m_ticksPerSecond; }
 
-	void SetBoneMatricesUniform(uint16_t uniform) { m_boneMatricesUniform = uniform; }
-	uint16_t GetBoneMatrixsUniform() const { return m_boneMatricesUniform; }
-
 	void SetBoneMatrices(std::vector<cd::Matrix4x4> boneMatrices) { m_boneMatrices = cd::MoveTemp(boneMatrices); }
 	std::vector<cd::Matrix4x4>& GetBoneMatrices() { return m_boneMatrices; }
 	const std::vector<cd::Matrix4x4>& GetBoneMatrices() const { return m_boneMatrices; }
@@ -56,11 +79,21 @@ public:
 private:
 	const cd::Animation* m_pAnimation = nullptr;
 	const cd::Track* m_pTrack = nullptr;
+	std::shared_ptr<const SkeletonBinding> m_pSkeletonBinding;
+	std::shared_ptr<const CompressedClip> m_pCompressedClip;
 	
-	float m_duration;
-	float m_ticksPerSecond;
-	uint16_t m_boneMatricesUniform;
+	float m_duration = 0.0f;
+	float m_ticksPerSecond = 0.0f;
 	std::vector<cd::Matrix4x4> m_boneMatrices;
+
+	float m_playTime = 0.0f;
+	float m_playbackSpeed = 1.0f;
+	bool m_isLooping = true;
+	bool m_isPlaying = true;
+
+	// Evaluation state of this instance.
+	std::vector<KeyframeCursor> m_keyframeCursors;
+	std::vector<cd::Matrix4x4> m_globalBoneTransforms;
 };
 
 }
\ No newline at end of file
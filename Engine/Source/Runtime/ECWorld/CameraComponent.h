@@ -81,12 +81,17 @@ public:
 	void SetConstrainAspectRatio(bool use) { m_doConstainAspectRatio = use; }
 
 	bool& GetIsPostProcessEnable() { return m_enablePostProcess; }
-	bool IsPostProcessEnable() { return m_enablePostProcess; }
+	bool IsPostProcessEnable() const { return m_enablePostProcess; }
 	void SetPostProcessEnable(bool use) { m_enablePostProcess = use; }
 
 	float& GetGammaCorrection() { return m_gammaCorrection; }
 	const float& GetGammaCorrection() const { return m_gammaCorrection; }
 	void SetGammaCorrection(float gamma) { m_gammaCorrection = gamma; }
+
+	// Manual exposure as EV100. 0 means an aperture of f/1, 1s shutter time and ISO 100.
+	float& GetExposure() { return m_exposure; }
+	float GetExposure() const { return m_exposure; }
+	void SetExposure(float ev100) { m_exposure = ev100; }
 #endif
 
 private:
@@ -109,6 +114,7 @@ private:
 	bool m_doConstainAspectRatio;
 	bool m_enablePostProcess;
 	float m_gammaCorrection;
+	float m_exposure;
 #endif
 };
 
@@ -15,6 +15,9 @@ class IComponentsStorage
 {
 public:
 	virtual ~IComponentsStorage() = default;
+
+	// Increases every time a component is created or removed.
+	virtual uint32_t GetVersion() const = 0;
 };
 
 // ComponentsStorage stores an array of Components in the same type and the entity which contains the component.
@@ -44,6 +47,8 @@ public:
 	// Need to check if it is still active.
 	const std::vector<Entity>& GetEntities() const { return m_entities; }
 
+	virtual uint32_t GetVersion() const override { return m_version; }
+
 	// Get component by entity.
 	Component* GetComponent(Entity entity)
 	{
@@ -56,6 +61,7 @@ public:
 	{
 		assert(entity != INVALID_ENTITY && !Contains(entity));
 
+		++m_version;
 		m_entityToIndex[entity] = m_components.size();
 		m_entities.emplace_back(entity);
 		m_components.emplace_back();
@@ -80,6 +86,7 @@ public:
 			m_entityToIndex[lastEntity] = unusedIndex;
 		}
 
+		++m_version;
 		m_entities.pop_back();
 		m_components.pop_back();
 		m_entityToIndex.erase(entity);
@@ -89,6 +96,7 @@ private:
 	std::vector<Entity> m_entities;
 	std::vector<Component> m_components;
 	std::unordered_map<Entity, size_t> m_entityToIndex;
+	uint32_t m_version = 0U;
 };
 
 }
\ No newline at end of file
@@ -168,6 +168,43 @@ void SceneWorld::SetSkyEntity(engine::Entity entity)
 	m_skyEntity = entity;
 }
 
+std::shared_ptr<const SkeletonBinding> SceneWorld::GetSkeletonBinding(const cd::Animation& animation, uint32_t rootBoneIndex)
+{
+	std::weak_ptr<const SkeletonBinding>& pCachedBinding = m_skeletonBindings[SkeletonKey(animation.GetID().Data(), rootBoneIndex)];
+	std::shared_ptr<const SkeletonBinding> pSkeletonBinding = pCachedBinding.lock();
+	if (!pSkeletonBinding)
+	{
+		pSkeletonBinding = std::make_shared<const SkeletonBinding>(*m_pSceneDatabase, animation, rootBoneIndex);
+		pCachedBinding = pSkeletonBinding;
+	}
+
+	return pSkeletonBinding;
+}
+
+std::shared_ptr<const CompressedClip> SceneWorld::GetCompressedClip(const cd::Animation& animation, uint32_t rootBoneIndex)
+{
+	std::shared_ptr<const CompressedClip>& pCompressedClip = m_compressedClips[SkeletonKey(animation.GetID().Data(), rootBoneIndex)];
+	if (!pCompressedClip)
+	{
+		std::shared_ptr<const SkeletonBinding> pSkeletonBinding = GetSkeletonBinding(animation, rootBoneIndex);
+		pCompressedClip = std::make_shared<const CompressedClip>(*pSkeletonBinding, m_pSceneDatabase->GetTracks().data());
+	}
+
+	return pCompressedClip;
+}
+
+void SceneWorld::ReleaseRawTracks(const cd::Animation& animation)
+{
+	// Names stay so that bindings can still be built. Only the keys are dropped.
+	for (cd::TrackID trackID : animation.GetBoneTrackIDs())
+	{
+		cd::Track& track = m_pSceneDatabase->GetTracks()[trackID.Data()];
+		track.SetTranslationKeys({});
+		track.SetRotationKeys({});
+		track.SetScaleKeys({});
+	}
+}
+
 void SceneWorld::AddCameraToSceneDatabase(engine::Entity entity)
 {
 	engine::CameraComponent* pCameraComponent = GetCameraComponent(entity);
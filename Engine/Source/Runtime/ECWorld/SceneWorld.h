@@ -1,5 +1,7 @@
 #pragma once
 
+#include "Animation/CompressedClip.h"
+#include "Animation/SkeletonBinding.h"
 #include "ECWorld/AllComponentsHeader.h"
 #include "ECWorld/World.h"
 #include "Log/Log.h"
@@ -7,13 +9,16 @@
 #include "Math/Transform.hpp"
 #include "Scene/SceneDatabase.h"
 
+#include <map>
 #include <memory>
+#include <utility>
 #include <vector>
 
 namespace engine
 {
 
 class MaterialType;
+class RenderPacket;
 
 // Helper macro to define a component type in the entity component world.
 #define DEFINE_COMPONENT_STORAGE_WITH_APIS(ComponentType) \
@@ -112,6 +117,14 @@ public:
 	CD_FORCEINLINE engine::MaterialType* GetDDGIMaterialType() const { return m_pDDGIMaterialType.get(); }
 #endif
 
+	// Built on first use per animation and shared by the components playing it. Only a weak reference is cached,
+	// so the binding goes away with the last component holding it.
+	std::shared_ptr<const SkeletonBinding> GetSkeletonBinding(const cd::Animation& animation, uint32_t rootBoneIndex = 0U);
+	// Tracks of the animation compressed on first use. The clip is kept as long as the SceneWorld because it can't be
+	// rebuilt once ReleaseRawTracks dropped the raw keys, which only the uncompressed path and tools still read.
+	std::shared_ptr<const CompressedClip> GetCompressedClip(const cd::Animation& animation, uint32_t rootBoneIndex = 0U);
+	void ReleaseRawTracks(const cd::Animation& animation);
+
 	void AddCameraToSceneDatabase(engine::Entity entity);
 	void AddLightToSceneDatabase(engine::Entity entity);
 	void AddMaterialToSceneDatabase(engine::Entity entity);
@@ -122,6 +135,10 @@ public:
 
 	void Update();
 
+	// Set by applications which simulate at a fixed rate. Renderers then draw the state blended by the packet.
+	void SetRenderPacket(const RenderPacket* pRenderPacket) { m_pRenderPacket = pRenderPacket; }
+	CD_FORCEINLINE const RenderPacket* GetRenderPacket() const { return m_pRenderPacket; }
+
 private:
 	std::unique_ptr<cd::SceneDatabase> m_pSceneDatabase;
 	std::unique_ptr<engine::World> m_pWorld;
@@ -131,6 +148,13 @@ private:
 	std::unique_ptr<engine::MaterialType> m_pTerrainMaterialType;
 	std::unique_ptr<engine::MaterialType> m_pDDGIMaterialType;
 
+	// Animation ID and root bone index. Both stay valid when later imports append to the SceneDatabase.
+	using SkeletonKey = std::pair<uint32_t, uint32_t>;
+
+	std::map<SkeletonKey, std::weak_ptr<const SkeletonBinding>> m_skeletonBindings;
+	std::map<SkeletonKey, std::shared_ptr<const CompressedClip>> m_compressedClips;
+	const RenderPacket* m_pRenderPacket = nullptr;
+
 	// TODO : wrap them into another class?
 	engine::Entity m_selectedEntity = engine::INVALID_ENTITY;
 	engine::Entity m_mainCameraEntity = engine::INVALID_ENTITY;
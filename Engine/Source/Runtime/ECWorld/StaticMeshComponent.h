@@ -45,15 +45,10 @@ public:
 	const cd::AABB& GetAABB() const { return m_aabb; }
 	uint16_t GetVertexBuffer() const { return m_vertexBufferHandle; }
 	uint16_t GetIndexBuffer() const { return m_indexBufferHandle; }
-	uint16_t GetAABBVertexBuffer() const { return m_aabbVBH; }
-	uint16_t GetAABBIndexBuffer() const { return m_aabbIBH; }
 
 	void Reset();
 	void Build();
 
-private:
-	void BuildDebug();
-
 private:
 	// Input
 	const cd::Mesh* m_pMeshData = nullptr;
@@ -67,10 +62,6 @@ private:
 
 	// For debug use
 	cd::AABB m_aabb;
-	std::vector<std::byte> m_aabbVertexBuffer;
-	std::vector<std::byte> m_aabbIndexBuffer;
-	uint16_t m_aabbVBH = UINT16_MAX;
-	uint16_t m_aabbIBH = UINT16_MAX;
 };
 
 }
\ No newline at end of file
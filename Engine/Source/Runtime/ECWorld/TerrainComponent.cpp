@@ -1,29 +1,145 @@
 #include "TerrainComponent.h"
 
+#include <algorithm>
+#include <limits>
+
 namespace engine
 {
 
-void TerrainComponent::InitElevationRawData()
+namespace
+{
+
+uint32_t GetArea(const TerrainComponent::ElevationRect& rect)
 {
-    std::optional<std::vector<std::byte>> optMap = GenerateElevationMap(m_texWidth, m_texDepth, m_roughness, m_minHeight, m_maxHeight);//std::vector<std::byte>129U
-    assert(optMap.has_value());
-    SetElevationRawData(optMap.value());
+	return (rect.maxX - rect.minX + 1U) * (rect.maxZ - rect.minZ + 1U);
 }
 
-void TerrainComponent::SetElevationRawDataAt(uint16_t x, uint16_t z, float data) {
-	float temp = 30.0f;
-	std::byte* bytePtr = reinterpret_cast<std::byte*>(&data);
-	for (uint16_t i = 0U; i < sizeof(float); ++i)
+TerrainComponent::ElevationRect GetUnion(const TerrainComponent::ElevationRect& a, const TerrainComponent::ElevationRect& b)
+{
+	return { std::min(a.minX, b.minX), std::min(a.minZ, b.minZ), std::max(a.maxX, b.maxX), std::max(a.maxZ, b.maxZ) };
+}
+
+bool IsContaining(const TerrainComponent::ElevationRect& outer, const TerrainComponent::ElevationRect& inner)
+{
+	return outer.minX <= inner.minX && outer.minZ <= inner.minZ && outer.maxX >= inner.maxX && outer.maxZ >= inner.maxZ;
+}
+
+// Touching rectangles are merged too as their union costs nothing more to upload.
+bool IsOverlappingOrTouching(const TerrainComponent::ElevationRect& a, const TerrainComponent::ElevationRect& b)
+{
+	return a.minX <= b.maxX + 1U && b.minX <= a.maxX + 1U && a.minZ <= b.maxZ + 1U && b.minZ <= a.maxZ + 1U;
+}
+
+}
+
+void TerrainComponent::InitElevationRawData(ThreadPool* pThreadPool)
+{
+    std::vector<float> heights(static_cast<size_t>(m_texWidth) * m_texDepth);
+    GenerateElevationMap(m_texWidth, m_texDepth, m_elevationMapSettings, heights.data(), pThreadPool);
+    SetElevationRawData(heights.data(), m_elevationMapSettings.minHeight, m_elevationMapSettings.maxHeight);
+}
+
+void TerrainComponent::SetElevationRawData(const float* pHeights, float minHeight, float maxHeight)
+{
+	m_minHeight = minHeight;
+	m_maxHeight = maxHeight;
+	m_elevationSamples.resize(static_cast<size_t>(m_texWidth) * m_texDepth);
+	QuantizedHeights elevations = GetElevations();
+	for (size_t sampleIndex = 0; sampleIndex < m_elevationSamples.size(); ++sampleIndex)
 	{
-		m_elevationRawData[(z * m_texWidth + x) * sizeof(float) + i] = bytePtr[i];
+		m_elevationSamples[sampleIndex] = elevations.Quantize(pHeights[sampleIndex]);
 	}
+
+	m_quadTree.Build(elevations, m_texWidth, m_texDepth);
+	m_heightPyramid.Build(elevations, m_texWidth, m_texDepth);
+	m_normalMap.Build(elevations, m_texWidth, m_texDepth);
+	m_hasPendingEdits = false;
+
+	m_elevationDirtyRects.clear();
+	m_elevationDirtyRects.push_back({ 0U, 0U, static_cast<uint16_t>(m_texWidth - 1U), static_cast<uint16_t>(m_texDepth - 1U) });
+}
+
+void TerrainComponent::MarkElevationDirty(const ElevationRect& rect)
+{
+	m_pendingEditRect = m_hasPendingEdits ? GetUnion(m_pendingEditRect, rect) : rect;
+	m_hasPendingEdits = true;
+
+	// Brushes mark their area first, so the samples they write afterwards are already covered.
+	for (const ElevationRect& dirtyRect : m_elevationDirtyRects)
+	{
+		if (IsContaining(dirtyRect, rect))
+		{
+			return;
+		}
+	}
+
+	// A merge can make the result reach other rectangles, so repeat until nothing is left to merge.
+	ElevationRect mergedRect = rect;
+	bool isMerged = true;
+	while (isMerged)
+	{
+		isMerged = false;
+		for (size_t rectIndex = 0; rectIndex < m_elevationDirtyRects.size(); ++rectIndex)
+		{
+			if (IsOverlappingOrTouching(m_elevationDirtyRects[rectIndex], mergedRect))
+			{
+				mergedRect = GetUnion(m_elevationDirtyRects[rectIndex], mergedRect);
+				m_elevationDirtyRects[rectIndex] = m_elevationDirtyRects.back();
+				m_elevationDirtyRects.pop_back();
+				isMerged = true;
+				break;
+			}
+		}
+	}
+
+	if (m_elevationDirtyRects.size() < MaxElevationDirtyRectCount)
+	{
+		m_elevationDirtyRects.push_back(mergedRect);
+		return;
+	}
+
+	size_t bestRectIndex = 0;
+	uint32_t bestGrowth = UINT32_MAX;
+	for (size_t rectIndex = 0; rectIndex < m_elevationDirtyRects.size(); ++rectIndex)
+	{
+		uint32_t growth = GetArea(GetUnion(m_elevationDirtyRects[rectIndex], mergedRect)) - GetArea(m_elevationDirtyRects[rectIndex]);
+		if (growth < bestGrowth)
+		{
+			bestGrowth = growth;
+			bestRectIndex = rectIndex;
+		}
+	}
+	m_elevationDirtyRects[bestRectIndex] = GetUnion(m_elevationDirtyRects[bestRectIndex], mergedRect);
+}
+
+void TerrainComponent::UpdateHeightStructures()
+{
+	if (!m_hasPendingEdits)
+	{
+		return;
+	}
+
+	QuantizedHeights elevations = GetElevations();
+	m_quadTree.UpdateRegion(elevations, m_pendingEditRect.minX, m_pendingEditRect.minZ, m_pendingEditRect.maxX, m_pendingEditRect.maxZ);
+	m_heightPyramid.UpdateRegion(elevations, m_pendingEditRect.minX, m_pendingEditRect.minZ, m_pendingEditRect.maxX, m_pendingEditRect.maxZ);
+	m_normalMap.UpdateRegion(elevations, m_pendingEditRect.minX, m_pendingEditRect.minZ, m_pendingEditRect.maxX, m_pendingEditRect.maxZ);
+	m_hasPendingEdits = false;
+}
+
+bool TerrainComponent::Raycast(const cd::Point& origin, const cd::Direction& direction, float maxDistance, TerrainHeightPyramid::RayHit& hit)
+{
+	UpdateHeightStructures();
+	return m_heightPyramid.Raycast(GetElevations(), origin, direction, maxDistance, hit);
+}
+
+void TerrainComponent::SetElevationRawDataAt(uint16_t x, uint16_t z, float data) {
+	m_elevationSamples[z * m_texWidth + x] = GetElevations().Quantize(data);
+	MarkElevationDirty({ x, z, x, z });
 }
 
 float TerrainComponent::GetElevationRawDataAt(uint16_t x, uint16_t z)
 {
-	float data;
-	memcpy(&data, &m_elevationRawData[(z * m_texWidth + x) * sizeof(float)], sizeof(data));
-	return data;
+	return GetElevations()[z * m_texWidth + x];
 }
 
 void TerrainComponent::SmoothElevationRawDataAround(uint16_t x, uint16_t z, int16_t brushSize, float power)
@@ -52,6 +168,12 @@ void TerrainComponent::SmoothElevationRawDataAround(uint16_t x, uint16_t z, int1
 	}
 
 	float average = sum / count;
+	if (count > 0U)
+	{
+		MarkElevationDirty({ static_cast<uint16_t>(std::max(x - brushSize, 0)), static_cast<uint16_t>(std::max(z - brushSize, 0)),
+			static_cast<uint16_t>(std::min(x + brushSize - 1, m_texWidth - 1)), static_cast<uint16_t>(std::min(z + brushSize - 1, m_texDepth - 1)) });
+	}
+
 	for (area_z = -brushSize; area_z < brushSize; ++area_z)
 	{
 		for (area_x = -brushSize; area_x < brushSize; ++area_x)
@@ -92,22 +214,13 @@ void TerrainComponent::ScreenSpaceSmooth(float screenSpaceX, float screenSpaceY,
     cd::Vec4f ray_world = invViewMtx * ray_eye;
     cd::Vec3f rayDir = ray_world.xyz().Normalize();
 
-    for (int i = 0; i < 1000; ++i)
+    TerrainHeightPyramid::RayHit hit;
+    if (Raycast(camPos, rayDir, std::numeric_limits<float>::max(), hit))
     {
-        camPos = camPos + rayDir;
-        uint32_t posX = static_cast<uint32_t>(camPos.x());
-        uint32_t posZ = static_cast<uint32_t>(camPos.z());
-        if (posX < 0U || posX >= 129U || posZ < 0U || posZ >= 129U)
-        {
-            continue;
-        }
-
-        float terrainY = GetElevationRawDataAt(posX, posZ);
-        if (camPos.y() < (terrainY))
-        {
-            SmoothElevationRawDataAround(posX, posZ, 10, 0.5f);
-            break;
-        }
+        // Brush on the nearest sample.
+        uint16_t posX = static_cast<uint16_t>(std::clamp(hit.position.x() + 0.5f, 0.0f, static_cast<float>(m_texWidth - 1)));
+        uint16_t posZ = static_cast<uint16_t>(std::clamp(hit.position.z() + 0.5f, 0.0f, static_cast<float>(m_texDepth - 1)));
+        SmoothElevationRawDataAround(posX, posZ, 10, 0.5f);
     }
 }
 
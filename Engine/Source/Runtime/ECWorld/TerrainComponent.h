@@ -4,6 +4,9 @@
 #include "ECWorld/Entity.h"
 #include "Math/Box.hpp"
 #include "Scene/Mesh.h"
+#include "Terrain/TerrainHeightPyramid.h"
+#include "Terrain/TerrainNormalMap.h"
+#include "Terrain/TerrainQuadTree.h"
 #include "Terrain/TerrainUtils.h"
 
 #include <cstdint>
@@ -26,6 +29,18 @@ public:
 		return className;
 	}
 
+	// Inclusive rectangle of elevation samples.
+	struct ElevationRect
+	{
+		uint16_t minX;
+		uint16_t minZ;
+		uint16_t maxX;
+		uint16_t maxZ;
+	};
+
+	// Past this count a new rectangle is merged into the one it grows the least.
+	static constexpr uint32_t MaxElevationDirtyRectCount = 8U;
+
 public:
 	TerrainComponent() = default;
 	TerrainComponent(const TerrainComponent&) = default;
@@ -44,10 +59,17 @@ public:
 	void SetTexDepth(const uint16_t depth) { m_texDepth = depth; }
 	uint16_t GetTexDepth() const { return m_texDepth; }
 	
-	void InitElevationRawData();
-	void SetElevationRawData(std::vector<std::byte> data) { m_elevationRawData = data; }
-	const std::byte* GetElevationRawData() const { return m_elevationRawData.data(); }
-	uint32_t GetElevationRawDataSize() const {return static_cast<uint32_t>(m_elevationRawData.size()); }
+	void SetElevationMapSettings(const ElevationMapSettings& settings) { m_elevationMapSettings = settings; }
+	const ElevationMapSettings& GetElevationMapSettings() const { return m_elevationMapSettings; }
+
+	// Generates the heightfield from the settings, over the thread pool when one is given.
+	void InitElevationRawData(ThreadPool* pThreadPool = nullptr);
+	// Quantizes texWidth * texDepth heights to 16 bits over [minHeight, maxHeight]. Heights outside of it are clamped.
+	void SetElevationRawData(const float* pHeights, float minHeight, float maxHeight);
+	QuantizedHeights GetElevations() const { return QuantizedHeights::FromRange(m_elevationSamples.data(), m_minHeight, m_maxHeight); }
+	float GetMinHeight() const { return m_minHeight; }
+	float GetMaxHeight() const { return m_maxHeight; }
+	uint32_t GetElevationRawDataSize() const { return static_cast<uint32_t>(m_elevationSamples.size() * sizeof(uint16_t)); }
 
 	void SetElevationRawDataAt(uint16_t x, uint16_t z, float data);
 	float GetElevationRawDataAt(uint16_t x, uint16_t z);
@@ -56,6 +78,22 @@ public:
 	
 	void ScreenSpaceSmooth(float screenSpaceX, float screenSpaceY, cd::Matrix4x4 invProjMtx, cd::Matrix4x4 invViewMtx, cd::Vec3f camPos);
 
+	// Samples changed since the renderer last uploaded them. Edits above mark them, overlapping and
+	// touching rectangles are merged. SetElevationRawData marks the whole heightfield.
+	void MarkElevationDirty(const ElevationRect& rect);
+	const std::vector<ElevationRect>& GetElevationDirtyRects() const { return m_elevationDirtyRects; }
+	void ClearElevationDirtyRects() { m_elevationDirtyRects.clear(); }
+
+	// Patch LOD, min/max pyramid and normals of the elevation data. Edits are applied to them lazily by UpdateHeightStructures.
+	void UpdateHeightStructures();
+	TerrainQuadTree& GetQuadTree() { return m_quadTree; }
+	const TerrainQuadTree& GetQuadTree() const { return m_quadTree; }
+	const TerrainHeightPyramid& GetHeightPyramid() const { return m_heightPyramid; }
+	const TerrainNormalMap& GetNormalMap() const { return m_normalMap; }
+
+	// Exact hit against the heightfield triangles in local terrain space, pending edits included.
+	bool Raycast(const cd::Point& origin, const cd::Direction& direction, float maxDistance, TerrainHeightPyramid::RayHit& hit);
+
 private:
 	//mesh
 	uint16_t m_meshWidth = 129U;//uint32_t is too big for width
@@ -64,15 +102,23 @@ private:
 	//height map input
 	uint16_t m_texWidth = 129U;//uint32_t is too big for width
 	uint16_t m_texDepth = 129U;//
-	float m_roughness = 1.55f;
-	float m_minHeight = 0.0f;
-	float m_maxHeight = 30.0f;
+	ElevationMapSettings m_elevationMapSettings;
 	
 	//for patch wise generating
 	//uint32_t m_PatchSize;
 
 	//height map output
-	std::vector<std::byte> m_elevationRawData;
+	std::vector<uint16_t> m_elevationSamples;
+	float m_minHeight = 0.0f;
+	float m_maxHeight = 0.0f;
+	std::vector<ElevationRect> m_elevationDirtyRects;
+
+	TerrainQuadTree m_quadTree;
+	TerrainHeightPyramid m_heightPyramid;
+	TerrainNormalMap m_normalMap;
+	// Union of the edits not applied to the height structures yet.
+	bool m_hasPendingEdits = false;
+	ElevationRect m_pendingEditRect;
 };
 
 }
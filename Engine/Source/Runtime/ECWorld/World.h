@@ -58,6 +58,17 @@ public:
 		return pStorage->CreateComponent(entity);
 	}
 
+	// Changes whenever any component is created or removed. In place edits of component data are not tracked.
+	uint32_t GetComponentsVersion() const
+	{
+		uint32_t version = 0U;
+		for (const auto& [_, pStorage] : m_componentsLib)
+		{
+			version += pStorage->GetVersion();
+		}
+		return version;
+	}
+
 private:
 	std::unordered_map<size_t, std::unique_ptr<IComponentsStorage>> m_componentsLib;
 };
@@ -392,7 +392,7 @@ void ImGuiContextInstance::AddInputEvent()
 		m_lastMousePositionY = mousePosY;
 	}
 
-	const std::vector<Input::KeyEvent> keyEvents = Input::Get().GetKeyEventList();
+	const std::vector<Input::KeyEvent>& keyEvents = Input::Get().GetKeyEventList();
 	for (uint32_t i = 0; i < keyEvents.size(); ++i)
 	{
 		const Input::KeyEvent keyEvent = keyEvents[i];
@@ -20,8 +20,28 @@ Process::~Process()
 }
 
 void Process::Run()
+{
+	if (!Start())
+	{
+		return;
+	}
+
+	if (m_printChildProcessLog || m_waitUntilFinished)
+	{
+		ReadLog();
+	}
+
+	if (m_waitUntilFinished)
+	{
+		Join();
+	}
+}
+
+bool Process::Start()
 {
 	m_pProcess = std::make_unique<subprocess_s>();
+	m_log.clear();
+	m_exitCode = -1;
 
 	std::vector<const char*> commandLine;
 	commandLine.push_back(m_processName.c_str());
@@ -39,7 +59,12 @@ void Process::Run()
 	environments.push_back(nullptr);
 
 	int processOptions = subprocess_option_combined_stdout_stderr | subprocess_option_no_window | subprocess_option_enable_async;
-	subprocess_create_ex(commandLine.data(), processOptions, environments.data(), m_pProcess.get());
+	if (0 != subprocess_create_ex(commandLine.data(), processOptions, environments.data(), m_pProcess.get()))
+	{
+		CD_ENGINE_ERROR("Failed to start process {0}", m_processName.c_str());
+		m_pProcess.reset();
+		return false;
+	}
 
 	// LOG
 	CD_ENGINE_INFO("Start process {0}", m_processName.c_str());
@@ -53,38 +78,48 @@ void Process::Run()
 		CD_ENGINE_TRACE("\tEnvironment {0}", environments[i]);
 	}
 
-	// Read logs from process.
-	using SubProcessReadLogFunction = unsigned (*)(struct subprocess_s* const, char* const, unsigned);
-	auto PrintSubProcessLog = [](const char* pTagName, subprocess_s* const pSubProcess, SubProcessReadLogFunction readMethod)
+	return true;
+}
+
+void Process::ReadLog()
+{
+	if (!m_pProcess)
+	{
+		return;
+	}
+
+	// stderr goes to stdout. The child blocks once the pipe is full, so it is drained even when the log isn't printed.
+	char processOutputData[4096];
+	uint32_t processOutputDataReadBytes = 0U;
+	do
 	{
-		static char processOutputData[65536] = { 0 };
-		uint32_t processOutputDataIndex = 0U;
-		uint32_t processOutputDataReadBytes = 0U;
-
-		do
-		{
-			processOutputDataReadBytes = readMethod(pSubProcess, processOutputData + processOutputDataIndex, sizeof(processOutputData) - 1 - processOutputDataIndex);
-			processOutputDataIndex += processOutputDataReadBytes;
-		} while (processOutputDataReadBytes != 0U);
-
-		if (processOutputDataIndex > 0U)
-		{
-			// Logs from child process's stdout maybe error info because many tool authors will use stdout to print rather than stderr.
-			CD_ENGINE_ERROR("{0}\n{1}", pTagName, processOutputData);
-		}
-	};
-
-	if (m_printChildProcessLog)
+		processOutputDataReadBytes = subprocess_read_stdout(m_pProcess.get(), processOutputData, sizeof(processOutputData));
+		m_log.append(processOutputData, processOutputDataReadBytes);
+	} while (processOutputDataReadBytes != 0U);
+
+	if (m_printChildProcessLog && !m_log.empty())
 	{
-		PrintSubProcessLog("StdErr", m_pProcess.get(), subprocess_read_stderr);
+		// Logs from child process's stdout maybe error info because many tool authors will use stdout to print rather than stderr.
+		CD_ENGINE_ERROR("{0}\n{1}", m_processName.c_str(), m_log.c_str());
 	}
+}
 
-	if (m_waitUntilFinished)
+int Process::Join()
+{
+	if (m_pProcess && 0 == subprocess_join(m_pProcess.get(), &m_exitCode))
 	{
-		int processResult;
-		subprocess_join(m_pProcess.get(), &processResult);
 		CD_ENGINE_INFO("End process {0}", m_processName.c_str());
 	}
+
+	return m_exitCode;
+}
+
+void Process::Terminate()
+{
+	if (m_pProcess)
+	{
+		subprocess_terminate(m_pProcess.get());
+	}
 }
 
 }
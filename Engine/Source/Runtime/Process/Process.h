@@ -26,14 +26,31 @@ public:
 	void SetWaitUntilFinished(bool doWait) { m_waitUntilFinished = doWait; }
 	void SetCommandArguments(std::vector<std::string> arguments) { m_commandArguments = cd::MoveTemp(arguments); }
 	void SetEnvironments(std::vector<std::string> environments) { m_environments = cd::MoveTemp(environments); }
+	const std::string& GetProcessName() const { return m_processName; }
+
+	// Start, then read the log and wait depending on the settings above.
 	void Run();
 
+	// Start only creates the child process. ReadLog blocks until the child closes its output, which happens when it exits
+	// or is terminated, and Join collects the exit code. Terminate may be called from another thread before Join.
+	bool Start();
+	void ReadLog();
+	int Join();
+	int Wait() { ReadLog(); return Join(); }
+	void Terminate();
+
+	int GetExitCode() const { return m_exitCode; }
+	// Combined stdout and stderr of the child process.
+	const std::string& GetLog() const { return m_log; }
+
 private:
 	std::unique_ptr<subprocess_s> m_pProcess;
 
 	std::string m_processName;
 	std::vector<std::string> m_commandArguments;
 	std::vector<std::string> m_environments;
+	std::string m_log;
+	int m_exitCode = -1;
 	bool m_waitUntilFinished = false;
 	bool m_printChildProcessLog = true;
 };
@@ -55,7 +72,7 @@ class Process final
 {
 public:
 	Process() = delete;
-	explicit Process(const char*) {}
+	explicit Process(const char* pProcessName) : m_processName(pProcessName) {}
 	Process(const Process&) = delete;
 	Process& operator=(const Process&) = delete;
 	Process(Process&&) = default;
@@ -66,7 +83,22 @@ public:
 	void SetWaitUntilFinished(bool doWait) {}
 	void SetCommandArguments(std::vector<std::string> arguments) {}
 	void SetEnvironments(std::vector<std::string> environments) {}
+	const std::string& GetProcessName() const { return m_processName; }
+
 	void Run() {}
+
+	bool Start() { return true; }
+	void ReadLog() {}
+	int Join() { return 0; }
+	int Wait() { return 0; }
+	void Terminate() {}
+
+	int GetExitCode() const { return 0; }
+	const std::string& GetLog() const { return m_log; }
+
+private:
+	std::string m_processName;
+	std::string m_log;
 };
 
 }
@@ -0,0 +1,177 @@
+#include "ProcessPool.h"
+
+#include <algorithm>
+#include <thread>
+
+namespace editor
+{
+
+uint32_t ProcessPool::GetDefaultMaxProcessCount()
+{
+	return std::max(std::thread::hardware_concurrency(), 1U);
+}
+
+ProcessPool::ProcessPool(uint32_t maxProcessCount)
+	: m_maxProcessCount(std::max(maxProcessCount, 1U))
+{
+}
+
+uint32_t ProcessPool::Add(Process process)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_processes.push_back(cd::MoveTemp(process));
+	m_taskStates.push_back(TaskState::Pending);
+	return static_cast<uint32_t>(m_processes.size() - 1U);
+}
+
+void ProcessPool::Run(const ResultFunction& onResult)
+{
+	std::vector<std::thread> workers;
+	while (true)
+	{
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			if (workers.empty() && m_isRunning)
+			{
+				uint32_t runIndex = m_finishedRunCount;
+				m_runFinishedCondition.wait(lock, [this, runIndex]() { return runIndex != m_finishedRunCount; });
+				return;
+			}
+
+			// Workers leave once nothing is left to start, so processes added after that need a new round.
+			uint32_t startableCount = static_cast<uint32_t>(m_processes.size()) - m_nextStartIndex;
+			if (0U == startableCount)
+			{
+				m_processes.clear();
+				m_taskStates.clear();
+				m_nextStartIndex = 0U;
+				m_nextReportIndex = 0U;
+				m_isRunning = false;
+				m_isCancelled = false;
+				++m_finishedRunCount;
+				m_runFinishedCondition.notify_all();
+				return;
+			}
+
+			m_isRunning = true;
+			workers.clear();
+			for (uint32_t workerIndex = 0U, workerCount = std::min(startableCount, m_maxProcessCount); workerIndex < workerCount; ++workerIndex)
+			{
+				workers.emplace_back([this, &onResult]() { WorkerLoop(onResult); });
+			}
+		}
+
+		for (std::thread& worker : workers)
+		{
+			worker.join();
+		}
+	}
+}
+
+void ProcessPool::WorkerLoop(const ResultFunction& onResult)
+{
+	while (true)
+	{
+		Process* pProcess = nullptr;
+		uint32_t processIndex;
+		bool isStarted = false;
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			if (m_nextStartIndex == m_processes.size())
+			{
+				return;
+			}
+
+			processIndex = m_nextStartIndex++;
+			if (m_isCancelled)
+			{
+				m_taskStates[processIndex] = TaskState::Cancelled;
+			}
+			else
+			{
+				// Starting under the lock also keeps the pipe handles of one child from being inherited by another on Windows.
+				pProcess = &m_processes[processIndex];
+				isStarted = pProcess->Start();
+				m_taskStates[processIndex] = isStarted ? TaskState::Running : TaskState::Finished;
+			}
+		}
+
+		if (isStarted)
+		{
+			pProcess->ReadLog();
+
+			// Cancel may only terminate the child until it is joined, after which its id can be reused.
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				m_taskStates[processIndex] = TaskState::Exiting;
+			}
+			pProcess->Join();
+
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_taskStates[processIndex] = TaskState::Finished;
+		}
+
+		ReportFinishedTasks(onResult);
+	}
+}
+
+void ProcessPool::ReportFinishedTasks(const ResultFunction& onResult)
+{
+	std::lock_guard<std::mutex> reportLock(m_reportMutex);
+
+	struct Result
+	{
+		const Process* pProcess;
+		bool isCancelled;
+	};
+
+	uint32_t beginIndex;
+	std::vector<Result> results;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		beginIndex = m_nextReportIndex;
+		for (uint32_t processIndex = beginIndex; processIndex < m_nextStartIndex; ++processIndex)
+		{
+			TaskState taskState = m_taskStates[processIndex];
+			if (TaskState::Finished != taskState && TaskState::Cancelled != taskState)
+			{
+				break;
+			}
+			results.push_back({ &m_processes[processIndex], TaskState::Cancelled == taskState });
+		}
+	}
+
+	for (uint32_t resultIndex = 0U; resultIndex < results.size(); ++resultIndex)
+	{
+		onResult(beginIndex + resultIndex, *results[resultIndex].pProcess, results[resultIndex].isCancelled);
+	}
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_nextReportIndex = beginIndex + static_cast<uint32_t>(results.size());
+}
+
+void ProcessPool::Cancel()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	if (m_processes.empty())
+	{
+		return;
+	}
+
+	m_isCancelled = true;
+	for (uint32_t processIndex = m_nextReportIndex; processIndex < m_nextStartIndex; ++processIndex)
+	{
+		if (TaskState::Running == m_taskStates[processIndex])
+		{
+			m_processes[processIndex].Terminate();
+		}
+	}
+}
+
+uint32_t ProcessPool::GetPendingCount() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return static_cast<uint32_t>(m_processes.size()) - m_nextReportIndex;
+}
+
+}
\ No newline at end of file
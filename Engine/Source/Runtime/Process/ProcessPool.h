@@ -0,0 +1,84 @@
+#pragma once
+
+#include "Process/Process.h"
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+namespace editor
+{
+
+// Runs external processes with at most a fixed number of them alive at once. Every slot is a thread which mostly
+// waits on its child process, so the count is about cores used by the children rather than by the pool.
+// Results are reported in the order processes were added, so build logs read the same whatever finished first.
+class ProcessPool final
+{
+public:
+	// Called once per process, as soon as it and every process added before it are done.
+	// Processes dropped by Cancel before they started are reported with isCancelled too.
+	using ResultFunction = std::function<void(uint32_t processIndex, const Process& process, bool isCancelled)>;
+
+	// One child process per hardware thread.
+	static uint32_t GetDefaultMaxProcessCount();
+
+public:
+	explicit ProcessPool(uint32_t maxProcessCount = GetDefaultMaxProcessCount());
+	ProcessPool(const ProcessPool&) = delete;
+	ProcessPool& operator=(const ProcessPool&) = delete;
+	ProcessPool(ProcessPool&&) = delete;
+	ProcessPool& operator=(ProcessPool&&) = delete;
+	~ProcessPool() = default;
+
+	uint32_t GetMaxProcessCount() const { return m_maxProcessCount; }
+
+	// Thread safe. Returns the index passed to ResultFunction, indices restart from 0 once the pool is empty.
+	uint32_t Add(Process process);
+
+	// Runs the processes added so far and the ones added meanwhile, and returns once all of them are reported.
+	// When another thread is already running the pool, it picks up the new processes and reports them through its own
+	// onResult, and this call waits until that run is done.
+	void Run(const ResultFunction& onResult);
+
+	// Thread safe. Drops processes which didn't start and terminates running ones, until the pool is empty again.
+	void Cancel();
+
+	// Processes added but not reported yet.
+	uint32_t GetPendingCount() const;
+	bool IsEmpty() const { return 0U == GetPendingCount(); }
+
+private:
+	enum class TaskState : uint8_t
+	{
+		Pending,
+		Running,
+		Exiting,
+		Finished,
+		Cancelled,
+	};
+
+	void WorkerLoop(const ResultFunction& onResult);
+	void ReportFinishedTasks(const ResultFunction& onResult);
+
+	uint32_t m_maxProcessCount;
+
+	mutable std::mutex m_mutex;
+	// A deque keeps processes in place while others are added, so workers use them outside of the lock.
+	std::deque<Process> m_processes;
+	std::vector<TaskState> m_taskStates;
+	uint32_t m_nextStartIndex = 0U;
+	uint32_t m_nextReportIndex = 0U;
+	bool m_isRunning = false;
+	bool m_isCancelled = false;
+	// Counts the runs which emptied the pool, so waiting callers can tell that theirs is over.
+	uint32_t m_finishedRunCount = 0U;
+	std::condition_variable m_runFinishedCondition;
+
+	// Held while results are reported so that two workers can't interleave their ranges.
+	std::mutex m_reportMutex;
+};
+
+}
\ No newline at end of file
@@ -1,18 +1,26 @@
 #include "AABBRenderer.h"
 
-#include "Core/StringCrc.h"
+#include "Animation/SkeletonBinding.h"
 #include "ECWorld/SceneWorld.h"
 #include "ECWorld/StaticMeshComponent.h"
 #include "ECWorld/TransformComponent.h"
 #include "RenderContext.h"
-#include "Scene/Texture.h"
+#include "RenderPacket.h"
 
 namespace engine
 {
 
+namespace
+{
+
+constexpr uint32_t aabbColor = 0xFF0000FF;
+constexpr uint32_t boneColor = 0xFF00FFFF;
+
+}
+
 void AABBRenderer::Init()
 {
-	GetRenderContext()->CreateProgram("AABBProgram", "vs_AABB.bin", "fs_AABB.bin");
+	m_debugDraw.Init();
 	bgfx::setViewName(GetViewID(), "AABBRenderer");
 }
 
@@ -22,7 +30,7 @@ void AABBRenderer::UpdateView(const float* pViewMatrix, const float* pProjection
 	bgfx::setViewTransform(GetViewID(), pViewMatrix, pProjectionMatrix);
 }
 
-void AABBRenderer::RenderAll(float deltaTime)
+void AABBRenderer::AddAll()
 {
 	for (Entity entity : m_pCurrentSceneWorld->GetStaticMeshEntities())
 	{
@@ -46,23 +54,16 @@ void AABBRenderer::RenderAll(float deltaTime)
 		if (TransformComponent* pTransformComponent = m_pCurrentSceneWorld->GetTransformComponent(entity))
 		{
 			pTransformComponent->Build();
-			bgfx::setTransform(pTransformComponent->GetWorldMatrix().Begin());
+			m_debugDraw.AddBox(pMeshComponent->GetAABB(), GetRenderWorldMatrix(*m_pCurrentSceneWorld, entity, *pTransformComponent), aabbColor);
+		}
+		else
+		{
+			m_debugDraw.AddBox(pMeshComponent->GetAABB(), aabbColor);
 		}
-
-		bgfx::setVertexBuffer(0, bgfx::VertexBufferHandle{ pMeshComponent->GetAABBVertexBuffer() });
-		bgfx::setIndexBuffer(bgfx::IndexBufferHandle{ pMeshComponent->GetAABBIndexBuffer() });
-
-		constexpr uint64_t state = BGFX_STATE_WRITE_MASK | BGFX_STATE_MSAA | BGFX_STATE_DEPTH_TEST_LESS |
-			BGFX_STATE_BLEND_FUNC(BGFX_STATE_BLEND_SRC_ALPHA, BGFX_STATE_BLEND_INV_SRC_ALPHA) | BGFX_STATE_PT_LINES;
-		bgfx::setState(state);
-
-		constexpr StringCrc AABBAllProgram("AABBProgram");
-		bgfx::submit(GetViewID(), GetRenderContext()->GetProgram(AABBAllProgram));
-
 	}
 }
 
-void AABBRenderer::RenderSelected(float deltaTime) 
+void AABBRenderer::AddSelected()
 {
 	Entity entity = m_pCurrentSceneWorld->GetSelectedEntity();
 	if (m_pCurrentSceneWorld->GetSkyEntity() == entity)
@@ -76,33 +77,53 @@ void AABBRenderer::RenderSelected(float deltaTime)
 		return;
 	}
 
+	cd::Matrix4x4 worldMatrix = cd::Matrix4x4::Identity();
 	if (TransformComponent* pTransformComponent = m_pCurrentSceneWorld->GetTransformComponent(entity))
 	{
 		pTransformComponent->Build();
-		bgfx::setTransform(pTransformComponent->GetWorldMatrix().Begin());
+		worldMatrix = GetRenderWorldMatrix(*m_pCurrentSceneWorld, entity, *pTransformComponent);
 	}
 
-	bgfx::setVertexBuffer(0, bgfx::VertexBufferHandle{ pMeshComponent->GetAABBVertexBuffer() });
-	bgfx::setIndexBuffer(bgfx::IndexBufferHandle{ pMeshComponent->GetAABBIndexBuffer() });
+	m_debugDraw.AddBox(pMeshComponent->GetAABB(), worldMatrix, aabbColor);
 
-	constexpr uint64_t state = BGFX_STATE_WRITE_MASK | BGFX_STATE_MSAA | BGFX_STATE_DEPTH_TEST_LESS |
-		BGFX_STATE_BLEND_FUNC(BGFX_STATE_BLEND_SRC_ALPHA, BGFX_STATE_BLEND_INV_SRC_ALPHA) | BGFX_STATE_PT_LINES;
-	bgfx::setState(state);
+	// Skeleton of the selected animated mesh, drawn over it.
+	AnimationComponent* pAnimationComponent = m_pCurrentSceneWorld->GetAnimationComponent(entity);
+	if (!pAnimationComponent || !pAnimationComponent->GetSkeletonBinding())
+	{
+		return;
+	}
+
+	const std::vector<uint32_t>& parentIndices = pAnimationComponent->GetSkeletonBinding()->GetParentIndices();
+	const std::vector<cd::Matrix4x4>& globalBoneTransforms = pAnimationComponent->GetGlobalBoneTransforms();
+	for (uint32_t boneIndex = 0U; boneIndex < globalBoneTransforms.size(); ++boneIndex)
+	{
+		uint32_t parentIndex = parentIndices[boneIndex];
+		if (SkeletonBinding::InvalidIndex == parentIndex)
+		{
+			continue;
+		}
 
-	constexpr StringCrc AABBProgram("AABBProgram");
-	bgfx::submit(GetViewID(), GetRenderContext()->GetProgram(AABBProgram));
+		cd::Point parentPosition = (worldMatrix * globalBoneTransforms[parentIndex]).GetTranslation();
+		cd::Point bonePosition = (worldMatrix * globalBoneTransforms[boneIndex]).GetTranslation();
+		m_debugDraw.AddBone(parentPosition, bonePosition, boneColor, DebugDraw::DepthMode::AlwaysOnTop);
+	}
 }
 
-void AABBRenderer::Render(float deltaTime)
+void AABBRenderer::Prepare()
 {
 	if (m_isRenderSelected) 
 	{
-		RenderSelected(deltaTime);
+		AddSelected();
 	}
 	else
 	{
-		RenderAll(deltaTime);
+		AddAll();
 	}
 }
 
+void AABBRenderer::Render(float deltaTime)
+{
+	m_debugDraw.Flush(GetViewID());
+}
+
 }
\ No newline at end of file
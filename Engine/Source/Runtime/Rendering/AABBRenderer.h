@@ -1,5 +1,6 @@
 #pragma once
 
+#include "DebugDraw.h"
 #include "Renderer.h"
 
 #include <vector>
@@ -16,17 +17,24 @@ public:
 
 	virtual void Init() override;
 	virtual void UpdateView(const float* pViewMatrix, const float* pProjectionMatrix) override;
+	// Boxes and bones are collected from the components here, Render only submits them.
+	virtual void Prepare() override;
 	virtual void Render(float deltaTime) override;
 
 	void SetSceneWorld(SceneWorld* pSceneWorld) { m_pCurrentSceneWorld = pSceneWorld; }
 	void SetIsRenderSelected(bool isRenderSelected) { m_isRenderSelected = isRenderSelected; }
 
+	const DebugDraw& GetDebugDraw() const { return m_debugDraw; }
+
 private:
-	void RenderSelected(float deltaTime);
-	void RenderAll(float deltaTime);
+	void AddSelected();
+	void AddAll();
 
 	SceneWorld* m_pCurrentSceneWorld = nullptr;
 	bool m_isRenderSelected = true;	//	false : all , true : selected
+
+	// Boxes of all meshes are batched into a few instanced draws.
+	DebugDraw m_debugDraw;
 };
 
 }
\ No newline at end of file
@@ -1,136 +1,35 @@
 #include "AnimationRenderer.h"
 
+#include "Core/FrameAllocator.h"
 #include "Core/StringCrc.h"
 #include "ECWorld/SceneWorld.h"
 #include "ECWorld/StaticMeshComponent.h"
 #include "ECWorld/TransformComponent.h"
 #include "RenderContext.h"
+#include "RenderPacket.h"
 #include "Scene/Texture.h"
 
-#include <cmath>
-//#include <format>
+#include "U_Skinning.sh"
 
-namespace engine
-{
+#include <cassert>
 
-namespace details
+namespace engine
 {
 
-float CustomFModf(float dividend, float divisor)
+namespace
 {
-	if (divisor == 0.0f)
-		return 0.0f;
 
-	int quotient = static_cast<int>(dividend / divisor);
-	float result = dividend - static_cast<float>(quotient) * divisor;
+constexpr uint32_t skinningPaletteBonesPerRow = SKINNING_PALETTE_WIDTH / SKINNING_PALETTE_TEXELS_PER_BONE;
+constexpr uint64_t skinningPaletteFlags = BGFX_TEXTURE_NONE | BGFX_SAMPLER_POINT | BGFX_SAMPLER_UVW_CLAMP;
 
-	// Handle potential precision issues near zero
-	if (result == 0.0f && dividend != 0.0f)
-		result = 0.0f;
-
-	// Ensure the result has the same sign as the divisor
-	if ((dividend < 0 && divisor > 0) || (dividend > 0 && divisor < 0))
-		result = -result;
-
-	return result;
 }
 
-void CalculateBoneTransform(std::vector<cd::Matrix4x4>& boneMatrices, const cd::SceneDatabase* pSceneDatabase,
-	float animationTime, const cd::Bone& bone, const cd::Matrix4x4& parentBoneTransform, const cd::Matrix4x4& globalInverse)
+AnimationRenderer::~AnimationRenderer()
 {
-	auto CalculateInterpolatedTranslation = [&animationTime](const cd::Track* pTrack) -> cd::Vec3f
-	{
-		if (1U == pTrack->GetTranslationKeyCount())
-		{
-			const auto& firstKey = pTrack->GetTranslationKeys()[0];
-			return firstKey.GetValue();
-		}
-
-		for (uint32_t keyIndex = 0U; keyIndex < pTrack->GetTranslationKeyCount() - 1; ++keyIndex)
-		{
-			const auto& nextKey = pTrack->GetTranslationKeys()[keyIndex + 1];
-			if (animationTime < nextKey.GetTime())
-			{
-				const auto& currentKey = pTrack->GetTranslationKeys()[keyIndex];
-				float keyFrameDeltaTime = nextKey.GetTime() - currentKey.GetTime();
-				float keyFrameRate = (animationTime - currentKey.GetTime()) / keyFrameDeltaTime;
-				assert(keyFrameRate >= 0.0f && keyFrameRate <= 1.0f);
-
-				return cd::Vec3f::Lerp(currentKey.GetValue(), nextKey.GetValue(), keyFrameRate);
-			}
-		}
-
-		return cd::Vec3f::Zero();
-	};
-
-	auto CalculateInterpolatedRotation = [&animationTime](const cd::Track* pTrack) -> cd::Quaternion
-	{
-		if (1U == pTrack->GetRotationKeyCount())
-		{
-			const auto& firstKey = pTrack->GetRotationKeys()[0];
-			return firstKey.GetValue();
-		}
-
-		for (uint32_t keyIndex = 0U; keyIndex < pTrack->GetRotationKeyCount() - 1; ++keyIndex)
-		{
-			const auto& nextKey = pTrack->GetRotationKeys()[keyIndex + 1];
-			if (animationTime < nextKey.GetTime())
-			{
-				const auto& currentKey = pTrack->GetRotationKeys()[keyIndex];
-				float keyFrameDeltaTime = nextKey.GetTime() - currentKey.GetTime();
-				float keyFrameRate = (animationTime - currentKey.GetTime()) / keyFrameDeltaTime;
-				assert(keyFrameRate >= 0.0f && keyFrameRate <= 1.0f);
-
-				return cd::Quaternion::Lerp(currentKey.GetValue(), nextKey.GetValue(), keyFrameRate).Normalize();
-			}
-		}
-
-		return cd::Quaternion::Identity();
-	};
-
-	auto CalculateInterpolatedScale = [&animationTime](const cd::Track* pTrack) -> cd::Vec3f
-	{
-		if (1U == pTrack->GetScaleKeyCount())
-		{
-			const auto& firstKey = pTrack->GetScaleKeys()[0];
-			return firstKey.GetValue();
-		}
-
-		for (uint32_t keyIndex = 0U; keyIndex < pTrack->GetScaleKeyCount() - 1; ++keyIndex)
-		{
-			const auto& nextKey = pTrack->GetScaleKeys()[keyIndex + 1];
-			if (animationTime < nextKey.GetTime())
-			{
-				const auto& currentKey = pTrack->GetScaleKeys()[keyIndex];
-				float keyFrameDeltaTime = nextKey.GetTime() - currentKey.GetTime();
-				float keyFrameRate = (animationTime - currentKey.GetTime()) / keyFrameDeltaTime;
-				assert(keyFrameRate >= 0.0f && keyFrameRate <= 1.0f);
-
-				return cd::Vec3f::Lerp(currentKey.GetValue(), nextKey.GetValue(), keyFrameRate);
-			}
-		}
-
-		return cd::Vec3f::One();
-	};
-
-	cd::Matrix4x4 boneLocalTransform = bone.GetTransform().GetMatrix();
-	if (const cd::Track* pTrack = pSceneDatabase->GetTrackByName(bone.GetName()))
-	{
-		boneLocalTransform = cd::Transform(CalculateInterpolatedTranslation(pTrack),
-									  CalculateInterpolatedRotation(pTrack),
-									  CalculateInterpolatedScale(pTrack)).GetMatrix();
-	}
-
-	cd::Matrix4x4 globalTransform = parentBoneTransform * boneLocalTransform;
-	boneMatrices[bone.GetID().Data()] = globalInverse * globalTransform * bone.GetOffset();
-
-	for (cd::BoneID boneID : bone.GetChildIDs())
+	if (bgfx::isValid(m_skinningPaletteTexture))
 	{
-		const cd::Bone& childBone = pSceneDatabase->GetBone(boneID.Data());
-		CalculateBoneTransform(boneMatrices, pSceneDatabase, animationTime, childBone, globalTransform, globalInverse);
+		bgfx::destroy(m_skinningPaletteTexture);
 	}
-};
-
 }
 
 void AnimationRenderer::Init()
@@ -142,6 +41,9 @@ void AnimationRenderer::Init()
 	GetRenderContext()->CreateProgram("AnimationProgram", "vs_animation.bin", "fs_animation.bin");
 #endif
 
+	m_skinningPaletteSampler = GetRenderContext()->CreateUniform("s_skinningPalette", bgfx::UniformType::Sampler);
+	m_skinningParams = GetRenderContext()->CreateUniform("u_skinningParams", bgfx::UniformType::Vec4);
+
 	bgfx::setViewName(GetViewID(), "AnimationRenderer");
 }
 
@@ -151,6 +53,39 @@ void AnimationRenderer::UpdateView(const float* pViewMatrix, const float* pProje
 	bgfx::setViewTransform(GetViewID(), pViewMatrix, pProjectionMatrix);
 }
 
+void AnimationRenderer::Prepare()
+{
+	// Palettes are evaluated by AnimationSystem before rendering and blended by the render packet when there is one.
+	m_drawItems.clear();
+	uint32_t paletteBoneCount = 0U;
+	for (Entity entity : m_pCurrentSceneWorld->GetAnimationEntities())
+	{
+		const StaticMeshComponent* pMeshComponent = m_pCurrentSceneWorld->GetStaticMeshComponent(entity);
+		const AnimationComponent* pAnimationComponent = m_pCurrentSceneWorld->GetAnimationComponent(entity);
+		const TransformComponent* pTransformComponent = m_pCurrentSceneWorld->GetTransformComponent(entity);
+		if (!pMeshComponent || !pAnimationComponent || !pTransformComponent)
+		{
+			continue;
+		}
+
+		uint32_t boneCount = 0U;
+		const cd::Matrix4x4* pBonePalette = GetRenderBonePalette(*m_pCurrentSceneWorld, entity, *pAnimationComponent, boneCount);
+		if (0U == boneCount)
+		{
+			continue;
+		}
+
+		const cd::Matrix4x4& worldMatrix = GetRenderWorldMatrix(*m_pCurrentSceneWorld, entity, *pTransformComponent);
+		m_drawItems.push_back({ pMeshComponent, &worldMatrix, pBonePalette, boneCount, paletteBoneCount });
+		paletteBoneCount += boneCount;
+	}
+
+	if (!m_drawItems.empty())
+	{
+		UploadSkinningPalettes(paletteBoneCount);
+	}
+}
+
 void AnimationRenderer::Render(float deltaTime)
 {
 #ifdef VISUALIZE_BONE_WEIGHTS
@@ -169,51 +104,76 @@ void AnimationRenderer::Render(float deltaTime)
 	}
 
 	constexpr StringCrc boneIndexUniform("u_debugBoneIndex");
-	bgfx::setUniform(m_pRenderContext->GetUniform(boneIndexUniform), selectedBoneIndex, 1);
+	GetEncoder()->setUniform(m_pRenderContext->GetUniform(boneIndexUniform), selectedBoneIndex, 1);
 #endif
 
-	static float animationRunningTime = 0.0f;
-	animationRunningTime += deltaTime;
-
-	const cd::SceneDatabase* pSceneDatabase = m_pCurrentSceneWorld->GetSceneDatabase();
-	for (Entity entity : m_pCurrentSceneWorld->GetAnimationEntities())
+	// Draw items and their palettes come from Prepare.
+	constexpr StringCrc animationProgram("AnimationProgram");
+	bgfx::ProgramHandle program = GetRenderContext()->GetProgram(animationProgram);
+	for (const DrawItem& drawItem : m_drawItems)
 	{
-		StaticMeshComponent* pMeshComponent = m_pCurrentSceneWorld->GetStaticMeshComponent(entity);
-		if (!pMeshComponent)
-		{
-			continue;
-		}
+		GetEncoder()->setTransform(drawItem.pWorldMatrix->Begin());
+
+		cd::Vec4f skinningParams(static_cast<float>(drawItem.paletteOffset), 0.0f, 0.0f, 0.0f);
+		GetEncoder()->setUniform(m_skinningParams, skinningParams.Begin(), 1);
+		GetEncoder()->setTexture(SKINNING_PALETTE_SLOT, m_skinningPaletteSampler, m_skinningPaletteTexture);
+		GetEncoder()->setVertexBuffer(0, bgfx::VertexBufferHandle{drawItem.pMeshComponent->GetVertexBuffer()});
+		GetEncoder()->setIndexBuffer(bgfx::IndexBufferHandle{drawItem.pMeshComponent->GetIndexBuffer()});
 
-		TransformComponent* pTransformComponent = m_pCurrentSceneWorld->GetTransformComponent(entity);
-		bgfx::setTransform(pTransformComponent->GetWorldMatrix().Begin());
+		constexpr uint64_t state = BGFX_STATE_WRITE_MASK | BGFX_STATE_CULL_CCW | BGFX_STATE_MSAA | BGFX_STATE_DEPTH_TEST_LESS;
+		GetEncoder()->setState(state);
 
-		AnimationComponent* pAnimationComponent = m_pCurrentSceneWorld->GetAnimationComponent(entity);
+		GetEncoder()->submit(GetViewID(), program);
+	}
+}
 
-		const cd::Animation* pAnimation = pAnimationComponent->GetAnimationData();
-		float ticksPerSecond = pAnimation->GetTicksPerSecnod();
-		assert(ticksPerSecond > 1.0f);
-		float animationTime = details::CustomFModf(animationRunningTime * ticksPerSecond, pAnimation->GetDuration());
+void AnimationRenderer::UploadSkinningPalettes(uint32_t boneCount)
+{
+	uint32_t rowCount = (boneCount + skinningPaletteBonesPerRow - 1U) / skinningPaletteBonesPerRow;
+	assert(rowCount <= bgfx::getCaps()->limits.maxTextureSize);
 
-		static std::vector<cd::Matrix4x4> boneMatrices;
-		boneMatrices.clear();
-		for (uint16_t boneIndex = 0; boneIndex < 128; ++boneIndex)
+	// Grows in powers of two so that the texture is only recreated a few times.
+	if (rowCount > m_skinningPaletteRowCapacity)
+	{
+		if (bgfx::isValid(m_skinningPaletteTexture))
 		{
-			boneMatrices.push_back(cd::Matrix4x4::Identity());
+			bgfx::destroy(m_skinningPaletteTexture);
 		}
 
-		const cd::Bone& rootBone = pSceneDatabase->GetBone(0);
-		details::CalculateBoneTransform(boneMatrices, pSceneDatabase, animationTime, rootBone,
-			cd::Matrix4x4::Identity(), pTransformComponent->GetWorldMatrix().Inverse());
-		bgfx::setUniform(bgfx::UniformHandle{pAnimationComponent->GetBoneMatrixsUniform()}, boneMatrices.data(), static_cast<uint16_t>(boneMatrices.size()));
-		bgfx::setVertexBuffer(0, bgfx::VertexBufferHandle{pMeshComponent->GetVertexBuffer()});
-		bgfx::setIndexBuffer(bgfx::IndexBufferHandle{pMeshComponent->GetIndexBuffer()});
+		uint16_t rowCapacity = 1U;
+		while (rowCapacity < rowCount)
+		{
+			rowCapacity <<= 1U;
+		}
 
-		constexpr uint64_t state = BGFX_STATE_WRITE_MASK | BGFX_STATE_CULL_CCW | BGFX_STATE_MSAA | BGFX_STATE_DEPTH_TEST_LESS;
-		bgfx::setState(state);
+		m_skinningPaletteTexture = bgfx::createTexture2D(SKINNING_PALETTE_WIDTH, rowCapacity, false, 1, bgfx::TextureFormat::RGBA32F, skinningPaletteFlags);
+		m_skinningPaletteRowCapacity = rowCapacity;
+	}
 
-		constexpr StringCrc animationProgram("AnimationProgram");
-		bgfx::submit(GetViewID(), GetRenderContext()->GetProgram(animationProgram));
+	// Written in place in frame memory, which lives long enough for bgfx::makeRef.
+	// Texels after the last bone are uploaded but never fetched.
+	constexpr uint32_t floatsPerBone = SKINNING_PALETTE_TEXELS_PER_BONE * 4U;
+	uint32_t texelFloatCount = rowCount * skinningPaletteBonesPerRow * floatsPerBone;
+	float* pTexels = FrameAllocator::AllocateArray<float>(texelFloatCount);
+	const bgfx::Memory* pMemory = bgfx::makeRef(pTexels, texelFloatCount * static_cast<uint32_t>(sizeof(float)));
+	for (const DrawItem& drawItem : m_drawItems)
+	{
+		float* pBoneTexels = pTexels + drawItem.paletteOffset * floatsPerBone;
+		for (uint32_t boneIndex = 0U; boneIndex < drawItem.boneCount; ++boneIndex)
+		{
+			// Matrices are column major and the last row of a skinning matrix is always (0, 0, 0, 1).
+			const float* pElements = drawItem.pBonePalette[boneIndex].Begin();
+			for (uint32_t row = 0U; row < 3U; ++row)
+			{
+				*pBoneTexels++ = pElements[row];
+				*pBoneTexels++ = pElements[row + 4U];
+				*pBoneTexels++ = pElements[row + 8U];
+				*pBoneTexels++ = pElements[row + 12U];
+			}
+		}
 	}
+
+	bgfx::updateTexture2D(m_skinningPaletteTexture, 0, 0, 0, 0, SKINNING_PALETTE_WIDTH, static_cast<uint16_t>(rowCount), pMemory);
 }
 
 }
\ No newline at end of file
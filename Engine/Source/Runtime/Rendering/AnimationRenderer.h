@@ -1,27 +1,53 @@
 #pragma once
 
+#include "Math/Matrix.hpp"
 #include "Renderer.h"
 
+#include <bgfx/bgfx.h>
+
 #include <vector>
 
 namespace engine
 {
 
 class SceneWorld;
+class StaticMeshComponent;
 
+// Skinning palettes of all animated entities are packed as 3x4 matrices into one texture per frame.
+// Draws only pass the offset of their palette, so skeletons are not limited by uniform array sizes.
 class AnimationRenderer final : public Renderer
 {
 public:
 	using Renderer::Renderer;
+	virtual ~AnimationRenderer();
 
 	virtual void Init() override;
 	virtual void UpdateView(const float* pViewMatrix, const float* pProjectionMatrix) override;
+	virtual void Prepare() override;
 	virtual void Render(float deltaTime) override;
 
 	void SetSceneWorld(SceneWorld* pSceneWorld) { m_pCurrentSceneWorld = pSceneWorld; }
 
 private:
+	struct DrawItem
+	{
+		const StaticMeshComponent* pMeshComponent;
+		const cd::Matrix4x4* pWorldMatrix;
+		const cd::Matrix4x4* pBonePalette;
+		uint32_t boneCount;
+		uint32_t paletteOffset;
+	};
+
+	void UploadSkinningPalettes(uint32_t boneCount);
+
 	SceneWorld* m_pCurrentSceneWorld = nullptr;
+
+	bgfx::UniformHandle m_skinningPaletteSampler = BGFX_INVALID_HANDLE;
+	bgfx::UniformHandle m_skinningParams = BGFX_INVALID_HANDLE;
+	bgfx::TextureHandle m_skinningPaletteTexture = BGFX_INVALID_HANDLE;
+	uint16_t m_skinningPaletteRowCapacity = 0;
+
+	std::vector<DrawItem> m_drawItems;
 };
 
 }
\ No newline at end of file
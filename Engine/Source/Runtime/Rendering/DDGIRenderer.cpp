@@ -7,6 +7,7 @@
 #include "ECWorld/TransformComponent.h"
 #include "Material/ShaderSchema.h"
 #include "RenderContext.h"
+#include "RenderPacket.h"
 #include "Rendering/DDGIDefinition.h"
 #include "Scene/Texture.h"
 #include "U_DDGI.sh"
@@ -194,10 +195,21 @@ void DDGIRenderer::UpdateView(const float* pViewMatrix, const float* pProjection
 	bgfx::setViewTransform(GetViewID(), pViewMatrix, pProjectionMatrix);
 }
 
+void DDGIRenderer::Prepare()
+{
+	UpdateDDGITexture(DDGITextureType::Distance, m_pDDGIComponent, GetRenderContext());
+	UpdateDDGITexture(DDGITextureType::Irradiance, m_pDDGIComponent, GetRenderContext());
+	// UpdateDDGITexture(DDGITextureType::Relocation, m_pDDGIComponent, GetRenderContext());
+	// UpdateDDGITexture(DDGITextureType::Classification, m_pDDGIComponent, GetRenderContext());
+
+	SkyComponent* pSkyComponent = m_pCurrentSceneWorld->GetSkyComponent(m_pCurrentSceneWorld->GetSkyEntity());
+	GetRenderContext()->CreateTexture(pSkyComponent->GetIrradianceTexturePath().c_str(), samplerFlags);
+	GetRenderContext()->CreateTexture(pSkyComponent->GetRadianceTexturePath().c_str(), samplerFlags);
+}
+
 void DDGIRenderer::Render(float deltaTime)
 {
-	const engine::CameraComponent *pCameraComponent = m_pCurrentSceneWorld->GetCameraComponent(m_pCurrentSceneWorld->GetMainCameraEntity());
-	const engine::TransformComponent* pCameraTransformComponent = m_pCurrentSceneWorld->GetTransformComponent(m_pCurrentSceneWorld->GetMainCameraEntity());
+	RenderCamera camera = GetRenderCamera(*m_pCurrentSceneWorld);
 
 	for(Entity entity : m_pCurrentSceneWorld->GetMaterialEntities())
 	{
@@ -217,12 +229,12 @@ void DDGIRenderer::Render(float deltaTime)
 		// Transform
 		if(TransformComponent* pTransformComponent = m_pCurrentSceneWorld->GetTransformComponent(entity))
 		{
-			bgfx::setTransform(pTransformComponent->GetWorldMatrix().Begin());
+			GetEncoder()->setTransform(GetRenderWorldMatrix(*m_pCurrentSceneWorld, entity, *pTransformComponent).Begin());
 		}
 
 		// Mesh
-		bgfx::setVertexBuffer(0, bgfx::VertexBufferHandle{pMeshComponent->GetVertexBuffer()});
-		bgfx::setIndexBuffer(bgfx::IndexBufferHandle{pMeshComponent->GetIndexBuffer()});
+		GetEncoder()->setVertexBuffer(0, bgfx::VertexBufferHandle{pMeshComponent->GetVertexBuffer()});
+		GetEncoder()->setIndexBuffer(bgfx::IndexBufferHandle{pMeshComponent->GetIndexBuffer()});
 
 		// Material, only albedo texture will be used for ddgi at now.
 		for(const auto& [textureType, _] : pMaterialComponent->GetTextureResources())
@@ -235,25 +247,23 @@ void DDGIRenderer::Render(float deltaTime)
 					GetRenderContext()->FillUniform(uvOffsetAndScale, &pTextureInfo->uvOffset, 1);
 				}
 
-				bgfx::setTexture(pTextureInfo->slot, bgfx::UniformHandle{pTextureInfo->samplerHandle}, bgfx::TextureHandle{pTextureInfo->textureHandle});
+				GetEncoder()->setTexture(pTextureInfo->slot, bgfx::UniformHandle{pTextureInfo->samplerHandle}, bgfx::TextureHandle{pTextureInfo->textureHandle});
 			}
 		}
 
 		cd::Vec3f tmpAlbedoColor = cd::Vec3f(1.0f, 1.0f, 1.0f);
 		GetRenderContext()->FillUniform(StringCrc(albedoColor), tmpAlbedoColor.Begin(), 1);
 
-		GetRenderContext()->FillUniform(StringCrc(cameraPos), &pCameraTransformComponent->GetTransform().GetTranslation().x(), 1);
+		GetRenderContext()->FillUniform(StringCrc(cameraPos), &camera.position.x(), 1);
 
-		auto lightEntities = m_pCurrentSceneWorld->GetLightEntities();
-		size_t lightEntityCount = lightEntities.size();
-		static cd::Vec4f lightInfoData(0.0f, LightUniform::LIGHT_STRIDE, 0.0f, 0.0f);
-		lightInfoData.x() = static_cast<float>(lightEntityCount);
+		uint32_t lightEntityCount = 0U;
+		const LightComponent* pLights = GetRenderLights(*m_pCurrentSceneWorld, lightEntityCount);
+		cd::Vec4f lightInfoData(static_cast<float>(lightEntityCount), LightUniform::LIGHT_STRIDE, 0.0f, 0.0f);
 		GetRenderContext()->FillUniform(StringCrc(lightCountAndStride), lightInfoData.Begin(), 1);
 
 		if (lightEntityCount > 0)
 		{
-			// Light component storage has continus memory address and layout.
-			float *pLightDataBegin = reinterpret_cast<float *>(m_pCurrentSceneWorld->GetLightComponent(lightEntities[0]));
+			const float* pLightDataBegin = reinterpret_cast<const float*>(pLights);
 			GetRenderContext()->FillUniform(StringCrc(lightParams), pLightDataBegin, static_cast<uint16_t>(lightEntityCount * LightUniform::LIGHT_STRIDE));
 		}
 
@@ -265,14 +275,9 @@ void DDGIRenderer::Render(float deltaTime)
 		cd::Vec4f tmpNormalAndViewBias = cd::Vec4f(m_pDDGIComponent->GetNormalBias(), m_pDDGIComponent->GetViewBias(), 0.0f, 0.0f);
 		GetRenderContext()->FillUniform(StringCrc(normalAndViewBias), &tmpNormalAndViewBias, 1);
 
-		UpdateDDGITexture(DDGITextureType::Distance, m_pDDGIComponent, GetRenderContext());
-		UpdateDDGITexture(DDGITextureType::Irradiance, m_pDDGIComponent, GetRenderContext());
-		// UpdateDDGITexture(DDGITextureType::Relocation, m_pDDGIComponent, GetRenderContext());
-		// UpdateDDGITexture(DDGITextureType::Classification, m_pDDGIComponent, GetRenderContext());
-
-		bgfx::setTexture(DIS_MAP_SLOT, GetRenderContext()->GetUniform(StringCrc(distanceSampler)),
+		GetEncoder()->setTexture(DIS_MAP_SLOT, GetRenderContext()->GetUniform(StringCrc(distanceSampler)),
 			GetRenderContext()->GetTexture(StringCrc(GetDDGITextureTypeName(DDGITextureType::Distance))));
-		bgfx::setTexture(IRR_MAP_SLOT, GetRenderContext()->GetUniform(StringCrc(irradianceSampler)),
+		GetEncoder()->setTexture(IRR_MAP_SLOT, GetRenderContext()->GetUniform(StringCrc(irradianceSampler)),
 			GetRenderContext()->GetTexture(StringCrc(GetDDGITextureTypeName(DDGITextureType::Irradiance))));
 		// bgfx::setTexture(REL_MAP_SLOT, GetRenderContext()->GetUniform(StringCrc(relocationSampler)),
 		// 	GetRenderContext()->GetTexture(StringCrc(GetDDGITextureTypeName(DDGITextureType::Relocation))));
@@ -281,20 +286,18 @@ void DDGIRenderer::Render(float deltaTime)
 
 		SkyComponent* pSkyComponent = m_pCurrentSceneWorld->GetSkyComponent(m_pCurrentSceneWorld->GetSkyEntity());
 		constexpr StringCrc irrSamplerCrc(cubeIrradianceSampler);
-		GetRenderContext()->CreateTexture(pSkyComponent->GetIrradianceTexturePath().c_str(), samplerFlags);
-		bgfx::setTexture(IBL_IRRADIANCE_SLOT,
+		GetEncoder()->setTexture(IBL_IRRADIANCE_SLOT,
 			GetRenderContext()->GetUniform(irrSamplerCrc),
 			GetRenderContext()->GetTexture(StringCrc(pSkyComponent->GetIrradianceTexturePath())));
 
 		constexpr StringCrc radSamplerCrc(cubeRadianceSampler);
-		GetRenderContext()->CreateTexture(pSkyComponent->GetRadianceTexturePath().c_str(), samplerFlags);
-		bgfx::setTexture(IBL_RADIANCE_SLOT,
+		GetEncoder()->setTexture(IBL_RADIANCE_SLOT,
 			GetRenderContext()->GetUniform(radSamplerCrc),
 			GetRenderContext()->GetTexture(StringCrc(pSkyComponent->GetRadianceTexturePath())));
 
 		constexpr StringCrc lutsamplerCrc(lutSampler);
 		constexpr StringCrc luttextureCrc(lutTexture);
-		bgfx::setTexture(BRDF_LUT_SLOT, GetRenderContext()->GetUniform(lutsamplerCrc), GetRenderContext()->GetTexture(luttextureCrc));
+		GetEncoder()->setTexture(BRDF_LUT_SLOT, GetRenderContext()->GetUniform(lutsamplerCrc), GetRenderContext()->GetTexture(luttextureCrc));
 
 		constexpr uint64_t defaultState = BGFX_STATE_WRITE_MASK | BGFX_STATE_MSAA | BGFX_STATE_DEPTH_TEST_LESS;
 		uint64_t state = defaultState;
@@ -302,9 +305,9 @@ void DDGIRenderer::Render(float deltaTime)
 		{
 			state |= BGFX_STATE_CULL_CCW;
 		}
-		bgfx::setState(state);
+		GetEncoder()->setState(state);
 
-		bgfx::submit(GetViewID(), bgfx::ProgramHandle{pMaterialComponent->GetShadreProgram()});
+		GetEncoder()->submit(GetViewID(), bgfx::ProgramHandle{pMaterialComponent->GetShadreProgram()});
 	}
 }
 
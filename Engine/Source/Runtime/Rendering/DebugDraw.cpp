@@ -0,0 +1,261 @@
+#include "DebugDraw.h"
+
+#include "Renderer.h"
+#include "RenderContext.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace engine
+{
+
+namespace
+{
+
+constexpr uint32_t sphereSegmentCount = 16U;
+
+// Lines are drawn over the scene without writing depth so they never hide each other.
+constexpr uint64_t lineState = BGFX_STATE_WRITE_RGB | BGFX_STATE_WRITE_A | BGFX_STATE_MSAA | BGFX_STATE_PT_LINES;
+
+constexpr float unitBoxVertices[] =
+{
+	0.0f, 0.0f, 0.0f,
+	1.0f, 0.0f, 0.0f,
+	0.0f, 1.0f, 0.0f,
+	1.0f, 1.0f, 0.0f,
+	0.0f, 0.0f, 1.0f,
+	1.0f, 0.0f, 1.0f,
+	0.0f, 1.0f, 1.0f,
+	1.0f, 1.0f, 1.0f,
+};
+
+constexpr uint16_t unitBoxIndices[] =
+{
+	0, 1, 1, 3, 3, 2, 2, 0,
+	4, 5, 5, 7, 7, 6, 6, 4,
+	0, 4, 1, 5, 3, 7, 2, 6,
+};
+
+cd::Point TransformPoint(const cd::Matrix4x4& matrix, float x, float y, float z, bool divideByW)
+{
+	// Column major.
+	const float* m = matrix.Begin();
+	float tx = m[0] * x + m[4] * y + m[8] * z + m[12];
+	float ty = m[1] * x + m[5] * y + m[9] * z + m[13];
+	float tz = m[2] * x + m[6] * y + m[10] * z + m[14];
+	float w = divideByW ? m[3] * x + m[7] * y + m[11] * z + m[15] : 1.0f;
+	return cd::Point(tx / w, ty / w, tz / w);
+}
+
+}
+
+DebugDraw::~DebugDraw()
+{
+	if (bgfx::isValid(m_boxVertexBuffer))
+	{
+		bgfx::destroy(m_boxVertexBuffer);
+	}
+
+	if (bgfx::isValid(m_boxIndexBuffer))
+	{
+		bgfx::destroy(m_boxIndexBuffer);
+	}
+}
+
+void DebugDraw::Init()
+{
+	m_lineVertexLayout.begin()
+		.add(bgfx::Attrib::Position, 3, bgfx::AttribType::Float)
+		.add(bgfx::Attrib::Color0, 4, bgfx::AttribType::Uint8, true)
+		.end();
+
+	bgfx::VertexLayout boxVertexLayout;
+	boxVertexLayout.begin()
+		.add(bgfx::Attrib::Position, 3, bgfx::AttribType::Float)
+		.end();
+	m_boxVertexBuffer = bgfx::createVertexBuffer(bgfx::makeRef(unitBoxVertices, sizeof(unitBoxVertices)), boxVertexLayout);
+	m_boxIndexBuffer = bgfx::createIndexBuffer(bgfx::makeRef(unitBoxIndices, sizeof(unitBoxIndices)));
+
+	m_lineProgram = Renderer::GetRenderContext()->CreateProgram("DebugLineProgram", "vs_debugLine.bin", "fs_debugLine.bin");
+	m_boxProgram = Renderer::GetRenderContext()->CreateProgram("DebugBoxProgram", "vs_debugBox.bin", "fs_debugLine.bin");
+}
+
+void DebugDraw::AddLine(const cd::Point& from, const cd::Point& to, uint32_t color, DepthMode depthMode)
+{
+	std::vector<LineVertex>& lineVertices = m_lineVertices[static_cast<size_t>(depthMode)];
+	lineVertices.push_back({ from.x(), from.y(), from.z(), color });
+	lineVertices.push_back({ to.x(), to.y(), to.z(), color });
+}
+
+void DebugDraw::AddBox(const cd::AABB& aabb, uint32_t color, DepthMode depthMode)
+{
+	AddBox(aabb, cd::Matrix4x4::Identity(), color, depthMode);
+}
+
+void DebugDraw::AddBox(const cd::AABB& aabb, const cd::Matrix4x4& transform, uint32_t color, DepthMode depthMode)
+{
+	if (aabb.IsEmpty())
+	{
+		return;
+	}
+
+	const cd::Point& minPoint = aabb.Min();
+	const cd::Point& maxPoint = aabb.Max();
+	const float extents[3] = { maxPoint.x() - minPoint.x(), maxPoint.y() - minPoint.y(), maxPoint.z() - minPoint.z() };
+
+	// Rows of transform * translate(min) * scale(extents), which places the unit cube over the box.
+	const float* m = transform.Begin();
+	BoxInstance& instance = m_boxInstances[static_cast<size_t>(depthMode)].emplace_back();
+	for (uint32_t row = 0U; row < 3U; ++row)
+	{
+		instance.rows[row][0] = m[row] * extents[0];
+		instance.rows[row][1] = m[row + 4U] * extents[1];
+		instance.rows[row][2] = m[row + 8U] * extents[2];
+		instance.rows[row][3] = m[row] * minPoint.x() + m[row + 4U] * minPoint.y() + m[row + 8U] * minPoint.z() + m[row + 12U];
+	}
+
+	for (uint32_t channel = 0U; channel < 4U; ++channel)
+	{
+		instance.color[channel] = static_cast<float>((color >> (channel * 8U)) & 0xFFU) / 255.0f;
+	}
+}
+
+void DebugDraw::AddSphere(const cd::Point& center, float radius, uint32_t color, DepthMode depthMode)
+{
+	// One circle in each axis plane.
+	auto CirclePoint = [&center, radius](uint32_t plane, uint32_t segment)
+	{
+		float angle = static_cast<float>(segment) / static_cast<float>(sphereSegmentCount) * cd::Math::TWO_PI;
+		float s = std::sin(angle) * radius;
+		float c = std::cos(angle) * radius;
+		switch (plane)
+		{
+		case 0U:
+			return cd::Point(center.x() + c, center.y() + s, center.z());
+		case 1U:
+			return cd::Point(center.x(), center.y() + c, center.z() + s);
+		default:
+			return cd::Point(center.x() + s, center.y(), center.z() + c);
+		}
+	};
+
+	for (uint32_t plane = 0U; plane < 3U; ++plane)
+	{
+		for (uint32_t segment = 0U; segment < sphereSegmentCount; ++segment)
+		{
+			AddLine(CirclePoint(plane, segment), CirclePoint(plane, segment + 1U), color, depthMode);
+		}
+	}
+}
+
+void DebugDraw::AddFrustum(const cd::Matrix4x4& inverseViewProjection, uint32_t color, DepthMode depthMode)
+{
+	const float nearZ = bgfx::getCaps()->homogeneousDepth ? -1.0f : 0.0f;
+	cd::Point corners[8];
+	for (uint32_t cornerIndex = 0U; cornerIndex < 8U; ++cornerIndex)
+	{
+		float x = (cornerIndex & 1U) ? 1.0f : -1.0f;
+		float y = (cornerIndex & 2U) ? 1.0f : -1.0f;
+		float z = (cornerIndex & 4U) ? 1.0f : nearZ;
+		corners[cornerIndex] = TransformPoint(inverseViewProjection, x, y, z, true);
+	}
+
+	// Same corner order as the unit cube.
+	for (uint32_t index = 0U; index < sizeof(unitBoxIndices) / sizeof(unitBoxIndices[0]); index += 2U)
+	{
+		AddLine(corners[unitBoxIndices[index]], corners[unitBoxIndices[index + 1U]], color, depthMode);
+	}
+}
+
+void DebugDraw::AddBone(const cd::Point& from, const cd::Point& to, uint32_t color, DepthMode depthMode)
+{
+	cd::Vec3f direction(to.x() - from.x(), to.y() - from.y(), to.z() - from.z());
+	float length = direction.Length();
+	if (length <= 0.0f)
+	{
+		return;
+	}
+
+	// Any vector not parallel to the bone gives the two side axes.
+	cd::Vec3f axis = direction * (1.0f / length);
+	cd::Vec3f helper = std::abs(axis.y()) < 0.9f ? cd::Vec3f(0.0f, 1.0f, 0.0f) : cd::Vec3f(1.0f, 0.0f, 0.0f);
+	cd::Vec3f side = axis.Cross(helper).Normalize() * (length * 0.1f);
+	cd::Vec3f up = axis.Cross(side);
+
+	cd::Point ringCenter = from + direction * 0.1f;
+	cd::Point ring[4] = { ringCenter + side, ringCenter + up, ringCenter - side, ringCenter - up };
+	for (uint32_t ringIndex = 0U; ringIndex < 4U; ++ringIndex)
+	{
+		AddLine(from, ring[ringIndex], color, depthMode);
+		AddLine(ring[ringIndex], to, color, depthMode);
+		AddLine(ring[ringIndex], ring[(ringIndex + 1U) % 4U], color, depthMode);
+	}
+}
+
+void DebugDraw::Flush(uint16_t viewID)
+{
+	m_statistics = Statistics();
+
+	for (size_t modeIndex = 0U; modeIndex < DepthModeCount; ++modeIndex)
+	{
+		uint64_t depthState = static_cast<size_t>(DepthMode::Test) == modeIndex ? BGFX_STATE_DEPTH_TEST_LESS : 0U;
+
+		const std::vector<LineVertex>& lineVertices = m_lineVertices[modeIndex];
+		if (!lineVertices.empty())
+		{
+			uint32_t vertexCount = static_cast<uint32_t>(lineVertices.size());
+			uint32_t availableVertexCount = bgfx::getAvailTransientVertexBuffer(vertexCount, m_lineVertexLayout) & ~1U;
+			if (availableVertexCount > 0U)
+			{
+				bgfx::TransientVertexBuffer vertexBuffer;
+				bgfx::allocTransientVertexBuffer(&vertexBuffer, availableVertexCount, m_lineVertexLayout);
+				std::memcpy(vertexBuffer.data, lineVertices.data(), availableVertexCount * sizeof(LineVertex));
+
+				Renderer::GetEncoder()->setVertexBuffer(0, &vertexBuffer);
+				Renderer::GetEncoder()->setState(lineState | depthState);
+				Renderer::GetEncoder()->submit(viewID, m_lineProgram);
+				++m_statistics.drawCount;
+			}
+
+			m_statistics.lineCount += availableVertexCount / 2U;
+			m_statistics.droppedCount += (vertexCount - availableVertexCount) / 2U;
+		}
+
+		const std::vector<BoxInstance>& boxInstances = m_boxInstances[modeIndex];
+		if (!boxInstances.empty())
+		{
+			uint32_t instanceCount = static_cast<uint32_t>(boxInstances.size());
+			uint32_t availableInstanceCount = bgfx::getAvailInstanceDataBuffer(instanceCount, sizeof(BoxInstance));
+			if (availableInstanceCount > 0U)
+			{
+				bgfx::InstanceDataBuffer instanceBuffer;
+				bgfx::allocInstanceDataBuffer(&instanceBuffer, availableInstanceCount, sizeof(BoxInstance));
+				std::memcpy(instanceBuffer.data, boxInstances.data(), availableInstanceCount * sizeof(BoxInstance));
+
+				Renderer::GetEncoder()->setVertexBuffer(0, m_boxVertexBuffer);
+				Renderer::GetEncoder()->setIndexBuffer(m_boxIndexBuffer);
+				Renderer::GetEncoder()->setInstanceDataBuffer(&instanceBuffer);
+				Renderer::GetEncoder()->setState(lineState | depthState);
+				Renderer::GetEncoder()->submit(viewID, m_boxProgram);
+				++m_statistics.drawCount;
+			}
+
+			m_statistics.boxCount += availableInstanceCount;
+			m_statistics.droppedCount += instanceCount - availableInstanceCount;
+		}
+	}
+
+	Clear();
+}
+
+void DebugDraw::Clear()
+{
+	for (size_t modeIndex = 0U; modeIndex < DepthModeCount; ++modeIndex)
+	{
+		m_lineVertices[modeIndex].clear();
+		m_boxInstances[modeIndex].clear();
+	}
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,89 @@
+#pragma once
+
+#include "Math/Box.hpp"
+#include "Math/Matrix.hpp"
+
+#include <bgfx/bgfx.h>
+
+#include <cstdint>
+#include <vector>
+
+namespace engine
+{
+
+// Immediate mode debug shapes. Shapes are appended during the frame and Flush submits them with one
+// draw per primitive kind and depth mode. Lines go through a transient vertex buffer and boxes are
+// instances of a shared unit cube, so the cost doesn't depend on how many meshes are in the scene.
+// Colors are packed as 0xAABBGGRR.
+class DebugDraw final
+{
+public:
+	enum class DepthMode
+	{
+		Test,
+		AlwaysOnTop,
+		Count,
+	};
+
+	struct Statistics
+	{
+		uint32_t lineCount = 0U;
+		uint32_t boxCount = 0U;
+		uint32_t drawCount = 0U;
+		// Shapes which didn't fit in the transient buffers of the frame.
+		uint32_t droppedCount = 0U;
+	};
+
+public:
+	DebugDraw() = default;
+	DebugDraw(const DebugDraw&) = delete;
+	DebugDraw& operator=(const DebugDraw&) = delete;
+	DebugDraw(DebugDraw&&) = delete;
+	DebugDraw& operator=(DebugDraw&&) = delete;
+	~DebugDraw();
+
+	void Init();
+
+	void AddLine(const cd::Point& from, const cd::Point& to, uint32_t color, DepthMode depthMode = DepthMode::Test);
+	void AddBox(const cd::AABB& aabb, uint32_t color, DepthMode depthMode = DepthMode::Test);
+	void AddBox(const cd::AABB& aabb, const cd::Matrix4x4& transform, uint32_t color, DepthMode depthMode = DepthMode::Test);
+	void AddSphere(const cd::Point& center, float radius, uint32_t color, DepthMode depthMode = DepthMode::Test);
+	// Corners are found by unprojecting the clip space cube.
+	void AddFrustum(const cd::Matrix4x4& inverseViewProjection, uint32_t color, DepthMode depthMode = DepthMode::Test);
+	// Octahedral bone shape pointing from the joint to its child.
+	void AddBone(const cd::Point& from, const cd::Point& to, uint32_t color, DepthMode depthMode = DepthMode::Test);
+
+	// Submits everything queued to the view and clears the queue.
+	void Flush(uint16_t viewID);
+	void Clear();
+
+	const Statistics& GetStatistics() const { return m_statistics; }
+
+private:
+	struct LineVertex
+	{
+		float x, y, z;
+		uint32_t abgr;
+	};
+
+	struct BoxInstance
+	{
+		float rows[3][4];
+		float color[4];
+	};
+
+	static constexpr size_t DepthModeCount = static_cast<size_t>(DepthMode::Count);
+
+	std::vector<LineVertex> m_lineVertices[DepthModeCount];
+	std::vector<BoxInstance> m_boxInstances[DepthModeCount];
+
+	bgfx::VertexLayout m_lineVertexLayout;
+	bgfx::VertexBufferHandle m_boxVertexBuffer = BGFX_INVALID_HANDLE;
+	bgfx::IndexBufferHandle m_boxIndexBuffer = BGFX_INVALID_HANDLE;
+	bgfx::ProgramHandle m_lineProgram = BGFX_INVALID_HANDLE;
+	bgfx::ProgramHandle m_boxProgram = BGFX_INVALID_HANDLE;
+
+	Statistics m_statistics;
+};
+
+}
\ No newline at end of file
@@ -5,6 +5,7 @@
 #include "ECWorld/StaticMeshComponent.h"
 #include "ECWorld/TransformComponent.h"
 #include "RenderContext.h"
+#include "RenderPacket.h"
 #include "Scene/Texture.h"
 
 namespace engine
@@ -22,6 +23,17 @@ void DebugRenderer::UpdateView(const float* pViewMatrix, const float* pProjectio
 	bgfx::setViewTransform(GetViewID(), pViewMatrix, pProjectionMatrix);
 }
 
+void DebugRenderer::Prepare()
+{
+	for (Entity entity : m_pCurrentSceneWorld->GetStaticMeshEntities())
+	{
+		if (TransformComponent* pTransformComponent = m_pCurrentSceneWorld->GetTransformComponent(entity))
+		{
+			pTransformComponent->Build();
+		}
+	}
+}
+
 void DebugRenderer::Render(float deltaTime)
 {
 	for (Entity entity : m_pCurrentSceneWorld->GetStaticMeshEntities())
@@ -43,21 +55,20 @@ void DebugRenderer::Render(float deltaTime)
 			continue;
 		}
 
-		if (TransformComponent* pTransformComponent = m_pCurrentSceneWorld->GetTransformComponent(entity))
+		if (const TransformComponent* pTransformComponent = m_pCurrentSceneWorld->GetTransformComponent(entity))
 		{
-			pTransformComponent->Build();
-			bgfx::setTransform(pTransformComponent->GetWorldMatrix().Begin());
+			GetEncoder()->setTransform(GetRenderWorldMatrix(*m_pCurrentSceneWorld, entity, *pTransformComponent).Begin());
 		}
 
-		bgfx::setVertexBuffer(0, bgfx::VertexBufferHandle{ pMeshComponent->GetVertexBuffer() });
-		bgfx::setIndexBuffer(bgfx::IndexBufferHandle{ pMeshComponent->GetIndexBuffer() });
+		GetEncoder()->setVertexBuffer(0, bgfx::VertexBufferHandle{ pMeshComponent->GetVertexBuffer() });
+		GetEncoder()->setIndexBuffer(bgfx::IndexBufferHandle{ pMeshComponent->GetIndexBuffer() });
 
 		constexpr uint64_t state = BGFX_STATE_WRITE_MASK | BGFX_STATE_MSAA | BGFX_STATE_DEPTH_TEST_LESS |
 			BGFX_STATE_BLEND_FUNC(BGFX_STATE_BLEND_SRC_ALPHA, BGFX_STATE_BLEND_INV_SRC_ALPHA);
-		bgfx::setState(state);
+		GetEncoder()->setState(state);
 
 		constexpr StringCrc debugProgram("DebugProgram");
-		bgfx::submit(GetViewID(), GetRenderContext()->GetProgram(debugProgram));
+		GetEncoder()->submit(GetViewID(), GetRenderContext()->GetProgram(debugProgram));
 	}
 }
 
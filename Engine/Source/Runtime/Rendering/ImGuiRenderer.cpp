@@ -1,12 +1,40 @@
 #include "ImGuiRenderer.h"
 
+#include "Core/FrameAllocator.h"
 #include "Rendering/RenderContext.h"
 
 #include <imgui/imgui.h>
 
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+
 namespace engine
 {
 
+namespace
+{
+
+constexpr bool useU32Index = std::is_same<uint32_t, ImDrawIdx>();
+
+// Indices are rebased to the first vertex of their batch so a batch can't span more vertices than ImDrawIdx addresses.
+constexpr uint32_t maxBatchVertexCount = useU32Index ? std::numeric_limits<uint32_t>::max() : std::numeric_limits<ImDrawIdx>::max() + 1U;
+
+constexpr uint64_t imguiState = BGFX_STATE_WRITE_RGB | BGFX_STATE_WRITE_A | BGFX_STATE_MSAA;
+
+uint32_t GrowCapacity(uint32_t capacity, uint32_t requiredCount)
+{
+	uint32_t newCapacity = std::max(capacity, 1024U);
+	while (newCapacity < requiredCount)
+	{
+		newCapacity *= 2U;
+	}
+	return newCapacity;
+}
+
+}
+
 void ImGuiRenderer::Init()
 {
 	constexpr StringCrc imguiVertexLayoutName("imgui_vertex_layout");
@@ -20,15 +48,26 @@ void ImGuiRenderer::Init()
 			.end();
 		GetRenderContext()->SetVertexLayout(imguiVertexLayoutName, std::move(imguiVertexLayout));
 	}
+	m_pVertexLayout = &GetRenderContext()->GetVertexLayout(imguiVertexLayoutName);
+	assert(sizeof(ImDrawVert) == m_pVertexLayout->getStride());
 
-	GetRenderContext()->CreateUniform("s_tex", bgfx::UniformType::Sampler);
-	GetRenderContext()->CreateProgram("ImGuiProgram", "vs_imgui.bin", "fs_imgui.bin");
+	m_textureSampler = GetRenderContext()->CreateUniform("s_tex", bgfx::UniformType::Sampler);
+	m_imguiProgram = GetRenderContext()->CreateProgram("ImGuiProgram", "vs_imgui.bin", "fs_imgui.bin");
 
 	bgfx::setViewName(GetViewID(), "ImGuiRenderer");
 }
 
 ImGuiRenderer::~ImGuiRenderer()
 {
+	if (bgfx::isValid(m_dynamicVertexBuffer))
+	{
+		bgfx::destroy(m_dynamicVertexBuffer);
+	}
+
+	if (bgfx::isValid(m_dynamicIndexBuffer))
+	{
+		bgfx::destroy(m_dynamicIndexBuffer);
+	}
 }
 
 void ImGuiRenderer::UpdateView(const float* pViewMatrix, const float* pProjectionMatrix)
@@ -74,106 +113,211 @@ void ImGuiRenderer::UpdateView(const float* pViewMatrix, const float* pProjectio
 	bgfx::setViewTransform(GetViewID(), nullptr, orthoMatrix.Begin());
 }
 
+void ImGuiRenderer::ReserveDynamicBuffers(uint32_t vertexCount, uint32_t indexCount)
+{
+	if (vertexCount > m_dynamicVertexCapacity)
+	{
+		if (bgfx::isValid(m_dynamicVertexBuffer))
+		{
+			bgfx::destroy(m_dynamicVertexBuffer);
+		}
+
+		m_dynamicVertexCapacity = GrowCapacity(m_dynamicVertexCapacity, vertexCount);
+		m_dynamicVertexBuffer = bgfx::createDynamicVertexBuffer(m_dynamicVertexCapacity, *m_pVertexLayout);
+	}
+
+	if (indexCount > m_dynamicIndexCapacity)
+	{
+		if (bgfx::isValid(m_dynamicIndexBuffer))
+		{
+			bgfx::destroy(m_dynamicIndexBuffer);
+		}
+
+		m_dynamicIndexCapacity = GrowCapacity(m_dynamicIndexCapacity, indexCount);
+		m_dynamicIndexBuffer = bgfx::createDynamicIndexBuffer(m_dynamicIndexCapacity, useU32Index ? BGFX_BUFFER_INDEX32 : 0U);
+	}
+}
+
 void ImGuiRenderer::Render(float deltaTime)
 {
 	ImDrawData* pImGuiDrawData = ImGui::GetDrawData();
+	const uint32_t totalVertexCount = static_cast<uint32_t>(pImGuiDrawData->TotalVtxCount);
+	const uint32_t totalIndexCount = static_cast<uint32_t>(pImGuiDrawData->TotalIdxCount);
+	if (0U == totalVertexCount || 0U == totalIndexCount)
+	{
+		return;
+	}
+
+	// One allocation for the whole frame. Heavy UI frames which don't fit in the transient buffers
+	// go to dynamic buffers instead of dropping the remaining draw lists.
+	const bool useTransientBuffers = totalVertexCount == bgfx::getAvailTransientVertexBuffer(totalVertexCount, *m_pVertexLayout) &&
+		totalIndexCount == bgfx::getAvailTransientIndexBuffer(totalIndexCount, useU32Index);
+
+	bgfx::TransientVertexBuffer transientVertexBuffer;
+	bgfx::TransientIndexBuffer transientIndexBuffer;
+	const bgfx::Memory* pVertexMemory = nullptr;
+	const bgfx::Memory* pIndexMemory = nullptr;
+	ImDrawVert* pVertices;
+	ImDrawIdx* pIndices;
+	if (useTransientBuffers)
+	{
+		bgfx::allocTransientVertexBuffer(&transientVertexBuffer, totalVertexCount, *m_pVertexLayout);
+		bgfx::allocTransientIndexBuffer(&transientIndexBuffer, totalIndexCount, useU32Index);
+		pVertices = reinterpret_cast<ImDrawVert*>(transientVertexBuffer.data);
+		pIndices = reinterpret_cast<ImDrawIdx*>(transientIndexBuffer.data);
+	}
+	else
+	{
+		ReserveDynamicBuffers(totalVertexCount, totalIndexCount);
+		pVertices = FrameAllocator::AllocateArray<ImDrawVert>(totalVertexCount);
+		pIndices = FrameAllocator::AllocateArray<ImDrawIdx>(totalIndexCount);
+		pVertexMemory = bgfx::makeRef(pVertices, totalVertexCount * static_cast<uint32_t>(sizeof(ImDrawVert)));
+		pIndexMemory = bgfx::makeRef(pIndices, totalIndexCount * static_cast<uint32_t>(sizeof(ImDrawIdx)));
+	}
+
+	constexpr StringCrc fontAtlasTexture("font_atlas");
+	const bgfx::TextureHandle fontAtlasTextureHandle = GetRenderContext()->GetTexture(fontAtlasTexture);
 
-	int frameBufferWidth = static_cast<int>(pImGuiDrawData->DisplaySize.x * pImGuiDrawData->FramebufferScale.x);
-	int frameBufferHeight = static_cast<int>(pImGuiDrawData->DisplaySize.y * pImGuiDrawData->FramebufferScale.y);
+	const float frameBufferWidth = pImGuiDrawData->DisplaySize.x * pImGuiDrawData->FramebufferScale.x;
+	const float frameBufferHeight = pImGuiDrawData->DisplaySize.y * pImGuiDrawData->FramebufferScale.y;
 	const ImVec2 clipPos = pImGuiDrawData->DisplayPos;			// (0,0) unless using multi-viewports
 	const ImVec2 clipScale = pImGuiDrawData->FramebufferScale;  // (1,1) unless using retina display which are often (2,2)
 
+	m_drawBatches.clear();
+	DrawBatch* pCurrentBatch = nullptr;
+	uint32_t listStartVertex = 0U;
+	uint32_t writtenIndexCount = 0U;
 	for (int32_t commandListIndex = 0, numCommandLists = pImGuiDrawData->CmdListsCount; commandListIndex < numCommandLists; ++commandListIndex)
 	{
 		const ImDrawList* pDrawList = pImGuiDrawData->CmdLists[commandListIndex];
+		const uint32_t listVertexCount = static_cast<uint32_t>(pDrawList->VtxBuffer.size());
+		std::memcpy(&pVertices[listStartVertex], pDrawList->VtxBuffer.begin(), listVertexCount * sizeof(ImDrawVert));
 
-		uint32_t numVertices = static_cast<uint32_t>(pDrawList->VtxBuffer.size());
-		uint32_t numIndices = static_cast<uint32_t>(pDrawList->IdxBuffer.size());
-		constexpr StringCrc imguiVertexLayoutName("imgui_vertex_layout");
-		const bool vertexBufferAvaiable = (numVertices == bgfx::getAvailTransientVertexBuffer(numVertices, GetRenderContext()->GetVertexLayout(imguiVertexLayoutName)));
-		const bool indexBufferAvaiable = (0 == numIndices || numIndices == bgfx::getAvailTransientIndexBuffer(numIndices));
-		if (!vertexBufferAvaiable || !indexBufferAvaiable)
+		for (const ImDrawCmd* cmd = pDrawList->CmdBuffer.begin(), *cmdEnd = pDrawList->CmdBuffer.end(); cmd != cmdEnd; ++cmd)
 		{
-			// not enough space in transient buffer just quit drawing the rest...
-			break;
-		}
+			if (cmd->UserCallback)
+			{
+				DrawBatch& callbackBatch = m_drawBatches.emplace_back();
+				callbackBatch.pCallbackDrawList = pDrawList;
+				callbackBatch.pCallbackCommand = cmd;
+				pCurrentBatch = nullptr;
+				continue;
+			}
 
-		bgfx::TransientVertexBuffer vertexBuffer;
-		bgfx::TransientIndexBuffer indexBuffer;
-		bgfx::allocTransientVertexBuffer(&vertexBuffer, numVertices, GetRenderContext()->GetVertexLayout(imguiVertexLayoutName));
-		bgfx::allocTransientIndexBuffer(&indexBuffer, numIndices, std::is_same<uint32_t, ImDrawIdx>());
+			if (0 == cmd->ElemCount)
+			{
+				continue;
+			}
 
-		ImDrawVert* pVertices = reinterpret_cast<ImDrawVert*>(vertexBuffer.data);
-		std::memcpy(pVertices, pDrawList->VtxBuffer.begin(), numVertices * sizeof(ImDrawVert));
+			// Project scissor/clipping rectangles into framebuffer space
+			ImVec4 clipRect;
+			clipRect.x = (cmd->ClipRect.x - clipPos.x) * clipScale.x;
+			clipRect.y = (cmd->ClipRect.y - clipPos.y) * clipScale.y;
+			clipRect.z = (cmd->ClipRect.z - clipPos.x) * clipScale.x;
+			clipRect.w = (cmd->ClipRect.w - clipPos.y) * clipScale.y;
+			if (clipRect.x >= frameBufferWidth ||
+				clipRect.y >= frameBufferHeight ||
+				clipRect.z < 0.0f ||
+				clipRect.w < 0.0f)
+			{
+				continue;
+			}
 
-		ImDrawIdx* pIndices = reinterpret_cast<ImDrawIdx*>(indexBuffer.data);
-		std::memcpy(pIndices, pDrawList->IdxBuffer.begin(), numIndices * sizeof(ImDrawIdx));
+			const uint16_t xx = static_cast<uint16_t>(std::max(clipRect.x, 0.0f));
+			const uint16_t yy = static_cast<uint16_t>(std::max(clipRect.y, 0.0f));
+			const uint16_t scissor[4] = { xx, yy, static_cast<uint16_t>(std::min(clipRect.z, 65535.0f) - xx), static_cast<uint16_t>(std::min(clipRect.w, 65535.0f) - yy) };
 
-		bgfx::Encoder* pEncoder = bgfx::begin();
+			uint64_t state = imguiState;
+			bgfx::TextureHandle textureHandle;
+			if (nullptr != cmd->TextureId)
+			{
+				union
+				{
+					ImTextureID ptr;
+					struct
+					{
+						bgfx::TextureHandle handle;
+						uint8_t flags;
+						uint8_t mip;
+					} s;
+				} texture = { cmd->TextureId };
+				textureHandle = texture.s.handle;
+			}
+			else
+			{
+				textureHandle = fontAtlasTextureHandle;
+				state |= BGFX_STATE_BLEND_FUNC(BGFX_STATE_BLEND_SRC_ALPHA, BGFX_STATE_BLEND_INV_SRC_ALPHA);
+			}
 
-		for (const ImDrawCmd* cmd = pDrawList->CmdBuffer.begin(), *cmdEnd = pDrawList->CmdBuffer.end(); cmd != cmdEnd; ++cmd)
-		{
-			if (cmd->UserCallback)
+			const uint32_t commandStartVertex = listStartVertex + cmd->VtxOffset;
+			const bool canMerge = pCurrentBatch &&
+				pCurrentBatch->textureHandle.idx == textureHandle.idx &&
+				pCurrentBatch->state == state &&
+				0 == std::memcmp(pCurrentBatch->scissor, scissor, sizeof(scissor)) &&
+				listStartVertex + listVertexCount - pCurrentBatch->startVertex <= maxBatchVertexCount;
+			if (!canMerge)
 			{
-				cmd->UserCallback(pDrawList, cmd);
+				pCurrentBatch = &m_drawBatches.emplace_back();
+				pCurrentBatch->textureHandle = textureHandle;
+				pCurrentBatch->state = state;
+				std::memcpy(pCurrentBatch->scissor, scissor, sizeof(scissor));
+				pCurrentBatch->startVertex = commandStartVertex;
+				pCurrentBatch->startIndex = writtenIndexCount;
 			}
-			else if (0 != cmd->ElemCount)
+
+			const ImDrawIdx* pSourceIndices = &pDrawList->IdxBuffer[cmd->IdxOffset];
+			const uint32_t indexOffset = commandStartVertex - pCurrentBatch->startVertex;
+			if (0U == indexOffset)
 			{
-				uint64_t state = BGFX_STATE_WRITE_RGB | BGFX_STATE_WRITE_A | BGFX_STATE_MSAA;
-				bgfx::TextureHandle textureHandle;
-				if (nullptr != cmd->TextureId)
-				{
-					union
-					{
-						ImTextureID ptr;
-						struct
-						{
-							bgfx::TextureHandle handle;
-							uint8_t flags;
-							uint8_t mip;
-						} s;
-					} texture = { cmd->TextureId };
-					textureHandle = texture.s.handle;
-				}
-				else
+				std::memcpy(&pIndices[writtenIndexCount], pSourceIndices, cmd->ElemCount * sizeof(ImDrawIdx));
+			}
+			else
+			{
+				for (uint32_t index = 0U; index < cmd->ElemCount; ++index)
 				{
-					constexpr StringCrc fontAtlasTexture("font_atlas");
-					textureHandle = GetRenderContext()->GetTexture(fontAtlasTexture);
-					state |= BGFX_STATE_BLEND_FUNC(BGFX_STATE_BLEND_SRC_ALPHA, BGFX_STATE_BLEND_INV_SRC_ALPHA);
+					pIndices[writtenIndexCount + index] = static_cast<ImDrawIdx>(pSourceIndices[index] + indexOffset);
 				}
+			}
+			writtenIndexCount += cmd->ElemCount;
+			pCurrentBatch->indexCount += cmd->ElemCount;
+		}
 
-				// Project scissor/clipping rectangles into framebuffer space
-				ImVec4 clipRect;
-				clipRect.x = (cmd->ClipRect.x - clipPos.x) * clipScale.x;
-				clipRect.y = (cmd->ClipRect.y - clipPos.y) * clipScale.y;
-				clipRect.z = (cmd->ClipRect.z - clipPos.x) * clipScale.x;
-				clipRect.w = (cmd->ClipRect.w - clipPos.y) * clipScale.y;
-
-				if (clipRect.x < frameBufferWidth &&
-					clipRect.y < frameBufferHeight &&
-					clipRect.z >= 0.0f &&
-					clipRect.w >= 0.0f)
-				{
-					const uint16_t xx = static_cast<uint16_t>(std::max(clipRect.x, 0.0f));
-					const uint16_t yy = static_cast<uint16_t>(std::max(clipRect.y, 0.0f));
-					pEncoder->setScissor(xx, yy, uint16_t(std::min(clipRect.z, 65535.0f) - xx), uint16_t(std::min(clipRect.w, 65535.0f) - yy));
-
-					pEncoder->setState(state);
+		listStartVertex += listVertexCount;
+	}
 
-					constexpr StringCrc textureSampler("s_tex");
-					pEncoder->setTexture(0, GetRenderContext()->GetUniform(textureSampler), textureHandle);
+	if (!useTransientBuffers)
+	{
+		bgfx::update(m_dynamicVertexBuffer, 0U, pVertexMemory);
+		bgfx::update(m_dynamicIndexBuffer, 0U, pIndexMemory);
+	}
 
-					pEncoder->setVertexBuffer(0, &vertexBuffer, cmd->VtxOffset, numVertices);
-					pEncoder->setIndexBuffer(&indexBuffer, cmd->IdxOffset, cmd->ElemCount);
+	bgfx::Encoder* pEncoder = bgfx::begin();
 
-					constexpr StringCrc imguiProgram("ImGuiProgram");
-					pEncoder->submit(GetViewID(), GetRenderContext()->GetProgram(imguiProgram));
-				}
-			}
+	for (const DrawBatch& batch : m_drawBatches)
+	{
+		if (batch.pCallbackCommand)
+		{
+			batch.pCallbackCommand->UserCallback(batch.pCallbackDrawList, batch.pCallbackCommand);
+			continue;
 		}
 
-		bgfx::end(pEncoder);
+		pEncoder->setScissor(batch.scissor[0], batch.scissor[1], batch.scissor[2], batch.scissor[3]);
+		pEncoder->setState(batch.state);
+		pEncoder->setTexture(0, m_textureSampler, batch.textureHandle);
+		if (useTransientBuffers)
+		{
+			pEncoder->setVertexBuffer(0, &transientVertexBuffer, batch.startVertex, totalVertexCount - batch.startVertex);
+			pEncoder->setIndexBuffer(&transientIndexBuffer, batch.startIndex, batch.indexCount);
+		}
+		else
+		{
+			pEncoder->setVertexBuffer(0, m_dynamicVertexBuffer, batch.startVertex, totalVertexCount - batch.startVertex);
+			pEncoder->setIndexBuffer(m_dynamicIndexBuffer, batch.startIndex, batch.indexCount);
+		}
+		pEncoder->submit(GetViewID(), m_imguiProgram);
 	}
+
+	bgfx::end(pEncoder);
 }
 
 }
\ No newline at end of file
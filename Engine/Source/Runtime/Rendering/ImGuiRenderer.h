@@ -2,9 +2,19 @@
 
 #include "Rendering/Renderer.h"
 
+#include <bgfx/bgfx.h>
+
+#include <vector>
+
+struct ImDrawCmd;
+struct ImDrawList;
+
 namespace engine
 {
 
+// All ImGui draw lists of a frame are packed into one vertex and index buffer. Commands which share
+// texture, scissor and state are merged into one submit, also across draw lists.
+// When the transient buffers can't hold the frame, dynamic buffers sized by the largest frame seen are used instead.
 class ImGuiRenderer final : public engine::Renderer
 {
 public:
@@ -14,6 +24,34 @@ public:
 	virtual void Init() override;
 	virtual void UpdateView(const float* pViewMatrix, const float* pProjectionMatrix) override;
 	virtual void Render(float deltaTime) override;
+
+private:
+	struct DrawBatch
+	{
+		bgfx::TextureHandle textureHandle;
+		uint64_t state;
+		uint16_t scissor[4];
+		uint32_t startVertex;
+		uint32_t startIndex;
+		uint32_t indexCount;
+
+		// Set for user callbacks which are invoked in place of a draw.
+		const ImDrawList* pCallbackDrawList;
+		const ImDrawCmd* pCallbackCommand;
+	};
+
+	void ReserveDynamicBuffers(uint32_t vertexCount, uint32_t indexCount);
+
+	bgfx::ProgramHandle m_imguiProgram = BGFX_INVALID_HANDLE;
+	bgfx::UniformHandle m_textureSampler = BGFX_INVALID_HANDLE;
+	const bgfx::VertexLayout* m_pVertexLayout = nullptr;
+
+	bgfx::DynamicVertexBufferHandle m_dynamicVertexBuffer = BGFX_INVALID_HANDLE;
+	bgfx::DynamicIndexBufferHandle m_dynamicIndexBuffer = BGFX_INVALID_HANDLE;
+	uint32_t m_dynamicVertexCapacity = 0U;
+	uint32_t m_dynamicIndexCapacity = 0U;
+
+	std::vector<DrawBatch> m_drawBatches;
 };
 
 }
\ No newline at end of file
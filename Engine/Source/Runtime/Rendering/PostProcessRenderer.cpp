@@ -1,35 +1,39 @@
 #include "PostProcessRenderer.h"
 
 #include "RenderContext.h"
+#include "RenderPacket.h"
+
+#include <cassert>
+#include <cmath>
 
 namespace engine
 {
 
-void PostProcessRenderer::Init()
+namespace
 {
-	GetRenderContext()->CreateUniform("s_lightingColor", bgfx::UniformType::Sampler);
-	GetRenderContext()->CreateUniform("u_gamma", bgfx::UniformType::Vec4);
-	GetRenderContext()->CreateProgram("PostProcessProgram", "vs_fullscreen.bin", "fs_PBR_postProcessing.bin");
 
-	bgfx::setViewName(GetViewID(), "PostProcessRenderer");
-}
+constexpr StringCrc sceneRenderTarget("SceneRenderTarget");
 
-PostProcessRenderer::~PostProcessRenderer()
+// Converts EV100 to the scale applied to scene luminance.
+// maxLum = 78 / (S * q) * 2^EV100 = 1.2 * 2^EV100 with S = 100 and q = 0.65.
+float ConvertEV100ToExposure(float ev100)
 {
+	return 1.0f / (1.2f * std::exp2(ev100));
 }
 
-void PostProcessRenderer::SetEnable(bool value)
+}
+
+void PostProcessRenderer::Init()
 {
-	Entity entity = m_pCurrentSceneWorld->GetMainCameraEntity();
-	CameraComponent* pCameraComponent = m_pCurrentSceneWorld->GetCameraComponent(entity);
-	pCameraComponent->SetPostProcessEnable(value);
+	m_lightingColorSampler = GetRenderContext()->CreateUniform("s_lightingColor", bgfx::UniformType::Sampler);
+	m_postProcessParams = GetRenderContext()->CreateUniform("u_postProcessParams", bgfx::UniformType::Vec4);
+	m_program = GetRenderContext()->CreateProgram("PostProcessProgram", "vs_fullscreen.bin", "fs_PBR_postProcessing.bin");
+
+	bgfx::setViewName(GetViewID(), "PostProcessRenderer");
 }
 
-bool PostProcessRenderer::IsEnable() const
+PostProcessRenderer::~PostProcessRenderer()
 {
-	Entity entity = m_pCurrentSceneWorld->GetMainCameraEntity();
-	CameraComponent* pCameraComponent = m_pCurrentSceneWorld->GetCameraComponent(entity);
-	return pCameraComponent->IsPostProcessEnable();
 }
 
 void PostProcessRenderer::UpdateView(const float* pViewMatrix, const float* pProjectionMatrix)
@@ -42,36 +46,26 @@ void PostProcessRenderer::UpdateView(const float* pViewMatrix, const float* pPro
 
 void PostProcessRenderer::Render(float deltaTime)
 {
-	constexpr StringCrc sceneRenderTarget("SceneRenderTarget");
-
+	// Sampling the scene target while writing to it is undefined, so the output must be another target.
 	const RenderTarget* pInputRT = GetRenderContext()->GetRenderTarget(sceneRenderTarget);
-	const RenderTarget* pOutputRT = GetRenderTarget();
+	assert(pInputRT != GetRenderTarget());
 
-	bgfx::TextureHandle screenTextureHandle;
-	if (pInputRT == pOutputRT)
-	{
-		constexpr StringCrc sceneRenderTargetBlitSRV("SceneRenderTargetBlitSRV");
-		screenTextureHandle = GetRenderContext()->GetTexture(sceneRenderTargetBlitSRV);
-	}
-	else
+	RenderCamera camera = GetRenderCamera(*m_pCurrentSceneWorld);
+
+	// x : exposure scale, y : gamma, z : tone mapping weight.
+	cd::Vec4f postProcessParams(1.0f, 1.0f, 0.0f, 0.0f);
+	if (camera.isPostProcessEnable)
 	{
-		screenTextureHandle = pInputRT->GetTextureHandle(0);
+		postProcessParams = cd::Vec4f(ConvertEV100ToExposure(camera.exposure), camera.gammaCorrection, 1.0f, 0.0f);
 	}
 
-	Entity entity = m_pCurrentSceneWorld->GetMainCameraEntity();
-	CameraComponent* pCameraComponent = m_pCurrentSceneWorld->GetCameraComponent(entity);
-
-	constexpr StringCrc gammaUniformName("u_gamma");
-	bgfx::setUniform(GetRenderContext()->GetUniform(gammaUniformName), &pCameraComponent->GetGammaCorrection());
-
-	constexpr StringCrc lightingResultSampler("s_lightingColor");
-	bgfx::setTexture(0, GetRenderContext()->GetUniform(lightingResultSampler), screenTextureHandle);
+	GetEncoder()->setUniform(m_postProcessParams, postProcessParams.Begin());
+	GetEncoder()->setTexture(0, m_lightingColorSampler, pInputRT->GetTextureHandle(0));
 
-	bgfx::setState(BGFX_STATE_WRITE_RGB | BGFX_STATE_WRITE_A);
+	GetEncoder()->setState(BGFX_STATE_WRITE_RGB | BGFX_STATE_WRITE_A);
 	Renderer::ScreenSpaceQuad(GetRenderTarget(), false);
 
-	constexpr StringCrc programName("PostProcessProgram");
-	bgfx::submit(GetViewID(), GetRenderContext()->GetProgram(programName));
+	GetEncoder()->submit(GetViewID(), m_program);
 }
 
 }
\ No newline at end of file
@@ -6,6 +6,10 @@
 namespace engine
 {
 
+// Resolves the HDR scene color into the output target in one full-screen pass.
+// Exposure, tone mapping and gamma correction are applied in the same shader. The pass always runs
+// because it is the only path from the scene target to the output, so disabling post processing on
+// the camera turns it into a plain copy.
 class PostProcessRenderer final : public Renderer
 {
 public:
@@ -15,14 +19,15 @@ public:
 	virtual void Init() override;
 	virtual void UpdateView(const float* pViewMatrix, const float* pProjectionMatrix) override;
 	virtual void Render(float deltaTime) override;
-	
-	virtual void SetEnable(bool value) override;
-	virtual bool IsEnable() const override;
 
 	void SetSceneWorld(SceneWorld* pSceneWorld) { m_pCurrentSceneWorld = pSceneWorld; }
 
 private:
 	SceneWorld* m_pCurrentSceneWorld = nullptr;
+
+	bgfx::UniformHandle m_lightingColorSampler = BGFX_INVALID_HANDLE;
+	bgfx::UniformHandle m_postProcessParams = BGFX_INVALID_HANDLE;
+	bgfx::ProgramHandle m_program = BGFX_INVALID_HANDLE;
 };
 
 }
\ No newline at end of file
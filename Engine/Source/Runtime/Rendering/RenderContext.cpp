@@ -1,5 +1,6 @@
 #include "RenderContext.h"
 
+#include "Core/FrameAllocator.h"
 #include "Log/Log.h"
 #include "Path/Path.h"
 #include "Renderer.h"
@@ -53,7 +54,7 @@ RenderContext::~RenderContext()
 	bgfx::shutdown();
 }
 
-void RenderContext::Init(GraphicsBackend backend, void* hwnd)
+void RenderContext::Init(GraphicsBackend backend, void* hwnd, bx::AllocatorI* pAllocator)
 {
 	bgfx::Init initDesc;
 	switch (backend)
@@ -97,6 +98,9 @@ void RenderContext::Init(GraphicsBackend backend, void* hwnd)
 	}
 
 	initDesc.platformData.nwh = hwnd;
+	initDesc.allocator = pAllocator;
+	// Debug boxes are 64 bytes instances so the default 6MB transient buffers run out before 100k boxes.
+	initDesc.limits.transientVbSize = 16 << 20;
 	bgfx::init(initDesc);
 }
 
@@ -132,6 +136,7 @@ void RenderContext::EndFrame()
 	// Advance to next frame. Rendering thread will be kicked to
 	// process submitted rendering primitives.
 	bgfx::frame();
+	FrameAllocator::AdvanceFrame();
 }
 
 void RenderContext::OnResize(uint16_t width, uint16_t height)
@@ -467,7 +472,7 @@ void RenderContext::SetUniform(StringCrc resourceCrc, bgfx::UniformHandle unifor
 
 void RenderContext::FillUniform(StringCrc resourceCrc, const void *pData, uint16_t vec4Count) const
 {
-	bgfx::setUniform(GetUniform(resourceCrc), pData, vec4Count);
+	Renderer::GetEncoder()->setUniform(GetUniform(resourceCrc), pData, vec4Count);
 }
 
 RenderTarget* RenderContext::GetRenderTarget(StringCrc resourceCrc) const
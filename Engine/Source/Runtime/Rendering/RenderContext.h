@@ -34,7 +34,8 @@ public:
 	RenderContext& operator=(RenderContext&&) = delete;
 	~RenderContext();
 
-	void Init(GraphicsBackend backend, void* hwnd = nullptr);
+	// pAllocator replaces the bgfx default allocator, it must outlive Shutdown.
+	void Init(GraphicsBackend backend, void* hwnd = nullptr, bx::AllocatorI* pAllocator = nullptr);
 	void OnResize(uint16_t width, uint16_t height);
 	void BeginFrame();
 	void EndFrame();
@@ -73,6 +74,8 @@ public:
 	void SetUniform(StringCrc resourceCrc, bgfx::UniformHandle uniformreHandle);
 	void FillUniform(StringCrc resourceCrc, const void *pData, uint16_t vec4Count = 1) const;
 
+	// Lookups by StringCrc go through hash maps. Renderers should resolve handles once in Init
+	// and keep them in their own tables rather than calling these apis per draw.
 	RenderTarget* GetRenderTarget(StringCrc resourceCrc) const;
 	const bgfx::VertexLayout& GetVertexLayout(StringCrc resourceCrc) const;
 	bgfx::ShaderHandle GetShader(StringCrc resourceCrc) const;
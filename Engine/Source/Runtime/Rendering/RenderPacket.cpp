@@ -0,0 +1,290 @@
+#include "RenderPacket.h"
+
+#include "ECWorld/SceneWorld.h"
+
+namespace engine
+{
+
+namespace
+{
+
+uint32_t FindIndex(const std::vector<uint32_t>& indices, Entity entity, uint32_t invalidIndex)
+{
+	return entity < indices.size() ? indices[entity] : invalidIndex;
+}
+
+// Entity ids are allocated densely from 0 so a plain array is cheaper than a map for per frame lookups.
+void BuildEntityIndices(const std::vector<Entity>& entities, uint32_t invalidIndex, std::vector<uint32_t>& indices)
+{
+	indices.clear();
+	for (size_t index = 0; index < entities.size(); ++index)
+	{
+		Entity entity = entities[index];
+		if (entity >= indices.size())
+		{
+			indices.resize(static_cast<size_t>(entity) + 1U, invalidIndex);
+		}
+		indices[entity] = static_cast<uint32_t>(index);
+	}
+}
+
+void LerpMatrix(const cd::Matrix4x4& a, const cd::Matrix4x4& b, float t, cd::Matrix4x4& result)
+{
+	const float* pA = a.Begin();
+	const float* pB = b.Begin();
+	float* pResult = result.Begin();
+	for (uint32_t elementIndex = 0U; elementIndex < 16U; ++elementIndex)
+	{
+		pResult[elementIndex] = pA[elementIndex] + (pB[elementIndex] - pA[elementIndex]) * t;
+	}
+}
+
+}
+
+void RenderPacket::Snapshot::Clear()
+{
+	transformEntities.clear();
+	transforms.clear();
+
+	paletteEntities.clear();
+	paletteRanges.clear();
+	bonePalettes.clear();
+
+	lightEntities.clear();
+	lights.clear();
+}
+
+void RenderPacket::Extract(const SceneWorld& sceneWorld)
+{
+	m_latestSnapshotIndex ^= 1U;
+	const Snapshot& previous = m_snapshots[m_latestSnapshotIndex ^ 1U];
+	Snapshot& latest = m_snapshots[m_latestSnapshotIndex];
+	latest.Clear();
+
+	for (Entity entity : sceneWorld.GetTransformEntities())
+	{
+		const TransformComponent* pTransformComponent = sceneWorld.GetTransformComponent(entity);
+		latest.transformEntities.push_back(entity);
+		latest.transforms.push_back(pTransformComponent->GetTransform());
+	}
+
+	for (Entity entity : sceneWorld.GetAnimationEntities())
+	{
+		const std::vector<cd::Matrix4x4>& boneMatrices = sceneWorld.GetAnimationComponent(entity)->GetBoneMatrices();
+		if (boneMatrices.empty())
+		{
+			continue;
+		}
+
+		latest.paletteEntities.push_back(entity);
+		latest.paletteRanges.push_back({ static_cast<uint32_t>(latest.bonePalettes.size()), static_cast<uint32_t>(boneMatrices.size()) });
+		latest.bonePalettes.insert(latest.bonePalettes.end(), boneMatrices.begin(), boneMatrices.end());
+	}
+
+	for (Entity entity : sceneWorld.GetLightEntities())
+	{
+		latest.lightEntities.push_back(entity);
+		latest.lights.push_back(*sceneWorld.GetLightComponent(entity));
+	}
+
+	// Index arrays keep their capacity across steps, unlike map nodes.
+	BuildEntityIndices(latest.transformEntities, InvalidIndex, latest.transformIndices);
+	BuildEntityIndices(latest.paletteEntities, InvalidIndex, latest.paletteIndices);
+
+	// Matching is done once per step so that Interpolate only walks arrays.
+	m_previousTransformIndices.resize(latest.transformEntities.size());
+	for (size_t index = 0; index < latest.transformEntities.size(); ++index)
+	{
+		m_previousTransformIndices[index] = FindIndex(previous.transformIndices, latest.transformEntities[index], InvalidIndex);
+	}
+
+	m_previousPaletteIndices.resize(latest.paletteEntities.size());
+	for (size_t index = 0; index < latest.paletteEntities.size(); ++index)
+	{
+		uint32_t previousIndex = FindIndex(previous.paletteIndices, latest.paletteEntities[index], InvalidIndex);
+		bool isSameSkeleton = InvalidIndex != previousIndex && previous.paletteRanges[previousIndex].boneCount == latest.paletteRanges[index].boneCount;
+		m_previousPaletteIndices[index] = isSameSkeleton ? previousIndex : InvalidIndex;
+	}
+
+	// Light storage is contiguous and rarely changes, so lights are matched in order.
+	m_previousLightIndices.resize(latest.lightEntities.size());
+	for (size_t index = 0; index < latest.lightEntities.size(); ++index)
+	{
+		bool isSameLight = index < previous.lightEntities.size() && previous.lightEntities[index] == latest.lightEntities[index];
+		m_previousLightIndices[index] = isSameLight ? static_cast<uint32_t>(index) : InvalidIndex;
+	}
+}
+
+void RenderPacket::Interpolate(float alpha)
+{
+	const Snapshot& previous = m_snapshots[m_latestSnapshotIndex ^ 1U];
+	const Snapshot& latest = m_snapshots[m_latestSnapshotIndex];
+	Frame& prepared = m_frames[m_publishedFrameIndex ^ 1U];
+
+	BuildEntityIndices(latest.transformEntities, InvalidIndex, prepared.worldMatrixIndices);
+	prepared.worldMatrices.resize(latest.transforms.size());
+	for (size_t index = 0; index < latest.transforms.size(); ++index)
+	{
+		const cd::Transform& latestTransform = latest.transforms[index];
+		uint32_t previousIndex = m_previousTransformIndices[index];
+		if (InvalidIndex == previousIndex)
+		{
+			prepared.worldMatrices[index] = latestTransform.GetMatrix();
+			continue;
+		}
+
+		const cd::Transform& previousTransform = previous.transforms[previousIndex];
+		cd::Transform transform(cd::Vec3f::Lerp(previousTransform.GetTranslation(), latestTransform.GetTranslation(), alpha),
+			cd::Quaternion::Lerp(previousTransform.GetRotation(), latestTransform.GetRotation(), alpha).Normalize(),
+			cd::Vec3f::Lerp(previousTransform.GetScale(), latestTransform.GetScale(), alpha));
+		prepared.worldMatrices[index] = transform.GetMatrix();
+	}
+
+	// Skinning matrices are blended per element which is close enough between two neighbouring steps.
+	BuildEntityIndices(latest.paletteEntities, InvalidIndex, prepared.paletteIndices);
+	prepared.paletteRanges = latest.paletteRanges;
+	prepared.bonePalettes.resize(latest.bonePalettes.size());
+	for (size_t index = 0; index < latest.paletteRanges.size(); ++index)
+	{
+		const PaletteRange& latestRange = latest.paletteRanges[index];
+		uint32_t previousIndex = m_previousPaletteIndices[index];
+		for (uint32_t boneIndex = 0U; boneIndex < latestRange.boneCount; ++boneIndex)
+		{
+			const cd::Matrix4x4& latestMatrix = latest.bonePalettes[latestRange.offset + boneIndex];
+			if (InvalidIndex == previousIndex)
+			{
+				prepared.bonePalettes[latestRange.offset + boneIndex] = latestMatrix;
+			}
+			else
+			{
+				const cd::Matrix4x4& previousMatrix = previous.bonePalettes[previous.paletteRanges[previousIndex].offset + boneIndex];
+				LerpMatrix(previousMatrix, latestMatrix, alpha, prepared.bonePalettes[latestRange.offset + boneIndex]);
+			}
+		}
+	}
+
+	prepared.lights = latest.lights;
+	for (size_t index = 0; index < prepared.lights.size(); ++index)
+	{
+		uint32_t previousIndex = m_previousLightIndices[index];
+		if (InvalidIndex == previousIndex)
+		{
+			continue;
+		}
+
+		const LightComponent& previousLight = previous.lights[previousIndex];
+		LightComponent& light = prepared.lights[index];
+		light.SetPosition(cd::Vec3f::Lerp(previousLight.GetPosition(), light.GetPosition(), alpha));
+		light.SetDirection(cd::Vec3f::Lerp(previousLight.GetDirection(), light.GetDirection(), alpha).Normalize());
+	}
+}
+
+void RenderPacket::Publish(const SceneWorld& sceneWorld)
+{
+	Frame& prepared = m_frames[m_publishedFrameIndex ^ 1U];
+
+	Entity cameraEntity = sceneWorld.GetMainCameraEntity();
+	const CameraComponent* pCameraComponent = sceneWorld.GetCameraComponent(cameraEntity);
+	const TransformComponent* pCameraTransformComponent = sceneWorld.GetTransformComponent(cameraEntity);
+	prepared.hasCamera = pCameraComponent && pCameraTransformComponent;
+	if (prepared.hasCamera)
+	{
+		RenderCamera& camera = prepared.camera;
+		camera.viewMatrix = pCameraComponent->GetViewMatrix();
+		camera.projectionMatrix = pCameraComponent->GetProjectionMatrix();
+		camera.position = pCameraTransformComponent->GetTransform().GetTranslation();
+		camera.isPostProcessEnable = pCameraComponent->IsPostProcessEnable();
+		camera.exposure = pCameraComponent->GetExposure();
+		camera.gammaCorrection = pCameraComponent->GetGammaCorrection();
+	}
+
+	m_publishedFrameIndex ^= 1U;
+}
+
+const cd::Matrix4x4* RenderPacket::FindWorldMatrix(Entity entity) const
+{
+	const Frame& published = m_frames[m_publishedFrameIndex];
+	uint32_t index = FindIndex(published.worldMatrixIndices, entity, InvalidIndex);
+	return InvalidIndex == index ? nullptr : &published.worldMatrices[index];
+}
+
+const cd::Matrix4x4* RenderPacket::FindBonePalette(Entity entity, uint32_t& boneCount) const
+{
+	const Frame& published = m_frames[m_publishedFrameIndex];
+	uint32_t index = FindIndex(published.paletteIndices, entity, InvalidIndex);
+	if (InvalidIndex == index)
+	{
+		return nullptr;
+	}
+
+	boneCount = published.paletteRanges[index].boneCount;
+	return &published.bonePalettes[published.paletteRanges[index].offset];
+}
+
+const RenderCamera* RenderPacket::GetCamera() const
+{
+	const Frame& published = m_frames[m_publishedFrameIndex];
+	return published.hasCamera ? &published.camera : nullptr;
+}
+
+const cd::Matrix4x4& GetRenderWorldMatrix(const SceneWorld& sceneWorld, Entity entity, const TransformComponent& transformComponent)
+{
+	if (const RenderPacket* pRenderPacket = sceneWorld.GetRenderPacket())
+	{
+		if (const cd::Matrix4x4* pWorldMatrix = pRenderPacket->FindWorldMatrix(entity))
+		{
+			return *pWorldMatrix;
+		}
+	}
+
+	return transformComponent.GetWorldMatrix();
+}
+
+const cd::Matrix4x4* GetRenderBonePalette(const SceneWorld& sceneWorld, Entity entity, const AnimationComponent& animationComponent, uint32_t& boneCount)
+{
+	if (const RenderPacket* pRenderPacket = sceneWorld.GetRenderPacket())
+	{
+		if (const cd::Matrix4x4* pBonePalette = pRenderPacket->FindBonePalette(entity, boneCount))
+		{
+			return pBonePalette;
+		}
+	}
+
+	const std::vector<cd::Matrix4x4>& boneMatrices = animationComponent.GetBoneMatrices();
+	boneCount = static_cast<uint32_t>(boneMatrices.size());
+	return boneMatrices.data();
+}
+
+const LightComponent* GetRenderLights(const SceneWorld& sceneWorld, uint32_t& lightCount)
+{
+	if (const RenderPacket* pRenderPacket = sceneWorld.GetRenderPacket())
+	{
+		const std::vector<LightComponent>& lights = pRenderPacket->GetLights();
+		lightCount = static_cast<uint32_t>(lights.size());
+		return lights.data();
+	}
+
+	// Light component storage has continus memory address and layout.
+	const std::vector<Entity>& lightEntities = sceneWorld.GetLightEntities();
+	lightCount = static_cast<uint32_t>(lightEntities.size());
+	return lightCount > 0U ? sceneWorld.GetLightComponent(lightEntities[0]) : nullptr;
+}
+
+RenderCamera GetRenderCamera(const SceneWorld& sceneWorld)
+{
+	if (const RenderPacket* pRenderPacket = sceneWorld.GetRenderPacket())
+	{
+		if (const RenderCamera* pCamera = pRenderPacket->GetCamera())
+		{
+			return *pCamera;
+		}
+	}
+
+	Entity cameraEntity = sceneWorld.GetMainCameraEntity();
+	const CameraComponent* pCameraComponent = sceneWorld.GetCameraComponent(cameraEntity);
+	return RenderCamera{ pCameraComponent->GetViewMatrix(), pCameraComponent->GetProjectionMatrix(),
+		sceneWorld.GetTransformComponent(cameraEntity)->GetTransform().GetTranslation(),
+		pCameraComponent->IsPostProcessEnable(), pCameraComponent->GetExposure(), pCameraComponent->GetGammaCorrection() };
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,125 @@
+#pragma once
+
+#include "ECWorld/Entity.h"
+#include "ECWorld/LightComponent.h"
+#include "Math/Matrix.hpp"
+#include "Math/Transform.hpp"
+
+#include <vector>
+
+namespace engine
+{
+
+class AnimationComponent;
+class SceneWorld;
+class TransformComponent;
+
+// Main camera as the renderers see it for one frame.
+struct RenderCamera
+{
+	cd::Matrix4x4 viewMatrix;
+	cd::Matrix4x4 projectionMatrix;
+	cd::Point position;
+	bool isPostProcessEnable;
+	float exposure;
+	float gammaCorrection;
+};
+
+// Render relevant state of the two last simulation steps and its blend for the frame being rendered.
+// Extract runs after every fixed step and Interpolate once per frame, so renderers see smooth motion
+// whatever the ratio between simulation and frame rate is. Entities which didn't exist in the previous
+// step are not blended.
+// The blended state is double buffered : Interpolate fills the prepared frame and Publish hands it to the
+// renderers. A render thread can draw the published frame while the next simulation steps are extracted and
+// interpolated, only Publish has to wait for it.
+class RenderPacket final
+{
+public:
+	RenderPacket() = default;
+	RenderPacket(const RenderPacket&) = delete;
+	RenderPacket& operator=(const RenderPacket&) = delete;
+	RenderPacket(RenderPacket&&) = default;
+	RenderPacket& operator=(RenderPacket&&) = default;
+	~RenderPacket() = default;
+
+	// Snapshots transforms, bone palettes and lights. The older snapshot is reused as storage.
+	void Extract(const SceneWorld& sceneWorld);
+
+	// Blends into the prepared frame.
+	// alpha is the fraction of a fixed step elapsed since the last one, from Clock::GetInterpolationAlpha.
+	void Interpolate(float alpha);
+
+	// Adds the main camera to the prepared frame and swaps it with the published one.
+	// Must not overlap with rendering.
+	void Publish(const SceneWorld& sceneWorld);
+
+	// Lookups below read the published frame.
+	// Null when the entity has no transform in the published frame.
+	const cd::Matrix4x4* FindWorldMatrix(Entity entity) const;
+	// Null when the entity has no bone palette in the published frame.
+	const cd::Matrix4x4* FindBonePalette(Entity entity, uint32_t& boneCount) const;
+	// Same layout as the light component storage so that it can be uploaded as is.
+	const std::vector<LightComponent>& GetLights() const { return m_frames[m_publishedFrameIndex].lights; }
+	// Null before the first Publish.
+	const RenderCamera* GetCamera() const;
+
+private:
+	static constexpr uint32_t InvalidIndex = UINT32_MAX;
+
+	struct PaletteRange
+	{
+		uint32_t offset;
+		uint32_t boneCount;
+	};
+
+	struct Snapshot
+	{
+		void Clear();
+
+		std::vector<Entity> transformEntities;
+		std::vector<cd::Transform> transforms;
+		std::vector<uint32_t> transformIndices;
+
+		std::vector<Entity> paletteEntities;
+		std::vector<PaletteRange> paletteRanges;
+		std::vector<cd::Matrix4x4> bonePalettes;
+		std::vector<uint32_t> paletteIndices;
+
+		std::vector<Entity> lightEntities;
+		std::vector<LightComponent> lights;
+	};
+
+	Snapshot m_snapshots[2];
+	uint32_t m_latestSnapshotIndex = 0U;
+
+	// Matching index in the previous snapshot for every element of the latest one, InvalidIndex when there is none.
+	std::vector<uint32_t> m_previousTransformIndices;
+	std::vector<uint32_t> m_previousPaletteIndices;
+	std::vector<uint32_t> m_previousLightIndices;
+
+	// Blended state, laid out like the latest snapshot at the time of Interpolate.
+	// Lookups are indexed by entity and hold InvalidIndex for entities without an entry.
+	struct Frame
+	{
+		std::vector<uint32_t> worldMatrixIndices;
+		std::vector<cd::Matrix4x4> worldMatrices;
+		std::vector<uint32_t> paletteIndices;
+		std::vector<PaletteRange> paletteRanges;
+		std::vector<cd::Matrix4x4> bonePalettes;
+		std::vector<LightComponent> lights;
+		RenderCamera camera;
+		bool hasCamera = false;
+	};
+
+	Frame m_frames[2];
+	uint32_t m_publishedFrameIndex = 0U;
+};
+
+// What renderers should draw : the state blended by the render packet of the scene when it has one,
+// otherwise the simulation state of the components.
+const cd::Matrix4x4& GetRenderWorldMatrix(const SceneWorld& sceneWorld, Entity entity, const TransformComponent& transformComponent);
+const cd::Matrix4x4* GetRenderBonePalette(const SceneWorld& sceneWorld, Entity entity, const AnimationComponent& animationComponent, uint32_t& boneCount);
+const LightComponent* GetRenderLights(const SceneWorld& sceneWorld, uint32_t& lightCount);
+RenderCamera GetRenderCamera(const SceneWorld& sceneWorld);
+
+}
\ No newline at end of file
@@ -0,0 +1,206 @@
+#include "RenderStateCache.h"
+
+#include "Renderer.h"
+
+#include <cassert>
+#include <cstddef>
+#include <cstring>
+#include <mutex>
+
+namespace engine
+{
+
+namespace
+{
+
+constexpr uint32_t vec4Size = 4U * sizeof(float);
+
+// Transforms and instance data are unique per draw. Everything else stays bound until it changes.
+constexpr uint8_t submitDiscardFlags = BGFX_DISCARD_TRANSFORM | BGFX_DISCARD_INSTANCE_DATA;
+
+std::mutex s_statisticsMutex;
+RenderStateCache::Statistics s_statistics;
+
+void Accumulate(RenderStateCache::Statistics& total, const RenderStateCache::Statistics& statistics)
+{
+	total.submitCount += statistics.submitCount;
+	total.stateCalls += statistics.stateCalls;
+	total.stateElided += statistics.stateElided;
+	total.vertexBufferCalls += statistics.vertexBufferCalls;
+	total.vertexBufferElided += statistics.vertexBufferElided;
+	total.indexBufferCalls += statistics.indexBufferCalls;
+	total.indexBufferElided += statistics.indexBufferElided;
+	total.textureCalls += statistics.textureCalls;
+	total.textureElided += statistics.textureElided;
+	total.uniformCalls += statistics.uniformCalls;
+	total.uniformElided += statistics.uniformElided;
+	total.uniformBytes += statistics.uniformBytes;
+	total.uniformBytesElided += statistics.uniformBytesElided;
+}
+
+}
+
+RenderStateCache::Statistics RenderStateCache::GetStatistics()
+{
+	std::lock_guard<std::mutex> lock(s_statisticsMutex);
+	return s_statistics;
+}
+
+void RenderStateCache::ResetStatistics()
+{
+	std::lock_guard<std::mutex> lock(s_statisticsMutex);
+	s_statistics = Statistics();
+}
+
+void RenderStateCache::Begin()
+{
+	m_isStateValid = false;
+	m_vertexBuffers.fill(bgfx::kInvalidHandle);
+	m_indexBuffer = bgfx::kInvalidHandle;
+	m_bindings.fill(Binding());
+	for (std::vector<float>& values : m_uniformValues)
+	{
+		values.clear();
+	}
+
+	m_pEncoder = Renderer::GetEncoder();
+	m_pEncoder->discard(BGFX_DISCARD_ALL);
+}
+
+void RenderStateCache::End()
+{
+	m_pEncoder->discard(BGFX_DISCARD_ALL);
+
+	std::lock_guard<std::mutex> lock(s_statisticsMutex);
+	Accumulate(s_statistics, m_statistics);
+	m_statistics = Statistics();
+}
+
+void RenderStateCache::SetState(uint64_t state, uint32_t rgba)
+{
+	++m_statistics.stateCalls;
+	if (m_isStateValid && m_state == state && m_rgba == rgba)
+	{
+		++m_statistics.stateElided;
+		return;
+	}
+
+	m_isStateValid = true;
+	m_state = state;
+	m_rgba = rgba;
+	m_pEncoder->setState(state, rgba);
+}
+
+void RenderStateCache::SetVertexBuffer(uint8_t stream, bgfx::VertexBufferHandle handle)
+{
+	assert(stream < MaxVertexStreamCount);
+
+	++m_statistics.vertexBufferCalls;
+	if (m_vertexBuffers[stream] == handle.idx)
+	{
+		++m_statistics.vertexBufferElided;
+		return;
+	}
+
+	m_vertexBuffers[stream] = handle.idx;
+	m_pEncoder->setVertexBuffer(stream, handle);
+}
+
+void RenderStateCache::SetIndexBuffer(bgfx::IndexBufferHandle handle)
+{
+	++m_statistics.indexBufferCalls;
+	if (m_indexBuffer == handle.idx)
+	{
+		++m_statistics.indexBufferElided;
+		return;
+	}
+
+	m_indexBuffer = handle.idx;
+	m_pEncoder->setIndexBuffer(handle);
+}
+
+void RenderStateCache::SetTexture(uint8_t stage, bgfx::UniformHandle sampler, bgfx::TextureHandle handle, uint32_t flags)
+{
+	assert(stage < MaxTextureStageCount);
+
+	++m_statistics.textureCalls;
+	Binding& binding = m_bindings[stage];
+	if (!binding.isImage && binding.sampler == sampler.idx && binding.texture == handle.idx && binding.flags == flags)
+	{
+		++m_statistics.textureElided;
+		return;
+	}
+
+	binding.sampler = sampler.idx;
+	binding.texture = handle.idx;
+	binding.flags = flags;
+	binding.isImage = false;
+	m_pEncoder->setTexture(stage, sampler, handle, flags);
+}
+
+void RenderStateCache::SetImage(uint8_t stage, bgfx::TextureHandle handle, uint8_t mip, bgfx::Access::Enum access, bgfx::TextureFormat::Enum format)
+{
+	assert(stage < MaxTextureStageCount);
+
+	++m_statistics.textureCalls;
+	Binding& binding = m_bindings[stage];
+	uint32_t flags = (static_cast<uint32_t>(format) << 16) | (static_cast<uint32_t>(access) << 8) | mip;
+	if (binding.isImage && binding.texture == handle.idx && binding.flags == flags)
+	{
+		++m_statistics.textureElided;
+		return;
+	}
+
+	binding.sampler = bgfx::kInvalidHandle;
+	binding.texture = handle.idx;
+	binding.flags = flags;
+	binding.isImage = true;
+	m_pEncoder->setImage(stage, handle, mip, access, format);
+}
+
+void RenderStateCache::SetUniform(bgfx::UniformHandle uniform, const void* pValue, uint16_t vec4Count)
+{
+	assert(bgfx::isValid(uniform) && pValue);
+
+	++m_statistics.uniformCalls;
+	if (uniform.idx >= m_uniformValues.size())
+	{
+		m_uniformValues.resize(uniform.idx + 1U);
+	}
+
+	// bgfx always writes an array uniform from its first element, so find the last changed vec4
+	// and send the prefix up to it.
+	std::vector<float>& cachedValues = m_uniformValues[uniform.idx];
+	const uint16_t cachedVec4Count = static_cast<uint16_t>(cachedValues.size() / 4U);
+	const auto* pNewBytes = static_cast<const std::byte*>(pValue);
+	uint16_t sendVec4Count = vec4Count;
+	while (sendVec4Count > 0U && sendVec4Count <= cachedVec4Count &&
+		0 == std::memcmp(&cachedValues[(sendVec4Count - 1U) * 4U], pNewBytes + (sendVec4Count - 1U) * vec4Size, vec4Size))
+	{
+		--sendVec4Count;
+	}
+
+	m_statistics.uniformBytesElided += static_cast<uint64_t>(vec4Count - sendVec4Count) * vec4Size;
+	if (0U == sendVec4Count)
+	{
+		++m_statistics.uniformElided;
+		return;
+	}
+
+	if (cachedVec4Count < sendVec4Count)
+	{
+		cachedValues.resize(sendVec4Count * 4U);
+	}
+	std::memcpy(cachedValues.data(), pValue, sendVec4Count * vec4Size);
+
+	m_statistics.uniformBytes += static_cast<uint64_t>(sendVec4Count) * vec4Size;
+	m_pEncoder->setUniform(uniform, pValue, sendVec4Count);
+}
+
+void RenderStateCache::Submit(uint16_t viewID, bgfx::ProgramHandle program)
+{
+	++m_statistics.submitCount;
+	m_pEncoder->submit(viewID, program, 0U, submitDiscardFlags);
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <bgfx/bgfx.h>
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+namespace engine
+{
+
+// Filters redundant binding and uniform calls in front of bgfx for one view.
+// Draws are submitted without discarding bindings, state and streams so that anything which
+// doesn't change between two draws is simply left bound. Uniform values persist in bgfx's
+// uniform registry, so only the changed prefix of a uniform array needs to be sent again.
+// That only holds in submission order, so views using the cache must be in sequential mode.
+class RenderStateCache
+{
+public:
+	static constexpr uint8_t MaxVertexStreamCount = 4;
+	static constexpr uint8_t MaxTextureStageCount = 16;
+
+	struct Statistics
+	{
+		uint64_t submitCount = 0;
+		uint64_t stateCalls = 0;
+		uint64_t stateElided = 0;
+		uint64_t vertexBufferCalls = 0;
+		uint64_t vertexBufferElided = 0;
+		uint64_t indexBufferCalls = 0;
+		uint64_t indexBufferElided = 0;
+		uint64_t textureCalls = 0;
+		uint64_t textureElided = 0;
+		uint64_t uniformCalls = 0;
+		uint64_t uniformElided = 0;
+		uint64_t uniformBytes = 0;
+		uint64_t uniformBytesElided = 0;
+	};
+
+	// Counters of all caches until reset. Each cache counts on its own and adds them at End, so caches
+	// recording on different threads never write the same counters.
+	static Statistics GetStatistics();
+	static void ResetStatistics();
+
+public:
+	RenderStateCache() = default;
+	RenderStateCache(const RenderStateCache&) = delete;
+	RenderStateCache& operator=(const RenderStateCache&) = delete;
+	RenderStateCache(RenderStateCache&&) = default;
+	RenderStateCache& operator=(RenderStateCache&&) = default;
+	~RenderStateCache() = default;
+
+	// Begin forgets everything cached from the last frame. End drops the bindings left in bgfx
+	// so that they can't leak into the next renderer. Calls go to the encoder of the thread calling Begin.
+	void Begin();
+	void End();
+
+	void SetState(uint64_t state, uint32_t rgba = 0U);
+	void SetVertexBuffer(uint8_t stream, bgfx::VertexBufferHandle handle);
+	void SetIndexBuffer(bgfx::IndexBufferHandle handle);
+	void SetTexture(uint8_t stage, bgfx::UniformHandle sampler, bgfx::TextureHandle handle, uint32_t flags = UINT32_MAX);
+	void SetImage(uint8_t stage, bgfx::TextureHandle handle, uint8_t mip, bgfx::Access::Enum access, bgfx::TextureFormat::Enum format);
+	void SetUniform(bgfx::UniformHandle uniform, const void* pValue, uint16_t vec4Count = 1);
+
+	void Submit(uint16_t viewID, bgfx::ProgramHandle program);
+
+private:
+	struct Binding
+	{
+		uint16_t sampler = bgfx::kInvalidHandle;
+		uint16_t texture = bgfx::kInvalidHandle;
+		uint32_t flags = 0U;
+		bool isImage = false;
+	};
+
+	bgfx::Encoder* m_pEncoder = nullptr;
+	bool m_isStateValid = false;
+	uint64_t m_state = 0U;
+	uint32_t m_rgba = 0U;
+	std::array<uint16_t, MaxVertexStreamCount> m_vertexBuffers;
+	uint16_t m_indexBuffer = bgfx::kInvalidHandle;
+	std::array<Binding, MaxTextureStageCount> m_bindings;
+
+	// Last values sent per uniform, indexed by handle, stored as vec4s.
+	std::vector<std::vector<float>> m_uniformValues;
+
+	// Counted since the last End.
+	Statistics m_statistics;
+};
+
+}
\ No newline at end of file
@@ -56,6 +56,9 @@ void RenderTarget::Resize(uint16_t width, uint16_t height)
 			bgfx::TextureFormat::Enum textureFormat;
 			switch (attachmentDescriptor.textureFormat)
 			{
+			case TextureFormat::RGBA8:
+				textureFormat = bgfx::TextureFormat::RGBA8;
+				break;
 			case TextureFormat::D32F:
 				textureFormat = bgfx::TextureFormat::D32F;
 				break;
@@ -20,6 +20,7 @@ namespace engine
 
 enum class TextureFormat
 {
+	RGBA8,
 	RGBA32F,
 	D32F
 };
@@ -0,0 +1,142 @@
+#include "RenderThread.h"
+
+#include "Base/Template.h"
+#include "Renderer.h"
+
+#include <bgfx/bgfx.h>
+
+#include <cassert>
+#include <chrono>
+
+#ifdef TRACY_ENABLE
+#include <tracy/Tracy.hpp>
+#else
+#define ZoneScopedN(name)
+#define TracyPlot(name, value)
+#endif
+
+namespace engine
+{
+
+namespace
+{
+
+float GetSecondsSince(std::chrono::steady_clock::time_point startTime)
+{
+	return std::chrono::duration<float>(std::chrono::steady_clock::now() - startTime).count();
+}
+
+}
+
+RenderThread::RenderThread()
+{
+	m_thread = std::thread(&RenderThread::ThreadLoop, this);
+}
+
+RenderThread::~RenderThread()
+{
+	Wait();
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_isExiting = true;
+	}
+	m_kickCondition.notify_one();
+	m_thread.join();
+}
+
+void RenderThread::Kick(FrameFunction function)
+{
+	assert(!m_isFrameInFlight && "Wait for the previous frame before kicking a new one.");
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_function = cd::MoveTemp(function);
+		m_hasWork = true;
+	}
+	m_isFrameInFlight = true;
+	m_kickCondition.notify_one();
+}
+
+void RenderThread::Wait()
+{
+	if (!m_isFrameInFlight)
+	{
+		return;
+	}
+
+	ZoneScopedN("RenderThread::Wait");
+
+	auto startTime = std::chrono::steady_clock::now();
+	bool isFrameDropped;
+	float recordTime;
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		m_doneCondition.wait(lock, [this]() { return !m_hasWork; });
+		isFrameDropped = m_isFrameDropped;
+		recordTime = m_recordTime;
+	}
+	m_isFrameInFlight = false;
+
+	float waitTime = GetSecondsSince(startTime);
+	++m_statistics.frameCount;
+	m_statistics.droppedFrameCount += isFrameDropped ? 1U : 0U;
+	m_statistics.totalWaitTime += waitTime;
+	m_statistics.totalRecordTime += recordTime;
+	m_statistics.lastWaitTime = waitTime;
+	m_statistics.lastRecordTime = recordTime;
+
+	TracyPlot("Render wait (ms)", waitTime * 1000.0f);
+	TracyPlot("Render record (ms)", recordTime * 1000.0f);
+}
+
+void RenderThread::ThreadLoop()
+{
+#ifdef TRACY_ENABLE
+	tracy::SetThreadName("Render");
+#endif
+
+	while (true)
+	{
+		FrameFunction function;
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_kickCondition.wait(lock, [this]() { return m_hasWork || m_isExiting; });
+			if (!m_hasWork)
+			{
+				return;
+			}
+			function = cd::MoveTemp(m_function);
+		}
+
+		auto startTime = std::chrono::steady_clock::now();
+		bool isFrameDropped = false;
+		{
+			ZoneScopedN("RenderThread::Record");
+
+			// Released before the main thread can call bgfx::frame, which only picks up ended encoders.
+			if (bgfx::Encoder* pEncoder = bgfx::begin(true))
+			{
+				Renderer::SetEncoder(pEncoder);
+				function();
+				Renderer::SetEncoder(nullptr);
+				bgfx::end(pEncoder);
+			}
+			else
+			{
+				isFrameDropped = true;
+			}
+		}
+		float recordTime = GetSecondsSince(startTime);
+
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_hasWork = false;
+			m_isFrameDropped = isFrameDropped;
+			m_recordTime = recordTime;
+		}
+		m_doneCondition.notify_one();
+	}
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+namespace engine
+{
+
+// Records the draw calls of one frame on a dedicated thread while the main thread simulates the next one.
+// The main thread stays the bgfx API thread : it calls Wait before bgfx::frame and Kick after it, so at most
+// one frame is in flight and neither side can get more than one frame ahead of the other.
+// A kicked function must only read state which the main thread leaves untouched until the next Wait.
+class RenderThread final
+{
+public:
+	using FrameFunction = std::function<void()>;
+
+	struct Statistics
+	{
+		uint64_t frameCount = 0U;
+		// Frames skipped because bgfx had no encoder left for the render thread.
+		uint64_t droppedFrameCount = 0U;
+		// Main thread blocked in Wait and render thread busy recording, in seconds over all frames.
+		double totalWaitTime = 0.0;
+		double totalRecordTime = 0.0;
+		float lastWaitTime = 0.0f;
+		float lastRecordTime = 0.0f;
+	};
+
+public:
+	RenderThread();
+	RenderThread(const RenderThread&) = delete;
+	RenderThread& operator=(const RenderThread&) = delete;
+	RenderThread(RenderThread&&) = delete;
+	RenderThread& operator=(RenderThread&&) = delete;
+	~RenderThread();
+
+	// Starts recording a frame. The previous one must have been waited for.
+	void Kick(FrameFunction function);
+
+	// Blocks until the kicked frame is recorded and its encoder is released. Returns at once when nothing is in flight.
+	void Wait();
+
+	bool IsFrameInFlight() const { return m_isFrameInFlight; }
+
+	// Only up to date after Wait.
+	const Statistics& GetStatistics() const { return m_statistics; }
+
+private:
+	void ThreadLoop();
+
+	std::thread m_thread;
+	std::mutex m_mutex;
+	std::condition_variable m_kickCondition;
+	std::condition_variable m_doneCondition;
+
+	// Shared with the render thread under the mutex.
+	FrameFunction m_function;
+	bool m_hasWork = false;
+	bool m_isExiting = false;
+	bool m_isFrameDropped = false;
+	float m_recordTime = 0.0f;
+
+	// Main thread only.
+	bool m_isFrameInFlight = false;
+	Statistics m_statistics;
+};
+
+}
\ No newline at end of file
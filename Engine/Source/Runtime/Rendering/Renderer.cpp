@@ -25,6 +25,18 @@ RenderContext* Renderer::GetRenderContext()
 	return m_pRenderContext;
 }
 
+static thread_local bgfx::Encoder* s_pEncoder = nullptr;
+void Renderer::SetEncoder(bgfx::Encoder* pEncoder)
+{
+	s_pEncoder = pEncoder;
+}
+
+bgfx::Encoder* Renderer::GetEncoder()
+{
+	// bgfx::begin returns the default encoder on the API thread.
+	return s_pEncoder ? s_pEncoder : bgfx::begin();
+}
+
 void Renderer::UpdateViewRenderTarget()
 {
 	if (m_pRenderTarget)
@@ -134,7 +146,7 @@ void Renderer::ScreenSpaceQuad(const RenderTarget* pRenderTarget, bool _originBo
 		vertex[2].m_u = maxu;
 		vertex[2].m_v = maxv;
 
-		bgfx::setVertexBuffer(0, &vb);
+		GetEncoder()->setVertexBuffer(0, &vb);
 	}
 }
 
@@ -2,6 +2,13 @@
 
 #include <cstdint>
 
+namespace bgfx
+{
+
+struct Encoder;
+
+}
+
 namespace engine
 {
 
@@ -23,8 +30,16 @@ public:
 	static void SetRenderContext(RenderContext* pRenderContext);
 	static RenderContext* GetRenderContext();
 
+	// Draw calls are recorded to the encoder of the calling thread. Threads other than the bgfx API thread
+	// have to set one from bgfx::begin(true) before rendering and release it before the next bgfx::frame.
+	static void SetEncoder(bgfx::Encoder* pEncoder);
+	static bgfx::Encoder* GetEncoder();
+
 	virtual void Init() = 0;
 	virtual void UpdateView(const float* pViewMatrix, const float* pProjectionMatrix) = 0;
+	// Runs on the bgfx API thread before Render. Resource creation, texture updates and writes to
+	// components belong here, so that Render only reads and records draw calls.
+	virtual void Prepare() {}
 	virtual void Render(float deltaTime) = 0;
 
 	uint16_t GetViewID() const { return m_viewID; }
@@ -51,6 +51,19 @@ void SkyboxRenderer::UpdateView(const float* pViewMatrix, const float* pProjecti
 	bgfx::setViewClear(GetViewID(), BGFX_CLEAR_COLOR | BGFX_CLEAR_DEPTH, 0x303030ff, 1.0f, 0);
 }
 
+void SkyboxRenderer::Prepare()
+{
+	if (!IsEnable())
+	{
+		return;
+	}
+
+	// Create a new TextureHandle each frame if the skybox texture path has been updated,
+	// otherwise RenderContext::CreateTexture will automatically skip it.
+	SkyComponent* pSkyComponent = m_pCurrentSceneWorld->GetSkyComponent(m_pCurrentSceneWorld->GetSkyEntity());
+	GetRenderContext()->CreateTexture(pSkyComponent->GetRadianceTexturePath().c_str(), sampleFalg);
+}
+
 void SkyboxRenderer::Render(float deltaTime)
 {
 	if (!IsEnable())
@@ -64,23 +77,20 @@ void SkyboxRenderer::Render(float deltaTime)
 		return;
 	}
 
-	bgfx::setVertexBuffer(0, bgfx::VertexBufferHandle{ pMeshComponent->GetVertexBuffer() });
-	bgfx::setIndexBuffer(bgfx::IndexBufferHandle{ pMeshComponent->GetIndexBuffer() });
+	GetEncoder()->setVertexBuffer(0, bgfx::VertexBufferHandle{ pMeshComponent->GetVertexBuffer() });
+	GetEncoder()->setIndexBuffer(bgfx::IndexBufferHandle{ pMeshComponent->GetIndexBuffer() });
 
-	// Create a new TextureHandle each frame if the skybox texture path has been updated,
-	// otherwise RenderContext::CreateTexture will automatically skip it.
 	SkyComponent* pSkyComponent = m_pCurrentSceneWorld->GetSkyComponent(m_pCurrentSceneWorld->GetSkyEntity());
-	GetRenderContext()->CreateTexture(pSkyComponent->GetRadianceTexturePath().c_str(), sampleFalg);
 
 	constexpr StringCrc samplerCrc(skyboxSampler);
 	constexpr StringCrc programCrc(skyboxShader);
 
-	bgfx::setTexture(0,
+	GetEncoder()->setTexture(0,
 		GetRenderContext()->GetUniform(samplerCrc),
 		GetRenderContext()->GetTexture(StringCrc(pSkyComponent->GetRadianceTexturePath())));
 
-	bgfx::setState(renderState);
-	bgfx::submit(GetViewID(), GetRenderContext()->GetProgram(programCrc));
+	GetEncoder()->setState(renderState);
+	GetEncoder()->submit(GetViewID(), GetRenderContext()->GetProgram(programCrc));
 }
 
 bool SkyboxRenderer::IsEnable() const
@@ -14,6 +14,7 @@ public:
 
 	virtual void Init() override;
 	virtual void UpdateView(const float* pViewMatrix, const float* pProjectionMatrix) override;
+	virtual void Prepare() override;
 	virtual void Render(float deltaTime) override;
 	virtual bool IsEnable() const override;
 
@@ -1,19 +1,25 @@
 #include "TerrainRenderer.h"
 
+#include "Core/FrameAllocator.h"
 #include "ECWorld/CameraComponent.h"
 #include "ECWorld/MaterialComponent.h"
 #include "ECWorld/SceneWorld.h"
 #include "ECWorld/SkyComponent.h"
-#include "ECWorld/StaticMeshComponent.h"
 #include "ECWorld/TransformComponent.h"
 #include "LightUniforms.h"
 #include "Material/ShaderSchema.h"
 #include "Math/Transform.hpp"
 #include "RenderContext.h"
+#include "RenderPacket.h"
 #include "Scene/Texture.h"
+#include "Terrain/TerrainTileStreamer.h"
 #include "U_IBL.sh"
 #include "U_Terrain.sh"
 
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
 namespace engine
 {
 
@@ -24,11 +30,11 @@ constexpr const char* snowSampler = "s_texSnow";
 constexpr const char* rockSampler = "s_texRock";
 constexpr const char* grassSampler = "s_texGrass";
 constexpr const char* elevationSampler = "s_texElevation";
+constexpr const char* normalSampler = "s_texTerrainNormal";
 
 constexpr const char* snowTexture = "Textures/terrain/snow_baseColor.dds";
 constexpr const char* rockTexture = "Textures/terrain/rock_baseColor.dds";
 constexpr const char* grassTexture = "Textures/terrain/grass_baseColor.dds";
-constexpr const char* elevationTexture = "Terrain";
 
 constexpr const char* lutSampler = "s_texLUT";
 constexpr const char* cubeIrradianceSampler = "s_texCubeIrr";
@@ -47,9 +53,114 @@ constexpr const char* emissiveColor = "u_emissiveColor";
 constexpr const char* lightCountAndStride = "u_lightCountAndStride";
 constexpr const char* lightParams = "u_lightParams";
 
+constexpr const char* terrainPatch = "u_terrainPatch";
+constexpr const char* terrainSize = "u_terrainSize";
+constexpr const char* terrainHeightRange = "u_terrainHeightRange";
+
 constexpr uint64_t samplerFlags = BGFX_SAMPLER_U_CLAMP | BGFX_SAMPLER_V_CLAMP | BGFX_SAMPLER_W_CLAMP;
+
 constexpr uint64_t defaultRenderingState = BGFX_STATE_WRITE_MASK | BGFX_STATE_MSAA | BGFX_STATE_DEPTH_TEST_LESS;
 
+// A streamed tile is drawn once the camera is at least its own width away from it, otherwise its children are.
+constexpr float streamedTileLodDistance = 1.0f;
+
+// Flat unit grid shared by all patches. Heights and normals come from the heightfield textures.
+struct PatchVertex
+{
+	float position[3];
+	float normal[3];
+	float tangent[3];
+	float uv[2];
+};
+
+// Sends one rectangle of a texture which mirrors a row major CPU array, and returns the bytes sent.
+// bgfx reads the texels up to two frames later while the component may be edited or destroyed meanwhile,
+// so the rectangle is always copied into frame memory, which lives that long.
+uint32_t UploadRect(bgfx::TextureHandle texture, const std::byte* pSource, uint16_t width, uint32_t bytesPerSample, const TerrainComponent::ElevationRect& rect)
+{
+	uint16_t rectWidth = rect.maxX - rect.minX + 1U;
+	uint16_t rectDepth = rect.maxZ - rect.minZ + 1U;
+	uint32_t rowBytes = rectWidth * bytesPerSample;
+	uint32_t rectBytes = rowBytes * rectDepth;
+
+	const std::byte* pRectBegin = pSource + (static_cast<size_t>(rect.minZ) * width + rect.minX) * bytesPerSample;
+	std::byte* pTexels = FrameAllocator::AllocateArray<std::byte>(rectBytes);
+	if (rectWidth == width)
+	{
+		// Full width rows are contiguous in the source.
+		std::memcpy(pTexels, pRectBegin, rectBytes);
+	}
+	else
+	{
+		for (uint16_t row = 0U; row < rectDepth; ++row)
+		{
+			std::memcpy(pTexels + row * rowBytes, pRectBegin + static_cast<size_t>(row) * width * bytesPerSample, rowBytes);
+		}
+	}
+
+	bgfx::updateTexture2D(texture, 0, 0, rect.minX, rect.minZ, rectWidth, rectDepth, bgfx::makeRef(pTexels, rectBytes));
+	return rectBytes;
+}
+
+// Quads along one side of a pyramid level, the last step being clamped at the edge like TerrainTileFile does.
+uint32_t GetLevelQuadCount(uint32_t sampleCount, uint32_t level)
+{
+	uint32_t step = 1U << level;
+	return (sampleCount - 1U + step - 1U) / step;
+}
+
+// Walks down from the tile until tiles are far enough for their level. Positions are in level 0 samples.
+void SelectStreamedTiles(const TerrainTileFile& tileFile, const cd::Point& cameraPosition, const TerrainTileKey& key, std::vector<TerrainTileKey>& keys)
+{
+	float span = static_cast<float>(tileFile.GetTileSize() << key.level);
+	float minX = static_cast<float>(key.x) * span;
+	float minZ = static_cast<float>(key.z) * span;
+	float distanceX = std::max(std::max(minX - cameraPosition.x(), cameraPosition.x() - minX - span), 0.0f);
+	float distanceY = std::max(std::max(tileFile.GetMinHeight() - cameraPosition.y(), cameraPosition.y() - tileFile.GetMaxHeight()), 0.0f);
+	float distanceZ = std::max(std::max(minZ - cameraPosition.z(), cameraPosition.z() - minZ - span), 0.0f);
+	float distance = std::sqrt(distanceX * distanceX + distanceY * distanceY + distanceZ * distanceZ);
+	if (0U == key.level || distance >= streamedTileLodDistance * span)
+	{
+		keys.push_back(key);
+		return;
+	}
+
+	for (uint32_t childZ = key.z * 2U; childZ < key.z * 2U + 2U; ++childZ)
+	{
+		for (uint32_t childX = key.x * 2U; childX < key.x * 2U + 2U; ++childX)
+		{
+			TerrainTileKey childKey { key.level - 1U, childX, childZ };
+			if (tileFile.IsValidTile(childKey))
+			{
+				SelectStreamedTiles(tileFile, cameraPosition, childKey, keys);
+			}
+		}
+	}
+}
+
+}
+
+TerrainRenderer::~TerrainRenderer()
+{
+	if (bgfx::isValid(m_patchVertexBuffer))
+	{
+		bgfx::destroy(m_patchVertexBuffer);
+		for (bgfx::IndexBufferHandle indexBuffer : m_patchIndexBuffers)
+		{
+			bgfx::destroy(indexBuffer);
+		}
+	}
+
+	for (const auto& [entity, heightfieldTextures] : m_heightfieldTextures)
+	{
+		bgfx::destroy(heightfieldTextures.elevation);
+		bgfx::destroy(heightfieldTextures.normal);
+	}
+
+	for (auto& [entity, streamedTerrain] : m_streamedTerrains)
+	{
+		DestroyStreamedTiles(streamedTerrain);
+	}
 }
 
 void TerrainRenderer::Init()
@@ -57,33 +168,73 @@ void TerrainRenderer::Init()
 	SkyComponent* pSkyComponent = m_pCurrentSceneWorld->GetSkyComponent(m_pCurrentSceneWorld->GetSkyEntity());
 	
 	GetRenderContext()->CreateProgram("TerrainProgram", "vs_terrain.bin", "fs_terrain.bin");
-	GetRenderContext()->CreateUniform(snowSampler, bgfx::UniformType::Sampler);
-	GetRenderContext()->CreateUniform(rockSampler, bgfx::UniformType::Sampler);
-	GetRenderContext()->CreateUniform(grassSampler, bgfx::UniformType::Sampler);
-	GetRenderContext()->CreateUniform(elevationSampler, bgfx::UniformType::Sampler);
+	m_uniforms.snowSampler = GetRenderContext()->CreateUniform(snowSampler, bgfx::UniformType::Sampler);
+	m_uniforms.rockSampler = GetRenderContext()->CreateUniform(rockSampler, bgfx::UniformType::Sampler);
+	m_uniforms.grassSampler = GetRenderContext()->CreateUniform(grassSampler, bgfx::UniformType::Sampler);
+	m_uniforms.elevationSampler = GetRenderContext()->CreateUniform(elevationSampler, bgfx::UniformType::Sampler);
+	m_uniforms.normalSampler = GetRenderContext()->CreateUniform(normalSampler, bgfx::UniformType::Sampler);
 
-	GetRenderContext()->CreateTexture(snowTexture);
-	GetRenderContext()->CreateTexture(rockTexture);
-	GetRenderContext()->CreateTexture(grassTexture);
-	GetRenderContext()->CreateTexture(elevationTexture);
+	m_textures.snow = GetRenderContext()->CreateTexture(snowTexture);
+	m_textures.rock = GetRenderContext()->CreateTexture(rockTexture);
+	m_textures.grass = GetRenderContext()->CreateTexture(grassTexture);
 
-	GetRenderContext()->CreateTexture(lutTexture);
+	m_uniforms.lutSampler = GetRenderContext()->CreateUniform(lutSampler, bgfx::UniformType::Sampler);
+	m_uniforms.cubeIrradianceSampler = GetRenderContext()->CreateUniform(cubeIrradianceSampler, bgfx::UniformType::Sampler);
+	m_uniforms.cubeRadianceSampler = GetRenderContext()->CreateUniform(cubeRadianceSampler, bgfx::UniformType::Sampler);
+
+	m_textures.lut = GetRenderContext()->CreateTexture(lutTexture);
 	GetRenderContext()->CreateTexture(pSkyComponent->GetIrradianceTexturePath().c_str(), samplerFlags);
 	GetRenderContext()->CreateTexture(pSkyComponent->GetRadianceTexturePath().c_str(), samplerFlags);
 
-	GetRenderContext()->CreateUniform(cameraPos, bgfx::UniformType::Vec4, 1);
-	GetRenderContext()->CreateUniform(albedoColor, bgfx::UniformType::Vec4, 1);
-	GetRenderContext()->CreateUniform(emissiveColor, bgfx::UniformType::Vec4, 1);
-	GetRenderContext()->CreateUniform(metallicRoughnessFactor, bgfx::UniformType::Vec4, 1);
-	GetRenderContext()->CreateUniform(albedoUVOffsetAndScale, bgfx::UniformType::Vec4, 1);
-	GetRenderContext()->CreateUniform(alphaCutOff, bgfx::UniformType::Vec4, 1);
-
-	GetRenderContext()->CreateUniform(lightCountAndStride, bgfx::UniformType::Vec4, 1);
-	GetRenderContext()->CreateUniform(lightParams, bgfx::UniformType::Vec4, LightUniform::VEC4_COUNT);
-
-	GetRenderContext()->CreateTexture(elevationTexture, 129U, 129U, 1, bgfx::TextureFormat::Enum::R32F, samplerFlags, nullptr, 0);
+	m_uniforms.cameraPos = GetRenderContext()->CreateUniform(cameraPos, bgfx::UniformType::Vec4, 1);
+	m_uniforms.albedoColor = GetRenderContext()->CreateUniform(albedoColor, bgfx::UniformType::Vec4, 1);
+	m_uniforms.emissiveColor = GetRenderContext()->CreateUniform(emissiveColor, bgfx::UniformType::Vec4, 1);
+	m_uniforms.metallicRoughnessFactor = GetRenderContext()->CreateUniform(metallicRoughnessFactor, bgfx::UniformType::Vec4, 1);
+	m_uniforms.albedoUVOffsetAndScale = GetRenderContext()->CreateUniform(albedoUVOffsetAndScale, bgfx::UniformType::Vec4, 1);
+	m_uniforms.alphaCutOff = GetRenderContext()->CreateUniform(alphaCutOff, bgfx::UniformType::Vec4, 1);
+
+	m_uniforms.lightCountAndStride = GetRenderContext()->CreateUniform(lightCountAndStride, bgfx::UniformType::Vec4, 1);
+	m_uniforms.lightParams = GetRenderContext()->CreateUniform(lightParams, bgfx::UniformType::Vec4, LightUniform::VEC4_COUNT);
+
+	m_uniforms.terrainPatch = GetRenderContext()->CreateUniform(terrainPatch, bgfx::UniformType::Vec4, 1);
+	m_uniforms.terrainSize = GetRenderContext()->CreateUniform(terrainSize, bgfx::UniformType::Vec4, 1);
+	m_uniforms.terrainHeightRange = GetRenderContext()->CreateUniform(terrainHeightRange, bgfx::UniformType::Vec4, 1);
+
+	bgfx::VertexLayout patchVertexLayout;
+	patchVertexLayout.begin()
+		.add(bgfx::Attrib::Position, 3, bgfx::AttribType::Float)
+		.add(bgfx::Attrib::Normal, 3, bgfx::AttribType::Float)
+		.add(bgfx::Attrib::Tangent, 3, bgfx::AttribType::Float)
+		.add(bgfx::Attrib::TexCoord0, 2, bgfx::AttribType::Float)
+		.end();
+
+	constexpr uint32_t patchVertexCount = TerrainQuadTree::PatchVertexCount * TerrainQuadTree::PatchVertexCount;
+	const bgfx::Memory* pVertexMemory = bgfx::alloc(patchVertexCount * sizeof(PatchVertex));
+	PatchVertex* pVertices = reinterpret_cast<PatchVertex*>(pVertexMemory->data);
+	for (uint32_t z = 0U; z < TerrainQuadTree::PatchVertexCount; ++z)
+	{
+		for (uint32_t x = 0U; x < TerrainQuadTree::PatchVertexCount; ++x)
+		{
+			float gridX = static_cast<float>(x);
+			float gridZ = static_cast<float>(z);
+			constexpr float inversePatchQuadCount = 1.0f / static_cast<float>(TerrainQuadTree::PatchQuadCount);
+			*pVertices++ = PatchVertex{ { gridX, 0.0f, gridZ }, { 0.0f, 1.0f, 0.0f }, { 1.0f, 0.0f, 0.0f },
+				{ gridX * inversePatchQuadCount, gridZ * inversePatchQuadCount } };
+		}
+	}
+	m_patchVertexBuffer = bgfx::createVertexBuffer(pVertexMemory, patchVertexLayout);
+
+	std::vector<uint16_t> indices;
+	for (uint32_t stitchMask = 0U; stitchMask < TerrainQuadTree::StitchVariantCount; ++stitchMask)
+	{
+		TerrainQuadTree::GenerateIndices(stitchMask, indices);
+		m_patchIndexBuffers[stitchMask] = bgfx::createIndexBuffer(bgfx::copy(indices.data(), static_cast<uint32_t>(indices.size() * sizeof(uint16_t))));
+		m_patchTriangleCounts[stitchMask] = static_cast<uint32_t>(indices.size() / 3U);
+	}
 
 	bgfx::setViewName(GetViewID(), "TerrainRenderer");
+	// RenderStateCache relies on draws running in submission order.
+	bgfx::setViewMode(GetViewID(), bgfx::ViewMode::Sequential);
 }
 
 void TerrainRenderer::UpdateView(const float* pViewMatrix, const float* pProjectionMatrix)
@@ -92,114 +243,175 @@ void TerrainRenderer::UpdateView(const float* pViewMatrix, const float* pProject
 	bgfx::setViewTransform(GetViewID(), pViewMatrix, pProjectionMatrix);
 }
 
-void TerrainRenderer::Render(float deltaTime)
+void TerrainRenderer::Prepare()
 {
-	// TODO : Remove it. If every renderer need to submit camera related uniform, it should be done not inside Renderer class.
-	const cd::Transform& cameraTransform = m_pCurrentSceneWorld->GetTransformComponent(m_pCurrentSceneWorld->GetMainCameraEntity())->GetTransform();
+	SkyComponent* pSkyComponent = m_pCurrentSceneWorld->GetSkyComponent(m_pCurrentSceneWorld->GetSkyEntity());
+	SkyType crtSkyType = pSkyComponent->GetSkyType();
+
+	m_textures.irradiance = BGFX_INVALID_HANDLE;
+	m_textures.radiance = BGFX_INVALID_HANDLE;
+	if (SkyType::SkyBox == crtSkyType)
+	{
+		// Create a new TextureHandle each frame if the skybox texture path has been updated,
+		// otherwise RenderContext::CreateTexture will automatically skip it.
+		m_textures.irradiance = GetRenderContext()->CreateTexture(pSkyComponent->GetIrradianceTexturePath().c_str(), samplerFlags);
+		m_textures.radiance = GetRenderContext()->CreateTexture(pSkyComponent->GetRadianceTexturePath().c_str(), samplerFlags);
+	}
+
+	// Upload and streaming statistics are counted here, selection ones by Render.
+	m_statistics = Statistics();
+	cd::Point cameraPosition = GetRenderCamera(*m_pCurrentSceneWorld).position;
 	for (Entity entity : m_pCurrentSceneWorld->GetTerrainEntities())
-	{		
+	{
 		MaterialComponent* pMaterialComponent = m_pCurrentSceneWorld->GetMaterialComponent(entity);
-		if (!pMaterialComponent ||
+		TerrainComponent* pTerrainComponent = m_pCurrentSceneWorld->GetTerrainComponent(entity);
+		if (!pMaterialComponent || !pTerrainComponent ||
 			pMaterialComponent->GetMaterialType() != m_pCurrentSceneWorld->GetTerrainMaterialType())
 		{
-			// TODO : improve this condition. As we want to skip some feature-specified entities to render.
-			// For example, terrain/particle/...
 			continue;
 		}
 
-		// No mesh attached?
-		StaticMeshComponent* pMeshComponent = m_pCurrentSceneWorld->GetStaticMeshComponent(entity);
-		if (!pMeshComponent)
+		// Sky type is an uber option of the material.
+		pMaterialComponent->SetSkyType(crtSkyType);
+
+		// Streamed terrains are drawn from the pyramid file, which heightfield edits don't reach.
+		auto itStreamedTerrain = m_streamedTerrains.find(entity);
+		if (itStreamedTerrain != m_streamedTerrains.end())
 		{
+			TransformComponent* pTransformComponent = m_pCurrentSceneWorld->GetTransformComponent(entity);
+			cd::Matrix4x4 worldMatrix = pTransformComponent ? GetRenderWorldMatrix(*m_pCurrentSceneWorld, entity, *pTransformComponent) : cd::Matrix4x4::Identity();
+			cd::Vec4f localCameraPosition = worldMatrix.Inverse() * cd::Vec4f(cameraPosition.x(), cameraPosition.y(), cameraPosition.z(), 1.0f);
+			UpdateStreamedTiles(itStreamedTerrain->second, cd::Point(localCameraPosition.x(), localCameraPosition.y(), localCameraPosition.z()));
 			continue;
 		}
 
-		// Transform
-		if (TransformComponent* pTransformComponent = m_pCurrentSceneWorld->GetTransformComponent(entity))
+		pTerrainComponent->UpdateHeightStructures();
+		if (!pTerrainComponent->GetQuadTree().IsEmpty())
 		{
-			bgfx::setTransform(pTransformComponent->GetWorldMatrix().Begin());
+			UpdateHeightfieldTextures(entity, *pTerrainComponent);
 		}
+	}
+}
 
-		// Mesh
-		bgfx::setVertexBuffer(0, bgfx::VertexBufferHandle{pMeshComponent->GetVertexBuffer()});
-		bgfx::setIndexBuffer(bgfx::IndexBufferHandle{pMeshComponent->GetIndexBuffer()});
+void TerrainRenderer::Render(float deltaTime)
+{
+	// TODO : Remove it. If every renderer need to submit camera related uniform, it should be done not inside Renderer class.
+	RenderCamera camera = GetRenderCamera(*m_pCurrentSceneWorld);
+	SkyComponent* pSkyComponent = m_pCurrentSceneWorld->GetSkyComponent(m_pCurrentSceneWorld->GetSkyEntity());
+	SkyType crtSkyType = pSkyComponent->GetSkyType();
 
-		// Material
-		bgfx::setTexture(TERRAIN_TOP_ALBEDO_MAP_SLOT,
-			GetRenderContext()->GetUniform(StringCrc(snowSampler)),
-			GetRenderContext()->GetTexture(StringCrc(snowTexture)));
+	// Everything below only changes per frame, so resolve it once before walking the entities.
+	cd::Vec4f cameraPosData(camera.position.x(), camera.position.y(), camera.position.z(), 1.0f);
 
-		bgfx::setTexture(TERRAIN_MEDIUM_ALBEDO_MAP_SLOT,
-			GetRenderContext()->GetUniform(StringCrc(rockSampler)),
-			GetRenderContext()->GetTexture(StringCrc(rockTexture)));
+	uint32_t lightEntityCount = 0U;
+	const LightComponent* pLights = GetRenderLights(*m_pCurrentSceneWorld, lightEntityCount);
+	cd::Vec4f lightInfoData(static_cast<float>(lightEntityCount), LightUniform::LIGHT_STRIDE, 0.0f, 0.0f);
+	const float* pLightDataBegin = lightEntityCount > 0U ? reinterpret_cast<const float*>(pLights) : nullptr;
+	uint16_t lightDataVec4Count = static_cast<uint16_t>(lightEntityCount * LightUniform::LIGHT_STRIDE);
 
-		bgfx::setTexture(TERRAIN_BOTTOM_ALBEDO_MAP_SLOT,
-			GetRenderContext()->GetUniform(StringCrc(grassSampler)),
-			GetRenderContext()->GetTexture(StringCrc(grassTexture)));
+	constexpr StringCrc terrainProgramCrc("TerrainProgram");
+	bgfx::ProgramHandle terrainProgram = GetRenderContext()->GetProgram(terrainProgramCrc);
 
-		TerrainComponent* pTerrainComponent = m_pCurrentSceneWorld->GetTerrainComponent(entity);
-		GetRenderContext()->UpdateTexture(elevationTexture, 0, 0, 0, 0, 0, pTerrainComponent->GetTexWidth(), pTerrainComponent->GetTexDepth(),
-			1, pTerrainComponent->GetElevationRawData(), pTerrainComponent->GetElevationRawDataSize());
+	cd::Matrix4x4 viewProjection = camera.projectionMatrix * camera.viewMatrix;
+	uint16_t viewportHeight = m_pRenderTarget ? m_pRenderTarget->GetHeight() : GetRenderContext()->GetBackBufferHeight();
 
-		bgfx::setTexture(TERRAIN_ELEVATION_MAP_SLOT,
-			GetRenderContext()->GetUniform(StringCrc(elevationSampler)),
-			GetRenderContext()->GetTexture(StringCrc(elevationTexture)));
+	TerrainQuadTree::SelectionSettings selectionSettings;
+	selectionSettings.projectionScale = static_cast<float>(viewportHeight) * 0.5f * camera.projectionMatrix.Begin()[5];
+	selectionSettings.maxScreenError = m_maxScreenError;
+	selectionSettings.homogeneousDepth = bgfx::getCaps()->homogeneousDepth;
 
-		// Sky
-		SkyComponent* pSkyComponent = m_pCurrentSceneWorld->GetSkyComponent(m_pCurrentSceneWorld->GetSkyEntity());
-		SkyType crtSkyType = pSkyComponent->GetSkyType();
-		pMaterialComponent->SetSkyType(crtSkyType);
+	m_stateCache.Begin();
 
-		if (crtSkyType == SkyType::SkyBox)
+	for (Entity entity : m_pCurrentSceneWorld->GetTerrainEntities())
+	{		
+		MaterialComponent* pMaterialComponent = m_pCurrentSceneWorld->GetMaterialComponent(entity);
+		if (!pMaterialComponent ||
+			pMaterialComponent->GetMaterialType() != m_pCurrentSceneWorld->GetTerrainMaterialType())
 		{
-			// Create a new TextureHandle each frame if the skybox texture path has been updated,
-			// otherwise RenderContext::CreateTexture will automatically skip it.
+			// TODO : improve this condition. As we want to skip some feature-specified entities to render.
+			// For example, terrain/particle/...
+			continue;
+		}
 
-			constexpr StringCrc irrSamplerCrc(cubeIrradianceSampler);
-			GetRenderContext()->CreateTexture(pSkyComponent->GetIrradianceTexturePath().c_str(), samplerFlags);
-			bgfx::setTexture(IBL_IRRADIANCE_SLOT,
-				GetRenderContext()->GetUniform(irrSamplerCrc),
-				GetRenderContext()->GetTexture(StringCrc(pSkyComponent->GetIrradianceTexturePath())));
+		TerrainComponent* pTerrainComponent = m_pCurrentSceneWorld->GetTerrainComponent(entity);
+		auto itStreamedTerrain = m_streamedTerrains.find(entity);
+		const StreamedTerrain* pStreamedTerrain = itStreamedTerrain != m_streamedTerrains.end() ? &itStreamedTerrain->second : nullptr;
+		if (!pTerrainComponent || (!pStreamedTerrain && pTerrainComponent->GetQuadTree().IsEmpty()))
+		{
+			continue;
+		}
 
-			constexpr StringCrc radSamplerCrc(cubeRadianceSampler);
-			GetRenderContext()->CreateTexture(pSkyComponent->GetRadianceTexturePath().c_str(), samplerFlags);
-			bgfx::setTexture(IBL_RADIANCE_SLOT,
-				GetRenderContext()->GetUniform(radSamplerCrc),
-				GetRenderContext()->GetTexture(StringCrc(pSkyComponent->GetRadianceTexturePath())));
+		// LOD and culling run in terrain space, where a heightfield sample is one unit.
+		TransformComponent* pTransformComponent = m_pCurrentSceneWorld->GetTransformComponent(entity);
+		cd::Matrix4x4 worldMatrix = pTransformComponent ? GetRenderWorldMatrix(*m_pCurrentSceneWorld, entity, *pTransformComponent) : cd::Matrix4x4::Identity();
 
-			constexpr StringCrc lutsamplerCrc(lutSampler);
-			constexpr StringCrc luttextureCrc(lutTexture);
-			bgfx::setTexture(BRDF_LUT_SLOT, GetRenderContext()->GetUniform(lutsamplerCrc), GetRenderContext()->GetTexture(luttextureCrc));
+		const HeightfieldTextures* pHeightfieldTextures = nullptr;
+		if (pStreamedTerrain)
+		{
+			// Tiles were picked by Prepare.
+			++m_statistics.terrainCount;
+			if (pStreamedTerrain->drawnTiles.empty())
+			{
+				continue;
+			}
+		}
+		else
+		{
+			cd::Vec4f localCameraPosition = worldMatrix.Inverse() * cameraPosData;
+			selectionSettings.worldViewProjection = viewProjection * worldMatrix;
+			selectionSettings.cameraPosition = cd::Point(localCameraPosition.x(), localCameraPosition.y(), localCameraPosition.z());
+
+			m_selectedPatches.clear();
+			TerrainQuadTree& quadTree = pTerrainComponent->GetQuadTree();
+			quadTree.Select(selectionSettings, m_selectedPatches);
+			++m_statistics.terrainCount;
+			m_statistics.culledNodeCount += quadTree.GetStatistics().culledNodeCount;
+			if (m_selectedPatches.empty())
+			{
+				continue;
+			}
+
+			auto itHeightfieldTextures = m_heightfieldTextures.find(entity);
+			if (itHeightfieldTextures == m_heightfieldTextures.end())
+			{
+				continue;
+			}
+			pHeightfieldTextures = &itHeightfieldTextures->second;
+		}
+
+		// Material
+		m_stateCache.SetTexture(TERRAIN_TOP_ALBEDO_MAP_SLOT, m_uniforms.snowSampler, m_textures.snow);
+		m_stateCache.SetTexture(TERRAIN_MEDIUM_ALBEDO_MAP_SLOT, m_uniforms.rockSampler, m_textures.rock);
+		m_stateCache.SetTexture(TERRAIN_BOTTOM_ALBEDO_MAP_SLOT, m_uniforms.grassSampler, m_textures.grass);
+
+		// Sky
+		if (crtSkyType == SkyType::SkyBox)
+		{
+			m_stateCache.SetTexture(IBL_IRRADIANCE_SLOT, m_uniforms.cubeIrradianceSampler, m_textures.irradiance);
+			m_stateCache.SetTexture(IBL_RADIANCE_SLOT, m_uniforms.cubeRadianceSampler, m_textures.radiance);
+			m_stateCache.SetTexture(BRDF_LUT_SLOT, m_uniforms.lutSampler, m_textures.lut);
 		}
 
 		// Submit uniform values : camera settings
-		constexpr StringCrc cameraPosCrc(cameraPos);
-		GetRenderContext()->FillUniform(cameraPosCrc, &cameraTransform.GetTranslation().x(), 1);
+		m_stateCache.SetUniform(m_uniforms.cameraPos, cameraPosData.Begin(), 1);
 
 		// Submit uniform values : material settings
-		constexpr StringCrc albedoColorCrc(albedoColor);
-		GetRenderContext()->FillUniform(albedoColorCrc, pMaterialComponent->GetAlbedoColor().Begin(), 1);
+		const cd::Vec3f& albedo = pMaterialComponent->GetAlbedoColor();
+		cd::Vec4f albedoColorData(albedo.x(), albedo.y(), albedo.z(), 1.0f);
+		m_stateCache.SetUniform(m_uniforms.albedoColor, albedoColorData.Begin(), 1);
 
-		constexpr StringCrc mrFactorCrc(metallicRoughnessFactor);
 		cd::Vec4f metallicRoughnessFactorData(pMaterialComponent->GetMetallicFactor(), pMaterialComponent->GetRoughnessFactor(), 1.0f, 1.0f);
-		GetRenderContext()->FillUniform(mrFactorCrc, metallicRoughnessFactorData.Begin(), 1);
+		m_stateCache.SetUniform(m_uniforms.metallicRoughnessFactor, metallicRoughnessFactorData.Begin(), 1);
 
-		constexpr StringCrc emissiveColorCrc(emissiveColor);
-		GetRenderContext()->FillUniform(emissiveColorCrc, pMaterialComponent->GetEmissiveColor().Begin(), 1);
+		const cd::Vec3f& emissive = pMaterialComponent->GetEmissiveColor();
+		cd::Vec4f emissiveColorData(emissive.x(), emissive.y(), emissive.z(), 1.0f);
+		m_stateCache.SetUniform(m_uniforms.emissiveColor, emissiveColorData.Begin(), 1);
 
 		// Submit uniform values : light settings
-		auto lightEntities = m_pCurrentSceneWorld->GetLightEntities();
-		size_t lightEntityCount = lightEntities.size();
-		constexpr engine::StringCrc lightCountAndStrideCrc(lightCountAndStride);
-		static cd::Vec4f lightInfoData(0, LightUniform::LIGHT_STRIDE, 0.0f, 0.0f);
-		lightInfoData.x() = static_cast<float>(lightEntityCount);
-		GetRenderContext()->FillUniform(lightCountAndStrideCrc, lightInfoData.Begin(), 1);
-		if (lightEntityCount > 0)
+		m_stateCache.SetUniform(m_uniforms.lightCountAndStride, lightInfoData.Begin(), 1);
+		if (pLightDataBegin)
 		{
-			// Light component storage has continus memory address and layout.
-			float* pLightDataBegin = reinterpret_cast<float*>(m_pCurrentSceneWorld->GetLightComponent(lightEntities[0]));
-			constexpr engine::StringCrc lightParamsCrc(lightParams);
-			GetRenderContext()->FillUniform(lightParamsCrc, pLightDataBegin, static_cast<uint16_t>(lightEntityCount * LightUniform::LIGHT_STRIDE));
+			m_stateCache.SetUniform(m_uniforms.lightParams, pLightDataBegin, lightDataVec4Count);
 		}
 
 		uint64_t state = defaultRenderingState;
@@ -208,11 +420,270 @@ void TerrainRenderer::Render(float deltaTime)
 			state |= BGFX_STATE_CULL_CCW;
 		}
 
-		bgfx::setState(state);
+		m_stateCache.SetState(state);
+		m_stateCache.SetVertexBuffer(0, m_patchVertexBuffer);
+
+		if (pStreamedTerrain)
+		{
+			SubmitStreamedTiles(*pStreamedTerrain, worldMatrix, terrainProgram);
+			continue;
+		}
+
+		m_stateCache.SetTexture(TERRAIN_ELEVATION_MAP_SLOT, m_uniforms.elevationSampler, pHeightfieldTextures->elevation);
+		m_stateCache.SetTexture(TERRAIN_NORMAL_MAP_SLOT, m_uniforms.normalSampler, pHeightfieldTextures->normal);
+
+		float width = static_cast<float>(pTerrainComponent->GetTexWidth());
+		float depth = static_cast<float>(pTerrainComponent->GetTexDepth());
+		cd::Vec4f terrainSizeData(width, depth, 1.0f / width, 1.0f / depth);
+		m_stateCache.SetUniform(m_uniforms.terrainSize, terrainSizeData.Begin(), 1);
+		float minHeight = pTerrainComponent->GetMinHeight();
+		cd::Vec4f terrainHeightRangeData(pTerrainComponent->GetMaxHeight() - minHeight, minHeight, 0.0f, 0.0f);
+		m_stateCache.SetUniform(m_uniforms.terrainHeightRange, terrainHeightRangeData.Begin(), 1);
+
+		// Patches reuse the cached matrix instead of copying it again for every draw.
+		uint32_t transformCache = GetEncoder()->setTransform(worldMatrix.Begin());
+
+		for (const TerrainQuadTree::Patch& patch : m_selectedPatches)
+		{
+			GetEncoder()->setTransform(transformCache);
+			m_stateCache.SetIndexBuffer(m_patchIndexBuffers[patch.stitchMask]);
+
+			cd::Vec4f terrainPatchData(static_cast<float>(patch.originX), static_cast<float>(patch.originZ), static_cast<float>(patch.step), 0.0f);
+			m_stateCache.SetUniform(m_uniforms.terrainPatch, terrainPatchData.Begin(), 1);
+
+			m_stateCache.Submit(GetViewID(), terrainProgram);
+			m_statistics.triangleCount += m_patchTriangleCounts[patch.stitchMask];
+		}
+		m_statistics.selectedPatchCount += static_cast<uint32_t>(m_selectedPatches.size());
+	}
+
+	m_stateCache.End();
+}
+
+void TerrainRenderer::UpdateHeightfieldTextures(Entity entity, TerrainComponent& terrainComponent)
+{
+	uint16_t width = terrainComponent.GetTexWidth();
+	uint16_t depth = terrainComponent.GetTexDepth();
+	const std::byte* pElevations = reinterpret_cast<const std::byte*>(terrainComponent.GetElevations().pSamples);
+	const TerrainNormalMap& normalMap = terrainComponent.GetNormalMap();
+	uint64_t sampleCount = static_cast<uint64_t>(width) * depth;
+	uint64_t textureBytes = sampleCount * (sizeof(uint16_t) + TerrainNormalMap::BytesPerSample);
+
+	HeightfieldTextures& heightfieldTextures = m_heightfieldTextures[entity];
+	if (width != heightfieldTextures.width || depth != heightfieldTextures.depth)
+	{
+		if (bgfx::isValid(heightfieldTextures.elevation))
+		{
+			bgfx::destroy(heightfieldTextures.elevation);
+			bgfx::destroy(heightfieldTextures.normal);
+		}
+
+		heightfieldTextures.elevation = bgfx::createTexture2D(width, depth, false, 1, bgfx::TextureFormat::R16, samplerFlags,
+			bgfx::copy(pElevations, static_cast<uint32_t>(sampleCount * sizeof(uint16_t))));
+		bgfx::setName(heightfieldTextures.elevation, "TerrainElevation");
+		heightfieldTextures.normal = bgfx::createTexture2D(width, depth, false, 1, bgfx::TextureFormat::RG8, samplerFlags,
+			bgfx::copy(normalMap.GetData(), normalMap.GetDataSize()));
+		bgfx::setName(heightfieldTextures.normal, "TerrainNormal");
+		heightfieldTextures.width = width;
+		heightfieldTextures.depth = depth;
+		terrainComponent.ClearElevationDirtyRects();
+
+		m_statistics.elevationUploadCount += 2U;
+		m_statistics.elevationUploadedBytes += textureBytes;
+		return;
+	}
+
+	uint64_t uploadedBytes = 0U;
+	for (const TerrainComponent::ElevationRect& rect : terrainComponent.GetElevationDirtyRects())
+	{
+		uploadedBytes += UploadRect(heightfieldTextures.elevation, pElevations, width, sizeof(uint16_t), rect);
+
+		// A Sobel normal depends on the samples around it, so edits reach one sample further in the normal map.
+		TerrainComponent::ElevationRect normalRect { static_cast<uint16_t>(rect.minX > 0U ? rect.minX - 1U : 0U), static_cast<uint16_t>(rect.minZ > 0U ? rect.minZ - 1U : 0U),
+			std::min<uint16_t>(rect.maxX + 1U, width - 1U), std::min<uint16_t>(rect.maxZ + 1U, depth - 1U) };
+		uploadedBytes += UploadRect(heightfieldTextures.normal, reinterpret_cast<const std::byte*>(normalMap.GetData()), width, TerrainNormalMap::BytesPerSample, normalRect);
+		m_statistics.elevationUploadCount += 2U;
+	}
+	terrainComponent.ClearElevationDirtyRects();
+
+	m_statistics.elevationUploadedBytes += uploadedBytes;
+	m_statistics.elevationSkippedBytes += textureBytes > uploadedBytes ? textureBytes - uploadedBytes : 0U;
+}
+
+void TerrainRenderer::SetTileStreamer(Entity entity, TerrainTileStreamer* pStreamer)
+{
+	auto itStreamedTerrain = m_streamedTerrains.find(entity);
+	if (itStreamedTerrain != m_streamedTerrains.end())
+	{
+		DestroyStreamedTiles(itStreamedTerrain->second);
+		m_streamedTerrains.erase(itStreamedTerrain);
+	}
+
+	if (pStreamer)
+	{
+		m_streamedTerrains[entity].pStreamer = pStreamer;
+	}
+}
+
+void TerrainRenderer::UpdateStreamedTiles(StreamedTerrain& streamedTerrain, const cd::Point& localCameraPosition)
+{
+	TerrainTileStreamer& streamer = *streamedTerrain.pStreamer;
+	streamer.Update();
+
+	const TerrainTileFile& tileFile = streamer.GetTileFile();
+	uint32_t tileSize = tileFile.GetTileSize();
+	uint32_t coarsestLevel = tileFile.GetLevelCount() - 1U;
+	m_streamedKeys.clear();
+	for (uint32_t tileZ = 0U; tileZ < tileFile.GetTileCountZ(coarsestLevel); ++tileZ)
+	{
+		for (uint32_t tileX = 0U; tileX < tileFile.GetTileCountX(coarsestLevel); ++tileX)
+		{
+			SelectStreamedTiles(tileFile, localCameraPosition, TerrainTileKey{ coarsestLevel, tileX, tileZ }, m_streamedKeys);
+		}
+	}
+
+	// Missing tiles are requested and drawn from their nearest resident ancestor meanwhile. The coarsest level is pinned,
+	// so one always exists.
+	m_resolvedTiles.clear();
+	for (const TerrainTileKey& key : m_streamedKeys)
+	{
+		TerrainTileKey resolvedKey;
+		const uint16_t* pSamples = streamer.AcquireTileOrAncestor(key, &resolvedKey);
+		if (!pSamples)
+		{
+			continue;
+		}
+
+		if (resolvedKey.level > key.level)
+		{
+			++m_statistics.streamedFallbackCount;
+		}
+		m_resolvedTiles.push_back(ResolvedTile{ resolvedKey, pSamples });
+	}
+
+	// Pyramid tiles either nest or don't overlap. Siblings may fall back to the same ancestor or to an ancestor of
+	// one another, so coarser tiles go first and tiles under one which is already drawn are skipped.
+	std::sort(m_resolvedTiles.begin(), m_resolvedTiles.end(), [](const ResolvedTile& lhs, const ResolvedTile& rhs)
+	{
+		return lhs.key.level > rhs.key.level;
+	});
+
+	m_drawnTileHashes.clear();
+	streamedTerrain.drawnTiles.clear();
+	for (const ResolvedTile& resolvedTile : m_resolvedTiles)
+	{
+		bool isCovered = false;
+		for (TerrainTileKey key = resolvedTile.key; !isCovered && key.level <= coarsestLevel; key = key.GetParent())
+		{
+			isCovered = m_drawnTileHashes.find(key.GetHash()) != m_drawnTileHashes.end();
+		}
+		if (isCovered)
+		{
+			continue;
+		}
+
+		uint64_t tileHash = resolvedTile.key.GetHash();
+		m_drawnTileHashes.insert(tileHash);
+		streamedTerrain.drawnTiles.push_back(tileHash);
+
+		StreamedTile& tile = streamedTerrain.tiles[tileHash];
+		if (bgfx::isValid(tile.elevation))
+		{
+			continue;
+		}
+
+		// Samples are copied since the streamer recycles the buffer after the next Update. Normals at the tile border
+		// repeat the edge instead of reading the neighbour tile, which may show as a faint seam in the lighting.
+		uint16_t tileSampleCount = static_cast<uint16_t>(tileSize + 1U);
+		uint32_t elevationBytes = tileFile.GetTileSampleCount() * static_cast<uint32_t>(sizeof(uint16_t));
+		tile.elevation = bgfx::createTexture2D(tileSampleCount, tileSampleCount, false, 1, bgfx::TextureFormat::R16, samplerFlags,
+			bgfx::copy(resolvedTile.pSamples, elevationBytes));
+		bgfx::setName(tile.elevation, "TerrainTileElevation");
+		streamedTerrain.normalMap.Build(tileFile.GetHeights(resolvedTile.pSamples), tileSampleCount, tileSampleCount);
+		tile.normal = bgfx::createTexture2D(tileSampleCount, tileSampleCount, false, 1, bgfx::TextureFormat::RG8, samplerFlags,
+			bgfx::copy(streamedTerrain.normalMap.GetData(), streamedTerrain.normalMap.GetDataSize()));
+		bgfx::setName(tile.normal, "TerrainTileNormal");
+
+		// Level L samples are 2^L level 0 samples apart. The clamped last step of a level is drawn as a full one,
+		// so the far edges of a coarse tile may reach past the terrain by less than one of its samples.
+		const TerrainTileKey& key = resolvedTile.key;
+		float scale = static_cast<float>(1U << key.level);
+		float span = static_cast<float>(tileSize << key.level);
+		tile.localMatrix = cd::Transform(cd::Vec3f(static_cast<float>(key.x) * span, 0.0f, static_cast<float>(key.z) * span),
+			cd::Quaternion::Identity(), cd::Vec3f(scale, 1.0f, scale)).GetMatrix();
+
+		uint32_t quadCountX = std::min(GetLevelQuadCount(tileFile.GetWidth(), key.level) - key.x * tileSize, tileSize);
+		uint32_t quadCountZ = std::min(GetLevelQuadCount(tileFile.GetDepth(), key.level) - key.z * tileSize, tileSize);
+		tile.patchCountX = std::max((quadCountX + TerrainQuadTree::PatchQuadCount - 1U) / TerrainQuadTree::PatchQuadCount, 1U);
+		tile.patchCountZ = std::max((quadCountZ + TerrainQuadTree::PatchQuadCount - 1U) / TerrainQuadTree::PatchQuadCount, 1U);
+
+		m_statistics.elevationUploadCount += 2U;
+		m_statistics.elevationUploadedBytes += elevationBytes + streamedTerrain.normalMap.GetDataSize();
+	}
+	m_statistics.streamedTileCount += static_cast<uint32_t>(streamedTerrain.drawnTiles.size());
+
+	// The streamer keeps the samples of tiles which go out of use for a while, so only their textures are released.
+	for (auto itTile = streamedTerrain.tiles.begin(); itTile != streamedTerrain.tiles.end();)
+	{
+		if (m_drawnTileHashes.find(itTile->first) != m_drawnTileHashes.end())
+		{
+			++itTile;
+			continue;
+		}
+
+		bgfx::destroy(itTile->second.elevation);
+		bgfx::destroy(itTile->second.normal);
+		itTile = streamedTerrain.tiles.erase(itTile);
+	}
+}
+
+void TerrainRenderer::SubmitStreamedTiles(const StreamedTerrain& streamedTerrain, const cd::Matrix4x4& worldMatrix, bgfx::ProgramHandle program)
+{
+	// Every tile is drawn as a small heightfield of its own. Neighbours share their edge samples, but tiles of different
+	// levels aren't stitched, so cracks may show where the level changes, and tiles aren't frustum culled.
+	const TerrainTileFile& tileFile = streamedTerrain.pStreamer->GetTileFile();
+	float tileSampleCount = static_cast<float>(tileFile.GetTileSize() + 1U);
+	cd::Vec4f terrainSizeData(tileSampleCount, tileSampleCount, 1.0f / tileSampleCount, 1.0f / tileSampleCount);
+	m_stateCache.SetUniform(m_uniforms.terrainSize, terrainSizeData.Begin(), 1);
+	float minHeight = tileFile.GetMinHeight();
+	cd::Vec4f terrainHeightRangeData(tileFile.GetMaxHeight() - minHeight, minHeight, 0.0f, 0.0f);
+	m_stateCache.SetUniform(m_uniforms.terrainHeightRange, terrainHeightRangeData.Begin(), 1);
+
+	for (uint64_t tileHash : streamedTerrain.drawnTiles)
+	{
+		const StreamedTile& tile = streamedTerrain.tiles.at(tileHash);
+		cd::Matrix4x4 tileWorldMatrix = worldMatrix * tile.localMatrix;
+		uint32_t transformCache = GetEncoder()->setTransform(tileWorldMatrix.Begin());
+		m_stateCache.SetTexture(TERRAIN_ELEVATION_MAP_SLOT, m_uniforms.elevationSampler, tile.elevation);
+		m_stateCache.SetTexture(TERRAIN_NORMAL_MAP_SLOT, m_uniforms.normalSampler, tile.normal);
+
+		for (uint32_t patchZ = 0U; patchZ < tile.patchCountZ; ++patchZ)
+		{
+			for (uint32_t patchX = 0U; patchX < tile.patchCountX; ++patchX)
+			{
+				GetEncoder()->setTransform(transformCache);
+				m_stateCache.SetIndexBuffer(m_patchIndexBuffers[0]);
+
+				cd::Vec4f terrainPatchData(static_cast<float>(patchX * TerrainQuadTree::PatchQuadCount), static_cast<float>(patchZ * TerrainQuadTree::PatchQuadCount), 1.0f, 0.0f);
+				m_stateCache.SetUniform(m_uniforms.terrainPatch, terrainPatchData.Begin(), 1);
 
-		constexpr StringCrc terrainProgram("TerrainProgram");
-		bgfx::submit(GetViewID(), GetRenderContext()->GetProgram(terrainProgram));
+				m_stateCache.Submit(GetViewID(), program);
+				m_statistics.triangleCount += m_patchTriangleCounts[0];
+			}
+		}
+		m_statistics.selectedPatchCount += tile.patchCountX * tile.patchCountZ;
+	}
+}
+
+void TerrainRenderer::DestroyStreamedTiles(StreamedTerrain& streamedTerrain)
+{
+	for (const auto& [tileHash, tile] : streamedTerrain.tiles)
+	{
+		bgfx::destroy(tile.elevation);
+		bgfx::destroy(tile.normal);
 	}
+	streamedTerrain.tiles.clear();
+	streamedTerrain.drawnTiles.clear();
 }
 
 }
\ No newline at end of file
@@ -1,25 +1,172 @@
 #pragma once
 
+#include "ECWorld/Entity.h"
 #include "Renderer.h"
+#include "RenderStateCache.h"
+#include "Math/Matrix.hpp"
+#include "Terrain/TerrainNormalMap.h"
+#include "Terrain/TerrainQuadTree.h"
+#include "Terrain/TerrainTileFile.h"
+
+#include <bgfx/bgfx.h>
+
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
 namespace engine
 {
 
 class SceneWorld;
+class TerrainComponent;
+class TerrainTileStreamer;
 
+// Terrains are drawn as TerrainQuadTree patches which all share one vertex grid and one index buffer
+// per stitch variant. The vertex shader places the grid over the heightfield from per patch uniforms.
+// A terrain with a tile streamer is drawn from the tiles of its pyramid file instead, one LOD level per tile.
 class TerrainRenderer final : public Renderer
 {
+public:
+	struct Statistics
+	{
+		uint32_t terrainCount = 0U;
+		uint32_t selectedPatchCount = 0U;
+		uint32_t culledNodeCount = 0U;
+		uint32_t triangleCount = 0U;
+
+		// Elevation and normal rectangles sent to the GPU, and the bytes which uploading both textures of every terrain
+		// whole would have added.
+		uint32_t elevationUploadCount = 0U;
+		uint64_t elevationUploadedBytes = 0U;
+		uint64_t elevationSkippedBytes = 0U;
+
+		// Tiles drawn for streamed terrains, and those drawn from a coarser ancestor while they load.
+		uint32_t streamedTileCount = 0U;
+		uint32_t streamedFallbackCount = 0U;
+	};
+
 public:
 	using Renderer::Renderer;
+	virtual ~TerrainRenderer();
 
 	virtual void Init() override;
 	virtual void UpdateView(const float* pViewMatrix, const float* pProjectionMatrix) override;
+	virtual void Prepare() override;
 	virtual void Render(float deltaTime) override;
 
 	void SetSceneWorld(SceneWorld* pSceneWorld) { m_pCurrentSceneWorld = pSceneWorld; }
 
+	// Largest height error in pixels a patch may show before it is replaced by its children.
+	void SetMaxScreenError(float maxScreenError) { m_maxScreenError = maxScreenError; }
+	float GetMaxScreenError() const { return m_maxScreenError; }
+
+	// Draws the terrain of the entity from the tiles of the streamer instead of its heightfield. Null goes back to
+	// the heightfield. The streamer is updated by Prepare and must stay open while it is set.
+	void SetTileStreamer(Entity entity, TerrainTileStreamer* pStreamer);
+
+	const Statistics& GetStatistics() const { return m_statistics; }
+
 private:
+	struct HeightfieldTextures
+	{
+		bgfx::TextureHandle elevation = BGFX_INVALID_HANDLE;
+		bgfx::TextureHandle normal = BGFX_INVALID_HANDLE;
+		uint16_t width = 0U;
+		uint16_t depth = 0U;
+	};
+
+	// Creates the textures on first use or when the heightfield is resized, otherwise only uploads the dirty rectangles.
+	void UpdateHeightfieldTextures(Entity entity, TerrainComponent& terrainComponent);
+
+	struct StreamedTile
+	{
+		bgfx::TextureHandle elevation = BGFX_INVALID_HANDLE;
+		bgfx::TextureHandle normal = BGFX_INVALID_HANDLE;
+		// Places the tile samples in terrain space, where a level 0 sample is one unit.
+		cd::Matrix4x4 localMatrix;
+		// Patches which cover the samples of the level, fewer on the last tiles of a row or column.
+		uint32_t patchCountX = 0U;
+		uint32_t patchCountZ = 0U;
+	};
+
+	struct StreamedTerrain
+	{
+		TerrainTileStreamer* pStreamer = nullptr;
+		// Tile textures by TerrainTileKey hash. Tiles which aren't drawn in a frame are released.
+		std::unordered_map<uint64_t, StreamedTile> tiles;
+		std::vector<uint64_t> drawnTiles;
+		TerrainNormalMap normalMap;
+	};
+
+	struct ResolvedTile
+	{
+		TerrainTileKey key;
+		const uint16_t* pSamples = nullptr;
+	};
+
+	// Picks a level per tile from the camera distance, acquires the tiles and uploads the ones not cached yet.
+	void UpdateStreamedTiles(StreamedTerrain& streamedTerrain, const cd::Point& localCameraPosition);
+	void SubmitStreamedTiles(const StreamedTerrain& streamedTerrain, const cd::Matrix4x4& worldMatrix, bgfx::ProgramHandle program);
+	void DestroyStreamedTiles(StreamedTerrain& streamedTerrain);
+
+	// Uniform handles are resolved once in Init. StringCrc lookups are only used at load time.
+	struct UniformHandles
+	{
+		bgfx::UniformHandle snowSampler = BGFX_INVALID_HANDLE;
+		bgfx::UniformHandle rockSampler = BGFX_INVALID_HANDLE;
+		bgfx::UniformHandle grassSampler = BGFX_INVALID_HANDLE;
+		bgfx::UniformHandle elevationSampler = BGFX_INVALID_HANDLE;
+		bgfx::UniformHandle normalSampler = BGFX_INVALID_HANDLE;
+
+		bgfx::UniformHandle lutSampler = BGFX_INVALID_HANDLE;
+		bgfx::UniformHandle cubeIrradianceSampler = BGFX_INVALID_HANDLE;
+		bgfx::UniformHandle cubeRadianceSampler = BGFX_INVALID_HANDLE;
+
+		bgfx::UniformHandle cameraPos = BGFX_INVALID_HANDLE;
+		bgfx::UniformHandle albedoColor = BGFX_INVALID_HANDLE;
+		bgfx::UniformHandle emissiveColor = BGFX_INVALID_HANDLE;
+		bgfx::UniformHandle metallicRoughnessFactor = BGFX_INVALID_HANDLE;
+		bgfx::UniformHandle albedoUVOffsetAndScale = BGFX_INVALID_HANDLE;
+		bgfx::UniformHandle alphaCutOff = BGFX_INVALID_HANDLE;
+
+		bgfx::UniformHandle lightCountAndStride = BGFX_INVALID_HANDLE;
+		bgfx::UniformHandle lightParams = BGFX_INVALID_HANDLE;
+
+		bgfx::UniformHandle terrainPatch = BGFX_INVALID_HANDLE;
+		bgfx::UniformHandle terrainSize = BGFX_INVALID_HANDLE;
+		bgfx::UniformHandle terrainHeightRange = BGFX_INVALID_HANDLE;
+	};
+
+	struct TextureHandles
+	{
+		bgfx::TextureHandle snow = BGFX_INVALID_HANDLE;
+		bgfx::TextureHandle rock = BGFX_INVALID_HANDLE;
+		bgfx::TextureHandle grass = BGFX_INVALID_HANDLE;
+		bgfx::TextureHandle lut = BGFX_INVALID_HANDLE;
+		// Resolved by Prepare from the sky component.
+		bgfx::TextureHandle irradiance = BGFX_INVALID_HANDLE;
+		bgfx::TextureHandle radiance = BGFX_INVALID_HANDLE;
+	};
+
 	SceneWorld* m_pCurrentSceneWorld = nullptr;
+	UniformHandles m_uniforms;
+	RenderStateCache m_stateCache;
+	TextureHandles m_textures;
+
+	std::unordered_map<Entity, HeightfieldTextures> m_heightfieldTextures;
+	std::unordered_map<Entity, StreamedTerrain> m_streamedTerrains;
+	std::vector<TerrainTileKey> m_streamedKeys;
+	std::vector<ResolvedTile> m_resolvedTiles;
+	std::unordered_set<uint64_t> m_drawnTileHashes;
+
+	bgfx::VertexBufferHandle m_patchVertexBuffer = BGFX_INVALID_HANDLE;
+	// Only valid once the vertex buffer is.
+	bgfx::IndexBufferHandle m_patchIndexBuffers[TerrainQuadTree::StitchVariantCount] = {};
+	uint32_t m_patchTriangleCounts[TerrainQuadTree::StitchVariantCount] = {};
+
+	float m_maxScreenError = 2.0f;
+	std::vector<TerrainQuadTree::Patch> m_selectedPatches;
+	Statistics m_statistics;
 };
 
 }
\ No newline at end of file
@@ -10,10 +10,13 @@
 #include "Material/ShaderSchema.h"
 #include "Math/Transform.hpp"
 #include "RenderContext.h"
+#include "RenderPacket.h"
 #include "Scene/Texture.h"
 #include "U_IBL.sh"
 #include "U_AtmophericScattering.sh"
 
+#include <algorithm>
+
 namespace engine
 {
 
@@ -42,6 +45,103 @@ constexpr const char* HeightOffsetAndshadowLength = "u_HeightOffsetAndshadowLeng
 
 constexpr uint64_t samplerFlags = BGFX_SAMPLER_U_CLAMP | BGFX_SAMPLER_V_CLAMP | BGFX_SAMPLER_W_CLAMP;
 constexpr uint64_t defaultRenderingState = BGFX_STATE_WRITE_MASK | BGFX_STATE_MSAA | BGFX_STATE_DEPTH_TEST_LESS;
+constexpr uint64_t depthPrePassRenderingState = BGFX_STATE_WRITE_Z | BGFX_STATE_MSAA | BGFX_STATE_DEPTH_TEST_LESS;
+// Depth is already resolved for pre-passed geometry so only the visible surface gets shaded. The two passes
+// run different programs, so LEQUAL rather than EQUAL keeps drivers which round their positions differently
+// from punching holes into the surface.
+constexpr uint64_t afterDepthPrePassRenderingState = BGFX_STATE_WRITE_RGB | BGFX_STATE_WRITE_A | BGFX_STATE_MSAA | BGFX_STATE_DEPTH_TEST_LEQUAL;
+
+// Auto mode only pays for the extra geometry pass when there is enough overdraw to save.
+constexpr uint32_t depthPrePassMinOpaqueDrawCount = 16U;
+constexpr float depthPrePassMinDepthComplexity = 1.5f;
+
+// Scratch storage for the material values of one draw. Each one is widened to a vec4 and still sent
+// through its own uniform, which the cache skips when it didn't change since the previous draw.
+struct MaterialUniformValues
+{
+	cd::Vec4f albedoColor;
+	cd::Vec4f emissiveColor;
+	cd::Vec4f metallicRoughnessFactor;
+	cd::Vec4f albedoUVOffsetAndScale;
+	cd::Vec4f alphaCutOff;
+};
+
+// Fraction of the screen covered by the projected box. Boxes behind the camera cover nothing and boxes
+// crossing the near plane are clipped against it first.
+float EstimateScreenCoverage(const cd::AABB& aabb, const cd::Matrix4x4& worldViewProjection)
+{
+	// Clip space w of the near plane, small enough to keep divisions by w finite.
+	constexpr float nearW = 1e-4f;
+
+	if (aabb.IsEmpty())
+	{
+		return 0.0f;
+	}
+
+	cd::Vec4f clipCorners[8];
+	uint32_t behindCount = 0U;
+	for (uint32_t cornerIndex = 0U; cornerIndex < 8U; ++cornerIndex)
+	{
+		cd::Vec4f corner((cornerIndex & 1U) ? aabb.Max().x() : aabb.Min().x(),
+			(cornerIndex & 2U) ? aabb.Max().y() : aabb.Min().y(),
+			(cornerIndex & 4U) ? aabb.Max().z() : aabb.Min().z(), 1.0f);
+		clipCorners[cornerIndex] = worldViewProjection * corner;
+		if (clipCorners[cornerIndex].w() < nearW)
+		{
+			++behindCount;
+		}
+	}
+
+	if (8U == behindCount)
+	{
+		return 0.0f;
+	}
+
+	float minX = 1.0f;
+	float minY = 1.0f;
+	float maxX = -1.0f;
+	float maxY = -1.0f;
+	auto AddPoint = [&minX, &minY, &maxX, &maxY](float clipX, float clipY, float clipW)
+	{
+		float ndcX = clipX / clipW;
+		float ndcY = clipY / clipW;
+		minX = std::min(minX, ndcX);
+		minY = std::min(minY, ndcY);
+		maxX = std::max(maxX, ndcX);
+		maxY = std::max(maxY, ndcY);
+	};
+
+	for (uint32_t cornerIndex = 0U; cornerIndex < 8U; ++cornerIndex)
+	{
+		const cd::Vec4f& corner = clipCorners[cornerIndex];
+		if (corner.w() >= nearW)
+		{
+			AddPoint(corner.x(), corner.y(), corner.w());
+		}
+
+		// Box edges join corners which differ in one axis bit. Edges crossing the near plane add their crossing point.
+		for (uint32_t axisBit = 1U; axisBit < 8U; axisBit <<= 1U)
+		{
+			if (cornerIndex & axisBit)
+			{
+				continue;
+			}
+
+			const cd::Vec4f& otherCorner = clipCorners[cornerIndex | axisBit];
+			if ((corner.w() < nearW) == (otherCorner.w() < nearW))
+			{
+				continue;
+			}
+
+			float t = (nearW - corner.w()) / (otherCorner.w() - corner.w());
+			AddPoint(corner.x() + (otherCorner.x() - corner.x()) * t, corner.y() + (otherCorner.y() - corner.y()) * t, nearW);
+		}
+	}
+
+	float width = std::clamp(maxX, -1.0f, 1.0f) - std::clamp(minX, -1.0f, 1.0f);
+	float height = std::clamp(maxY, -1.0f, 1.0f) - std::clamp(minY, -1.0f, 1.0f);
+	return width > 0.0f && height > 0.0f ? width * height * 0.25f : 0.0f;
+}
 
 }
 
@@ -49,28 +149,33 @@ void WorldRenderer::Init()
 {
 	SkyComponent* pSkyComponent = m_pCurrentSceneWorld->GetSkyComponent(m_pCurrentSceneWorld->GetSkyEntity());
 
-	GetRenderContext()->CreateUniform(lutSampler, bgfx::UniformType::Sampler);
-	GetRenderContext()->CreateUniform(cubeIrradianceSampler, bgfx::UniformType::Sampler);
-	GetRenderContext()->CreateUniform(cubeRadianceSampler, bgfx::UniformType::Sampler);
+	m_uniforms.lutSampler = GetRenderContext()->CreateUniform(lutSampler, bgfx::UniformType::Sampler);
+	m_uniforms.cubeIrradianceSampler = GetRenderContext()->CreateUniform(cubeIrradianceSampler, bgfx::UniformType::Sampler);
+	m_uniforms.cubeRadianceSampler = GetRenderContext()->CreateUniform(cubeRadianceSampler, bgfx::UniformType::Sampler);
 
-	GetRenderContext()->CreateTexture(lutTexture);
+	m_lutTexture = GetRenderContext()->CreateTexture(lutTexture);
 	GetRenderContext()->CreateTexture(pSkyComponent->GetIrradianceTexturePath().c_str(), samplerFlags);
 	GetRenderContext()->CreateTexture(pSkyComponent->GetRadianceTexturePath().c_str(), samplerFlags);
 
-	GetRenderContext()->CreateUniform(cameraPos, bgfx::UniformType::Vec4, 1);
-	GetRenderContext()->CreateUniform(albedoColor, bgfx::UniformType::Vec4, 1);
-	GetRenderContext()->CreateUniform(emissiveColor, bgfx::UniformType::Vec4, 1);
-	GetRenderContext()->CreateUniform(metallicRoughnessFactor, bgfx::UniformType::Vec4, 1);
-	GetRenderContext()->CreateUniform(albedoUVOffsetAndScale, bgfx::UniformType::Vec4, 1);
-	GetRenderContext()->CreateUniform(alphaCutOff, bgfx::UniformType::Vec4, 1);
+	m_uniforms.cameraPos = GetRenderContext()->CreateUniform(cameraPos, bgfx::UniformType::Vec4, 1);
+	m_uniforms.albedoColor = GetRenderContext()->CreateUniform(albedoColor, bgfx::UniformType::Vec4, 1);
+	m_uniforms.emissiveColor = GetRenderContext()->CreateUniform(emissiveColor, bgfx::UniformType::Vec4, 1);
+	m_uniforms.metallicRoughnessFactor = GetRenderContext()->CreateUniform(metallicRoughnessFactor, bgfx::UniformType::Vec4, 1);
+	m_uniforms.albedoUVOffsetAndScale = GetRenderContext()->CreateUniform(albedoUVOffsetAndScale, bgfx::UniformType::Vec4, 1);
+	m_uniforms.alphaCutOff = GetRenderContext()->CreateUniform(alphaCutOff, bgfx::UniformType::Vec4, 1);
 
-	GetRenderContext()->CreateUniform(lightCountAndStride, bgfx::UniformType::Vec4, 1);
-	GetRenderContext()->CreateUniform(lightParams, bgfx::UniformType::Vec4, LightUniform::VEC4_COUNT);
+	m_uniforms.lightCountAndStride = GetRenderContext()->CreateUniform(lightCountAndStride, bgfx::UniformType::Vec4, 1);
+	m_uniforms.lightParams = GetRenderContext()->CreateUniform(lightParams, bgfx::UniformType::Vec4, LightUniform::VEC4_COUNT);
 
-	GetRenderContext()->CreateUniform(LightDir, bgfx::UniformType::Vec4, 1);
-	GetRenderContext()->CreateUniform(HeightOffsetAndshadowLength, bgfx::UniformType::Vec4, 1);
+	m_uniforms.lightDir = GetRenderContext()->CreateUniform(LightDir, bgfx::UniformType::Vec4, 1);
+	m_uniforms.heightOffsetAndShadowLength = GetRenderContext()->CreateUniform(HeightOffsetAndshadowLength, bgfx::UniformType::Vec4, 1);
+
+	m_depthPrePassProgram = GetRenderContext()->CreateProgram("DepthPrePassProgram", "vs_depthPrePass.bin", "fs_depthPrePass.bin");
 
 	bgfx::setViewName(GetViewID(), "WorldRenderer");
+	// RenderStateCache relies on draws running in submission order.
+	// Also keeps the depth pre-pass in front of the main pass.
+	bgfx::setViewMode(GetViewID(), bgfx::ViewMode::Sequential);
 }
 
 void WorldRenderer::UpdateView(const float* pViewMatrix, const float* pProjectionMatrix)
@@ -79,11 +184,38 @@ void WorldRenderer::UpdateView(const float* pViewMatrix, const float* pProjectio
 	bgfx::setViewTransform(GetViewID(), pViewMatrix, pProjectionMatrix);
 }
 
-void WorldRenderer::Render(float deltaTime)
+void WorldRenderer::Prepare()
 {
-	// TODO : Remove it. If every renderer need to submit camera related uniform, it should be done not inside Renderer class.
-	const cd::Transform& cameraTransform = m_pCurrentSceneWorld->GetTransformComponent(m_pCurrentSceneWorld->GetMainCameraEntity())->GetTransform();
 	SkyComponent* pSkyComponent = m_pCurrentSceneWorld->GetSkyComponent(m_pCurrentSceneWorld->GetSkyEntity());
+	SkyType crtSkyType = pSkyComponent->GetSkyType();
+
+	m_irradianceTexture = BGFX_INVALID_HANDLE;
+	m_radianceTexture = BGFX_INVALID_HANDLE;
+	if (SkyType::SkyBox == crtSkyType)
+	{
+		// Create a new TextureHandle each frame if the skybox texture path has been updated,
+		// otherwise RenderContext::CreateTexture will automatically skip it.
+		m_irradianceTexture = GetRenderContext()->CreateTexture(pSkyComponent->GetIrradianceTexturePath().c_str(), samplerFlags);
+		m_radianceTexture = GetRenderContext()->CreateTexture(pSkyComponent->GetRadianceTexturePath().c_str(), samplerFlags);
+	}
+
+	// Sky type is an uber option of the material.
+	for (Entity entity : m_pCurrentSceneWorld->GetMaterialEntities())
+	{
+		MaterialComponent* pMaterialComponent = m_pCurrentSceneWorld->GetMaterialComponent(entity);
+		if (pMaterialComponent && pMaterialComponent->GetMaterialType() == m_pCurrentSceneWorld->GetPBRMaterialType())
+		{
+			pMaterialComponent->SetSkyType(crtSkyType);
+		}
+	}
+}
+
+void WorldRenderer::CollectDrawItems(const RenderCamera& camera)
+{
+	m_drawItems.clear();
+	m_overdrawStatistics = OverdrawStatistics();
+
+	cd::Matrix4x4 viewProjection = camera.projectionMatrix * camera.viewMatrix;
 
 	for (Entity entity : m_pCurrentSceneWorld->GetMaterialEntities())
 	{
@@ -109,15 +241,120 @@ void WorldRenderer::Render(float deltaTime)
 			continue;
 		}
 
+		TransformComponent* pTransformComponent = m_pCurrentSceneWorld->GetTransformComponent(entity);
+		const cd::Matrix4x4* pWorldMatrix = pTransformComponent ? &GetRenderWorldMatrix(*m_pCurrentSceneWorld, entity, *pTransformComponent) : nullptr;
+		bool isOpaque = cd::BlendMode::Opaque == pMaterialComponent->GetBlendMode();
+		m_drawItems.push_back({ pMaterialComponent, pMeshComponent, pWorldMatrix, isOpaque });
+
+		cd::Matrix4x4 worldViewProjection = pWorldMatrix ? viewProjection * *pWorldMatrix : viewProjection;
+		m_overdrawStatistics.estimatedDepthComplexity += EstimateScreenCoverage(pMeshComponent->GetAABB(), worldViewProjection);
+		if (isOpaque)
+		{
+			++m_overdrawStatistics.opaqueDrawCount;
+		}
+	}
+
+	m_overdrawStatistics.drawCount = static_cast<uint32_t>(m_drawItems.size());
+}
+
+bool WorldRenderer::ShouldUseDepthPrePass() const
+{
+	switch (m_depthPrePassMode)
+	{
+	case DepthPrePassMode::Enabled:
+		return m_overdrawStatistics.opaqueDrawCount > 0U;
+	case DepthPrePassMode::Disabled:
+		return false;
+	case DepthPrePassMode::Auto:
+	default:
+		return m_overdrawStatistics.opaqueDrawCount >= depthPrePassMinOpaqueDrawCount &&
+			m_overdrawStatistics.estimatedDepthComplexity >= depthPrePassMinDepthComplexity;
+	}
+}
+
+void WorldRenderer::RenderDepthPrePass()
+{
+	// Alpha masked and blended materials need the full shader to decide coverage so they stay in the main pass.
+	for (const DrawItem& drawItem : m_drawItems)
+	{
+		if (!drawItem.isOpaque)
+		{
+			continue;
+		}
+
+		if (drawItem.pWorldMatrix)
+		{
+			GetEncoder()->setTransform(drawItem.pWorldMatrix->Begin());
+		}
+
+		// The depth-only program reads positions only and bgfx skips the other attributes of the layout,
+		// so the main vertex buffer is bound as is and stays bound for the main pass.
+		m_stateCache.SetVertexBuffer(0, bgfx::VertexBufferHandle{drawItem.pMeshComponent->GetVertexBuffer()});
+		m_stateCache.SetIndexBuffer(bgfx::IndexBufferHandle{drawItem.pMeshComponent->GetIndexBuffer()});
+
+		uint64_t state = depthPrePassRenderingState;
+		if (!drawItem.pMaterialComponent->GetTwoSided())
+		{
+			state |= BGFX_STATE_CULL_CCW;
+		}
+		m_stateCache.SetState(state);
+
+		m_stateCache.Submit(GetViewID(), m_depthPrePassProgram);
+		++m_overdrawStatistics.prePassDrawCount;
+	}
+}
+
+void WorldRenderer::Render(float deltaTime)
+{
+	// TODO : Remove it. If every renderer need to submit camera related uniform, it should be done not inside Renderer class.
+	RenderCamera camera = GetRenderCamera(*m_pCurrentSceneWorld);
+	SkyComponent* pSkyComponent = m_pCurrentSceneWorld->GetSkyComponent(m_pCurrentSceneWorld->GetSkyEntity());
+	SkyType crtSkyType = pSkyComponent->GetSkyType();
+
+	// Everything below only changes per frame, so resolve it once before walking the entities.
+	bgfx::TextureHandle atmTransmittanceTexture = BGFX_INVALID_HANDLE;
+	bgfx::TextureHandle atmIrradianceTexture = BGFX_INVALID_HANDLE;
+	bgfx::TextureHandle atmScatteringTexture = BGFX_INVALID_HANDLE;
+	cd::Vec4f heightOffsetAndShadowLengthData(pSkyComponent->GetHeightOffset(), pSkyComponent->GetShadowLength(), 0.0f, 0.0f);
+	if (SkyType::AtmosphericScattering == crtSkyType)
+	{
+		atmTransmittanceTexture = GetRenderContext()->GetTexture(pSkyComponent->GetATMTransmittanceCrc());
+		atmIrradianceTexture = GetRenderContext()->GetTexture(pSkyComponent->GetATMIrradianceCrc());
+		atmScatteringTexture = GetRenderContext()->GetTexture(pSkyComponent->GetATMScatteringCrc());
+	}
+
+	cd::Vec4f cameraPosData(camera.position.x(), camera.position.y(), camera.position.z(), 1.0f);
+
+	uint32_t lightEntityCount = 0U;
+	const LightComponent* pLights = GetRenderLights(*m_pCurrentSceneWorld, lightEntityCount);
+	cd::Vec4f lightInfoData(static_cast<float>(lightEntityCount), LightUniform::LIGHT_STRIDE, 0.0f, 0.0f);
+	const float* pLightDataBegin = lightEntityCount > 0U ? reinterpret_cast<const float*>(pLights) : nullptr;
+	uint16_t lightDataVec4Count = static_cast<uint16_t>(lightEntityCount * LightUniform::LIGHT_STRIDE);
+
+	CollectDrawItems(camera);
+	m_overdrawStatistics.isDepthPrePassEnabled = ShouldUseDepthPrePass();
+
+	m_stateCache.Begin();
+	if (m_overdrawStatistics.isDepthPrePassEnabled)
+	{
+		RenderDepthPrePass();
+	}
+
+	MaterialUniformValues materialValues;
+	for (const DrawItem& drawItem : m_drawItems)
+	{
+		MaterialComponent* pMaterialComponent = drawItem.pMaterialComponent;
+		StaticMeshComponent* pMeshComponent = drawItem.pMeshComponent;
+
 		// Transform
-		if (TransformComponent* pTransformComponent = m_pCurrentSceneWorld->GetTransformComponent(entity))
+		if (drawItem.pWorldMatrix)
 		{
-			bgfx::setTransform(pTransformComponent->GetWorldMatrix().Begin());
+			GetEncoder()->setTransform(drawItem.pWorldMatrix->Begin());
 		}
 
 		// Mesh
-		bgfx::setVertexBuffer(0, bgfx::VertexBufferHandle{pMeshComponent->GetVertexBuffer()});
-		bgfx::setIndexBuffer(bgfx::IndexBufferHandle{pMeshComponent->GetIndexBuffer()});
+		m_stateCache.SetVertexBuffer(0, bgfx::VertexBufferHandle{pMeshComponent->GetVertexBuffer()});
+		m_stateCache.SetIndexBuffer(bgfx::IndexBufferHandle{pMeshComponent->GetIndexBuffer()});
 
 		// Material
 		for (const auto& [textureType, _] : pMaterialComponent->GetTextureResources())
@@ -126,86 +363,55 @@ void WorldRenderer::Render(float deltaTime)
 			{
 				if (cd::MaterialTextureType::BaseColor == textureType)
 				{
-					constexpr StringCrc albedoUVOffsetAndScaleCrc(albedoUVOffsetAndScale);
-					cd::Vec4f uvOffsetAndScaleData(pTextureInfo->GetUVOffset().x(), pTextureInfo->GetUVOffset().y(),
+					materialValues.albedoUVOffsetAndScale = cd::Vec4f(pTextureInfo->GetUVOffset().x(), pTextureInfo->GetUVOffset().y(),
 						pTextureInfo->GetUVScale().x(), pTextureInfo->GetUVScale().y());
-					GetRenderContext()->FillUniform(albedoUVOffsetAndScaleCrc, &uvOffsetAndScaleData, 1);
+					m_stateCache.SetUniform(m_uniforms.albedoUVOffsetAndScale, materialValues.albedoUVOffsetAndScale.Begin(), 1);
 				}
 
-				bgfx::setTexture(pTextureInfo->slot, bgfx::UniformHandle{pTextureInfo->samplerHandle}, bgfx::TextureHandle{pTextureInfo->textureHandle});
+				m_stateCache.SetTexture(pTextureInfo->slot, bgfx::UniformHandle{pTextureInfo->samplerHandle}, bgfx::TextureHandle{pTextureInfo->textureHandle});
 			}
 		}
 
 		// Sky
-		SkyType crtSkyType = pSkyComponent->GetSkyType();
-		pMaterialComponent->SetSkyType(crtSkyType);
-
 		if (SkyType::SkyBox == crtSkyType)
 		{
-			// Create a new TextureHandle each frame if the skybox texture path has been updated,
-			// otherwise RenderContext::CreateTexture will automatically skip it.
-
-			constexpr StringCrc irrSamplerCrc(cubeIrradianceSampler);
-			GetRenderContext()->CreateTexture(pSkyComponent->GetIrradianceTexturePath().c_str(), samplerFlags);
-			bgfx::setTexture(IBL_IRRADIANCE_SLOT,
-				GetRenderContext()->GetUniform(irrSamplerCrc),
-				GetRenderContext()->GetTexture(StringCrc(pSkyComponent->GetIrradianceTexturePath())));
-
-			constexpr StringCrc radSamplerCrc(cubeRadianceSampler);
-			GetRenderContext()->CreateTexture(pSkyComponent->GetRadianceTexturePath().c_str(), samplerFlags);
-			bgfx::setTexture(IBL_RADIANCE_SLOT,
-				GetRenderContext()->GetUniform(radSamplerCrc),
-				GetRenderContext()->GetTexture(StringCrc(pSkyComponent->GetRadianceTexturePath())));
-
-			constexpr StringCrc lutsamplerCrc(lutSampler);
-			constexpr StringCrc luttextureCrc(lutTexture);
-			bgfx::setTexture(BRDF_LUT_SLOT, GetRenderContext()->GetUniform(lutsamplerCrc), GetRenderContext()->GetTexture(luttextureCrc));
+			m_stateCache.SetTexture(IBL_IRRADIANCE_SLOT, m_uniforms.cubeIrradianceSampler, m_irradianceTexture);
+			m_stateCache.SetTexture(IBL_RADIANCE_SLOT, m_uniforms.cubeRadianceSampler, m_radianceTexture);
+			m_stateCache.SetTexture(BRDF_LUT_SLOT, m_uniforms.lutSampler, m_lutTexture);
 		}
 		else if (SkyType::AtmosphericScattering == crtSkyType)
 		{
-			bgfx::setImage(ATM_TRANSMITTANCE_SLOT, GetRenderContext()->GetTexture(pSkyComponent->GetATMTransmittanceCrc()), 0, bgfx::Access::Read, bgfx::TextureFormat::RGBA32F);
-			bgfx::setImage(ATM_IRRADIANCE_SLOT, GetRenderContext()->GetTexture(pSkyComponent->GetATMIrradianceCrc()), 0, bgfx::Access::Read, bgfx::TextureFormat::RGBA32F);
-			bgfx::setImage(ATM_SCATTERING_SLOT, GetRenderContext()->GetTexture(pSkyComponent->GetATMScatteringCrc()), 0, bgfx::Access::Read, bgfx::TextureFormat::RGBA32F);
-
-			constexpr StringCrc LightDirCrc(LightDir);
-			GetRenderContext()->FillUniform(LightDirCrc, &(pSkyComponent->GetSunDirection().x()), 1);
+			m_stateCache.SetImage(ATM_TRANSMITTANCE_SLOT, atmTransmittanceTexture, 0, bgfx::Access::Read, bgfx::TextureFormat::RGBA32F);
+			m_stateCache.SetImage(ATM_IRRADIANCE_SLOT, atmIrradianceTexture, 0, bgfx::Access::Read, bgfx::TextureFormat::RGBA32F);
+			m_stateCache.SetImage(ATM_SCATTERING_SLOT, atmScatteringTexture, 0, bgfx::Access::Read, bgfx::TextureFormat::RGBA32F);
 
-			constexpr StringCrc HeightOffsetAndshadowLengthCrc(HeightOffsetAndshadowLength);
-			cd::Vec4f tmpHeightOffsetAndshadowLength = cd::Vec4f(pSkyComponent->GetHeightOffset(), pSkyComponent->GetShadowLength(), 0.0f, 0.0f);
-			GetRenderContext()->FillUniform(HeightOffsetAndshadowLengthCrc, &(tmpHeightOffsetAndshadowLength.x()), 1);
+			m_stateCache.SetUniform(m_uniforms.lightDir, &(pSkyComponent->GetSunDirection().x()), 1);
+			m_stateCache.SetUniform(m_uniforms.heightOffsetAndShadowLength, heightOffsetAndShadowLengthData.Begin(), 1);
 		}
 
 		// Submit uniform values : camera settings
-		constexpr StringCrc cameraPosCrc(cameraPos);
-		GetRenderContext()->FillUniform(cameraPosCrc, &cameraTransform.GetTranslation().x(), 1);
+		m_stateCache.SetUniform(m_uniforms.cameraPos, cameraPosData.Begin(), 1);
 
 		// Submit uniform values : material settings
-		constexpr StringCrc albedoColorCrc(albedoColor);
-		GetRenderContext()->FillUniform(albedoColorCrc, pMaterialComponent->GetAlbedoColor().Begin(), 1);
+		const cd::Vec3f& albedo = pMaterialComponent->GetAlbedoColor();
+		materialValues.albedoColor = cd::Vec4f(albedo.x(), albedo.y(), albedo.z(), 1.0f);
+		m_stateCache.SetUniform(m_uniforms.albedoColor, materialValues.albedoColor.Begin(), 1);
 
-		constexpr StringCrc mrFactorCrc(metallicRoughnessFactor);
-		cd::Vec4f metallicRoughnessFactorData(pMaterialComponent->GetMetallicFactor(), pMaterialComponent->GetRoughnessFactor(), 1.0f, 1.0f);
-		GetRenderContext()->FillUniform(mrFactorCrc, metallicRoughnessFactorData.Begin(), 1);
+		materialValues.metallicRoughnessFactor = cd::Vec4f(pMaterialComponent->GetMetallicFactor(), pMaterialComponent->GetRoughnessFactor(), 1.0f, 1.0f);
+		m_stateCache.SetUniform(m_uniforms.metallicRoughnessFactor, materialValues.metallicRoughnessFactor.Begin(), 1);
 
-		constexpr StringCrc emissiveColorCrc(emissiveColor);
-		GetRenderContext()->FillUniform(emissiveColorCrc, pMaterialComponent->GetEmissiveColor().Begin(), 1);
+		const cd::Vec3f& emissive = pMaterialComponent->GetEmissiveColor();
+		materialValues.emissiveColor = cd::Vec4f(emissive.x(), emissive.y(), emissive.z(), 1.0f);
+		m_stateCache.SetUniform(m_uniforms.emissiveColor, materialValues.emissiveColor.Begin(), 1);
 
 		// Submit uniform values : light settings
-		auto lightEntities = m_pCurrentSceneWorld->GetLightEntities();
-		size_t lightEntityCount = lightEntities.size();
-		constexpr engine::StringCrc lightCountAndStrideCrc(lightCountAndStride);
-		static cd::Vec4f lightInfoData(0, LightUniform::LIGHT_STRIDE, 0.0f, 0.0f);
-		lightInfoData.x() = static_cast<float>(lightEntityCount);
-		GetRenderContext()->FillUniform(lightCountAndStrideCrc, lightInfoData.Begin(), 1);
-		if (lightEntityCount > 0)
+		m_stateCache.SetUniform(m_uniforms.lightCountAndStride, lightInfoData.Begin(), 1);
+		if (pLightDataBegin)
 		{
-			// Light component storage has continus memory address and layout.
-			float* pLightDataBegin = reinterpret_cast<float*>(m_pCurrentSceneWorld->GetLightComponent(lightEntities[0]));
-			constexpr engine::StringCrc lightParamsCrc(lightParams);
-			GetRenderContext()->FillUniform(lightParamsCrc, pLightDataBegin, static_cast<uint16_t>(lightEntityCount * LightUniform::LIGHT_STRIDE));
+			m_stateCache.SetUniform(m_uniforms.lightParams, pLightDataBegin, lightDataVec4Count);
 		}
 
-		uint64_t state = defaultRenderingState;
+		uint64_t state = drawItem.isOpaque && m_overdrawStatistics.isDepthPrePassEnabled ? afterDepthPrePassRenderingState : defaultRenderingState;
 		if (!pMaterialComponent->GetTwoSided())
 		{
 			state |= BGFX_STATE_CULL_CCW;
@@ -213,14 +419,16 @@ void WorldRenderer::Render(float deltaTime)
 
 		if (cd::BlendMode::Mask == pMaterialComponent->GetBlendMode())
 		{
-			constexpr StringCrc alphaCutOffCrc(alphaCutOff);
-			GetRenderContext()->FillUniform(alphaCutOffCrc, &pMaterialComponent->GetAlphaCutOff(), 1);
+			materialValues.alphaCutOff = cd::Vec4f(pMaterialComponent->GetAlphaCutOff(), 0.0f, 0.0f, 0.0f);
+			m_stateCache.SetUniform(m_uniforms.alphaCutOff, materialValues.alphaCutOff.Begin(), 1);
 		}
 
-		bgfx::setState(state);
+		m_stateCache.SetState(state);
 
-		bgfx::submit(GetViewID(), bgfx::ProgramHandle{pMaterialComponent->GetShadreProgram()});
+		m_stateCache.Submit(GetViewID(), bgfx::ProgramHandle{pMaterialComponent->GetShadreProgram()});
 	}
+
+	m_stateCache.End();
 }
 
 }
\ No newline at end of file
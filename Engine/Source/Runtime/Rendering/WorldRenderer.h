@@ -1,25 +1,106 @@
 #pragma once
 
+#include "Math/Matrix.hpp"
 #include "Renderer.h"
+#include "RenderStateCache.h"
+
+#include <bgfx/bgfx.h>
+
+#include <vector>
 
 namespace engine
 {
 
+class MaterialComponent;
 class SceneWorld;
+struct RenderCamera;
+class StaticMeshComponent;
+class TransformComponent;
 
 class WorldRenderer final : public Renderer
 {
+public:
+	enum class DepthPrePassMode
+	{
+		Auto,
+		Enabled,
+		Disabled,
+	};
+
+	// Describes the last rendered frame.
+	struct OverdrawStatistics
+	{
+		bool isDepthPrePassEnabled = false;
+		uint32_t drawCount = 0U;
+		uint32_t opaqueDrawCount = 0U;
+		uint32_t prePassDrawCount = 0U;
+		// Sum of the screen coverage of all drawn bounding boxes. Values above 1 mean overdraw.
+		float estimatedDepthComplexity = 0.0f;
+	};
+
 public:
 	using Renderer::Renderer;
 
 	virtual void Init() override;
 	virtual void UpdateView(const float* pViewMatrix, const float* pProjectionMatrix) override;
+	virtual void Prepare() override;
 	virtual void Render(float deltaTime) override;
 
 	void SetSceneWorld(SceneWorld* pSceneWorld) { m_pCurrentSceneWorld = pSceneWorld; }
 
+	// Opaque geometry can be drawn to depth first so that the PBR shader runs once per pixel.
+	// Auto decides per frame from the estimated overdraw.
+	void SetDepthPrePassMode(DepthPrePassMode mode) { m_depthPrePassMode = mode; }
+	DepthPrePassMode GetDepthPrePassMode() const { return m_depthPrePassMode; }
+	const OverdrawStatistics& GetOverdrawStatistics() const { return m_overdrawStatistics; }
+
 private:
+	struct DrawItem
+	{
+		MaterialComponent* pMaterialComponent;
+		StaticMeshComponent* pMeshComponent;
+		// Null when the entity has no transform.
+		const cd::Matrix4x4* pWorldMatrix;
+		bool isOpaque;
+	};
+
+	void CollectDrawItems(const RenderCamera& camera);
+	bool ShouldUseDepthPrePass() const;
+	void RenderDepthPrePass();
+
+	// Uniform handles are resolved once in Init. StringCrc lookups are only used at load time.
+	struct UniformHandles
+	{
+		bgfx::UniformHandle lutSampler = BGFX_INVALID_HANDLE;
+		bgfx::UniformHandle cubeIrradianceSampler = BGFX_INVALID_HANDLE;
+		bgfx::UniformHandle cubeRadianceSampler = BGFX_INVALID_HANDLE;
+
+		bgfx::UniformHandle cameraPos = BGFX_INVALID_HANDLE;
+		bgfx::UniformHandle albedoColor = BGFX_INVALID_HANDLE;
+		bgfx::UniformHandle emissiveColor = BGFX_INVALID_HANDLE;
+		bgfx::UniformHandle metallicRoughnessFactor = BGFX_INVALID_HANDLE;
+		bgfx::UniformHandle albedoUVOffsetAndScale = BGFX_INVALID_HANDLE;
+		bgfx::UniformHandle alphaCutOff = BGFX_INVALID_HANDLE;
+
+		bgfx::UniformHandle lightCountAndStride = BGFX_INVALID_HANDLE;
+		bgfx::UniformHandle lightParams = BGFX_INVALID_HANDLE;
+
+		bgfx::UniformHandle lightDir = BGFX_INVALID_HANDLE;
+		bgfx::UniformHandle heightOffsetAndShadowLength = BGFX_INVALID_HANDLE;
+	};
+
 	SceneWorld* m_pCurrentSceneWorld = nullptr;
+	UniformHandles m_uniforms;
+	RenderStateCache m_stateCache;
+	bgfx::TextureHandle m_lutTexture = BGFX_INVALID_HANDLE;
+	// Resolved by Prepare from the sky component.
+	bgfx::TextureHandle m_irradianceTexture = BGFX_INVALID_HANDLE;
+	bgfx::TextureHandle m_radianceTexture = BGFX_INVALID_HANDLE;
+	bgfx::ProgramHandle m_depthPrePassProgram = BGFX_INVALID_HANDLE;
+
+	DepthPrePassMode m_depthPrePassMode = DepthPrePassMode::Auto;
+	OverdrawStatistics m_overdrawStatistics;
+	std::vector<DrawItem> m_drawItems;
 };
 
 }
\ No newline at end of file
@@ -0,0 +1,153 @@
+#include "MappedFile.h"
+
+#include "Base/Template.h"
+
+#if CD_PLATFORM_WINDOWS
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <utility>
+
+namespace engine
+{
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+{
+	*this = cd::MoveTemp(other);
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept
+{
+	if (this != &other)
+	{
+		Close();
+		m_pData = std::exchange(other.m_pData, nullptr);
+		m_size = std::exchange(other.m_size, 0U);
+		m_pFileHandle = std::exchange(other.m_pFileHandle, nullptr);
+		m_pMappingHandle = std::exchange(other.m_pMappingHandle, nullptr);
+		m_fileDescriptor = std::exchange(other.m_fileDescriptor, -1);
+	}
+
+	return *this;
+}
+
+MappedFile::~MappedFile()
+{
+	Close();
+}
+
+#if CD_PLATFORM_WINDOWS
+
+bool MappedFile::Open(const char* pFilePath)
+{
+	Close();
+
+	HANDLE fileHandle = CreateFileA(pFilePath, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_RANDOM_ACCESS, nullptr);
+	if (INVALID_HANDLE_VALUE == fileHandle)
+	{
+		return false;
+	}
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(fileHandle, &fileSize) || 0 == fileSize.QuadPart)
+	{
+		CloseHandle(fileHandle);
+		return false;
+	}
+
+	HANDLE mappingHandle = CreateFileMappingA(fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (!mappingHandle)
+	{
+		CloseHandle(fileHandle);
+		return false;
+	}
+
+	void* pView = MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0);
+	if (!pView)
+	{
+		CloseHandle(mappingHandle);
+		CloseHandle(fileHandle);
+		return false;
+	}
+
+	m_pData = static_cast<const std::byte*>(pView);
+	m_size = static_cast<size_t>(fileSize.QuadPart);
+	m_pFileHandle = fileHandle;
+	m_pMappingHandle = mappingHandle;
+	return true;
+}
+
+void MappedFile::Close()
+{
+	if (m_pData)
+	{
+		UnmapViewOfFile(m_pData);
+		CloseHandle(m_pMappingHandle);
+		CloseHandle(m_pFileHandle);
+	}
+
+	m_pData = nullptr;
+	m_size = 0U;
+	m_pFileHandle = nullptr;
+	m_pMappingHandle = nullptr;
+}
+
+#else
+
+bool MappedFile::Open(const char* pFilePath)
+{
+	Close();
+
+	int fileDescriptor = open(pFilePath, O_RDONLY);
+	if (fileDescriptor < 0)
+	{
+		return false;
+	}
+
+	struct stat fileStatus;
+	if (fstat(fileDescriptor, &fileStatus) != 0 || 0 == fileStatus.st_size)
+	{
+		close(fileDescriptor);
+		return false;
+	}
+
+	size_t fileSize = static_cast<size_t>(fileStatus.st_size);
+	void* pView = mmap(nullptr, fileSize, PROT_READ, MAP_PRIVATE, fileDescriptor, 0);
+	if (MAP_FAILED == pView)
+	{
+		close(fileDescriptor);
+		return false;
+	}
+
+	// Large files are read in scattered blocks, so read ahead would mostly load unwanted pages.
+	madvise(pView, fileSize, MADV_RANDOM);
+
+	m_pData = static_cast<const std::byte*>(pView);
+	m_size = fileSize;
+	m_fileDescriptor = fileDescriptor;
+	return true;
+}
+
+void MappedFile::Close()
+{
+	if (m_pData)
+	{
+		munmap(const_cast<std::byte*>(m_pData), m_size);
+		close(m_fileDescriptor);
+	}
+
+	m_pData = nullptr;
+	m_size = 0U;
+	m_fileDescriptor = -1;
+}
+
+#endif
+
+}
\ No newline at end of file
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstddef>
+
+namespace engine
+{
+
+// Read only view of a whole file mapped into the address space. Pages are read from disk when they are
+// first touched, so opening a file far larger than the memory doesn't load anything yet.
+class MappedFile final
+{
+public:
+	MappedFile() = default;
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+	MappedFile(MappedFile&& other) noexcept;
+	MappedFile& operator=(MappedFile&& other) noexcept;
+	~MappedFile();
+
+	bool Open(const char* pFilePath);
+	void Close();
+
+	bool IsOpen() const { return m_pData != nullptr; }
+	const std::byte* GetData() const { return m_pData; }
+	size_t GetSize() const { return m_size; }
+
+private:
+	const std::byte* m_pData = nullptr;
+	size_t m_size = 0U;
+
+	// File and mapping handles on Windows, the file descriptor elsewhere.
+	void* m_pFileHandle = nullptr;
+	void* m_pMappingHandle = nullptr;
+	int m_fileDescriptor = -1;
+};
+
+}
\ No newline at end of file
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+namespace engine
+{
+
+// Read only view of heightfield samples stored as 16 bits unorm, row by row along x. A sample decodes to
+// sample * scale + offset, so the height range of a terrain spreads over all the sample values and the same
+// samples upload to an R16 texture as they are.
+struct QuantizedHeights
+{
+	static constexpr float MaxSample = 65535.0f;
+
+	static QuantizedHeights FromRange(const uint16_t* pSamples, float minHeight, float maxHeight)
+	{
+		return { pSamples, (maxHeight - minHeight) / MaxSample, minHeight };
+	}
+
+	float operator[](size_t index) const { return static_cast<float>(pSamples[index]) * scale + offset; }
+
+	// Heights outside of the range are clamped to it.
+	uint16_t Quantize(float height) const
+	{
+		float sample = scale > 0.0f ? (height - offset) / scale : 0.0f;
+		return static_cast<uint16_t>(std::clamp(sample, 0.0f, MaxSample) + 0.5f);
+	}
+
+	const uint16_t* pSamples;
+	float scale;
+	float offset;
+};
+
+}
\ No newline at end of file
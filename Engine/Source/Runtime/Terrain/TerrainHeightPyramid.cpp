@@ -0,0 +1,299 @@
+#include "TerrainHeightPyramid.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace engine
+{
+
+namespace
+{
+
+// Tolerance on the barycentric bounds so that rays through a shared edge hit one of the two cells.
+constexpr double cellEdgeEpsilon = 1e-7;
+
+}
+
+void TerrainHeightPyramid::Build(const QuantizedHeights& heights, uint16_t width, uint16_t depth)
+{
+	m_width = width;
+	m_depth = depth;
+	m_levelOffsets.clear();
+	m_ranges.clear();
+	if (width < 2U || depth < 2U)
+	{
+		return;
+	}
+
+	uint32_t rangeCount = 0U;
+	for (uint32_t level = 0U; ; ++level)
+	{
+		m_levelOffsets.push_back(rangeCount);
+		rangeCount += GetCellCountX(level) * GetCellCountZ(level);
+		if (1U == GetCellCountX(level) && 1U == GetCellCountZ(level))
+		{
+			break;
+		}
+	}
+
+	m_ranges.resize(rangeCount);
+	BuildCells(heights, 0U, 0U, GetCellCountX(0U) - 1U, GetCellCountZ(0U) - 1U);
+}
+
+void TerrainHeightPyramid::UpdateRegion(const QuantizedHeights& heights, uint16_t minX, uint16_t minZ, uint16_t maxX, uint16_t maxZ)
+{
+	if (IsEmpty())
+	{
+		return;
+	}
+
+	// A sample is a corner of up to four cells.
+	uint32_t minCellX = minX > 0U ? minX - 1U : 0U;
+	uint32_t minCellZ = minZ > 0U ? minZ - 1U : 0U;
+	uint32_t maxCellX = std::min<uint32_t>(maxX, GetCellCountX(0U) - 1U);
+	uint32_t maxCellZ = std::min<uint32_t>(maxZ, GetCellCountZ(0U) - 1U);
+	BuildCells(heights, minCellX, minCellZ, maxCellX, maxCellZ);
+}
+
+void TerrainHeightPyramid::BuildCells(const QuantizedHeights& heights, uint32_t minCellX, uint32_t minCellZ, uint32_t maxCellX, uint32_t maxCellZ)
+{
+	for (uint32_t cellZ = minCellZ; cellZ <= maxCellZ; ++cellZ)
+	{
+		size_t row = static_cast<size_t>(cellZ) * m_width;
+		size_t nextRow = row + m_width;
+		for (uint32_t cellX = minCellX; cellX <= maxCellX; ++cellX)
+		{
+			float h00 = heights[row + cellX];
+			float h10 = heights[row + cellX + 1U];
+			float h01 = heights[nextRow + cellX];
+			float h11 = heights[nextRow + cellX + 1U];
+			Range& range = m_ranges[cellZ * GetCellCountX(0U) + cellX];
+			range.minHeight = std::min(std::min(h00, h10), std::min(h01, h11));
+			range.maxHeight = std::max(std::max(h00, h10), std::max(h01, h11));
+		}
+	}
+
+	for (uint32_t level = 1U; level < GetLevelCount(); ++level)
+	{
+		minCellX >>= 1U;
+		minCellZ >>= 1U;
+		maxCellX >>= 1U;
+		maxCellZ >>= 1U;
+
+		uint32_t childCountX = GetCellCountX(level - 1U);
+		uint32_t childCountZ = GetCellCountZ(level - 1U);
+		Range* pChildren = &m_ranges[m_levelOffsets[level - 1U]];
+		Range* pRanges = &m_ranges[m_levelOffsets[level]];
+		for (uint32_t cellZ = minCellZ; cellZ <= maxCellZ; ++cellZ)
+		{
+			for (uint32_t cellX = minCellX; cellX <= maxCellX; ++cellX)
+			{
+				Range range { std::numeric_limits<float>::max(), std::numeric_limits<float>::lowest() };
+				for (uint32_t childZ = cellZ * 2U; childZ < std::min(cellZ * 2U + 2U, childCountZ); ++childZ)
+				{
+					for (uint32_t childX = cellX * 2U; childX < std::min(cellX * 2U + 2U, childCountX); ++childX)
+					{
+						const Range& childRange = pChildren[childZ * childCountX + childX];
+						range.minHeight = std::min(range.minHeight, childRange.minHeight);
+						range.maxHeight = std::max(range.maxHeight, childRange.maxHeight);
+					}
+				}
+				pRanges[cellZ * GetCellCountX(level) + cellX] = range;
+			}
+		}
+	}
+}
+
+bool TerrainHeightPyramid::Raycast(const QuantizedHeights& heights, const cd::Point& origin, const cd::Direction& direction, float maxDistance,
+	RayHit& hit, RaycastStatistics* pStatistics) const
+{
+	if (IsEmpty())
+	{
+		return false;
+	}
+
+	// Traversal runs in double precision, floats lose the fraction of a cell on wide terrains.
+	double length = std::sqrt(static_cast<double>(direction.x()) * direction.x() + static_cast<double>(direction.y()) * direction.y() +
+		static_cast<double>(direction.z()) * direction.z());
+	if (length <= 0.0)
+	{
+		return false;
+	}
+
+	const double ox = origin.x();
+	const double oy = origin.y();
+	const double oz = origin.z();
+	const double dx = direction.x() / length;
+	const double dy = direction.y() / length;
+	const double dz = direction.z() / length;
+	const int64_t cellCountX = GetCellCountX(0U);
+	const int64_t cellCountZ = GetCellCountZ(0U);
+	const uint32_t topLevel = GetLevelCount() - 1U;
+	const double infinity = std::numeric_limits<double>::infinity();
+
+	// Clip the ray to the box of the root node.
+	double tEnter = 0.0;
+	double tExit = maxDistance;
+	auto ClipSlab = [&tEnter, &tExit](double o, double d, double minValue, double maxValue)
+	{
+		if (0.0 == d)
+		{
+			return o >= minValue && o <= maxValue;
+		}
+
+		double t0 = (minValue - o) / d;
+		double t1 = (maxValue - o) / d;
+		tEnter = std::max(tEnter, std::min(t0, t1));
+		tExit = std::min(tExit, std::max(t0, t1));
+		return tEnter <= tExit;
+	};
+
+	const Range& rootRange = m_ranges.back();
+	if (!ClipSlab(ox, dx, 0.0, static_cast<double>(cellCountX)) || !ClipSlab(oz, dz, 0.0, static_cast<double>(cellCountZ)) ||
+		!ClipSlab(oy, dy, rootRange.minHeight, rootRange.maxHeight))
+	{
+		return false;
+	}
+
+	// Intersects the two triangles of a level 0 cell, whose heights are the planes y = h00 + b * u + c * v in cell coordinates.
+	auto IntersectCell = [&](int64_t cellX, int64_t cellZ)
+	{
+		size_t row = static_cast<size_t>(cellZ) * m_width;
+		size_t nextRow = row + m_width;
+		double h00 = heights[row + cellX];
+		double h10 = heights[row + cellX + 1];
+		double h01 = heights[nextRow + cellX];
+		double h11 = heights[nextRow + cellX + 1];
+		double ou = ox - static_cast<double>(cellX);
+		double ov = oz - static_cast<double>(cellZ);
+
+		// { b, c, is the u <= v half }
+		const double triangles[2][3] = { { h11 - h01, h01 - h00, 1.0 }, { h10 - h00, h11 - h10, 0.0 } };
+		double bestT = infinity;
+		double bestB = 0.0;
+		double bestC = 0.0;
+		for (const auto& triangle : triangles)
+		{
+			double b = triangle[0];
+			double c = triangle[1];
+			double denominator = dy - b * dx - c * dz;
+			if (std::abs(denominator) < 1e-12)
+			{
+				continue;
+			}
+
+			double t = (h00 + b * ou + c * ov - oy) / denominator;
+			if (t < 0.0 || t > maxDistance || t >= bestT)
+			{
+				continue;
+			}
+
+			double u = ou + dx * t;
+			double v = ov + dz * t;
+			bool isInsideCell = u >= -cellEdgeEpsilon && u <= 1.0 + cellEdgeEpsilon && v >= -cellEdgeEpsilon && v <= 1.0 + cellEdgeEpsilon;
+			bool isInsideHalf = triangle[2] > 0.0 ? u <= v + cellEdgeEpsilon : u >= v - cellEdgeEpsilon;
+			if (isInsideCell && isInsideHalf)
+			{
+				bestT = t;
+				bestB = b;
+				bestC = c;
+			}
+		}
+
+		if (infinity == bestT)
+		{
+			return false;
+		}
+
+		hit.distance = static_cast<float>(bestT);
+		hit.position = cd::Point(static_cast<float>(ox + dx * bestT), static_cast<float>(oy + dy * bestT), static_cast<float>(oz + dz * bestT));
+		hit.normal = cd::Direction(static_cast<float>(-bestB), 1.0f, static_cast<float>(-bestC)).Normalize();
+		return true;
+	};
+
+	uint32_t visitedNodeCount = 0U;
+	uint32_t testedCellCount = 0U;
+	auto WriteStatistics = [&]()
+	{
+		if (pStatistics)
+		{
+			pStatistics->visitedNodeCount = visitedNodeCount;
+			pStatistics->testedCellCount = testedCellCount;
+		}
+	};
+
+	// Current level 0 cell. Steps between nodes are done on these integers so rounding can never send the walk back.
+	double t = tEnter;
+	int64_t cellX = std::clamp(static_cast<int64_t>(std::floor(ox + dx * t)), int64_t(0), cellCountX - 1);
+	int64_t cellZ = std::clamp(static_cast<int64_t>(std::floor(oz + dz * t)), int64_t(0), cellCountZ - 1);
+	uint32_t level = topLevel;
+	while (true)
+	{
+		++visitedNodeCount;
+		int64_t nodeMinX = (cellX >> level) << level;
+		int64_t nodeMinZ = (cellZ >> level) << level;
+		int64_t nodeMaxX = std::min(nodeMinX + (int64_t(1) << level), cellCountX);
+		int64_t nodeMaxZ = std::min(nodeMinZ + (int64_t(1) << level), cellCountZ);
+		double tExitX = dx > 0.0 ? (static_cast<double>(nodeMaxX) - ox) / dx : (dx < 0.0 ? (static_cast<double>(nodeMinX) - ox) / dx : infinity);
+		double tExitZ = dz > 0.0 ? (static_cast<double>(nodeMaxZ) - oz) / dz : (dz < 0.0 ? (static_cast<double>(nodeMinZ) - oz) / dz : infinity);
+		double tNodeExit = std::max(std::min(std::min(tExitX, tExitZ), tExit), t);
+
+		// The ray is a line over the node, so its height range over the node is reached at the two ends.
+		double y0 = oy + dy * t;
+		double y1 = oy + dy * tNodeExit;
+		const Range& range = GetRange(level, static_cast<uint32_t>(cellX >> level), static_cast<uint32_t>(cellZ >> level));
+		if (std::min(y0, y1) <= range.maxHeight && std::max(y0, y1) >= range.minHeight)
+		{
+			if (level > 0U)
+			{
+				--level;
+				continue;
+			}
+
+			++testedCellCount;
+			if (IntersectCell(cellX, cellZ))
+			{
+				WriteStatistics();
+				return true;
+			}
+		}
+
+		if (tNodeExit >= tExit)
+		{
+			break;
+		}
+
+		// Move to the neighbour across the nearer face. The other coordinate is kept inside the node as it only
+		// changes along the face.
+		int64_t previousCellX = cellX;
+		int64_t previousCellZ = cellZ;
+		if (tExitX <= tExitZ)
+		{
+			cellX = dx > 0.0 ? nodeMaxX : nodeMinX - 1;
+			cellZ = std::clamp(static_cast<int64_t>(std::floor(oz + dz * tNodeExit)), nodeMinZ, nodeMaxZ - 1);
+		}
+		else
+		{
+			cellZ = dz > 0.0 ? nodeMaxZ : nodeMinZ - 1;
+			cellX = std::clamp(static_cast<int64_t>(std::floor(ox + dx * tNodeExit)), nodeMinX, nodeMaxX - 1);
+		}
+
+		if (cellX < 0 || cellX >= cellCountX || cellZ < 0 || cellZ >= cellCountZ)
+		{
+			break;
+		}
+		t = tNodeExit;
+
+		// Ancestors shared with the previous cell have been entered already, the first one which isn't can be tested whole.
+		while (level < topLevel && ((cellX >> (level + 1U)) != (previousCellX >> (level + 1U)) || (cellZ >> (level + 1U)) != (previousCellZ >> (level + 1U))))
+		{
+			++level;
+		}
+	}
+
+	WriteStatistics();
+	return false;
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,74 @@
+#pragma once
+
+#include "Math/Vector.hpp"
+#include "QuantizedHeights.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace engine
+{
+
+// Min/max height pyramid over the cells of a heightfield, a cell being the quad between four samples.
+// Level 0 keeps the range of every cell and each level above merges 2 x 2 cells, up to a single root.
+// Raycast walks it top down and skips every node whose range the ray stays above or below, then intersects
+// the two triangles of the remaining cells exactly. They are split along the (x, z) to (x + 1, z + 1)
+// diagonal like the rendered patches, so hits lie on the drawn surface.
+// Coordinates are in local terrain space where one heightfield sample is one unit on x and z.
+class TerrainHeightPyramid final
+{
+public:
+	struct RayHit
+	{
+		float distance = 0.0f;
+		cd::Point position = cd::Point(0.0f);
+		cd::Direction normal = cd::Direction(0.0f, 1.0f, 0.0f);
+	};
+
+	struct RaycastStatistics
+	{
+		uint32_t visitedNodeCount = 0U;
+		uint32_t testedCellCount = 0U;
+	};
+
+public:
+	TerrainHeightPyramid() = default;
+	TerrainHeightPyramid(const TerrainHeightPyramid&) = default;
+	TerrainHeightPyramid& operator=(const TerrainHeightPyramid&) = default;
+	TerrainHeightPyramid(TerrainHeightPyramid&&) = default;
+	TerrainHeightPyramid& operator=(TerrainHeightPyramid&&) = default;
+	~TerrainHeightPyramid() = default;
+
+	// heights holds width * depth samples.
+	void Build(const QuantizedHeights& heights, uint16_t width, uint16_t depth);
+	// Refreshes the cells touching the inclusive sample rectangle and their ancestors.
+	void UpdateRegion(const QuantizedHeights& heights, uint16_t minX, uint16_t minZ, uint16_t maxX, uint16_t maxZ);
+
+	bool IsEmpty() const { return m_ranges.empty(); }
+	uint32_t GetLevelCount() const { return static_cast<uint32_t>(m_levelOffsets.size()); }
+
+	// First hit within maxDistance along direction, which doesn't need to be normalized. heights must be the
+	// heightfield the pyramid was built from. Const and free of shared state, so queries can run on any thread.
+	bool Raycast(const QuantizedHeights& heights, const cd::Point& origin, const cd::Direction& direction, float maxDistance,
+		RayHit& hit, RaycastStatistics* pStatistics = nullptr) const;
+
+private:
+	struct Range
+	{
+		float minHeight;
+		float maxHeight;
+	};
+
+	uint32_t GetCellCountX(uint32_t level) const { return ((m_width - 1U) + (1U << level) - 1U) >> level; }
+	uint32_t GetCellCountZ(uint32_t level) const { return ((m_depth - 1U) + (1U << level) - 1U) >> level; }
+	const Range& GetRange(uint32_t level, uint32_t cellX, uint32_t cellZ) const { return m_ranges[m_levelOffsets[level] + cellZ * GetCellCountX(level) + cellX]; }
+
+	void BuildCells(const QuantizedHeights& heights, uint32_t minCellX, uint32_t minCellZ, uint32_t maxCellX, uint32_t maxCellZ);
+
+	uint16_t m_width = 0U;
+	uint16_t m_depth = 0U;
+	std::vector<uint32_t> m_levelOffsets;
+	std::vector<Range> m_ranges;
+};
+
+}
\ No newline at end of file
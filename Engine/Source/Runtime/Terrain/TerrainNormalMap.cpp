@@ -0,0 +1,124 @@
+#include "TerrainNormalMap.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace engine
+{
+
+namespace
+{
+
+uint8_t PackComponent(float value)
+{
+	return static_cast<uint8_t>(value * 127.0f + 128.5f);
+}
+
+float UnpackComponent(uint8_t value)
+{
+	return (static_cast<float>(value) - 128.0f) / 127.0f;
+}
+
+// Writes the normals of [beginX, endX) of one row. The three rows and the left and right columns are resolved
+// by the caller, so the loop has no branch and the compiler can vectorize it.
+// The kernels only take differences of samples, so they run on the quantized values and the offset cancels out.
+// rowSpan is the distance in rows between pAbove and pBelow, which is 1 instead of 2 on the first and last rows.
+void ComputeSpan(const uint16_t* pAbove, const uint16_t* pRow, const uint16_t* pBelow, float scale, uint32_t rowSpan, uint32_t beginX, uint32_t endX,
+	int32_t leftOffset, int32_t rightOffset, uint8_t* pOutput)
+{
+	// Each Sobel kernel sums to 4 times the difference over its span, so borders divide by their shorter span.
+	float slopeScaleX = scale / static_cast<float>(4 * (rightOffset - leftOffset));
+	float slopeScaleZ = scale / static_cast<float>(4U * rowSpan);
+	for (uint32_t x = beginX; x < endX; ++x)
+	{
+		uint32_t left = static_cast<uint32_t>(static_cast<int32_t>(x) + leftOffset);
+		uint32_t right = static_cast<uint32_t>(static_cast<int32_t>(x) + rightOffset);
+
+		// Slopes in height per sample.
+		int32_t differenceX = (pAbove[right] + 2 * pRow[right] + pBelow[right]) - (pAbove[left] + 2 * pRow[left] + pBelow[left]);
+		int32_t differenceZ = (pBelow[left] + 2 * pBelow[x] + pBelow[right]) - (pAbove[left] + 2 * pAbove[x] + pAbove[right]);
+		float slopeX = static_cast<float>(differenceX) * slopeScaleX;
+		float slopeZ = static_cast<float>(differenceZ) * slopeScaleZ;
+		float inverseLength = 1.0f / std::sqrt(slopeX * slopeX + slopeZ * slopeZ + 1.0f);
+
+		pOutput[x * TerrainNormalMap::BytesPerSample] = PackComponent(-slopeX * inverseLength);
+		pOutput[x * TerrainNormalMap::BytesPerSample + 1U] = PackComponent(-slopeZ * inverseLength);
+	}
+}
+
+}
+
+void TerrainNormalMap::Build(const QuantizedHeights& heights, uint16_t width, uint16_t depth)
+{
+	m_width = width;
+	m_depth = depth;
+	m_packedNormals.assign(static_cast<size_t>(width) * depth * BytesPerSample, 0U);
+	if (width < 2U || depth < 2U)
+	{
+		m_packedNormals.clear();
+		return;
+	}
+
+	ComputeRows(heights, 0U, 0U, width - 1U, depth - 1U);
+}
+
+void TerrainNormalMap::UpdateRegion(const QuantizedHeights& heights, uint16_t minX, uint16_t minZ, uint16_t maxX, uint16_t maxZ)
+{
+	if (IsEmpty())
+	{
+		return;
+	}
+
+	ComputeRows(heights, minX > 0U ? minX - 1U : 0U, minZ > 0U ? minZ - 1U : 0U,
+		std::min<uint32_t>(maxX + 1U, m_width - 1U), std::min<uint32_t>(maxZ + 1U, m_depth - 1U));
+}
+
+void TerrainNormalMap::ComputeRows(const QuantizedHeights& heights, uint32_t minX, uint32_t minZ, uint32_t maxX, uint32_t maxZ)
+{
+	uint32_t lastX = m_width - 1U;
+	uint32_t lastZ = m_depth - 1U;
+	for (uint32_t z = minZ; z <= maxZ; ++z)
+	{
+		uint32_t aboveZ = z > 0U ? z - 1U : 0U;
+		uint32_t belowZ = std::min(z + 1U, lastZ);
+		uint32_t rowSpan = belowZ - aboveZ;
+		const uint16_t* pAbove = heights.pSamples + aboveZ * m_width;
+		const uint16_t* pRow = heights.pSamples + z * m_width;
+		const uint16_t* pBelow = heights.pSamples + belowZ * m_width;
+		uint8_t* pOutput = m_packedNormals.data() + static_cast<size_t>(z) * m_width * BytesPerSample;
+
+		// Border columns clamp their missing neighbour, the interior runs without any clamp.
+		uint32_t interiorBegin = std::max(minX, 1U);
+		uint32_t interiorEnd = std::min(maxX + 1U, lastX);
+		if (0U == minX)
+		{
+			ComputeSpan(pAbove, pRow, pBelow, heights.scale, rowSpan, 0U, 1U, 0, 1, pOutput);
+		}
+		if (interiorBegin < interiorEnd)
+		{
+			ComputeSpan(pAbove, pRow, pBelow, heights.scale, rowSpan, interiorBegin, interiorEnd, -1, 1, pOutput);
+		}
+		if (lastX == maxX)
+		{
+			ComputeSpan(pAbove, pRow, pBelow, heights.scale, rowSpan, lastX, lastX + 1U, -1, 0, pOutput);
+		}
+	}
+}
+
+cd::Direction TerrainNormalMap::GetNormal(uint16_t x, uint16_t z) const
+{
+	const uint8_t* pPacked = &m_packedNormals[(static_cast<size_t>(z) * m_width + x) * BytesPerSample];
+	float normalX = UnpackComponent(pPacked[0]);
+	float normalZ = UnpackComponent(pPacked[1]);
+	float normalY = std::sqrt(std::max(1.0f - normalX * normalX - normalZ * normalZ, 0.0f));
+	return cd::Direction(normalX, normalY, normalZ);
+}
+
+cd::Direction TerrainNormalMap::GetTangent(uint16_t x, uint16_t z) const
+{
+	// (1, slopeX, 0) is (normal.y, -normal.x, 0) up to its length.
+	cd::Direction normal = GetNormal(x, z);
+	return cd::Direction(normal.y(), -normal.x(), 0.0f).Normalize();
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "Math/Vector.hpp"
+#include "QuantizedHeights.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace engine
+{
+
+// Per sample normals of a heightfield from a 3 x 3 Sobel filter, samples past the border repeating the edge.
+// Normals are stored as two bytes, x and z mapped from [-1, 1] to [1, 255] with 128 as zero, and y is rebuilt from them
+// because it is always positive on a heightfield. The layout matches an RG8 texture so the data is uploaded as is.
+// Tangents follow +x over the surface and are rebuilt from the normal too.
+class TerrainNormalMap final
+{
+public:
+	static constexpr uint32_t BytesPerSample = 2U;
+
+public:
+	TerrainNormalMap() = default;
+	TerrainNormalMap(const TerrainNormalMap&) = default;
+	TerrainNormalMap& operator=(const TerrainNormalMap&) = default;
+	TerrainNormalMap(TerrainNormalMap&&) = default;
+	TerrainNormalMap& operator=(TerrainNormalMap&&) = default;
+	~TerrainNormalMap() = default;
+
+	// heights holds width * depth samples.
+	void Build(const QuantizedHeights& heights, uint16_t width, uint16_t depth);
+	// Recomputes the normals which depend on the inclusive rectangle of edited samples, so one more sample on every side.
+	void UpdateRegion(const QuantizedHeights& heights, uint16_t minX, uint16_t minZ, uint16_t maxX, uint16_t maxZ);
+
+	bool IsEmpty() const { return m_packedNormals.empty(); }
+	const uint8_t* GetData() const { return m_packedNormals.data(); }
+	uint32_t GetDataSize() const { return static_cast<uint32_t>(m_packedNormals.size()); }
+
+	cd::Direction GetNormal(uint16_t x, uint16_t z) const;
+	cd::Direction GetTangent(uint16_t x, uint16_t z) const;
+
+private:
+	void ComputeRows(const QuantizedHeights& heights, uint32_t minX, uint32_t minZ, uint32_t maxX, uint32_t maxZ);
+
+	uint16_t m_width = 0U;
+	uint16_t m_depth = 0U;
+	std::vector<uint8_t> m_packedNormals;
+};
+
+}
\ No newline at end of file
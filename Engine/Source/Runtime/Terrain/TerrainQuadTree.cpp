@@ -0,0 +1,434 @@
+#include "TerrainQuadTree.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
+
+namespace engine
+{
+
+namespace
+{
+
+// Shared by the four edge directions of the neighbour walks, in StitchEdge bit order.
+constexpr int32_t neighbourOffsets[4][2] = { { -1, 0 }, { 1, 0 }, { 0, -1 }, { 0, 1 } };
+
+float GetHeight(const QuantizedHeights& heights, uint16_t width, uint16_t depth, uint32_t x, uint32_t z)
+{
+	x = std::min<uint32_t>(x, width - 1U);
+	z = std::min<uint32_t>(z, depth - 1U);
+	return heights[z * width + x];
+}
+
+bool IsOutsideFrustum(const cd::Vec4f* pPlanes, const cd::Point& boxMin, const cd::Point& boxMax)
+{
+	for (uint32_t planeIndex = 0U; planeIndex < 6U; ++planeIndex)
+	{
+		// Corner of the box furthest along the plane normal.
+		const cd::Vec4f& plane = pPlanes[planeIndex];
+		float x = plane.x() >= 0.0f ? boxMax.x() : boxMin.x();
+		float y = plane.y() >= 0.0f ? boxMax.y() : boxMin.y();
+		float z = plane.z() >= 0.0f ? boxMax.z() : boxMin.z();
+		if (plane.x() * x + plane.y() * y + plane.z() * z + plane.w() < 0.0f)
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+}
+
+void TerrainQuadTree::GenerateIndices(uint32_t stitchMask, std::vector<uint16_t>& indices)
+{
+	// Odd vertices of a stitched edge are moved onto the previous even one, which makes the edge follow
+	// the coarser neighbour. Triangles collapsed by the move are left out.
+	auto GetVertexIndex = [stitchMask](uint32_t x, uint32_t z)
+	{
+		if (((0U == x && (stitchMask & StitchNegativeX)) || (PatchQuadCount == x && (stitchMask & StitchPositiveX))) && (z & 1U))
+		{
+			--z;
+		}
+		if (((0U == z && (stitchMask & StitchNegativeZ)) || (PatchQuadCount == z && (stitchMask & StitchPositiveZ))) && (x & 1U))
+		{
+			--x;
+		}
+		return static_cast<uint16_t>(z * PatchVertexCount + x);
+	};
+
+	auto AddTriangle = [&indices](uint16_t a, uint16_t b, uint16_t c)
+	{
+		if (a != b && b != c && c != a)
+		{
+			indices.push_back(a);
+			indices.push_back(b);
+			indices.push_back(c);
+		}
+	};
+
+	indices.clear();
+	indices.reserve(PatchQuadCount * PatchQuadCount * 6U);
+	for (uint32_t z = 0U; z < PatchQuadCount; ++z)
+	{
+		for (uint32_t x = 0U; x < PatchQuadCount; ++x)
+		{
+			// Same winding as GenerateTerrainMesh, front faces point to +y.
+			AddTriangle(GetVertexIndex(x, z), GetVertexIndex(x, z + 1U), GetVertexIndex(x + 1U, z + 1U));
+			AddTriangle(GetVertexIndex(x, z), GetVertexIndex(x + 1U, z + 1U), GetVertexIndex(x + 1U, z));
+		}
+	}
+}
+
+void TerrainQuadTree::Build(const QuantizedHeights& heights, uint16_t width, uint16_t depth)
+{
+	m_width = width;
+	m_depth = depth;
+	m_levelCount = 0U;
+	m_levelOffsets.clear();
+	m_nodes.clear();
+	m_isSplit.clear();
+	if (width < 2U || depth < 2U)
+	{
+		return;
+	}
+
+	uint32_t quadCount = std::max(width, depth) - 1U;
+	m_levelCount = 1U;
+	while ((static_cast<uint32_t>(PatchQuadCount) << (m_levelCount - 1U)) < quadCount)
+	{
+		++m_levelCount;
+	}
+
+	uint32_t nodeCount = 0U;
+	for (uint32_t level = 0U; level < m_levelCount; ++level)
+	{
+		m_levelOffsets.push_back(nodeCount);
+		nodeCount += 1U << (level * 2U);
+	}
+
+	constexpr float infinity = std::numeric_limits<float>::infinity();
+	m_nodes.assign(nodeCount, Node{ infinity, -infinity, 0.0f });
+	m_isSplit.assign(nodeCount, 0U);
+
+	// Children first as parents merge their bounds and errors.
+	for (uint32_t level = m_levelCount; level-- > 0U;)
+	{
+		uint32_t levelNodeCount = 1U << level;
+		for (uint32_t nodeZ = 0U; nodeZ < levelNodeCount; ++nodeZ)
+		{
+			for (uint32_t nodeX = 0U; nodeX < levelNodeCount; ++nodeX)
+			{
+				if (IsInside(level, nodeX, nodeZ))
+				{
+					BuildNode(heights, level, nodeX, nodeZ);
+				}
+			}
+		}
+	}
+}
+
+void TerrainQuadTree::UpdateRegion(const QuantizedHeights& heights, uint16_t minX, uint16_t minZ, uint16_t maxX, uint16_t maxZ)
+{
+	for (uint32_t level = m_levelCount; level-- > 0U;)
+	{
+		// Nodes own the samples on both of their borders.
+		uint32_t span = GetNodeSpan(level);
+		uint32_t lastNode = (1U << level) - 1U;
+		uint32_t beginX = minX > 0U ? (minX - 1U) / span : 0U;
+		uint32_t beginZ = minZ > 0U ? (minZ - 1U) / span : 0U;
+		uint32_t endX = std::min(maxX / span, lastNode);
+		uint32_t endZ = std::min(maxZ / span, lastNode);
+		for (uint32_t nodeZ = beginZ; nodeZ <= endZ; ++nodeZ)
+		{
+			for (uint32_t nodeX = beginX; nodeX <= endX; ++nodeX)
+			{
+				if (IsInside(level, nodeX, nodeZ))
+				{
+					BuildNode(heights, level, nodeX, nodeZ);
+				}
+			}
+		}
+	}
+}
+
+bool TerrainQuadTree::IsInside(uint32_t level, uint32_t nodeX, uint32_t nodeZ) const
+{
+	uint32_t span = GetNodeSpan(level);
+	return nodeX * span < m_width - 1U && nodeZ * span < m_depth - 1U;
+}
+
+void TerrainQuadTree::BuildNode(const QuantizedHeights& heights, uint32_t level, uint32_t nodeX, uint32_t nodeZ)
+{
+	uint32_t span = GetNodeSpan(level);
+	uint32_t originX = nodeX * span;
+	uint32_t originZ = nodeZ * span;
+	Node& node = m_nodes[GetNodeIndex(level, nodeX, nodeZ)];
+	node.minHeight = std::numeric_limits<float>::infinity();
+	node.maxHeight = -std::numeric_limits<float>::infinity();
+	node.error = 0.0f;
+
+	// Leaves are drawn at full resolution so they have no error.
+	if (level + 1U == m_levelCount)
+	{
+		uint32_t endX = std::min<uint32_t>(originX + span, m_width - 1U);
+		uint32_t endZ = std::min<uint32_t>(originZ + span, m_depth - 1U);
+		for (uint32_t z = originZ; z <= endZ; ++z)
+		{
+			for (uint32_t x = originX; x <= endX; ++x)
+			{
+				float height = heights[z * m_width + x];
+				node.minHeight = std::min(node.minHeight, height);
+				node.maxHeight = std::max(node.maxHeight, height);
+			}
+		}
+		return;
+	}
+
+	for (uint32_t childIndex = 0U; childIndex < 4U; ++childIndex)
+	{
+		uint32_t childX = nodeX * 2U + (childIndex & 1U);
+		uint32_t childZ = nodeZ * 2U + (childIndex >> 1U);
+		if (IsInside(level + 1U, childX, childZ))
+		{
+			const Node& child = m_nodes[GetNodeIndex(level + 1U, childX, childZ)];
+			node.minHeight = std::min(node.minHeight, child.minHeight);
+			node.maxHeight = std::max(node.maxHeight, child.maxHeight);
+			node.error = std::max(node.error, child.error);
+		}
+	}
+
+	// How far the vertices only the children have are from this grid, never less than the children error
+	// so that errors only grow towards the root.
+	uint32_t halfStep = span / (PatchQuadCount * 2U);
+	uint32_t gridSize = PatchQuadCount * 2U;
+	for (uint32_t gridZ = 0U; gridZ <= gridSize; ++gridZ)
+	{
+		uint32_t z = originZ + gridZ * halfStep;
+		if (z >= m_depth)
+		{
+			break;
+		}
+
+		for (uint32_t gridX = 0U; gridX <= gridSize; ++gridX)
+		{
+			uint32_t x = originX + gridX * halfStep;
+			if (x >= m_width)
+			{
+				break;
+			}
+
+			bool isOddX = gridX & 1U;
+			bool isOddZ = gridZ & 1U;
+			if (!isOddX && !isOddZ)
+			{
+				continue;
+			}
+
+			float interpolated;
+			if (isOddX && isOddZ)
+			{
+				interpolated = (GetHeight(heights, m_width, m_depth, x - halfStep, z - halfStep) + GetHeight(heights, m_width, m_depth, x + halfStep, z - halfStep) +
+					GetHeight(heights, m_width, m_depth, x - halfStep, z + halfStep) + GetHeight(heights, m_width, m_depth, x + halfStep, z + halfStep)) * 0.25f;
+			}
+			else if (isOddX)
+			{
+				interpolated = (GetHeight(heights, m_width, m_depth, x - halfStep, z) + GetHeight(heights, m_width, m_depth, x + halfStep, z)) * 0.5f;
+			}
+			else
+			{
+				interpolated = (GetHeight(heights, m_width, m_depth, x, z - halfStep) + GetHeight(heights, m_width, m_depth, x, z + halfStep)) * 0.5f;
+			}
+
+			node.error = std::max(node.error, std::abs(heights[z * m_width + x] - interpolated));
+		}
+	}
+}
+
+void TerrainQuadTree::Select(const SelectionSettings& settings, std::vector<Patch>& patches)
+{
+	m_statistics = SelectionStatistics();
+	if (m_nodes.empty())
+	{
+		return;
+	}
+
+	std::fill(m_isSplit.begin(), m_isSplit.end(), 0U);
+	DecideSplit(settings, 0U, 0U, 0U);
+	Balance();
+
+	// Gribb-Hartmann planes pointing inwards : left, right, bottom, top, near, far.
+	const float* m = settings.worldViewProjection.Begin();
+	auto GetRow = [m](uint32_t row) { return cd::Vec4f(m[row], m[row + 4U], m[row + 8U], m[row + 12U]); };
+	cd::Vec4f rows[4] = { GetRow(0U), GetRow(1U), GetRow(2U), GetRow(3U) };
+	cd::Vec4f planes[6] = {
+		rows[3] + rows[0],
+		rows[3] - rows[0],
+		rows[3] + rows[1],
+		rows[3] - rows[1],
+		settings.homogeneousDepth ? rows[3] + rows[2] : rows[2],
+		rows[3] - rows[2],
+	};
+
+	CollectPatches(settings, planes, 0U, 0U, 0U, patches);
+}
+
+void TerrainQuadTree::MarkSplit(uint32_t level, uint32_t nodeX, uint32_t nodeZ)
+{
+	// A split node needs its ancestors split to be reachable.
+	while (!m_isSplit[GetNodeIndex(level, nodeX, nodeZ)])
+	{
+		m_isSplit[GetNodeIndex(level, nodeX, nodeZ)] = 1U;
+		++m_statistics.balanceSplitCount;
+		if (0U == level)
+		{
+			break;
+		}
+
+		--level;
+		nodeX >>= 1U;
+		nodeZ >>= 1U;
+	}
+}
+
+void TerrainQuadTree::DecideSplit(const SelectionSettings& settings, uint32_t level, uint32_t nodeX, uint32_t nodeZ)
+{
+	if (level + 1U == m_levelCount)
+	{
+		return;
+	}
+
+	uint32_t span = GetNodeSpan(level);
+	const Node& node = m_nodes[GetNodeIndex(level, nodeX, nodeZ)];
+	float minX = static_cast<float>(nodeX * span);
+	float minZ = static_cast<float>(nodeZ * span);
+	float maxX = static_cast<float>(std::min<uint32_t>(nodeX * span + span, m_width - 1U));
+	float maxZ = static_cast<float>(std::min<uint32_t>(nodeZ * span + span, m_depth - 1U));
+
+	// Distance to the closest point of the node bounds, zero when the camera is inside.
+	const cd::Point& camera = settings.cameraPosition;
+	float dx = std::max({ minX - camera.x(), 0.0f, camera.x() - maxX });
+	float dy = std::max({ node.minHeight - camera.y(), 0.0f, camera.y() - node.maxHeight });
+	float dz = std::max({ minZ - camera.z(), 0.0f, camera.z() - maxZ });
+	float distance = std::sqrt(dx * dx + dy * dy + dz * dz);
+	if (node.error * settings.projectionScale <= settings.maxScreenError * distance)
+	{
+		return;
+	}
+
+	m_isSplit[GetNodeIndex(level, nodeX, nodeZ)] = 1U;
+	for (uint32_t childIndex = 0U; childIndex < 4U; ++childIndex)
+	{
+		uint32_t childX = nodeX * 2U + (childIndex & 1U);
+		uint32_t childZ = nodeZ * 2U + (childIndex >> 1U);
+		if (IsInside(level + 1U, childX, childZ))
+		{
+			DecideSplit(settings, level + 1U, childX, childZ);
+		}
+	}
+}
+
+void TerrainQuadTree::Balance()
+{
+	// A leaf touching a split node of the level below would face patches two levels finer, which one
+	// stitch can't close. So the parent of every neighbour of a split node has to be split too.
+	// Going from fine to coarse settles everything in one pass as splits only propagate upwards.
+	for (uint32_t level = m_levelCount - 1U; level-- > 1U;)
+	{
+		int32_t levelNodeCount = 1 << level;
+		for (int32_t nodeZ = 0; nodeZ < levelNodeCount; ++nodeZ)
+		{
+			for (int32_t nodeX = 0; nodeX < levelNodeCount; ++nodeX)
+			{
+				if (!m_isSplit[GetNodeIndex(level, nodeX, nodeZ)])
+				{
+					continue;
+				}
+
+				for (const auto& offset : neighbourOffsets)
+				{
+					int32_t neighbourX = nodeX + offset[0];
+					int32_t neighbourZ = nodeZ + offset[1];
+					if (neighbourX < 0 || neighbourZ < 0 || neighbourX >= levelNodeCount || neighbourZ >= levelNodeCount ||
+						!IsInside(level, neighbourX, neighbourZ))
+					{
+						continue;
+					}
+
+					MarkSplit(level - 1U, static_cast<uint32_t>(neighbourX) >> 1U, static_cast<uint32_t>(neighbourZ) >> 1U);
+				}
+			}
+		}
+	}
+}
+
+void TerrainQuadTree::CollectPatches(const SelectionSettings& settings, const cd::Vec4f* pPlanes, uint32_t level, uint32_t nodeX, uint32_t nodeZ, std::vector<Patch>& patches)
+{
+	++m_statistics.visitedNodeCount;
+
+	uint32_t span = GetNodeSpan(level);
+	uint32_t originX = nodeX * span;
+	uint32_t originZ = nodeZ * span;
+	if (settings.cull)
+	{
+		const Node& node = m_nodes[GetNodeIndex(level, nodeX, nodeZ)];
+		cd::Point boxMin(static_cast<float>(originX), node.minHeight, static_cast<float>(originZ));
+		cd::Point boxMax(static_cast<float>(std::min<uint32_t>(originX + span, m_width - 1U)), node.maxHeight,
+			static_cast<float>(std::min<uint32_t>(originZ + span, m_depth - 1U)));
+		if (IsOutsideFrustum(pPlanes, boxMin, boxMax))
+		{
+			++m_statistics.culledNodeCount;
+			return;
+		}
+	}
+
+	if (m_isSplit[GetNodeIndex(level, nodeX, nodeZ)])
+	{
+		for (uint32_t childIndex = 0U; childIndex < 4U; ++childIndex)
+		{
+			uint32_t childX = nodeX * 2U + (childIndex & 1U);
+			uint32_t childZ = nodeZ * 2U + (childIndex >> 1U);
+			if (IsInside(level + 1U, childX, childZ))
+			{
+				CollectPatches(settings, pPlanes, level + 1U, childX, childZ, patches);
+			}
+		}
+		return;
+	}
+
+	patches.push_back({ static_cast<uint16_t>(originX), static_cast<uint16_t>(originZ), static_cast<uint16_t>(span / PatchQuadCount),
+		static_cast<uint8_t>(level), GetStitchMask(level, nodeX, nodeZ) });
+	++m_statistics.selectedPatchCount;
+}
+
+uint8_t TerrainQuadTree::GetStitchMask(uint32_t level, uint32_t nodeX, uint32_t nodeZ) const
+{
+	if (0U == level)
+	{
+		return 0U;
+	}
+
+	// The neighbour is drawn coarser when its parent isn't split. Balance keeps it within one level.
+	uint8_t stitchMask = 0U;
+	int32_t levelNodeCount = 1 << level;
+	for (uint32_t edgeIndex = 0U; edgeIndex < 4U; ++edgeIndex)
+	{
+		int32_t neighbourX = static_cast<int32_t>(nodeX) + neighbourOffsets[edgeIndex][0];
+		int32_t neighbourZ = static_cast<int32_t>(nodeZ) + neighbourOffsets[edgeIndex][1];
+		if (neighbourX < 0 || neighbourZ < 0 || neighbourX >= levelNodeCount || neighbourZ >= levelNodeCount ||
+			!IsInside(level, neighbourX, neighbourZ))
+		{
+			continue;
+		}
+
+		if (!m_isSplit[GetNodeIndex(level - 1U, static_cast<uint32_t>(neighbourX) >> 1U, static_cast<uint32_t>(neighbourZ) >> 1U)])
+		{
+			stitchMask |= static_cast<uint8_t>(1U << edgeIndex);
+		}
+	}
+
+	return stitchMask;
+}
+
+}
\ No newline at end of file
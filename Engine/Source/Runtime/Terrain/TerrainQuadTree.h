@@ -0,0 +1,120 @@
+#pragma once
+
+#include "Math/Matrix.hpp"
+#include "Math/Vector.hpp"
+#include "QuantizedHeights.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace engine
+{
+
+// Chunked LOD over a heightfield. Every node is drawn as the same grid of PatchQuadCount x PatchQuadCount quads,
+// so a node at depth d spans PatchQuadCount << (LevelCount - 1 - d) heightfield samples and the vertex count
+// on screen only depends on how many patches are selected. Nodes keep their height range for culling and the
+// largest height error against the full resolution heightfield for LOD selection.
+// Coordinates are in local terrain space where one heightfield sample is one unit on x and z.
+class TerrainQuadTree final
+{
+public:
+	static constexpr uint16_t PatchQuadCount = 32U;
+	static constexpr uint16_t PatchVertexCount = PatchQuadCount + 1U;
+
+	// Edges of a patch which border a coarser patch. Their odd vertices are dropped to close the T-junctions.
+	enum StitchEdge : uint8_t
+	{
+		StitchNegativeX = 1U << 0U,
+		StitchPositiveX = 1U << 1U,
+		StitchNegativeZ = 1U << 2U,
+		StitchPositiveZ = 1U << 3U,
+	};
+	static constexpr uint32_t StitchVariantCount = 16U;
+
+	struct Patch
+	{
+		// Heightfield sample under the first vertex and samples between two vertices.
+		uint16_t originX;
+		uint16_t originZ;
+		uint16_t step;
+		uint8_t level;
+		uint8_t stitchMask;
+	};
+
+	struct SelectionSettings
+	{
+		// Local terrain space to clip space.
+		cd::Matrix4x4 worldViewProjection = cd::Matrix4x4::Identity();
+		cd::Point cameraPosition = cd::Point(0.0f);
+		// Pixels per unit of error at a distance of one unit : viewport height * 0.5 * projection[1][1].
+		float projectionScale = 1.0f;
+		float maxScreenError = 2.0f;
+		bool homogeneousDepth = false;
+		bool cull = true;
+	};
+
+	struct SelectionStatistics
+	{
+		uint32_t visitedNodeCount = 0U;
+		uint32_t culledNodeCount = 0U;
+		uint32_t selectedPatchCount = 0U;
+		// Nodes split only to keep neighbours within one level of each other.
+		uint32_t balanceSplitCount = 0U;
+	};
+
+	// Triangle list of the shared patch grid for one stitch mask. Vertices are laid out row by row along x.
+	static void GenerateIndices(uint32_t stitchMask, std::vector<uint16_t>& indices);
+
+public:
+	TerrainQuadTree() = default;
+	TerrainQuadTree(const TerrainQuadTree&) = default;
+	TerrainQuadTree& operator=(const TerrainQuadTree&) = default;
+	TerrainQuadTree(TerrainQuadTree&&) = default;
+	TerrainQuadTree& operator=(TerrainQuadTree&&) = default;
+	~TerrainQuadTree() = default;
+
+	// heights holds width * depth samples.
+	void Build(const QuantizedHeights& heights, uint16_t width, uint16_t depth);
+	// Refreshes bounds and errors of the nodes covering the inclusive sample rectangle after an edit.
+	void UpdateRegion(const QuantizedHeights& heights, uint16_t minX, uint16_t minZ, uint16_t maxX, uint16_t maxZ);
+
+	bool IsEmpty() const { return m_nodes.empty(); }
+	uint32_t GetLevelCount() const { return m_levelCount; }
+	uint32_t GetNodeCount() const { return static_cast<uint32_t>(m_nodes.size()); }
+
+	// Appends the patches to draw, each of them holding the stitch mask of its coarser neighbours.
+	void Select(const SelectionSettings& settings, std::vector<Patch>& patches);
+	const SelectionStatistics& GetStatistics() const { return m_statistics; }
+
+private:
+	struct Node
+	{
+		float minHeight;
+		float maxHeight;
+		float error;
+	};
+
+	uint32_t GetNodeIndex(uint32_t level, uint32_t nodeX, uint32_t nodeZ) const { return m_levelOffsets[level] + nodeZ * (1U << level) + nodeX; }
+	uint32_t GetNodeSpan(uint32_t level) const { return static_cast<uint32_t>(PatchQuadCount) << (m_levelCount - 1U - level); }
+	// False for nodes lying past the heightfield when its size isn't a power of two multiple of a patch.
+	bool IsInside(uint32_t level, uint32_t nodeX, uint32_t nodeZ) const;
+
+	void BuildNode(const QuantizedHeights& heights, uint32_t level, uint32_t nodeX, uint32_t nodeZ);
+	void MarkSplit(uint32_t level, uint32_t nodeX, uint32_t nodeZ);
+	void DecideSplit(const SelectionSettings& settings, uint32_t level, uint32_t nodeX, uint32_t nodeZ);
+	void Balance();
+	void CollectPatches(const SelectionSettings& settings, const cd::Vec4f* pPlanes, uint32_t level, uint32_t nodeX, uint32_t nodeZ, std::vector<Patch>& patches);
+	uint8_t GetStitchMask(uint32_t level, uint32_t nodeX, uint32_t nodeZ) const;
+
+	uint16_t m_width = 0U;
+	uint16_t m_depth = 0U;
+	uint32_t m_levelCount = 0U;
+	std::vector<uint32_t> m_levelOffsets;
+	std::vector<Node> m_nodes;
+
+	// Selection state, rebuilt by every Select.
+	std::vector<uint8_t> m_isSplit;
+	SelectionStatistics m_statistics;
+};
+
+}
\ No newline at end of file
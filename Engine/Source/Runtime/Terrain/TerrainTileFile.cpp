@@ -0,0 +1,167 @@
+#include "TerrainTileFile.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+namespace engine
+{
+
+namespace
+{
+
+constexpr uint32_t fileMagic = 0x48544443U; // "CDTH"
+constexpr uint32_t fileVersion = 2U;
+constexpr size_t pageSize = 4096U;
+
+size_t AlignToPage(size_t size)
+{
+	return (size + pageSize - 1U) & ~(pageSize - 1U);
+}
+
+// Samples of a level along one axis. The last step is shorter when the size isn't 2^n + 1, so the edge is always kept.
+uint32_t GetLevelSampleCount(uint32_t sampleCount, uint32_t level)
+{
+	uint32_t step = 1U << level;
+	return (sampleCount - 1U + step - 1U) / step + 1U;
+}
+
+uint32_t GetLevelTileCount(uint32_t sampleCount, uint32_t level, uint32_t tileSize)
+{
+	uint32_t levelSampleCount = GetLevelSampleCount(sampleCount, level);
+	return std::max((levelSampleCount - 1U + tileSize - 1U) / tileSize, 1U);
+}
+
+uint32_t CalculateLevelCount(uint32_t width, uint32_t depth, uint32_t tileSize)
+{
+	uint32_t levelCount = 1U;
+	while (GetLevelTileCount(width, levelCount - 1U, tileSize) > 1U || GetLevelTileCount(depth, levelCount - 1U, tileSize) > 1U)
+	{
+		++levelCount;
+	}
+	return levelCount;
+}
+
+}
+
+bool TerrainTileFile::Write(const char* pFilePath, const QuantizedHeights& heights, uint32_t width, uint32_t depth, uint32_t tileSize)
+{
+	if (width < 2U || depth < 2U || 0U == tileSize || (tileSize & (tileSize - 1U)) != 0U)
+	{
+		return false;
+	}
+
+	std::ofstream fout(pFilePath, std::ios::out | std::ios::binary | std::ios::trunc);
+	if (!fout.is_open())
+	{
+		return false;
+	}
+
+	Header header { fileMagic, fileVersion, width, depth, tileSize, CalculateLevelCount(width, depth, tileSize), heights.scale, heights.offset };
+
+	std::vector<std::byte> headerPage(AlignToPage(sizeof(Header)));
+	std::memcpy(headerPage.data(), &header, sizeof(Header));
+	fout.write(reinterpret_cast<const char*>(headerPage.data()), headerPage.size());
+
+	// Level samples are picked straight from level 0, so only the source heightfield is ever in memory.
+	uint32_t tileSampleCount = tileSize + 1U;
+	std::vector<uint16_t> tileData(AlignToPage(tileSampleCount * tileSampleCount * sizeof(uint16_t)) / sizeof(uint16_t));
+	for (uint32_t level = 0U; level < header.levelCount; ++level)
+	{
+		uint32_t levelWidth = GetLevelSampleCount(width, level);
+		uint32_t levelDepth = GetLevelSampleCount(depth, level);
+		for (uint32_t tileZ = 0U; tileZ < GetLevelTileCount(depth, level, tileSize); ++tileZ)
+		{
+			for (uint32_t tileX = 0U; tileX < GetLevelTileCount(width, level, tileSize); ++tileX)
+			{
+				// Samples past the edge of the level repeat the edge.
+				for (uint32_t z = 0U; z < tileSampleCount; ++z)
+				{
+					uint32_t levelZ = std::min(tileZ * tileSize + z, levelDepth - 1U);
+					size_t sourceZ = std::min(levelZ << level, depth - 1U);
+					for (uint32_t x = 0U; x < tileSampleCount; ++x)
+					{
+						uint32_t levelX = std::min(tileX * tileSize + x, levelWidth - 1U);
+						size_t sourceX = std::min(levelX << level, width - 1U);
+						tileData[z * tileSampleCount + x] = heights.pSamples[sourceZ * width + sourceX];
+					}
+				}
+
+				fout.write(reinterpret_cast<const char*>(tileData.data()), tileData.size() * sizeof(uint16_t));
+			}
+		}
+	}
+
+	return fout.good();
+}
+
+bool TerrainTileFile::Open(const char* pFilePath)
+{
+	Close();
+
+	if (!m_file.Open(pFilePath) || m_file.GetSize() < sizeof(Header))
+	{
+		m_file.Close();
+		return false;
+	}
+
+	std::memcpy(&m_header, m_file.GetData(), sizeof(Header));
+	if (m_header.magic != fileMagic || m_header.version != fileVersion || m_header.width < 2U || m_header.depth < 2U ||
+		0U == m_header.tileSize || m_header.levelCount != CalculateLevelCount(m_header.width, m_header.depth, m_header.tileSize))
+	{
+		Close();
+		return false;
+	}
+
+	m_tileStride = AlignToPage(GetTileSampleCount() * sizeof(uint16_t));
+	m_levelFirstTiles.resize(m_header.levelCount + 1U);
+	m_levelFirstTiles[0] = 0U;
+	for (uint32_t level = 0U; level < m_header.levelCount; ++level)
+	{
+		m_levelFirstTiles[level + 1U] = m_levelFirstTiles[level] + static_cast<uint64_t>(GetTileCountX(level)) * GetTileCountZ(level);
+	}
+
+	if (m_file.GetSize() < AlignToPage(sizeof(Header)) + m_levelFirstTiles.back() * m_tileStride)
+	{
+		Close();
+		return false;
+	}
+
+	return true;
+}
+
+void TerrainTileFile::Close()
+{
+	m_file.Close();
+	m_header = Header {};
+	m_levelFirstTiles.clear();
+	m_tileStride = 0U;
+}
+
+uint32_t TerrainTileFile::GetTileCountX(uint32_t level) const
+{
+	return GetLevelTileCount(m_header.width, level, m_header.tileSize);
+}
+
+uint32_t TerrainTileFile::GetTileCountZ(uint32_t level) const
+{
+	return GetLevelTileCount(m_header.depth, level, m_header.tileSize);
+}
+
+bool TerrainTileFile::IsValidTile(const TerrainTileKey& key) const
+{
+	return key.level < m_header.levelCount && key.x < GetTileCountX(key.level) && key.z < GetTileCountZ(key.level);
+}
+
+const uint16_t* TerrainTileFile::GetTileData(const TerrainTileKey& key) const
+{
+	if (!IsOpen() || !IsValidTile(key))
+	{
+		return nullptr;
+	}
+
+	uint64_t tileIndex = m_levelFirstTiles[key.level] + static_cast<uint64_t>(key.z) * GetTileCountX(key.level) + key.x;
+	return reinterpret_cast<const uint16_t*>(m_file.GetData() + AlignToPage(sizeof(Header)) + tileIndex * m_tileStride);
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,88 @@
+#pragma once
+
+#include "Resources/MappedFile.h"
+#include "Terrain/QuantizedHeights.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace engine
+{
+
+// Tile of one level of the heightfield pyramid. Level 0 is full resolution and every level above keeps every other sample.
+struct TerrainTileKey
+{
+	uint32_t level;
+	uint32_t x;
+	uint32_t z;
+
+	uint64_t GetHash() const { return (static_cast<uint64_t>(level) << 56U) | (static_cast<uint64_t>(z) << 28U) | x; }
+	bool operator==(const TerrainTileKey& other) const { return level == other.level && x == other.x && z == other.z; }
+
+	// Tile of the next level which covers this one.
+	TerrainTileKey GetParent() const { return { level + 1U, x / 2U, z / 2U }; }
+};
+
+// Heightfield stored on disk as square tiles of every pyramid level, read through a memory mapping.
+// Layout : a header padded to a page, then the tiles of level 0, 1, ... each in row major order.
+// A tile holds (tileSize + 1)^2 16 bits samples so that neighbours share their border samples and a tile can be drawn on its own.
+// Samples keep the scale and offset of the terrain they were written from, as TerrainComponent and the R16 texture do.
+// Tiles start on page boundaries so that reading one never touches the pages of another.
+class TerrainTileFile final
+{
+public:
+	static constexpr uint32_t DefaultTileSize = 256U;
+
+	// Levels are added until one tile covers the whole heightfield. tileSize is in quads and must be a power of two.
+	static bool Write(const char* pFilePath, const QuantizedHeights& heights, uint32_t width, uint32_t depth, uint32_t tileSize = DefaultTileSize);
+
+public:
+	TerrainTileFile() = default;
+	TerrainTileFile(const TerrainTileFile&) = delete;
+	TerrainTileFile& operator=(const TerrainTileFile&) = delete;
+	TerrainTileFile(TerrainTileFile&&) = default;
+	TerrainTileFile& operator=(TerrainTileFile&&) = default;
+	~TerrainTileFile() = default;
+
+	// Fails on a missing file, an unknown version or a file shorter than its header says.
+	bool Open(const char* pFilePath);
+	void Close();
+	bool IsOpen() const { return m_file.IsOpen(); }
+
+	uint32_t GetWidth() const { return m_header.width; }
+	uint32_t GetDepth() const { return m_header.depth; }
+	uint32_t GetTileSize() const { return m_header.tileSize; }
+	uint32_t GetLevelCount() const { return m_header.levelCount; }
+	float GetMinHeight() const { return m_header.heightOffset; }
+	float GetMaxHeight() const { return m_header.heightOffset + m_header.heightScale * QuantizedHeights::MaxSample; }
+	// Decodes samples of a tile of this file, whether they point into the mapping or into a copy.
+	QuantizedHeights GetHeights(const uint16_t* pSamples) const { return { pSamples, m_header.heightScale, m_header.heightOffset }; }
+
+	uint32_t GetTileSampleCount() const { return (m_header.tileSize + 1U) * (m_header.tileSize + 1U); }
+	uint32_t GetTileCountX(uint32_t level) const;
+	uint32_t GetTileCountZ(uint32_t level) const;
+	bool IsValidTile(const TerrainTileKey& key) const;
+
+	// Points into the mapping, so the first read of a tile may wait for the disk.
+	const uint16_t* GetTileData(const TerrainTileKey& key) const;
+
+private:
+	struct Header
+	{
+		uint32_t magic;
+		uint32_t version;
+		uint32_t width;
+		uint32_t depth;
+		uint32_t tileSize;
+		uint32_t levelCount;
+		float heightScale;
+		float heightOffset;
+	};
+
+	MappedFile m_file;
+	Header m_header {};
+	std::vector<uint64_t> m_levelFirstTiles;
+	size_t m_tileStride = 0U;
+};
+
+}
\ No newline at end of file
@@ -0,0 +1,295 @@
+#include "TerrainTileStreamer.h"
+
+#include "Base/Template.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace engine
+{
+
+namespace
+{
+
+// Evicted buffers kept for the next loads. Beyond that they go back to the heap.
+constexpr size_t maxFreeBufferCount = 16U;
+
+}
+
+TerrainTileStreamer::TerrainTileStreamer(size_t memoryBudget)
+	: m_memoryBudget(memoryBudget)
+{
+}
+
+TerrainTileStreamer::~TerrainTileStreamer()
+{
+	Close();
+}
+
+bool TerrainTileStreamer::Open(const char* pFilePath)
+{
+	Close();
+
+	if (!m_tileFile.Open(pFilePath))
+	{
+		return false;
+	}
+
+	m_tileBytes = m_tileFile.GetTileSampleCount() * sizeof(uint16_t);
+
+	// The coarsest level is a single tile, or a few for very elongated heightfields.
+	uint32_t coarsestLevel = m_tileFile.GetLevelCount() - 1U;
+	for (uint32_t tileZ = 0U; tileZ < m_tileFile.GetTileCountZ(coarsestLevel); ++tileZ)
+	{
+		for (uint32_t tileX = 0U; tileX < m_tileFile.GetTileCountX(coarsestLevel); ++tileX)
+		{
+			TerrainTileKey key { coarsestLevel, tileX, tileZ };
+			TileBuffer pSamples(new uint16_t[m_tileFile.GetTileSampleCount()]);
+			std::memcpy(pSamples.get(), m_tileFile.GetTileData(key), m_tileBytes);
+			MakeResident(key, cd::MoveTemp(pSamples), true);
+		}
+	}
+
+	m_isExiting = false;
+	m_worker = std::thread(&TerrainTileStreamer::WorkerLoop, this);
+	return true;
+}
+
+void TerrainTileStreamer::Close()
+{
+	StopWorker();
+
+	m_residentTiles.clear();
+	m_lruOrder.clear();
+	m_requestedFrames.clear();
+	m_requestQueue.clear();
+	m_loadedTiles.clear();
+	m_freeBuffers.clear();
+	m_statistics = Statistics();
+	m_tileFile.Close();
+	m_tileBytes = 0U;
+}
+
+void TerrainTileStreamer::StopWorker()
+{
+	if (!m_worker.joinable())
+	{
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_isExiting = true;
+	}
+	m_wakeCondition.notify_all();
+	m_worker.join();
+}
+
+void TerrainTileStreamer::Update()
+{
+	m_statistics.hitCount = 0U;
+	m_statistics.missCount = 0U;
+	m_statistics.loadCount = 0U;
+	m_statistics.evictionCount = 0U;
+
+	std::vector<LoadedTile> loadedTiles;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		loadedTiles.swap(m_loadedTiles);
+
+		// Requests which weren't renewed during the frame are out of view now.
+		auto itEnd = std::remove_if(m_requestQueue.begin(), m_requestQueue.end(), [this](const TerrainTileKey& key)
+		{
+			auto itRequest = m_requestedFrames.find(key.GetHash());
+			if (itRequest->second == m_frameIndex)
+			{
+				return false;
+			}
+
+			m_requestedFrames.erase(itRequest);
+			return true;
+		});
+		m_requestQueue.erase(itEnd, m_requestQueue.end());
+	}
+
+	for (LoadedTile& loadedTile : loadedTiles)
+	{
+		m_requestedFrames.erase(loadedTile.key.GetHash());
+		if (m_residentTiles.find(loadedTile.key.GetHash()) != m_residentTiles.end())
+		{
+			continue;
+		}
+
+		MakeResident(loadedTile.key, cd::MoveTemp(loadedTile.pSamples), false);
+		++m_statistics.loadCount;
+	}
+
+	EvictOverBudget();
+
+	m_statistics.residentTileCount = static_cast<uint32_t>(m_residentTiles.size());
+	m_statistics.residentBytes = m_residentTiles.size() * m_tileBytes;
+	m_statistics.pendingTileCount = static_cast<uint32_t>(m_requestedFrames.size());
+	++m_frameIndex;
+}
+
+const uint16_t* TerrainTileStreamer::AcquireTile(const TerrainTileKey& key)
+{
+	if (!m_tileFile.IsValidTile(key))
+	{
+		return nullptr;
+	}
+
+	uint64_t hash = key.GetHash();
+	auto itResident = m_residentTiles.find(hash);
+	if (itResident != m_residentTiles.end())
+	{
+		ResidentTile& residentTile = itResident->second;
+		if (!residentTile.isPinned)
+		{
+			m_lruOrder.splice(m_lruOrder.begin(), m_lruOrder, residentTile.lruIterator);
+		}
+		residentTile.lastUsedFrame = m_frameIndex;
+		++m_statistics.hitCount;
+		return residentTile.pSamples.get();
+	}
+
+	++m_statistics.missCount;
+	auto [itRequest, isNewRequest] = m_requestedFrames.try_emplace(hash, m_frameIndex);
+	itRequest->second = m_frameIndex;
+	if (isNewRequest)
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_requestQueue.push_back(key);
+		}
+		m_wakeCondition.notify_one();
+	}
+
+	return nullptr;
+}
+
+const uint16_t* TerrainTileStreamer::AcquireTileOrAncestor(const TerrainTileKey& key, TerrainTileKey* pResolvedKey)
+{
+	TerrainTileKey currentKey = key;
+	const uint16_t* pSamples = AcquireTile(currentKey);
+	while (!pSamples && currentKey.level + 1U < m_tileFile.GetLevelCount())
+	{
+		// Ancestors are only looked up, requesting them too would spend the budget on tiles nobody asked for.
+		currentKey = currentKey.GetParent();
+		auto itResident = m_residentTiles.find(currentKey.GetHash());
+		if (itResident != m_residentTiles.end())
+		{
+			pSamples = AcquireTile(currentKey);
+		}
+	}
+
+	if (pResolvedKey)
+	{
+		*pResolvedKey = currentKey;
+	}
+	return pSamples;
+}
+
+void TerrainTileStreamer::RequestAround(float x, float z, uint32_t tileRadius)
+{
+	if (!m_tileFile.IsOpen())
+	{
+		return;
+	}
+
+	for (uint32_t level = 0U; level < m_tileFile.GetLevelCount(); ++level)
+	{
+		float levelTileSize = static_cast<float>(m_tileFile.GetTileSize() << level);
+		int64_t centerX = static_cast<int64_t>(std::floor(x / levelTileSize));
+		int64_t centerZ = static_cast<int64_t>(std::floor(z / levelTileSize));
+		int64_t maxX = static_cast<int64_t>(m_tileFile.GetTileCountX(level)) - 1;
+		int64_t maxZ = static_cast<int64_t>(m_tileFile.GetTileCountZ(level)) - 1;
+		for (int64_t tileZ = std::max<int64_t>(centerZ - tileRadius, 0); tileZ <= std::min<int64_t>(centerZ + tileRadius, maxZ); ++tileZ)
+		{
+			for (int64_t tileX = std::max<int64_t>(centerX - tileRadius, 0); tileX <= std::min<int64_t>(centerX + tileRadius, maxX); ++tileX)
+			{
+				AcquireTile({ level, static_cast<uint32_t>(tileX), static_cast<uint32_t>(tileZ) });
+			}
+		}
+	}
+}
+
+void TerrainTileStreamer::WorkerLoop()
+{
+	while (true)
+	{
+		TerrainTileKey key;
+		TileBuffer pSamples;
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_wakeCondition.wait(lock, [this]() { return m_isExiting || !m_requestQueue.empty(); });
+			if (m_isExiting)
+			{
+				return;
+			}
+
+			key = m_requestQueue.front();
+			m_requestQueue.pop_front();
+			if (!m_freeBuffers.empty())
+			{
+				pSamples = cd::MoveTemp(m_freeBuffers.back());
+				m_freeBuffers.pop_back();
+			}
+		}
+
+		if (!pSamples)
+		{
+			pSamples.reset(new uint16_t[m_tileFile.GetTileSampleCount()]);
+		}
+
+		// Page faults of the mapping happen here instead of on the thread which draws the terrain.
+		std::memcpy(pSamples.get(), m_tileFile.GetTileData(key), m_tileBytes);
+
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_loadedTiles.push_back({ key, cd::MoveTemp(pSamples) });
+	}
+}
+
+void TerrainTileStreamer::MakeResident(const TerrainTileKey& key, TileBuffer pSamples, bool isPinned)
+{
+	ResidentTile& residentTile = m_residentTiles[key.GetHash()];
+	residentTile.pSamples = cd::MoveTemp(pSamples);
+	residentTile.lastUsedFrame = m_frameIndex;
+	residentTile.isPinned = isPinned;
+	if (!isPinned)
+	{
+		m_lruOrder.push_front(key.GetHash());
+		residentTile.lruIterator = m_lruOrder.begin();
+	}
+}
+
+void TerrainTileStreamer::EvictOverBudget()
+{
+	std::vector<TileBuffer> evictedBuffers;
+	while (m_residentTiles.size() * m_tileBytes > m_memoryBudget && !m_lruOrder.empty())
+	{
+		auto itResident = m_residentTiles.find(m_lruOrder.back());
+		evictedBuffers.push_back(cd::MoveTemp(itResident->second.pSamples));
+		m_residentTiles.erase(itResident);
+		m_lruOrder.pop_back();
+		++m_statistics.evictionCount;
+	}
+
+	if (evictedBuffers.empty())
+	{
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	for (TileBuffer& pBuffer : evictedBuffers)
+	{
+		if (m_freeBuffers.size() >= maxFreeBufferCount)
+		{
+			break;
+		}
+		m_freeBuffers.push_back(cd::MoveTemp(pBuffer));
+	}
+}
+
+}
\ No newline at end of file
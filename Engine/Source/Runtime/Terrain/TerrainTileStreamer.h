@@ -0,0 +1,116 @@
+#pragma once
+
+#include "TerrainTileFile.h"
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace engine
+{
+
+// Keeps the tiles of a TerrainTileFile which are in use resident within a memory budget.
+// A background thread copies requested tiles out of the mapping, so page faults and disk waits never happen on the
+// calling thread. Once the budget is reached, the least recently used tiles are evicted and their buffers reused.
+// The coarsest level is loaded on Open and never evicted, so a coarser fallback always exists, the way a virtual
+// texture or clipmap expects. Everything except the worker is meant to be called from one thread.
+class TerrainTileStreamer final
+{
+public:
+	static constexpr size_t DefaultMemoryBudget = 64U << 20U;
+
+	struct Statistics
+	{
+		uint32_t residentTileCount = 0U;
+		size_t residentBytes = 0U;
+		uint32_t pendingTileCount = 0U;
+		// Since the last Update.
+		uint32_t hitCount = 0U;
+		uint32_t missCount = 0U;
+		uint32_t loadCount = 0U;
+		uint32_t evictionCount = 0U;
+	};
+
+public:
+	explicit TerrainTileStreamer(size_t memoryBudget = DefaultMemoryBudget);
+	TerrainTileStreamer(const TerrainTileStreamer&) = delete;
+	TerrainTileStreamer& operator=(const TerrainTileStreamer&) = delete;
+	TerrainTileStreamer(TerrainTileStreamer&&) = delete;
+	TerrainTileStreamer& operator=(TerrainTileStreamer&&) = delete;
+	~TerrainTileStreamer();
+
+	bool Open(const char* pFilePath);
+	void Close();
+	const TerrainTileFile& GetTileFile() const { return m_tileFile; }
+
+	void SetMemoryBudget(size_t memoryBudget) { m_memoryBudget = memoryBudget; }
+	size_t GetMemoryBudget() const { return m_memoryBudget; }
+
+	// Once per frame : makes finished loads resident, evicts over the budget and drops requests which weren't renewed.
+	void Update();
+
+	// Returns the samples of the tile when it is resident, otherwise requests it and returns nullptr.
+	// Pointers stay valid until the next Update. GetTileFile().GetHeights decodes them.
+	const uint16_t* AcquireTile(const TerrainTileKey& key);
+
+	// Same as AcquireTile, but walks up to the nearest resident ancestor when the tile is missing.
+	// pResolvedKey receives the tile which was returned.
+	const uint16_t* AcquireTileOrAncestor(const TerrainTileKey& key, TerrainTileKey* pResolvedKey = nullptr);
+
+	// Clipmap style request : the tiles within tileRadius of the point on every level, finer levels first.
+	// x and z are in level 0 samples.
+	void RequestAround(float x, float z, uint32_t tileRadius);
+
+	const Statistics& GetStatistics() const { return m_statistics; }
+
+private:
+	using TileBuffer = std::unique_ptr<uint16_t[]>;
+
+	struct ResidentTile
+	{
+		TileBuffer pSamples;
+		std::list<uint64_t>::iterator lruIterator;
+		uint64_t lastUsedFrame = 0U;
+		bool isPinned = false;
+	};
+
+	struct LoadedTile
+	{
+		TerrainTileKey key;
+		TileBuffer pSamples;
+	};
+
+	void WorkerLoop();
+	void StopWorker();
+	TileBuffer TakeBuffer();
+	void MakeResident(const TerrainTileKey& key, TileBuffer pSamples, bool isPinned);
+	void EvictOverBudget();
+
+	TerrainTileFile m_tileFile;
+	size_t m_tileBytes = 0U;
+	size_t m_memoryBudget;
+	uint64_t m_frameIndex = 0U;
+
+	// Owned by the calling thread.
+	std::unordered_map<uint64_t, ResidentTile> m_residentTiles;
+	std::list<uint64_t> m_lruOrder;
+	std::unordered_map<uint64_t, uint64_t> m_requestedFrames;
+	Statistics m_statistics;
+
+	// Shared with the worker.
+	std::thread m_worker;
+	std::mutex m_mutex;
+	std::condition_variable m_wakeCondition;
+	std::deque<TerrainTileKey> m_requestQueue;
+	std::vector<LoadedTile> m_loadedTiles;
+	std::vector<TileBuffer> m_freeBuffers;
+	bool m_isExiting = false;
+};
+
+}
\ No newline at end of file
@@ -1,8 +1,203 @@
 #include "TerrainUtils.h"
 
+#include "Core/ThreadPool.h"
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+
 namespace engine
 {
 
+namespace
+{
+
+// Rows are batched until a batch holds about this many samples.
+constexpr uint32_t samplesPerBatch = 16384U;
+
+uint32_t MixBits(uint32_t value)
+{
+    value ^= value >> 16U;
+    value *= 0x7FEB352DU;
+    value ^= value >> 15U;
+    value *= 0x846CA68BU;
+    value ^= value >> 16U;
+    return value;
+}
+
+// Hashing the row first lets row loops compute it once.
+uint32_t HashLatticeRow(uint32_t seed, int32_t z)
+{
+    return MixBits(static_cast<uint32_t>(z) + MixBits(seed));
+}
+
+uint32_t HashCoordinates(uint32_t seed, int32_t x, int32_t z)
+{
+    return MixBits(static_cast<uint32_t>(x) + HashLatticeRow(seed, z));
+}
+
+// Uniform in [-1, 1) with the 24 bits a float mantissa can hold.
+float ToSignedUnit(uint32_t hash)
+{
+    return static_cast<float>(hash >> 8U) * (2.0f / 16777216.0f) - 1.0f;
+}
+
+template<typename RowFunction>
+void GenerateDiamondSquare(uint16_t terrainWidth, uint16_t terrainDepth, const ElevationMapSettings& settings, float* pElevations, const RowFunction& ForEachRow)
+{
+    int32_t width = terrainWidth;
+    int32_t depth = terrainDepth;
+    int32_t rectSize = 1;
+    while (rectSize < std::max(width - 1, depth - 1))
+    {
+        rectSize *= 2;
+    }
+
+    // Samples outside of the map are skipped, so sizes other than 2^n + 1 need no larger scratch grid.
+    auto GetNeighbourAverage = [pElevations, width, depth](int32_t x, int32_t z, const int32_t (&offsets)[4][2])
+    {
+        float sum = 0.0f;
+        float count = 0.0f;
+        for (const auto& offset : offsets)
+        {
+            int32_t neighbourX = x + offset[0];
+            int32_t neighbourZ = z + offset[1];
+            if (neighbourX >= 0 && neighbourX < width && neighbourZ >= 0 && neighbourZ < depth)
+            {
+                sum += pElevations[neighbourZ * width + neighbourX];
+                count += 1.0f;
+            }
+        }
+        return sum / count;
+    };
+
+    float displacement = static_cast<float>(rectSize) / 2.0f;
+    float displacementReduce = std::pow(2.0f, -settings.roughness);
+    for (int32_t z = 0; z < depth; z += rectSize)
+    {
+        for (int32_t x = 0; x < width; x += rectSize)
+        {
+            pElevations[z * width + x] = ToSignedUnit(HashCoordinates(settings.seed, x, z)) * displacement;
+        }
+    }
+
+    // Every sample is written once by the level which reaches it, and reads only samples of coarser levels or
+    // of the diamond step before, so rows of one step are independent.
+    for (; rectSize > 1; rectSize /= 2)
+    {
+        int32_t halfSize = rectSize / 2;
+        const int32_t diamondOffsets[4][2] = { { -halfSize, -halfSize }, { halfSize, -halfSize }, { -halfSize, halfSize }, { halfSize, halfSize } };
+        const int32_t squareOffsets[4][2] = { { -halfSize, 0 }, { halfSize, 0 }, { 0, -halfSize }, { 0, halfSize } };
+
+        // Diamond step : centers of the rectangles.
+        uint32_t diamondRowCount = depth > halfSize ? static_cast<uint32_t>((depth - 1 - halfSize) / rectSize + 1) : 0U;
+        ForEachRow(diamondRowCount, static_cast<uint32_t>(width / rectSize + 1), [&](uint32_t begin, uint32_t end)
+        {
+            for (uint32_t row = begin; row < end; ++row)
+            {
+                int32_t z = halfSize + static_cast<int32_t>(row) * rectSize;
+                for (int32_t x = halfSize; x < width; x += rectSize)
+                {
+                    pElevations[z * width + x] = GetNeighbourAverage(x, z, diamondOffsets) + ToSignedUnit(HashCoordinates(settings.seed, x, z)) * displacement;
+                }
+            }
+        });
+
+        // Square step : edge midpoints, which alternate between odd and even rows.
+        uint32_t squareRowCount = static_cast<uint32_t>((depth - 1) / halfSize + 1);
+        ForEachRow(squareRowCount, static_cast<uint32_t>(width / rectSize + 1), [&](uint32_t begin, uint32_t end)
+        {
+            for (uint32_t row = begin; row < end; ++row)
+            {
+                int32_t z = static_cast<int32_t>(row) * halfSize;
+                for (int32_t x = (row & 1U) ? 0 : halfSize; x < width; x += rectSize)
+                {
+                    pElevations[z * width + x] = GetNeighbourAverage(x, z, squareOffsets) + ToSignedUnit(HashCoordinates(settings.seed, x, z)) * displacement;
+                }
+            }
+        });
+
+        displacement *= displacementReduce;
+    }
+}
+
+float GetLatticeValue(uint32_t rowHash, int32_t x)
+{
+    return ToSignedUnit(MixBits(static_cast<uint32_t>(x) + rowHash));
+}
+
+float Smoothstep(float t)
+{
+    return t * t * (3.0f - 2.0f * t);
+}
+
+// Octaves of value noise, an integer lattice of hashed values with smoothstep interpolation.
+// Octaves are accumulated row by row and the lattice values of the current cell are reused until x leaves it.
+template<typename RowFunction>
+void GenerateFractalNoise(uint16_t terrainWidth, uint16_t terrainDepth, const ElevationMapSettings& settings, float* pElevations, const RowFunction& ForEachRow)
+{
+    bool isRidged = ElevationNoiseType::Ridged == settings.noiseType;
+    float baseFrequency = settings.frequency / static_cast<float>(std::max(terrainWidth, terrainDepth) - 1);
+    ForEachRow(terrainDepth, terrainWidth, [&](uint32_t begin, uint32_t end)
+    {
+        for (uint32_t z = begin; z < end; ++z)
+        {
+            float* pRow = pElevations + z * terrainWidth;
+            std::fill(pRow, pRow + terrainWidth, 0.0f);
+
+            float frequency = baseFrequency;
+            float amplitude = 1.0f;
+            for (uint32_t octave = 0U; octave < settings.octaveCount; ++octave)
+            {
+                // Every octave gets its own lattice so that their features don't line up at the origin.
+                uint32_t octaveSeed = settings.seed + octave;
+                float sampleZ = static_cast<float>(z) * frequency;
+                float floorZ = std::floor(sampleZ);
+                int32_t cellZ = static_cast<int32_t>(floorZ);
+                float tz = Smoothstep(sampleZ - floorZ);
+                uint32_t rowHash0 = HashLatticeRow(octaveSeed, cellZ);
+                uint32_t rowHash1 = HashLatticeRow(octaveSeed, cellZ + 1);
+
+                int32_t cachedCellX = INT32_MIN;
+                float v0Begin = 0.0f;
+                float v0Delta = 0.0f;
+                float v1Begin = 0.0f;
+                float v1Delta = 0.0f;
+                for (uint32_t x = 0U; x < terrainWidth; ++x)
+                {
+                    float sampleX = static_cast<float>(x) * frequency;
+                    float floorX = std::floor(sampleX);
+                    int32_t cellX = static_cast<int32_t>(floorX);
+                    if (cellX != cachedCellX)
+                    {
+                        cachedCellX = cellX;
+                        v0Begin = GetLatticeValue(rowHash0, cellX);
+                        v0Delta = GetLatticeValue(rowHash0, cellX + 1) - v0Begin;
+                        v1Begin = GetLatticeValue(rowHash1, cellX);
+                        v1Delta = GetLatticeValue(rowHash1, cellX + 1) - v1Begin;
+                    }
+
+                    float tx = Smoothstep(sampleX - floorX);
+                    float v0 = v0Begin + v0Delta * tx;
+                    float v1 = v1Begin + v1Delta * tx;
+                    float noise = v0 + (v1 - v0) * tz;
+                    if (isRidged)
+                    {
+                        noise = 1.0f - std::abs(noise);
+                        noise *= noise;
+                    }
+                    pRow[x] += noise * amplitude;
+                }
+
+                frequency *= settings.lacunarity;
+                amplitude *= settings.gain;
+            }
+        }
+    });
+}
+
+}
+
 std::optional<cd::Mesh> GenerateTerrainMesh(uint16_t width, uint16_t depth, const cd::VertexFormat& vertexFormat) 
 {
     assert(vertexFormat.Contains(cd::VertexAttributeType::Position));
@@ -111,125 +306,79 @@ std::optional<cd::Mesh> GenerateTerrainMesh(uint16_t width, uint16_t depth, cons
     return mesh;
 }
 
-uint16_t CalcNextPowerOfTwo(uint16_t x)
+void GenerateElevationMap(uint16_t terrainWidth, uint16_t terrainDepth, const ElevationMapSettings& settings, float* pElevations, ThreadPool* pThreadPool)
 {
-    uint16_t ret = 1;
-    if (x == 1) { return 2U; }
-    while (ret < x) { ret = ret * 2; }
-    return ret;
-}
-
-float RandomFloatRange(float Start, float End)
-{
-    float Delta = End - Start;
-    float RandomValue = rand() * Delta + Start;
-    return RandomValue;
-}
-
-std::optional<std::vector<std::byte>> GenerateElevationMap(uint16_t terrainWidth, uint16_t terrainDepth, float roughness, float minHeight, float maxHeight)
-{
-    assert(roughness > 0.0f);
-
-    uint16_t RectSize = CalcNextPowerOfTwo(std::max(terrainWidth - 1, terrainDepth - 1));
-    float CurElevation = static_cast<float>(RectSize) / 2.0f;
-    float ElevationReduce = pow(2.0f, -roughness);
-    std::vector<float> ElevationMap;
-    ElevationMap.resize(terrainWidth * terrainDepth, 0);//* sizeof(int32_t)
+    assert(terrainWidth > 1U && terrainDepth > 1U);
 
-    while (RectSize > 0U)
+    // The row functions only write the samples of their own rows.
+    auto ForEachRow = [pThreadPool](uint32_t rowCount, uint32_t rowSampleCount, const ThreadPool::BatchFunction& function)
     {
-        //DiamondStep
-        int HalfRectSize = RectSize / 2;
-        for (uint16_t z = 0U; z < terrainDepth; z += RectSize)
+        uint32_t rowBatchSize = std::max(1U, samplesPerBatch / std::max(rowSampleCount, 1U));
+        if (pThreadPool)
         {
-            for (uint16_t x = 0U; x < terrainWidth; x += RectSize)
-            {
-                uint16_t next_x = (x + RectSize) % terrainWidth;
-                uint16_t next_z = (z + RectSize) % terrainDepth;
-                if (next_x < x)
-                {
-                    next_x = terrainWidth - 1;
-                }
-                if (next_z < z)
-                {
-                    next_z = terrainDepth - 1;
-                }
-                float TopLeft = ElevationMap[z * terrainWidth + x];
-                float TopRight = ElevationMap[z * terrainWidth + next_x];
-                float BottomLeft = ElevationMap[next_z * terrainWidth + x];
-                float BottomRight = ElevationMap[next_z * terrainWidth + next_x];
-
-                uint16_t mid_x = (x + HalfRectSize) % terrainWidth;
-                uint16_t mid_z = (z + HalfRectSize) % terrainDepth;
-
-                float RandValue = RandomFloatRange(CurElevation, -CurElevation);
-                float MidPoint = (TopLeft + TopRight + BottomLeft + BottomRight) / 4.0f;
-
-                ElevationMap[mid_z * terrainWidth + mid_x] = MidPoint + RandValue;
-            }
+            pThreadPool->ParallelFor(rowCount, rowBatchSize, function);
         }
-
-        //SquareStep
-        for (uint16_t z = 0U; z < terrainDepth; z += RectSize)
+        else
         {
-            for (uint16_t x = 0U; x < terrainWidth; x += RectSize)
-            {
-                uint16_t next_x = (x + RectSize) % terrainWidth;
-                uint16_t next_z = (z + RectSize) % terrainDepth;
-
-                if (next_x < x)
-                {
-                    next_x = terrainWidth - 1;
-                }
-                if (next_z < z)
-                {
-                    next_z = terrainDepth - 1;
-                }
-
-                uint32_t mid_x = (x + HalfRectSize) % terrainWidth;
-                uint32_t mid_z = (z + HalfRectSize) % terrainDepth;
-                uint32_t prev_mid_x = (x - HalfRectSize - 1 + terrainWidth) % terrainWidth;
-                uint32_t prev_mid_z = (z - HalfRectSize - 1 + terrainDepth) % terrainDepth;
-
-                float CurTopLeft = ElevationMap[z * terrainWidth + x];
-                float CurTopRight = ElevationMap[z * terrainWidth + next_x];
-                float CurCenter = ElevationMap[mid_z * terrainWidth + mid_x];
-                float PrevYCenter = ElevationMap[prev_mid_z * terrainWidth + mid_x];
-                float CurBotLeft = ElevationMap[next_z * terrainWidth + x];
-                float PrevXCenter = ElevationMap[mid_z * terrainWidth + prev_mid_x];
-
-                float CurLeftMid = (CurTopLeft + CurCenter + CurBotLeft + PrevXCenter) / 4.0f + RandomFloatRange(-CurElevation, CurElevation);
-                float CurTopMid = (CurTopLeft + CurCenter + CurTopRight + PrevYCenter) / 4.0f + RandomFloatRange(-CurElevation, CurElevation);
-
-                ElevationMap[z * terrainWidth + mid_x] = CurTopMid;
-                ElevationMap[mid_z * terrainWidth + x] = CurLeftMid;
-            }
+            function(0U, rowCount);
         }
-        RectSize /= 2;
-        CurElevation *= ElevationReduce;
+    };
 
+    if (ElevationNoiseType::DiamondSquare == settings.noiseType)
+    {
+        GenerateDiamondSquare(terrainWidth, terrainDepth, settings, pElevations, ForEachRow);
     }
-
-    //mapping to [minHeight, maxHeight]
-    float min = *std::min_element(ElevationMap.begin(), ElevationMap.end());
-    float max = *std::max_element(ElevationMap.begin(), ElevationMap.end());
-    for (auto& Elevation : ElevationMap)
+    else
     {
-        Elevation = (Elevation - min) / (max - min) * (maxHeight - minHeight) + minHeight;
+        GenerateFractalNoise(terrainWidth, terrainDepth, settings, pElevations, ForEachRow);
     }
 
-    //float to std::byte
-    std::vector<std::byte> outElevationMap;
-    outElevationMap.reserve(terrainWidth * terrainDepth * sizeof(float));//
-    for (auto& Elevation : ElevationMap)
+    // Mapping to [minHeight, maxHeight]. Rows are reduced separately and then merged in a fixed order.
+    std::vector<float> rowMinimums(terrainDepth);
+    std::vector<float> rowMaximums(terrainDepth);
+    ForEachRow(terrainDepth, terrainWidth, [&](uint32_t begin, uint32_t end)
     {
-        std::byte* bytePtr = reinterpret_cast<std::byte*>(&Elevation);
-        for (std::size_t i = 0; i < sizeof(float); ++i)
+        for (uint32_t z = begin; z < end; ++z)
         {
-            outElevationMap.push_back(bytePtr[i]);
+            const float* pRow = pElevations + z * terrainWidth;
+            float rowMinimum = pRow[0];
+            float rowMaximum = pRow[0];
+            for (uint32_t x = 1U; x < terrainWidth; ++x)
+            {
+                rowMinimum = std::min(rowMinimum, pRow[x]);
+                rowMaximum = std::max(rowMaximum, pRow[x]);
+            }
+            rowMinimums[z] = rowMinimum;
+            rowMaximums[z] = rowMaximum;
         }
+    });
+
+    float minimum = *std::min_element(rowMinimums.begin(), rowMinimums.end());
+    float maximum = *std::max_element(rowMaximums.begin(), rowMaximums.end());
+    float scale = maximum > minimum ? (settings.maxHeight - settings.minHeight) / (maximum - minimum) : 0.0f;
+    float offset = settings.minHeight - minimum * scale;
+    ForEachRow(terrainDepth, terrainWidth, [pElevations, terrainWidth, scale, offset](uint32_t begin, uint32_t end)
+    {
+        // Contiguous and branchless so that the compiler emits vector loads and stores.
+        float* pBegin = pElevations + begin * terrainWidth;
+        float* pEnd = pElevations + end * terrainWidth;
+        for (float* pElevation = pBegin; pElevation < pEnd; ++pElevation)
+        {
+            *pElevation = *pElevation * scale + offset;
+        }
+    });
+}
+
+std::optional<std::vector<std::byte>> GenerateElevationMap(uint16_t terrainWidth, uint16_t terrainDepth, const ElevationMapSettings& settings, ThreadPool* pThreadPool)
+{
+    if (terrainWidth < 2U || terrainDepth < 2U)
+    {
+        return std::nullopt;
     }
 
+    // Samples are written as floats in place, std::vector storage is suitably aligned for them.
+    std::vector<std::byte> outElevationMap(static_cast<size_t>(terrainWidth) * terrainDepth * sizeof(float));
+    GenerateElevationMap(terrainWidth, terrainDepth, settings, reinterpret_cast<float*>(outElevationMap.data()), pThreadPool);
     return outElevationMap;
 }
 
@@ -1,3 +1,5 @@
+#pragma once
+
 #include "Scene/VertexFormat.h"
 #include "Scene/Mesh.h"
 
@@ -7,7 +9,38 @@
 namespace engine
 {
 
+class ThreadPool;
+
+enum class ElevationNoiseType
+{
+	DiamondSquare,
+	FractalBrownian,
+	Ridged,
+};
+
+struct ElevationMapSettings
+{
+	ElevationNoiseType noiseType = ElevationNoiseType::DiamondSquare;
+	uint32_t seed = 0U;
+	float minHeight = 0.0f;
+	float maxHeight = 30.0f;
+
+	// Diamond square : displacements shrink by 2^-roughness at every level.
+	float roughness = 1.55f;
+
+	// Noise : lattice cells across the larger side at the first octave.
+	float frequency = 4.0f;
+	uint32_t octaveCount = 8U;
+	float lacunarity = 2.0f;
+	float gain = 0.5f;
+};
+
 std::optional<cd::Mesh> GenerateTerrainMesh(uint16_t width, uint16_t depth, const cd::VertexFormat& vertexFormat);
-std::optional<std::vector<std::byte>> GenerateElevationMap(uint16_t terrainWidth, uint16_t terrainDepth, float roughness, float minHeight, float maxHeight);
+
+// Random values come from a hash of the seed and the sample coordinates instead of a shared generator,
+// so the map is the same whatever the thread count and the order in which rows are processed.
+// Rows are spread over the thread pool when one is given. pElevations holds terrainWidth * terrainDepth floats.
+void GenerateElevationMap(uint16_t terrainWidth, uint16_t terrainDepth, const ElevationMapSettings& settings, float* pElevations, ThreadPool* pThreadPool = nullptr);
+std::optional<std::vector<std::byte>> GenerateElevationMap(uint16_t terrainWidth, uint16_t terrainDepth, const ElevationMapSettings& settings, ThreadPool* pThreadPool = nullptr);
 
 }
\ No newline at end of file
@@ -1,5 +1,7 @@
 #include "Clock.h"
 
+#include <algorithm>
+
 namespace engine
 {
 
@@ -32,6 +34,19 @@ void Clock::Update()
 
     m_deltaTime = static_cast<float>(std::chrono::duration_cast<std::chrono::duration<double>>(m_elapsed).count());
     //m_timeSinceStart += m_deltaTime;
+
+    m_accumulatedTime = std::min(m_accumulatedTime + m_deltaTime, m_fixedDeltaTime * static_cast<float>(m_maxFixedStepCount));
+}
+
+bool Clock::ConsumeFixedStep()
+{
+    if (m_accumulatedTime < m_fixedDeltaTime)
+    {
+        return false;
+    }
+
+    m_accumulatedTime -= m_fixedDeltaTime;
+    return true;
 }
 
 }
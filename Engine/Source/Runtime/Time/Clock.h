@@ -1,6 +1,7 @@
 #pragma once
 
 #include <chrono>
+#include <cstdint>
 #include <filesystem>
 
 namespace engine
@@ -26,8 +27,26 @@ public:
 	float GetDeltaTime() const { return m_deltaTime; }
 	//float GetTimeSinceStart() const { m_timeSinceStart; }
 
+	// Fixed timestep : Update adds the frame time to an accumulator and ConsumeFixedStep takes
+	// fixed steps out of it, so simulation runs at the same rate whatever the frame rate is.
+	void SetFixedDeltaTime(float fixedDeltaTime) { m_fixedDeltaTime = fixedDeltaTime; }
+	float GetFixedDeltaTime() const { return m_fixedDeltaTime; }
+
+	// Steps which don't fit in one frame are dropped so that a hitch doesn't make the next frames slower.
+	void SetMaxFixedStepCount(uint32_t count) { m_maxFixedStepCount = count; }
+	uint32_t GetMaxFixedStepCount() const { return m_maxFixedStepCount; }
+
+	// Returns true and removes one fixed step from the accumulator if there is enough time left.
+	bool ConsumeFixedStep();
+
+	// Fraction of a fixed step which is accumulated but not simulated yet, used to blend the last two steps.
+	float GetInterpolationAlpha() const { return m_accumulatedTime / m_fixedDeltaTime; }
+
 private:
 	float m_deltaTime = 0.0f;
+	float m_fixedDeltaTime = 1.0f / 60.0f;
+	float m_accumulatedTime = 0.0f;
+	uint32_t m_maxFixedStepCount = 8U;
 	//float m_timeSinceStart = 0.0f;
 
 	std::chrono::duration<float> m_elapsed;
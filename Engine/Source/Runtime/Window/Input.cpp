@@ -3,6 +3,9 @@
 #include "Log/Log.h"
 
 #include <imgui/imgui.h>
+
+#include <algorithm>
+#include <iterator>
 #include <unordered_map>
 #include <utility>
 
@@ -43,6 +46,16 @@ void Input::SetKeyPressed(KeyCode code, bool pressed)
 	m_keyPressed[static_cast<std::underlying_type_t<KeyCode>>(code)] = pressed;
 }
 
+bool Input::IsAnyPressed() const
+{
+	if (m_mouseLBPressed || m_mouseRBPressed || m_mouseMBPressed)
+	{
+		return true;
+	}
+
+	return std::any_of(std::begin(m_keyPressed), std::end(m_keyPressed), [](bool pressed) { return pressed; });
+}
+
 void Input::AppendKeyEvent(KeyCode code, KeyMod mod, bool pressed)
 {
 	KeyEvent newEvent;
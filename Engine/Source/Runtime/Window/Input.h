@@ -79,6 +79,8 @@ public:
 
 	// Keyboard device
 	bool IsKeyPressed(KeyCode code) const { return m_keyPressed[static_cast<uint8_t>(code)]; }
+	// Held keys and mouse buttons keep driving continuous tools without sending new events.
+	bool IsAnyPressed() const;
 	void SetKeyPressed(KeyCode code, bool pressed);
 
 	void SetModifier(KeyMod mod);
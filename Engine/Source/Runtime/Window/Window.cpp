@@ -75,10 +75,12 @@ void Window::Close(bool bPushSdlEvent)
 void Window::Update()
 {
 	Input::Get().Reset();
+	m_hasReceivedEvents = false;
 
 	SDL_Event sdlEvent;
 	while (SDL_PollEvent(&sdlEvent))
 	{
+		m_hasReceivedEvents = true;
 		switch (sdlEvent.type)
 		{
 		case SDL_QUIT:
@@ -222,6 +224,12 @@ void Window::Update()
 	}
 }
 
+bool Window::WaitEvent(uint32_t timeoutMilliseconds) const
+{
+	// Leaves the event in the queue for the next Update.
+	return 1 == SDL_WaitEventTimeout(nullptr, static_cast<int>(timeoutMilliseconds));
+}
+
 void Window::SetTitle(const char* pTitle)
 {
 	SDL_SetWindowTitle(m_pSDLWindow, pTitle);
@@ -37,6 +37,10 @@ public:
     void SetWindowIcon(const char* pFilePath) const;
 
     void Update();
+    // Returns if the last Update processed any event.
+    bool HasReceivedEvents() const { return m_hasReceivedEvents; }
+    // Blocks until an event is queued or the timeout expires. Returns false on timeout.
+    bool WaitEvent(uint32_t timeoutMilliseconds) const;
 
     bool ShouldClose() const { return m_isClosed; }
     void Close(bool bPushSdlEvent = true);
@@ -53,6 +57,7 @@ private:
     uint16_t m_width = 1;
     uint16_t m_height = 1;
     bool m_isClosed = false;
+    bool m_hasReceivedEvents = false;
 };
 
 }
\ No newline at end of file